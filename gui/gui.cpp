@@ -584,6 +584,12 @@ void Ep128EmuGUI::createMenus()
                    (char *) 0, &menuCallback_Machine_Speed_200, (void *) this);
   mainMenuBar->add("Machine/Speed/400%",
                    (char *) 0, &menuCallback_Machine_Speed_400, (void *) this);
+  mainMenuBar->add("Machine/Run-ahead/Disabled",
+                   (char *) 0, &menuCallback_Machine_RunAhead_0, (void *) this);
+  mainMenuBar->add("Machine/Run-ahead/1 frame",
+                   (char *) 0, &menuCallback_Machine_RunAhead_1, (void *) this);
+  mainMenuBar->add("Machine/Run-ahead/2 frames",
+                   (char *) 0, &menuCallback_Machine_RunAhead_2, (void *) this);
   mainMenuBar->add("Machine/Tape/Select image file (Alt+T)",
                    (char *) 0, &menuCallback_Machine_OpenTape, (void *) this);
   mainMenuBar->add("Machine/Tape/Play (Alt+P)",
@@ -1276,6 +1282,7 @@ void Ep128EmuGUI::applyEmulatorConfiguration(bool updateWindowFlag_)
       vmThread.setSpeedPercentage(config.vm.speedPercentage == 100U &&
                                   config.sound.enabled ?
                                   0 : int(config.vm.speedPercentage));
+      vmThread.setRunAheadFrames(int(config.vm.runAheadFrames));
       if (config.joystickSettingsChanged) {
         joystickInput.setConfiguration(config.joystick);
         config.joystickSettingsChanged = false;
@@ -1811,7 +1818,7 @@ void Ep128EmuGUI::menuCallback_File_RecordVideo(Fl_Widget *o, void *v)
     if (gui_.lockVMThread()) {
       try {
         gui_.vm.openVideoCapture(gui_.config.videoCapture.frameRate,
-                                 gui_.config.videoCapture.yuvFormat,
+                                 gui_.config.videoCapture.format,
                                  &Ep128EmuGUI::errorMessageCallback,
                                  &Ep128EmuGUI::fileNameCallback, v);
         gui_.getMenuItem(2).activate();         // "File/Record video/Stop"
@@ -1981,6 +1988,45 @@ void Ep128EmuGUI::menuCallback_Machine_Speed_400(Fl_Widget *o, void *v)
   }
 }
 
+void Ep128EmuGUI::menuCallback_Machine_RunAhead_0(Fl_Widget *o, void *v)
+{
+  (void) o;
+  Ep128EmuGUI&  gui_ = *(reinterpret_cast<Ep128EmuGUI *>(v));
+  try {
+    gui_.config["vm.runAheadFrames"] = 0U;
+    gui_.applyEmulatorConfiguration();
+  }
+  catch (std::exception& e) {
+    gui_.errorMessage(e.what());
+  }
+}
+
+void Ep128EmuGUI::menuCallback_Machine_RunAhead_1(Fl_Widget *o, void *v)
+{
+  (void) o;
+  Ep128EmuGUI&  gui_ = *(reinterpret_cast<Ep128EmuGUI *>(v));
+  try {
+    gui_.config["vm.runAheadFrames"] = 1U;
+    gui_.applyEmulatorConfiguration();
+  }
+  catch (std::exception& e) {
+    gui_.errorMessage(e.what());
+  }
+}
+
+void Ep128EmuGUI::menuCallback_Machine_RunAhead_2(Fl_Widget *o, void *v)
+{
+  (void) o;
+  Ep128EmuGUI&  gui_ = *(reinterpret_cast<Ep128EmuGUI *>(v));
+  try {
+    gui_.config["vm.runAheadFrames"] = 2U;
+    gui_.applyEmulatorConfiguration();
+  }
+  catch (std::exception& e) {
+    gui_.errorMessage(e.what());
+  }
+}
+
 void Ep128EmuGUI::menuCallback_Machine_OpenTape(Fl_Widget *o, void *v)
 {
   (void) o;
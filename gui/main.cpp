@@ -24,6 +24,7 @@
 #include "tvc64vm.hpp"
 #include "system.hpp"
 #include "guicolor.hpp"
+#include "demorender.hpp"
 
 #include <typeinfo>
 
@@ -62,6 +63,7 @@ int8_t getSnapshotType(const Ep128Emu::File& f)
 int main(int argc, char **argv)
 {
   Fl_Window *w = (Fl_Window *) 0;
+  Ep128Emu::VideoDisplay    *display = (Ep128Emu::VideoDisplay *) 0;
   Ep128Emu::VirtualMachine  *vm = (Ep128Emu::VirtualMachine *) 0;
   Ep128Emu::AudioOutput     *audioOutput = (Ep128Emu::AudioOutput *) 0;
 #ifdef ENABLE_MIDI_PORT
@@ -74,6 +76,10 @@ int main(int argc, char **argv)
   const char      *cfgFileName = "ep128cfg.dat";
   Ep128Emu::File  *snapshotFile = (Ep128Emu::File *) 0;
   int       snapshotNameIndex = 0;
+  // if non-zero, play the demo file without a window, and write the video
+  // (and optionally audio) output to a file as fast as possible
+  int       renderNameIndex = 0;
+  int       renderWAVNameIndex = 0;
   int       colorScheme = 0;
   int8_t    machineType = -1;   // 0: EP (default), 1: ZX, 2: CPC, 3: TVC
   int8_t    retval = 0;
@@ -117,6 +123,16 @@ int main(int argc, char **argv)
           throw Ep128Emu::Exception("missing snapshot file name");
         snapshotNameIndex = i;
       }
+      else if (std::strcmp(argv[i], "-render") == 0) {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing AVI file name");
+        renderNameIndex = i;
+      }
+      else if (std::strcmp(argv[i], "-render-wav") == 0) {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing sound file name");
+        renderWAVNameIndex = i;
+      }
       else if (std::strcmp(argv[i], "-colorscheme") == 0) {
         if (++i >= argc)
           throw Ep128Emu::Exception("missing color scheme number");
@@ -160,6 +176,15 @@ int main(int argc, char **argv)
         std::fprintf(stderr,
                      "    -snapshot <FNAME>   "
                      "load snapshot or demo file on startup\n");
+        std::fprintf(stderr,
+                     "    -render <FILENAME>  "
+                     "convert the demo file specified with -snapshot\n"
+                     "                        "
+                     "to AVI format without opening a window, and exit\n");
+        std::fprintf(stderr,
+                     "    -render-wav <FNAME> "
+                     "also write sound output to WAV file when using "
+                     "-render\n");
 #ifndef DISABLE_OPENGL_DISPLAY
         std::fprintf(stderr,
                      "    -opengl             "
@@ -184,22 +209,32 @@ int main(int argc, char **argv)
       }
     }
 
-    Fl::lock();
-    Ep128Emu::setGUIColorScheme(colorScheme);
-    audioOutput = new Ep128Emu::AudioOutput_PortAudio();
-#ifndef DISABLE_OPENGL_DISPLAY
-    if (glEnabled) {
-      glCanDoSingleBuf = bool(Fl_Gl_Window::can_do(FL_RGB | FL_SINGLE));
-      glCanDoDoubleBuf = bool(Fl_Gl_Window::can_do(FL_RGB | FL_DOUBLE));
-      if (glCanDoSingleBuf | glCanDoDoubleBuf)
-        w = new Ep128Emu::OpenGLDisplay(32, 32, 384, 288, "");
-      else
-        glEnabled = false;
+    if (renderNameIndex > 0) {
+      if (snapshotNameIndex < 1)
+        throw Ep128Emu::Exception("-render requires a demo file (-snapshot)");
+      glEnabled = false;
+      audioOutput = new Ep128Emu::AudioOutput();
+      display = new Ep128Emu::NullVideoDisplay();
     }
+    else {
+      Fl::lock();
+      Ep128Emu::setGUIColorScheme(colorScheme);
+      audioOutput = new Ep128Emu::AudioOutput_PortAudio();
+#ifndef DISABLE_OPENGL_DISPLAY
+      if (glEnabled) {
+        glCanDoSingleBuf = bool(Fl_Gl_Window::can_do(FL_RGB | FL_SINGLE));
+        glCanDoDoubleBuf = bool(Fl_Gl_Window::can_do(FL_RGB | FL_DOUBLE));
+        if (glCanDoSingleBuf | glCanDoDoubleBuf)
+          w = new Ep128Emu::OpenGLDisplay(32, 32, 384, 288, "");
+        else
+          glEnabled = false;
+      }
 #endif
-    if (!glEnabled)
-      w = new Ep128Emu::FLTKDisplay(32, 32, 384, 288, "");
-    w->end();
+      if (!glEnabled)
+        w = new Ep128Emu::FLTKDisplay(32, 32, 384, 288, "");
+      w->end();
+      display = dynamic_cast<Ep128Emu::VideoDisplay *>(w);
+    }
     if (snapshotNameIndex > 0) {
       snapshotFile = new Ep128Emu::File(argv[snapshotNameIndex], false);
       if (machineType < 0)
@@ -207,28 +242,24 @@ int main(int argc, char **argv)
     }
     if (machineType == 1) {
       cfgFileName = "zx128cfg.dat";
-      vm = new ZX128::ZX128VM(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
-                              *audioOutput);
+      vm = new ZX128::ZX128VM(*display, *audioOutput);
     }
     else if (machineType == 2) {
       cfgFileName = "cpc_cfg.dat";
-      vm = new CPC464::CPC464VM(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
-                                *audioOutput);
+      vm = new CPC464::CPC464VM(*display, *audioOutput);
     }
     else if (machineType == 3) {
       cfgFileName = "tvc_cfg.dat";
-      vm = new TVC64::TVC64VM(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
-                              *audioOutput);
+      vm = new TVC64::TVC64VM(*display, *audioOutput);
     }
     else {
-      vm = new Ep128::Ep128VM(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
-                              *audioOutput);
+      vm = new Ep128::Ep128VM(*display, *audioOutput);
     }
 #ifdef ENABLE_MIDI_PORT
     midiPort = new Ep128Emu::MIDIPort(*vm);
 #endif
     config = new Ep128Emu::EmulatorConfiguration(
-        *vm, *(dynamic_cast<Ep128Emu::VideoDisplay *>(w)), *audioOutput
+        *vm, *display, *audioOutput
 #ifdef ENABLE_MIDI_PORT
         , *midiPort
 #endif
@@ -318,7 +349,7 @@ int main(int argc, char **argv)
           config = (Ep128Emu::EmulatorConfiguration *) 0;
           makecfgNeeded = true;
           config = new Ep128Emu::EmulatorConfiguration(
-              *vm, *(dynamic_cast<Ep128Emu::VideoDisplay *>(w)), *audioOutput
+              *vm, *display, *audioOutput
 #ifdef ENABLE_MIDI_PORT
               , *midiPort
 #endif
@@ -355,7 +386,9 @@ int main(int argc, char **argv)
         config->loadState(argv[i], false);
       }
       else if (std::strcmp(argv[i], "-snapshot") == 0 ||
-               std::strcmp(argv[i], "-colorscheme") == 0) {
+               std::strcmp(argv[i], "-colorscheme") == 0 ||
+               std::strcmp(argv[i], "-render") == 0 ||
+               std::strcmp(argv[i], "-render-wav") == 0) {
         i++;
       }
       else {
@@ -394,6 +427,17 @@ int main(int argc, char **argv)
       }
     }
 #endif
+    if (renderNameIndex > 0) {
+      // do not overwrite the configuration file with the settings below
+      configLoaded = false;
+      // emulation speed is not limited without a real audio device, and
+      // sound output is only needed if a WAV file is written
+      config->vm.speedPercentage = 100U;
+      config->sound.enabled = (renderWAVNameIndex > 0);
+      config->sound.file =
+          (renderWAVNameIndex > 0 ? argv[renderWAVNameIndex] : "");
+      config->soundSettingsChanged = true;
+    }
     config->applySettings();
     if (snapshotFile) {
       vm->registerChunkTypes(*snapshotFile);
@@ -401,10 +445,18 @@ int main(int argc, char **argv)
       delete snapshotFile;
       snapshotFile = (Ep128Emu::File *) 0;
     }
-    vmThread = new Ep128Emu::VMThread(*vm);
-    gui_ = new Ep128EmuGUI(*(dynamic_cast<Ep128Emu::VideoDisplay *>(w)),
-                           *audioOutput, *vm, *vmThread, *config);
-    gui_->run();
+    if (renderNameIndex > 0) {
+      Ep128Emu::renderDemoToVideo(*vm, argv[renderNameIndex],
+                                  config->videoCapture.frameRate,
+                                  config->videoCapture.format);
+      // flush and close the WAV file
+      audioOutput->setOutputFile(std::string(""));
+    }
+    else {
+      vmThread = new Ep128Emu::VMThread(*vm);
+      gui_ = new Ep128EmuGUI(*display, *audioOutput, *vm, *vmThread, *config);
+      gui_->run();
+    }
   }
   catch (std::exception& e) {
     if (snapshotFile) {
@@ -448,6 +500,8 @@ int main(int argc, char **argv)
     delete vm;
   if (w)
     delete w;
+  else if (display)
+    delete display;
   if (audioOutput)
     delete audioOutput;
 #ifdef WIN32
@@ -23,6 +23,10 @@
 #include "spline.hpp"
 #include <cmath>
 
+#ifdef RESID_FILTER_USE_SSE2
+#  include <emmintrin.h>
+#endif
+
 namespace Ep128 {
 
   // This is the SID 6581 op-amp voltage transfer function, measured on
@@ -420,6 +424,8 @@ namespace Ep128 {
       class_init = true;
     }
 
+    // no DAC bias by default (see adjust_filter_bias())
+    Vw_bias = 0;
     enable_filter(true);
     set_chip_model(MOS6581);
     set_voice_mask(0x07);
@@ -673,5 +679,181 @@ namespace Ep128 {
       & voice_mask;
   }
 
-}       // namespace Ep128
+#ifdef RESID_FILTER_USE_SSE2
+
+  // SSE2 has no 32x32->32 bit (signed) multiply, but the low 32 bits of the
+  // product are the same as with unsigned multiplication
+
+  static EP128EMU_INLINE __m128i mulLow32_SSE2(__m128i a, __m128i b)
+  {
+    __m128i tmp0 = _mm_mul_epu32(a, b);
+    __m128i tmp1 = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(tmp0, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(tmp1, _MM_SHUFFLE(0, 0, 2, 0)));
+  }
+
+#endif  // RESID_FILTER_USE_SSE2
+
+  // --------------------------------------------------------------------------
+  // SID clocking - one cycle for each of the 'n' voice output samples.
+  // The result is the same as calling clock(voice1[i], voice2[i], voice3[i])
+  // for i = 0 to n - 1, and storing output() in out[i] if 'out' is not NULL,
+  // but the filter input of all cycles is calculated first, with the voices
+  // processed in parallel lanes.
+  // --------------------------------------------------------------------------
+  void Filter::clock_block(int n, const int *voice1, const int *voice2,
+                           const int *voice3, int *out)
+  {
+    if (EP128EMU_UNLIKELY(n < 1))
+      return;
+    model_filter_t& f = model_filter[sid_model];
+
+    // only the last sample is needed by output()
+    v1 = (voice1[n - 1]*f.voice_scale_s14 >> 18) + f.voice_DC;
+    v2 = (voice2[n - 1]*f.voice_scale_s14 >> 18) + f.voice_DC;
+    v3 = (voice3[n - 1]*f.voice_scale_s14 >> 18) + f.voice_DC;
 
+    if (EP128EMU_UNLIKELY(!enabled)) {
+      if (out)
+        mix_block(n, voice1, voice2, voice3, (int *) 0, out);
+      return;
+    }
+
+    // Sum inputs routed into the filter. The constant part of the sum (EXT IN
+    // and the voice DC levels) is calculated only once, and the voices that
+    // are not routed into the filter are masked out.
+    static const int  offset_table[5] = {
+      summer_offset<0>::value, summer_offset<1>::value,
+      summer_offset<2>::value, summer_offset<3>::value,
+      summer_offset<4>::value
+    };
+    const int   mask1 = -(sum & 0x01);
+    const int   mask2 = -((sum >> 1) & 0x01);
+    const int   mask3 = -((sum >> 2) & 0x01);
+    const int   nInputs = (mask1 & 1) + (mask2 & 1) + (mask3 & 1);
+    const int   offset = offset_table[nInputs + ((sum >> 3) & 0x01)];
+    const int   Vi_DC = nInputs*f.voice_DC + ((sum & 0x08) ? ve : 0);
+    const int   scale = f.voice_scale_s14;
+    int         Vi[block_size];
+    // filter outputs routed into the mixer
+    const int   mask_lp = -((mix >> 4) & 0x01);
+    const int   mask_bp = -((mix >> 5) & 0x01);
+    const int   mask_hp = -((mix >> 6) & 0x01);
+    int         Vf[block_size];
+
+    int         i = 0;
+#ifdef RESID_FILTER_USE_SSE2
+    {
+      const __m128i scale_ = _mm_set1_epi32(scale);
+      const __m128i mask1_ = _mm_set1_epi32(mask1);
+      const __m128i mask2_ = _mm_set1_epi32(mask2);
+      const __m128i mask3_ = _mm_set1_epi32(mask3);
+      const __m128i Vi_DC_ = _mm_set1_epi32(Vi_DC);
+      for ( ; (i + 4) <= n; i += 4) {
+        __m128i tmp1 = mulLow32_SSE2(_mm_loadu_si128(
+            reinterpret_cast< const __m128i * >(voice1 + i)), scale_);
+        __m128i tmp2 = mulLow32_SSE2(_mm_loadu_si128(
+            reinterpret_cast< const __m128i * >(voice2 + i)), scale_);
+        __m128i tmp3 = mulLow32_SSE2(_mm_loadu_si128(
+            reinterpret_cast< const __m128i * >(voice3 + i)), scale_);
+        tmp1 = _mm_and_si128(_mm_srai_epi32(tmp1, 18), mask1_);
+        tmp2 = _mm_and_si128(_mm_srai_epi32(tmp2, 18), mask2_);
+        tmp3 = _mm_and_si128(_mm_srai_epi32(tmp3, 18), mask3_);
+        _mm_storeu_si128(reinterpret_cast< __m128i * >(&(Vi[i])),
+                         _mm_add_epi32(_mm_add_epi32(tmp1, tmp2),
+                                       _mm_add_epi32(tmp3, Vi_DC_)));
+      }
+    }
+#endif
+    for ( ; i < n; i++) {
+      Vi[i] = ((voice1[i]*scale >> 18) & mask1)
+              + ((voice2[i]*scale >> 18) & mask2)
+              + ((voice3[i]*scale >> 18) & mask3) + Vi_DC;
+    }
+
+    // Calculate filter outputs.
+    if (sid_model == 0) {
+      // MOS 6581.
+      const unsigned short  *gain = f.gain[_8_div_Q];
+      for (i = 0; i < n; i++) {
+        int     Vhp_prv = Vhp;
+        int     Vbp_prv = Vbp;
+        int     Vlp_prv = Vlp;
+        int     Vbp_vc_prv = Vbp_vc;
+        int     Vlp_vc_prv = Vlp_vc;
+        Vlp = solve_integrate_6581(1, Vbp, Vlp_x, Vlp_vc, f);
+        Vbp = solve_integrate_6581(1, Vhp, Vbp_x, Vbp_vc, f);
+        Vhp = f.summer[offset + gain[Vbp] + Vlp + Vi[i]];
+        Vf[i] = (Vlp & mask_lp) + (Vbp & mask_bp) + (Vhp & mask_hp);
+        if (EP128EMU_UNLIKELY(Vhp == Vhp_prv && Vbp == Vbp_prv &&
+                              Vlp == Vlp_prv && Vbp_vc == Vbp_vc_prv &&
+                              Vlp_vc == Vlp_vc_prv)) {
+          // The filter has settled, and the state does not change any more
+          // while the input is the same (typically silence). This is exact,
+          // and saves most of the CPU time if the SID is not used.
+          while ((i + 1) < n && Vi[i + 1] == Vi[i]) {
+            i++;
+            Vf[i] = Vf[i - 1];
+          }
+        }
+      }
+    }
+    else {
+      // MOS 8580. FIXME: Not yet using op-amp model.
+      for (i = 0; i < n; i++) {
+        int     dVbp = w0*(Vhp >> 4) >> 16;
+        int     dVlp = w0*(Vbp >> 4) >> 16;
+        Vbp -= dVbp;
+        Vlp -= dVlp;
+        Vhp = (Vbp*_1024_div_Q >> 10) - Vlp - Vi[i];
+        Vf[i] = (Vlp & mask_lp) + (Vbp & mask_bp) + (Vhp & mask_hp);
+      }
+    }
+
+    if (out)
+      mix_block(n, voice1, voice2, voice3, &(Vf[0]), out);
+  }
+
+  // --------------------------------------------------------------------------
+  // Mixer output of 'n' cycles, the same as output() with v1, v2 and v3
+  // calculated from voice1[i], voice2[i] and voice3[i], and the filter
+  // outputs routed into the mixer summed in Vf[i].
+  // --------------------------------------------------------------------------
+  void Filter::mix_block(int n, const int *voice1, const int *voice2,
+                         const int *voice3, const int *Vf, int *out)
+  {
+    model_filter_t& f = model_filter[sid_model];
+    static const int  offset_table[8] = {
+      mixer_offset<0>::value, mixer_offset<1>::value,
+      mixer_offset<2>::value, mixer_offset<3>::value,
+      mixer_offset<4>::value, mixer_offset<5>::value,
+      mixer_offset<6>::value, mixer_offset<7>::value
+    };
+    const int   mask1 = -(mix & 0x01);
+    const int   mask2 = -((mix >> 1) & 0x01);
+    const int   mask3 = -((mix >> 2) & 0x01);
+    int         nInputs = 0;
+    for (int i = 0; i < 7; i++)
+      nInputs += int((mix >> i) & 0x01);
+    const int   offset = offset_table[nInputs];
+    const int   Vi_DC = ((mask1 & 1) + (mask2 & 1) + (mask3 & 1))*f.voice_DC
+                        + ((mix & 0x08) ? ve : 0);
+    const int   scale = f.voice_scale_s14;
+    for (int i = 0; i < n; i++) {
+      int     Vi = ((voice1[i]*scale >> 18) & mask1)
+                   + ((voice2[i]*scale >> 18) & mask2)
+                   + ((voice3[i]*scale >> 18) & mask3) + Vi_DC;
+      if (Vf)
+        Vi += Vf[i];
+      if (sid_model == 0) {
+        // MOS 6581.
+        out[i] = (short)(f.gain[vol][f.mixer[offset + Vi]] - (1 << 15));
+      }
+      else {
+        // MOS 8580, see the FIXME in output().
+        out[i] = (Vi*(int)vol >> 4);
+      }
+    }
+  }
+
+}       // namespace Ep128
@@ -23,6 +23,12 @@
 #include "ep128emu.hpp"
 #include "siddefs.hpp"
 
+// Filter::clock_block() uses SSE2 if it is available at compile time
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#  define RESID_FILTER_USE_SSE2         1
+#endif
+
 namespace Ep128 {
 
   // --------------------------------------------------------------------------
@@ -356,6 +362,12 @@ namespace Ep128 {
     EP128EMU_INLINE void clock(int voice1, int voice2, int voice3);
     EP128EMU_INLINE void clock(cycle_count delta_t,
                                int voice1, int voice2, int voice3);
+    // clock 'n' (at most block_size) cycles, using one sample per cycle
+    // from each voice output buffer; if 'out' is not NULL, the output() of
+    // each cycle is stored in it
+    void clock_block(int n, const int *voice1, const int *voice2,
+                     const int *voice3, int *out);
+    static const int block_size = 64;
     void reset();
 
     // Write registers.
@@ -372,6 +384,10 @@ namespace Ep128 {
 
   protected:
     void set_sum_mix();
+    // calculate output() for 'n' cycles of voice output samples, and 'Vf'
+    // (the sum of the filter outputs routed into the mixer, or NULL if none)
+    void mix_block(int n, const int *voice1, const int *voice2,
+                   const int *voice3, const int *Vf, int *out);
     void set_w0();
     void set_Q();
 
@@ -368,6 +368,20 @@ namespace Ep128 {
   // SID clocking - delta_t cycles.
   // --------------------------------------------------------------------------
   void SID::clock(cycle_count delta_t)
+  {
+    clock_(delta_t, true);
+  }
+
+  // --------------------------------------------------------------------------
+  // SID clocking - delta_t cycles, without the external filter.
+  // --------------------------------------------------------------------------
+  void SID::clock_fast(cycle_count delta_t)
+  {
+    clock_(delta_t, false);
+    soundOutputAccumulator = int32_t(filter.output()) << 4;
+  }
+
+  void SID::clock_(cycle_count delta_t, bool enableExtFilter)
   {
     int i;
 
@@ -375,7 +389,7 @@ namespace Ep128 {
     if (EP128EMU_UNLIKELY(write_pipeline) && EP128EMU_EXPECT(delta_t > 0)) {
       // Step one cycle by a recursive call to ourselves.
       write_pipeline = 0;
-      clock(1);
+      clock_(1, enableExtFilter);
       write();
       delta_t -= 1;
     }
@@ -454,7 +468,91 @@ namespace Ep128 {
                  voice[0].output(), voice[1].output(), voice[2].output());
 
     // Clock external filter.
-    extfilt.clock(delta_t, filter.output());
+    if (enableExtFilter)
+      extfilt.clock(delta_t, filter.output());
+  }
+
+  // --------------------------------------------------------------------------
+  // SID clocking - delta_t cycles, with the filter run over blocks of
+  // voice output samples.
+  // --------------------------------------------------------------------------
+  void SID::clock_block(cycle_count delta_t, int *outBuf)
+  {
+    int voice_buf[3][Filter::block_size];
+
+    // Pipelined writes on the MOS8580.
+    if (EP128EMU_UNLIKELY(write_pipeline) && EP128EMU_EXPECT(delta_t > 0)) {
+      // Step one cycle by a recursive call to ourselves.
+      write_pipeline = 0;
+      clock_block(1, outBuf);
+      write();
+      if (outBuf)
+        outBuf++;
+      delta_t -= 1;
+    }
+
+    if (EP128EMU_UNLIKELY(delta_t <= 0)) {
+      return;
+    }
+
+    // Age bus value.
+    bus_value_ttl -= delta_t;
+    if (EP128EMU_UNLIKELY(bus_value_ttl <= 0)) {
+      bus_value = 0;
+      bus_value_ttl = 0;
+    }
+
+    while (delta_t > 0) {
+      int n = int(delta_t < Filter::block_size ?
+                  delta_t : cycle_count(Filter::block_size));
+      if (EP128EMU_EXPECT(!(voice[0].wave.sync | voice[1].wave.sync |
+                            voice[2].wave.sync)) &&
+          EP128EMU_EXPECT(!(voice[0].wave.ring_msb_mask |
+                            voice[1].wave.ring_msb_mask |
+                            voice[2].wave.ring_msb_mask))) {
+        // Without hard sync and ring modulation, the voices are independent
+        // of each other, and each one can be clocked for the whole block.
+        for (int i = 0; i < 3; i++) {
+          voice[i].clock_block(n, voice_buf[i]);
+        }
+      }
+      else {
+        for (int j = 0; j < n; j++) {
+          int i;
+
+          // Clock amplitude modulators.
+          for (i = 0; i < 3; i++) {
+            voice[i].envelope.clock();
+          }
+
+          // Clock oscillators.
+          for (i = 0; i < 3; i++) {
+            voice[i].wave.clock();
+          }
+
+          // Synchronize oscillators.
+          for (i = 0; i < 3; i++) {
+            voice[i].wave.synchronize();
+          }
+
+          // Calculate waveform output.
+          for (i = 0; i < 3; i++) {
+            voice[i].wave.set_waveform_output();
+            voice_buf[i][j] = voice[i].output();
+          }
+        }
+      }
+
+      // Clock filter.
+      filter.clock_block(n, voice_buf[0], voice_buf[1], voice_buf[2],
+                         outBuf);
+      if (outBuf)
+        outBuf += n;
+
+      delta_t -= n;
+    }
+
+    soundOutputAccumulator = int32_t(filter.output()) << 4;
   }
 
   // --------------------------------------------------------------------------
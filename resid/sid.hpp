@@ -45,6 +45,16 @@ namespace Ep128 {
     static EP128EMU_REGPARM1 void clockCallback(void *userData);
     EP128EMU_INLINE void clock();
     void clock(cycle_count delta_t);
+    // run 'delta_t' cycles without the external filter, and store the
+    // filter output at the end multiplied by 16 in soundOutputAccumulator
+    // (the same scale as the sum of two clockCallback() calls)
+    void clock_fast(cycle_count delta_t);
+    // same as clock_fast(delta_t), but the voices and the filter are clocked
+    // in every cycle like clock(), with the filter run over blocks of voice
+    // output samples; this is slower, but the output is identical to the
+    // cycle by cycle emulation; if 'outBuf' is not NULL, the filter output
+    // of each cycle is also stored in it (delta_t samples, not multiplied)
+    void clock_block(cycle_count delta_t, int *outBuf = (int *) 0);
     void reset();
 
     // Read/write registers.
@@ -65,6 +75,8 @@ namespace Ep128 {
     // simplified version with no external filter,
     // adds the output to soundOutputAccumulator
     EP128EMU_INLINE void clock_fast();
+    // clock(delta_t) with optional external filter
+    void clock_(cycle_count delta_t, bool enableExtFilter);
 
     chip_model sid_model;
     Voice voice[3];
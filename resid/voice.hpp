@@ -42,6 +42,11 @@ namespace Ep128 {
     // Range [-2048*255, 2047*255].
     EP128EMU_INLINE int output();
 
+    // Clock 'n' cycles, and store the output of each cycle in 'buf'.
+    // Only valid if the oscillator is not synchronized with or ring
+    // modulated by another one.
+    EP128EMU_INLINE void clock_block(int n, int *buf);
+
     WaveformGenerator wave;
     EnvelopeGenerator envelope;
 
@@ -54,7 +59,7 @@ namespace Ep128 {
 
   // --------------------------------------------------------------------------
   // Inline functions.
-  // The following function is defined inline because it is called every
+  // The following functions are defined inline because they are called every
   // time a sample is calculated.
   // --------------------------------------------------------------------------
 
@@ -98,6 +103,18 @@ namespace Ep128 {
     return (wave.output() - wave_zero)*envelope.output();
   }
 
+  // --------------------------------------------------------------------------
+  // SID clocking - 'n' cycles, with the output of each cycle stored in 'buf'.
+  // --------------------------------------------------------------------------
+  EP128EMU_INLINE void Voice::clock_block(int n, int *buf)
+  {
+    wave.clock_block(n, buf);
+    for (int i = 0; i < n; i++) {
+      envelope.clock();
+      buf[i] = (buf[i] - wave_zero)*envelope.output();
+    }
+  }
+
 }       // namespace Ep128
 
 #endif  // not RESID_VOICE_HPP
@@ -60,6 +60,12 @@ namespace Ep128 {
     EP128EMU_INLINE void set_waveform_output();
     EP128EMU_INLINE void set_waveform_output(cycle_count delta_t);
 
+    // Clock 'n' cycles, and store the DAC output of each cycle in 'buf'.
+    // This is the same as calling clock(), set_waveform_output() and
+    // output() 'n' times, but it is only valid if the oscillator is not
+    // synchronized with or ring modulated by another one.
+    EP128EMU_INLINE void clock_block(int n, int *buf);
+
   protected:
     EP128EMU_INLINE void clock_shift_register();
     EP128EMU_INLINE void write_shift_register();
@@ -536,6 +542,97 @@ namespace Ep128 {
     }
   }
 
+  // --------------------------------------------------------------------------
+  // SID clocking - 'n' cycles, with the output of each cycle stored in 'buf'.
+  // --------------------------------------------------------------------------
+  EP128EMU_INLINE void WaveformGenerator::clock_block(int n, int *buf)
+  {
+    if (EP128EMU_UNLIKELY(!(waveform | floating_output_ttl | test))) {
+      // No waveform is selected, and the floating DAC input has faded out,
+      // so only the accumulator and the noise shift register are clocked.
+      reg24   accumulator_ = accumulator;
+      reg24   accumulator_bits_set = 0;
+      cycle_count shift_pipeline_ = shift_pipeline;
+      int     output_ = output();
+      for (int i = 0; i < n; i++) {
+        reg24 accumulator_next = (accumulator_ + freq) & 0xffffff;
+        accumulator_bits_set = ~accumulator_ & accumulator_next;
+        accumulator_ = accumulator_next;
+        if (EP128EMU_UNLIKELY(accumulator_bits_set & 0x080000)) {
+          shift_pipeline_ = 2;
+        }
+        else if (EP128EMU_UNLIKELY(shift_pipeline_) && !--shift_pipeline_) {
+          clock_shift_register();
+        }
+        buf[i] = output_;
+      }
+      accumulator = accumulator_;
+      msb_rising = (accumulator_bits_set & 0x800000) ? true : false;
+      shift_pipeline = shift_pipeline_;
+      pulse_output = -((accumulator >> 12) >= pw) & 0xfff;
+      return;
+    }
+    if (EP128EMU_UNLIKELY(test || !waveform || waveform > 0x8)) {
+      // Test bit, floating DAC input, or combined waveforms with noise.
+      for (int i = 0; i < n; i++) {
+        clock();
+        set_waveform_output();
+        buf[i] = output();
+      }
+      return;
+    }
+
+    // Common case: the state is kept in local variables, since the compiler
+    // cannot do that across writes to the output buffer.
+    const unsigned short  *wave_ = wave;
+    const unsigned short  *dac = model_dac[sid_model];
+    const bool  tri_saw_8580 = ((waveform & 3) && (sid_model == MOS8580));
+    const reg24 freq_ = freq;
+    const reg12 pw_ = pw;
+    const reg12 no_pulse_ = no_pulse;
+    reg12   no_noise_or_noise_output_ = no_noise_or_noise_output;
+    reg24   accumulator_ = accumulator;
+    reg24   accumulator_bits_set = 0;
+    cycle_count shift_pipeline_ = shift_pipeline;
+    reg12   pulse_output_ = pulse_output;
+    reg12   waveform_output_ = waveform_output;
+    reg12   tri_saw_pipeline_ = tri_saw_pipeline;
+    reg12   osc3_ = osc3;
+    for (int i = 0; i < n; i++) {
+      reg24 accumulator_next = (accumulator_ + freq_) & 0xffffff;
+      accumulator_bits_set = ~accumulator_ & accumulator_next;
+      accumulator_ = accumulator_next;
+
+      // Shift noise register once for each time accumulator bit 19 is set
+      // high, with 2 cycles delay.
+      if (EP128EMU_UNLIKELY(accumulator_bits_set & 0x080000)) {
+        shift_pipeline_ = 2;
+      }
+      else if (EP128EMU_UNLIKELY(shift_pipeline_) && !--shift_pipeline_) {
+        clock_shift_register();
+        no_noise_or_noise_output_ = no_noise_or_noise_output;
+      }
+
+      int ix = accumulator_ >> 12;
+      waveform_output_ =
+          wave_[ix] & (no_pulse_ | pulse_output_) & no_noise_or_noise_output_;
+      if (tri_saw_8580) {
+        osc3_ = tri_saw_pipeline_ & (no_pulse_ | pulse_output_)
+                & no_noise_or_noise_output_;
+        tri_saw_pipeline_ = wave_[ix];
+      }
+      pulse_output_ = -((accumulator_ >> 12) >= pw_) & 0xfff;
+      buf[i] = dac[waveform_output_];
+    }
+    accumulator = accumulator_;
+    msb_rising = (accumulator_bits_set & 0x800000) ? true : false;
+    shift_pipeline = shift_pipeline_;
+    pulse_output = pulse_output_;
+    waveform_output = waveform_output_;
+    tri_saw_pipeline = tri_saw_pipeline_;
+    osc3 = (tri_saw_8580 ? osc3_ : waveform_output_);
+  }
+
   // --------------------------------------------------------------------------
   // Waveform output (12 bits).
   // --------------------------------------------------------------------------
@@ -245,6 +245,131 @@ namespace ZX128 {
     }
   }
 
+  // advance a tone or envelope generator counter by 'nCycles' cycles,
+  // and return the number of times it was reloaded
+
+  template <typename T>
+  static EP128EMU_INLINE size_t skipCounterCycles(T& cnt, T freq,
+                                                  size_t nCycles)
+  {
+    if (size_t(cnt) > nCycles) {
+      cnt = cnt - T(nCycles);
+      return 0;
+    }
+    if (nCycles < 1)
+      return 0;
+    // count down to 1, and reload on the next cycle
+    nCycles = nCycles - (cnt > T(1) ? size_t(cnt) : size_t(1));
+    cnt = freq;
+    if (freq <= T(1))
+      return (nCycles + 1);
+    cnt = freq - T(nCycles % size_t(freq));
+    return ((nCycles / size_t(freq)) + 1);
+  }
+
+  EP128EMU_INLINE void AY3_8912::skipNoiseCycles(size_t nCycles)
+  {
+    while (nCycles > 0) {
+      size_t  n = size_t(ngCnt & 0x7F);
+      if (n > 1) {
+        if (n > nCycles) {
+          ngCnt = ngCnt - int(nCycles);
+          return;
+        }
+        ngCnt = ngCnt - int(n - 1);
+        nCycles = nCycles - (n - 1);
+      }
+      ngCnt = (ngCnt ^ 0x80) | ngFreq;
+      if (!(ngCnt & 0x80)) {
+        ngState = bool(ngShiftReg & 0x00008000U);
+        ngShiftReg = ((ngShiftReg & 0x0000FFFFU) << 1)
+                     | ((~((ngShiftReg >> 16) ^ (ngShiftReg >> 13))) & 1U);
+      }
+      nCycles--;
+      int     p = ngFreq | 1;
+      n = size_t(ngCnt & 0x7F);
+      if (n == size_t(p) || (n == 0 && p == 1)) {
+        // the counter is reloaded every 'p' cycles from now on, and the
+        // shift register is clocked on every second reload
+        size_t  nReloads = nCycles / size_t(p);
+        size_t  nShifts = (nReloads + size_t(ngCnt >> 7)) >> 1;
+        if (nReloads & 1)
+          ngCnt = ngCnt ^ 0x80;
+        if (p > 1)
+          ngCnt = (ngCnt & 0x80) | (p - int(nCycles % size_t(p)));
+        if (nShifts > 0) {
+          uint32_t  sr = ngShiftReg;
+          // the feedback taps are bits 16 and 13, so the next 13 output
+          // bits can be calculated at once
+          for ( ; nShifts >= 13; nShifts -= 13) {
+            sr = ((sr << 13) & 0x0001FFFFU)
+                 | ((~((sr >> 4) ^ (sr >> 1))) & 0x00001FFFU);
+          }
+          for ( ; nShifts > 0; nShifts--) {
+            sr = ((sr & 0x0000FFFFU) << 1)
+                 | ((~((sr >> 16) ^ (sr >> 13))) & 1U);
+          }
+          ngShiftReg = sr;
+          ngState = bool(sr & 0x00010000U);
+        }
+        return;
+      }
+    }
+  }
+
+  void AY3_8912::runCycles(uint16_t *outBuf, size_t nCycles)
+  {
+    while (nCycles > 0) {
+      uint16_t  outA = (((tgStateA | tgDisabledA) & (ngState | ngDisabledA)) ?
+                        amplitudeA : uint16_t(0));
+      uint16_t  outB = (((tgStateB | tgDisabledB) & (ngState | ngDisabledB)) ?
+                        amplitudeB : uint16_t(0));
+      uint16_t  outC = (((tgStateC | tgDisabledC) & (ngState | ngDisabledC)) ?
+                        amplitudeC : uint16_t(0));
+      // find the number of cycles until the next tone or noise generator
+      // state change that is audible, or envelope step; the generators
+      // that are disabled or muted are only needed to be kept in sync
+      size_t  n = nCycles;
+      if (!tgDisabledA && amplitudeA != 0 && size_t(tgCntA) <= n)
+        n = (tgCntA > 1 ? size_t(tgCntA - 1) : 0);
+      if (!tgDisabledB && amplitudeB != 0 && size_t(tgCntB) <= n)
+        n = (tgCntB > 1 ? size_t(tgCntB - 1) : 0);
+      if (!tgDisabledC && amplitudeC != 0 && size_t(tgCntC) <= n)
+        n = (tgCntC > 1 ? size_t(tgCntC - 1) : 0);
+      if (((!ngDisabledA && amplitudeA != 0) ||
+           (!ngDisabledB && amplitudeB != 0) ||
+           (!ngDisabledC && amplitudeC != 0)) &&
+          size_t(ngCnt & 0x7F) <= n) {
+        n = ((ngCnt & 0x7F) > 1 ? size_t((ngCnt & 0x7F) - 1) : 0);
+      }
+      if (envDir != 0 && size_t(envCnt) <= n)
+        n = (envCnt > 1U ? size_t(envCnt - 1U) : 0);
+      if (n > 0) {
+        for (size_t i = 0; i < n; i++) {
+          outBuf[0] = outA;
+          outBuf[1] = outB;
+          outBuf[2] = outC;
+          outBuf = outBuf + 3;
+        }
+        if (skipCounterCycles(tgCntA, tgFreqA, n) & 1)
+          tgStateA = !tgStateA;
+        if (skipCounterCycles(tgCntB, tgFreqB, n) & 1)
+          tgStateB = !tgStateB;
+        if (skipCounterCycles(tgCntC, tgFreqC, n) & 1)
+          tgStateC = !tgStateC;
+        skipNoiseCycles(n);
+        (void) skipCounterCycles(envCnt, envFreq, n);
+        nCycles = nCycles - n;
+        if (nCycles < 1)
+          break;
+      }
+      // the output changes after this cycle
+      runOneCycle(outBuf[0], outBuf[1], outBuf[2]);
+      outBuf = outBuf + 3;
+      nCycles--;
+    }
+  }
+
   // --------------------------------------------------------------------------
 
   class ChunkType_AY3Snapshot : public Ep128Emu::File::ChunkTypeHandler {
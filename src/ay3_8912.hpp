@@ -65,6 +65,7 @@ namespace ZX128 {
     uint8_t   portAInput;               // port A input byte (defaults to 0xFF)
     // --------
     void resetRegisters();
+    void skipNoiseCycles(size_t nCycles);
    public:
     AY3_8912();
     virtual ~AY3_8912();
@@ -72,6 +73,12 @@ namespace ZX128 {
     uint8_t readRegister(uint16_t addr) const;
     void writeRegister(uint16_t addr, uint8_t value);
     void runOneCycle(uint16_t& outA, uint16_t& outB, uint16_t& outC);
+    // run the AY for 'nCycles' cycles, and store the output of channels
+    // A, B, and C of cycle N in outBuf[N * 3], outBuf[N * 3 + 1], and
+    // outBuf[N * 3 + 2]; the result is the same as calling
+    // runOneCycle() 'nCycles' times, but the generators are only clocked
+    // cycle by cycle when an audible event happens
+    void runCycles(uint16_t *outBuf, size_t nCycles);
     inline void setPortAInput(uint8_t value)
     {
       portAInput = value;
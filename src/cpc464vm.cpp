@@ -117,15 +117,10 @@ namespace CPC464 {
         floppyCycleCnt = 4;             // 31.25 kHz
         floppyDrive->runOneByte();
       }
-      uint16_t  tmpA = 0;
-      uint16_t  tmpB = 0;
-      uint16_t  tmpC = 0;
-      ay3.runOneCycle(tmpA, tmpB, tmpC);
-      tmpB = tmpB + (uint16_t(tapeInputSignal) << 12);
-      uint32_t  tmpL = (((uint32_t(tmpA) * 3U) + 1U) >> 1) + uint32_t(tmpB);
-      uint32_t  tmpR = (((uint32_t(tmpC) * 3U) + 1U) >> 1) + uint32_t(tmpB);
-      soundOutputSignal = (tmpR << 16) | tmpL;
-      sendAudioOutput(soundOutputSignal);
+      ayTapeInputBuf[ayCyclesPending++] = tapeInputSignal;
+      // video capture needs the sound output on every cycle
+      if (ayCyclesPending >= ayBatchLength || videoCapture)
+        runAY();
     }
     videoRenderer.runOneCycle();
     crtc.runOneCycle();
@@ -133,6 +128,33 @@ namespace CPC464 {
     z80OpcodeHalfCycles = z80OpcodeHalfCycles - 8;
   }
 
+  void CPC464VM::runAY()
+  {
+    if (ayCyclesPending < 1)
+      return;
+    size_t  nCycles = size_t(ayCyclesPending);
+    ayCyclesPending = 0;
+    ay3.runCycles(&(ayOutputBuf[0]), nCycles);
+    // send runs of identical samples to the audio converter at once
+    size_t  runLength = 0;
+    for (size_t i = 0; i < nCycles; i++) {
+      uint16_t  tmpA = ayOutputBuf[i * 3];
+      uint16_t  tmpB = ayOutputBuf[i * 3 + 1];
+      uint16_t  tmpC = ayOutputBuf[i * 3 + 2];
+      tmpB = tmpB + (uint16_t(ayTapeInputBuf[i]) << 12);
+      uint32_t  tmpL = (((uint32_t(tmpA) * 3U) + 1U) >> 1) + uint32_t(tmpB);
+      uint32_t  tmpR = (((uint32_t(tmpC) * 3U) + 1U) >> 1) + uint32_t(tmpB);
+      uint32_t  tmp = (tmpR << 16) | tmpL;
+      if (tmp != soundOutputSignal) {
+        sendHeldAudioOutput(soundOutputSignal, runLength);
+        soundOutputSignal = tmp;
+        runLength = 0;
+      }
+      runLength++;
+    }
+    sendHeldAudioOutput(soundOutputSignal, runLength);
+  }
+
   // --------------------------------------------------------------------------
 
   CPC464VM::Z80_::Z80_(CPC464VM& vm_)
@@ -356,6 +378,8 @@ namespace CPC464 {
   void CPC464VM::CPCVideo_::vsyncStateChange(bool newState,
                                              unsigned int currentSlot_)
   {
+    if (newState)
+      vm.turboTapeVSync();
     if (vm.getIsDisplayEnabled())
       vm.display.vsyncStateChange(newState, currentSlot_);
     if (vm.videoCapture)
@@ -441,6 +465,7 @@ namespace CPC464 {
     }
     switch (ppiPortCState & 0xC0) {
     case 0x80:                          // write AY register
+      runAY();
       ay3.writeRegister(ayRegisterSelected & 0x0F, ppiPortAState);
       break;
     case 0xC0:                          // select AY register
@@ -464,6 +489,7 @@ namespace CPC464 {
         retval &= vm.ppiPortAState;
         break;
       case 0x0100:              // port B data
+        vm.countTapeInputRead();
         retval &= vm.ppiPortBState;
         break;
       case 0x0200:              // port C data
@@ -1021,6 +1047,7 @@ namespace CPC464 {
       tapeCallbackFlag(false),
       prvTapeCallbackFlag(false),
       soundOutputSignal(0U),
+      ayCyclesPending(0),
       demoFile((Ep128Emu::File *) 0),
       demoBuffer(),
       isRecordingDemo(false),
@@ -1123,6 +1150,7 @@ namespace CPC464 {
     stopDemoRecording(false);
     z80.reset();
     memory.setPaging(0x00C0);
+    runAY();
     ay3.reset();
     crtc.reset();
     videoRenderer.reset();
@@ -1194,6 +1222,7 @@ namespace CPC464 {
     crtcFrequency = freq;
     stopDemoPlayback();         // changing configuration implies stopping
     stopDemoRecording(false);   // any demo playback or recording
+    runAY();
     setAudioConverterSampleRate(float(long(crtcFrequency >> 3)));
     if (haveTape()) {
       tapeSamplesPerCRTCCycle =
@@ -1244,20 +1273,28 @@ namespace CPC464 {
 
   void CPC464VM::openVideoCapture(
       int frameRate_,
-      bool yuvFormat_,
+      int videoFormat_,
       void (*errorCallback_)(void *userData, const char *msg),
       void (*fileNameCallback_)(void *userData, std::string& fileName),
       void *userData_)
   {
     if (!videoCapture) {
-      if (yuvFormat_) {
+      if (videoFormat_ == 1) {
         videoCapture = new Ep128Emu::VideoCapture_YV12(
                                &CPCVideo::convertPixelToRGB, frameRate_);
       }
+      else if (videoFormat_ == 2) {
+        videoCapture = new Ep128Emu::VideoCapture_ZMBV(
+                               &CPCVideo::convertPixelToRGB, frameRate_);
+      }
       else {
         videoCapture = new Ep128Emu::VideoCapture_RLE8(
                                &CPCVideo::convertPixelToRGB, frameRate_);
       }
+      if (getIsVideoCaptureThreadEnabled()) {
+        videoCapture = new Ep128Emu::VideoCapture_Async(videoCapture,
+                                                        frameRate_);
+      }
       videoCapture->setClockFrequency(crtcFrequency);
       setCallback(&videoCaptureCallback, this, true);
     }
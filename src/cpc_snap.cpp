@@ -26,6 +26,7 @@ namespace CPC464 {
 
   void CPC464VM::saveState(Ep128Emu::File& f)
   {
+    runAY();
     memory.saveState(f);
     crtc.saveState(f);
     ay3.saveState(f);
@@ -116,6 +117,9 @@ namespace CPC464 {
     }
     stopDemo();
     snapshotLoadFlag = true;
+    // the AY state has already been loaded from its own chunk, so the
+    // cycles pending from before the snapshot are discarded
+    ayCyclesPending = 0;
     // reset floppy emulation, as its state is not saved
     floppyDrive->reset();
     try {
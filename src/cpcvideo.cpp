@@ -85,6 +85,8 @@ namespace CPC464 {
       videoModeLatched(0),
       videoMemory(videoMemory_),
       lineBuf((uint8_t *) 0),
+      charBuf((uint8_t *) 0),
+      charCnt(0),
       borderColor(0x00),
       videoMode(0),
       hSyncMax(107),
@@ -94,10 +96,12 @@ namespace CPC464 {
     videoDelayBuf[1] = 0U;
     for (size_t i = 0; i < 16; i++)
       palette[i] = 0x00;
-    lineBuf = reinterpret_cast<uint8_t *>(new uint32_t[112]);
+    // line buffer and character buffer
+    lineBuf = reinterpret_cast<uint8_t *>(new uint32_t[112 + 64]);
     for (size_t i = 0; i < 448; i++)
       lineBuf[i] = uint8_t((~i) & 0x01);
     lineBufPtr = lineBuf;
+    charBuf = lineBuf + 448;
   }
 
   CPCVideo::~CPCVideo()
@@ -113,14 +117,6 @@ namespace CPC464 {
     b = float(cpcColorTable[pixelValue & 0x1F] & 0x0003) / 2.0f;
   }
 
-  void CPCVideo::setColor(uint8_t penNum, uint8_t c)
-  {
-    if (penNum & 0x10)
-      borderColor = c & 0x3F;
-    else
-      palette[penNum & 0x0F] = c & 0x3F;
-  }
-
   uint8_t CPCVideo::getColor(uint8_t penNum) const
   {
     if (penNum & 0x10)
@@ -131,74 +127,28 @@ namespace CPC464 {
   EP128EMU_REGPARM1 void CPCVideo::runOneCycle()
   {
     if (EP128EMU_EXPECT((unsigned int) hSyncCnt < 97U)) {
-      if (EP128EMU_UNLIKELY((reinterpret_cast<unsigned char *>(
-                                 &(videoDelayBuf[0])))[0] != 0)) {
-        lineBufPtr[0] = 0x01;           // sync
-        lineBufPtr[1] = 0x14;
-        lineBufPtr = lineBufPtr + 2;
-      }
-      else if ((reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[1]) {
-        uint8_t videoByte0 =
-            (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[2];
-        uint8_t videoByte1 =
-            (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[3];
-        switch (videoModeLatched) {
-        case 0:                         // 16 color mode
-          {
-            lineBufPtr[0] = 0x04;
-            lineBufPtr[1] = palette[pixelConvTable_16[videoByte0 & 0xAA]];
-            lineBufPtr[2] = palette[pixelConvTable_16[videoByte0 & 0x55]];
-            lineBufPtr[3] = palette[pixelConvTable_16[videoByte1 & 0xAA]];
-            lineBufPtr[4] = palette[pixelConvTable_16[videoByte1 & 0x55]];
-            lineBufPtr = lineBufPtr + 5;
-          }
-          break;
-        case 1:                         // 4 color mode
-          {
-            lineBufPtr[0] = 0x08;
-            lineBufPtr[1] = palette[pixelConvTable_4[videoByte0 & 0x88]];
-            lineBufPtr[2] = palette[pixelConvTable_4[videoByte0 & 0x44]];
-            lineBufPtr[3] = palette[pixelConvTable_4[videoByte0 & 0x22]];
-            lineBufPtr[4] = palette[pixelConvTable_4[videoByte0 & 0x11]];
-            lineBufPtr[5] = palette[pixelConvTable_4[videoByte1 & 0x88]];
-            lineBufPtr[6] = palette[pixelConvTable_4[videoByte1 & 0x44]];
-            lineBufPtr[7] = palette[pixelConvTable_4[videoByte1 & 0x22]];
-            lineBufPtr[8] = palette[pixelConvTable_4[videoByte1 & 0x11]];
-            lineBufPtr = lineBufPtr + 9;
-          }
-          break;
-        case 2:                         // 2 color mode
-          lineBufPtr[0] = 0x06;
-          lineBufPtr[1] = palette[0];
-          lineBufPtr[2] = palette[1];
-          lineBufPtr[3] = videoByte0;
-          lineBufPtr[4] = palette[0];
-          lineBufPtr[5] = palette[1];
-          lineBufPtr[6] = videoByte1;
-          lineBufPtr = lineBufPtr + 7;
-          break;
-        case 3:                         // 4 color mode (half resolution)
-          {
-            lineBufPtr[0] = 0x04;
-            lineBufPtr[1] = palette[pixelConvTable_16[videoByte0 & 0xAA] & 3];
-            lineBufPtr[2] = palette[pixelConvTable_16[videoByte0 & 0x55] & 3];
-            lineBufPtr[3] = palette[pixelConvTable_16[videoByte1 & 0xAA] & 3];
-            lineBufPtr[4] = palette[pixelConvTable_16[videoByte1 & 0x55] & 3];
-            lineBufPtr = lineBufPtr + 5;
-          }
-          break;
-        }
-      }
-      else {
-        lineBufPtr[0] = 0x01;           // border
-        lineBufPtr[1] = borderColor;
-        lineBufPtr = lineBufPtr + 2;
-      }
+      // only store the character here, it is rendered with the palette
+      // in renderCharacters() at the end of the line, or before a color
+      // is changed
+      const uint8_t *videoDelayBytes =
+          reinterpret_cast<const uint8_t *>(&(videoDelayBuf[0]));
+      uint8_t *p = &(charBuf[charCnt << 2]);
+      if (EP128EMU_UNLIKELY(videoDelayBytes[0] != 0))
+        p[0] = 4;                       // sync
+      else if (videoDelayBytes[1])
+        p[0] = videoModeLatched;
+      else
+        p[0] = 5;                       // border
+      p[1] = videoDelayBytes[2];
+      p[2] = videoDelayBytes[3];
+      charCnt = (charCnt + 1) & 63;
     }
     hSyncCnt += 2;
     if (EP128EMU_UNLIKELY(crtcHSyncCnt)) {      // horizontal sync
       if (crtcHSyncCnt == 3) {
         if (hSyncCnt >= (int(hSyncMax) - 8)) {
+          if (charCnt)
+            renderCharacters();
           if (EP128EMU_EXPECT(hSyncCnt & 1))
             drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
           else
@@ -223,6 +173,8 @@ namespace CPC464 {
     }
     if ((unsigned int) (hSyncCnt + 4) >= 101U) {
       if (EP128EMU_UNLIKELY(hSyncCnt >= int(hSyncMax))) {
+        if (charCnt)
+          renderCharacters();
         if (EP128EMU_EXPECT(hSyncCnt & 1))
           drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
         else
@@ -250,6 +202,70 @@ namespace CPC464 {
     }
   }
 
+  EP128EMU_REGPARM1 void CPCVideo::renderCharacters()
+  {
+    const uint8_t *p = charBuf;
+    const uint8_t *endp = p + (charCnt << 2);
+    charCnt = 0;
+    uint8_t *bufp = lineBufPtr;
+    do {
+      uint8_t videoByte0 = p[1];
+      uint8_t videoByte1 = p[2];
+      switch (p[0]) {
+      case 0:                           // 16 color mode
+        bufp[0] = 0x04;
+        bufp[1] = palette[pixelConvTable_16[videoByte0 & 0xAA]];
+        bufp[2] = palette[pixelConvTable_16[videoByte0 & 0x55]];
+        bufp[3] = palette[pixelConvTable_16[videoByte1 & 0xAA]];
+        bufp[4] = palette[pixelConvTable_16[videoByte1 & 0x55]];
+        bufp = bufp + 5;
+        break;
+      case 1:                           // 4 color mode
+        bufp[0] = 0x08;
+        bufp[1] = palette[pixelConvTable_4[videoByte0 & 0x88]];
+        bufp[2] = palette[pixelConvTable_4[videoByte0 & 0x44]];
+        bufp[3] = palette[pixelConvTable_4[videoByte0 & 0x22]];
+        bufp[4] = palette[pixelConvTable_4[videoByte0 & 0x11]];
+        bufp[5] = palette[pixelConvTable_4[videoByte1 & 0x88]];
+        bufp[6] = palette[pixelConvTable_4[videoByte1 & 0x44]];
+        bufp[7] = palette[pixelConvTable_4[videoByte1 & 0x22]];
+        bufp[8] = palette[pixelConvTable_4[videoByte1 & 0x11]];
+        bufp = bufp + 9;
+        break;
+      case 2:                           // 2 color mode
+        bufp[0] = 0x06;
+        bufp[1] = palette[0];
+        bufp[2] = palette[1];
+        bufp[3] = videoByte0;
+        bufp[4] = palette[0];
+        bufp[5] = palette[1];
+        bufp[6] = videoByte1;
+        bufp = bufp + 7;
+        break;
+      case 3:                           // 4 color mode (half resolution)
+        bufp[0] = 0x04;
+        bufp[1] = palette[pixelConvTable_16[videoByte0 & 0xAA] & 3];
+        bufp[2] = palette[pixelConvTable_16[videoByte0 & 0x55] & 3];
+        bufp[3] = palette[pixelConvTable_16[videoByte1 & 0xAA] & 3];
+        bufp[4] = palette[pixelConvTable_16[videoByte1 & 0x55] & 3];
+        bufp = bufp + 5;
+        break;
+      case 4:                           // sync
+        bufp[0] = 0x01;
+        bufp[1] = 0x14;
+        bufp = bufp + 2;
+        break;
+      default:                          // border
+        bufp[0] = 0x01;
+        bufp[1] = borderColor;
+        bufp = bufp + 2;
+        break;
+      }
+      p = p + 4;
+    } while (p < endp);
+    lineBufPtr = bufp;
+  }
+
   EP128EMU_REGPARM1 void CPCVideo::shiftLineBuffer()
   {
     uint32_t  tmpBuf[108];              // 432 bytes (48 characters * 9)
@@ -490,6 +506,8 @@ namespace CPC464 {
 
   void CPCVideo::reset()
   {
+    if (charCnt)
+      renderCharacters();
     videoModeLatched = 0;
     videoDelayBuf[0] = 0U;
     videoDelayBuf[1] = 0U;
@@ -39,6 +39,10 @@ namespace CPC464 {
     uint32_t  videoDelayBuf[2];
     const uint8_t *videoMemory;
     uint8_t   *lineBuf;         // 448 bytes (112 uint32_t's) for 49 characters
+    // characters not rendered to the line buffer yet, 4 bytes each:
+    // type (0 to 3: video mode, 4: sync, 5: border) and two video bytes
+    uint8_t   *charBuf;         // 256 bytes (64 uint32_t's) after lineBuf
+    size_t    charCnt;
     uint8_t   palette[16];
     uint8_t   borderColor;
     uint8_t   videoMode;
@@ -85,10 +89,20 @@ namespace CPC464 {
     {
       return videoMode;
     }
-    void setColor(uint8_t penNum, uint8_t c);   // penNum >= 16 is border
+    // penNum >= 16 is border
+    EP128EMU_INLINE void setColor(uint8_t penNum, uint8_t c)
+    {
+      if (charCnt)
+        renderCharacters();
+      if (penNum & 0x10)
+        borderColor = c & 0x3F;
+      else
+        palette[penNum & 0x0F] = c & 0x3F;
+    }
     uint8_t getColor(uint8_t penNum) const;
     EP128EMU_REGPARM1 void runOneCycle();
    private:
+    EP128EMU_REGPARM1 void renderCharacters();
     EP128EMU_REGPARM1 void shiftLineBuffer();
    public:
     EP128EMU_INLINE void crtcHSyncStateChange(bool newState)
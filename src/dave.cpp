@@ -1168,6 +1168,35 @@ namespace Ep128 {
                                 "Dave snapshot data");
   }
 
+  void Dave::cloneState(Ep128Emu::MachineState& s) const
+  {
+    const char  *p = reinterpret_cast<const char *>(&clockDiv);
+    size_t  nBytes =
+        size_t(reinterpret_cast<const char *>(&mouseInput) + 1 - p);
+    s.writeData(p, nBytes);
+    // pointers to members are stored separately as offsets, so that the
+    // state can also be restored into a different object
+    s.writePointer(chn0_input_polycnt, this);
+    s.writePointer(chn1_input_polycnt, this);
+    s.writePointer(chn2_input_polycnt, this);
+    s.writePointer(chn3_clk_source, this);
+    s.writePointer(chn3_input_polycnt, this);
+    s.writePointer(int_snd_phase, this);
+  }
+
+  void Dave::restoreState(Ep128Emu::MachineState& s)
+  {
+    char    *p = reinterpret_cast<char *>(&clockDiv);
+    size_t  nBytes = size_t(reinterpret_cast<char *>(&mouseInput) + 1 - p);
+    s.readData(p, nBytes);
+    s.readPointer(chn0_input_polycnt, this);
+    s.readPointer(chn1_input_polycnt, this);
+    s.readPointer(chn2_input_polycnt, this);
+    s.readPointer(chn3_clk_source, this);
+    s.readPointer(chn3_input_polycnt, this);
+    s.readPointer(int_snd_phase, this);
+  }
+
   void Dave::registerChunkType(Ep128Emu::File& f)
   {
     ChunkType_DaveSnapshot  *p;
@@ -253,6 +253,12 @@ namespace Ep128 {
      */
     void loadState(Ep128Emu::File::Buffer&);
     void registerChunkType(Ep128Emu::File&);
+    /*!
+     * Save (cloneState()) or restore (restoreState()) a fast in-memory copy
+     * of the internal state, see Ep128Emu::MachineState.
+     */
+    void cloneState(Ep128Emu::MachineState&) const;
+    void restoreState(Ep128Emu::MachineState&);
   };
 
 }       // namespace Ep128
@@ -0,0 +1,161 @@
+
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2017 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "ep128emu.hpp"
+#include "display.hpp"
+#include "vm.hpp"
+#include "system.hpp"
+#include "demorender.hpp"
+
+#include <cstdio>
+
+namespace Ep128Emu {
+
+  NullVideoDisplay::NullVideoDisplay()
+    : VideoDisplay()
+  {
+  }
+
+  NullVideoDisplay::~NullVideoDisplay()
+  {
+  }
+
+  void NullVideoDisplay::setDisplayParameters(const DisplayParameters& dp)
+  {
+    displayParameters = dp;
+  }
+
+  const VideoDisplay::DisplayParameters&
+      NullVideoDisplay::getDisplayParameters() const
+  {
+    return displayParameters;
+  }
+
+  void NullVideoDisplay::drawLine(const uint8_t *buf, size_t nBytes)
+  {
+    (void) buf;
+    (void) nBytes;
+  }
+
+  void NullVideoDisplay::vsyncStateChange(bool newState,
+                                          unsigned int currentSlot_)
+  {
+    (void) newState;
+    (void) currentSlot_;
+  }
+
+  // --------------------------------------------------------------------------
+
+  struct DemoRenderState {
+    std::string baseName;
+    int         fileCnt;
+    bool        verbose;
+    bool        errorFlag;
+  };
+
+  static void renderErrorCallback(void *userData, const char *msg)
+  {
+    DemoRenderState&  state = *(reinterpret_cast<DemoRenderState *>(userData));
+    state.errorFlag = true;
+    if (state.verbose)
+      std::fprintf(stderr, " *** error: %s\n", msg);
+  }
+
+  static void renderFileNameCallback(void *userData, std::string& fileName)
+  {
+    // called when the current AVI file is full: continue with
+    // "name_002.avi", "name_003.avi", etc.
+    DemoRenderState&  state = *(reinterpret_cast<DemoRenderState *>(userData));
+    char    tmpBuf[32];
+    state.fileCnt++;
+    std::snprintf(&(tmpBuf[0]), sizeof(tmpBuf), "_%03d.avi", state.fileCnt);
+    fileName = state.baseName;
+    fileName += &(tmpBuf[0]);
+    if (state.verbose)
+      std::fprintf(stderr, "Writing '%s'\n", fileName.c_str());
+  }
+
+  double renderDemoToVideo(VirtualMachine& vm, const char *aviFileName,
+                           int frameRate, int videoFormat, bool verbose)
+  {
+    if (!vm.getIsPlayingDemo())
+      throw Exception("no demo file is being played");
+    if (aviFileName == (char *) 0 || aviFileName[0] == '\0')
+      throw Exception("invalid AVI file name");
+    DemoRenderState state;
+    state.baseName = aviFileName;
+    state.fileCnt = 1;
+    state.verbose = verbose;
+    state.errorFlag = false;
+    {
+      size_t  n = state.baseName.length();
+      if (n >= 4 && (state.baseName[n - 4] == '.' &&
+                     (state.baseName[n - 3] | char(0x20)) == 'a' &&
+                     (state.baseName[n - 2] | char(0x20)) == 'v' &&
+                     (state.baseName[n - 1] | char(0x20)) == 'i')) {
+        state.baseName.resize(n - 4);
+      }
+    }
+    vm.setEnableDisplay(false);
+    vm.setEnableVideoCaptureThread(true);
+    Timer   timer;
+    double  demoTime = 0.0;
+    double  nextProgressTime = 0.0;
+    try {
+      vm.openVideoCapture(frameRate, videoFormat,
+                          &renderErrorCallback, &renderFileNameCallback,
+                          (void *) &state);
+      vm.setVideoCaptureFile(std::string(aviFileName));
+      if (verbose)
+        std::fprintf(stderr, "Writing '%s'\n", aviFileName);
+      // run in 2 ms steps, similarly to VMThread
+      while (vm.getIsPlayingDemo()) {
+        vm.run(2000);
+        demoTime += 0.002;
+        if (verbose && demoTime >= nextProgressTime) {
+          double  t = timer.getRealTime();
+          std::fprintf(stderr, "\r%8.1f s (%.1fx real time)",
+                       demoTime, (t > 0.0 ? (demoTime / t) : 0.0));
+          nextProgressTime = demoTime + 10.0;
+        }
+      }
+      // the destructor of the capture object waits until all queued data
+      // is encoded and written
+      vm.closeVideoCapture();
+    }
+    catch (...) {
+      vm.closeVideoCapture();
+      vm.setEnableVideoCaptureThread(false);
+      vm.setEnableDisplay(true);
+      throw;
+    }
+    vm.setEnableVideoCaptureThread(false);
+    vm.setEnableDisplay(true);
+    if (verbose) {
+      double  t = timer.getRealTime();
+      std::fprintf(stderr, "\r%8.1f s (%.1fx real time)\ndone\n",
+                   demoTime, (t > 0.0 ? (demoTime / t) : 0.0));
+    }
+    if (state.errorFlag)
+      throw Exception("error writing AVI file");
+    return demoTime;
+  }
+
+}       // namespace Ep128Emu
+
@@ -0,0 +1,62 @@
+
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2017 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef EP128EMU_DEMORENDER_HPP
+#define EP128EMU_DEMORENDER_HPP
+
+#include "ep128emu.hpp"
+#include "display.hpp"
+#include "vm.hpp"
+
+namespace Ep128Emu {
+
+  /*!
+   * Video display that discards all output, for running the emulation
+   * without a window.
+   */
+  class NullVideoDisplay : public VideoDisplay {
+   private:
+    DisplayParameters   displayParameters;
+   public:
+    NullVideoDisplay();
+    virtual ~NullVideoDisplay();
+    virtual void setDisplayParameters(const DisplayParameters& dp);
+    virtual const DisplayParameters& getDisplayParameters() const;
+    virtual void drawLine(const uint8_t *buf, size_t nBytes);
+    virtual void vsyncStateChange(bool newState, unsigned int currentSlot_);
+  };
+
+  /*!
+   * Play the demo already loaded into 'vm' as fast as possible, writing
+   * video capture output to 'aviFileName' (an OpenDML AVI file, which is
+   * only split into multiple numbered files when its super index is full,
+   * after about 11 hours of video). The capture is encoded on a separate
+   * thread, 'videoFormat' is the same as in
+   * VirtualMachine::openVideoCapture(). Progress and error messages are
+   * printed to stderr if 'verbose' is true.
+   * Returns the length of the demo in seconds.
+   */
+  double renderDemoToVideo(VirtualMachine& vm, const char *aviFileName,
+                           int frameRate = 50, int videoFormat = 1,
+                           bool verbose = true);
+
+}       // namespace Ep128Emu
+
+#endif  // EP128EMU_DEMORENDER_HPP
+
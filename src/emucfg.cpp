@@ -71,6 +71,20 @@ static void defineConfigurationVariable(
                        &changeFlag, true);
 }
 
+static void videoCaptureYUVFormatCallback(void *userData,
+                                          const std::string& name, bool value)
+{
+  // map the obsolete videoCapture.yuvFormat setting to videoCapture.format
+  (void) name;
+  Ep128Emu::EmulatorConfiguration&  cfg =
+      *(reinterpret_cast<Ep128Emu::EmulatorConfiguration *>(userData));
+  if (value)
+    cfg.videoCapture.format = 1;
+  else if (cfg.videoCapture.format == 1)
+    cfg.videoCapture.format = 0;
+  cfg.videoCaptureSettingsChanged = true;
+}
+
 static void defaultErrorCallback(void *userData, const char *msg)
 {
   (void) userData;
@@ -107,6 +121,9 @@ namespace Ep128Emu {
     defineConfigurationVariable(*this, "vm.speedPercentage",
                                 vm.speedPercentage, 100U,
                                 soundSettingsChanged, 0.0, 1000.0);
+    defineConfigurationVariable(*this, "vm.runAheadFrames",
+                                vm.runAheadFrames, 0U,
+                                displaySettingsChanged, 0.0, 10.0);
     defineConfigurationVariable(*this, "vm.processPriority",
                                 vm.processPriority, int(0),
                                 vmProcessPriorityChanged,
@@ -393,9 +410,15 @@ namespace Ep128Emu {
                                 tape.soundFileFilterMaxFreq, 5000.0,
                                 tapeSoundFileSettingsChanged,
                                 1000.0, 20000.0);
+    defineConfigurationVariable(*this, "tape.soundFilePreDecode",
+                                tape.soundFilePreDecode, true,
+                                tapeSoundFileSettingsChanged);
     defineConfigurationVariable(*this, "tape.forceMotorOn",
                                 tape.forceMotorOn, false,
                                 tapeSettingsChanged);
+    defineConfigurationVariable(*this, "tape.turboLoad",
+                                tape.turboLoad, false,
+                                tapeSettingsChanged);
     // ----------------
     defineConfigurationVariable(*this, "fileio.workingDirectory",
                                 fileio.workingDirectory, std::string("."),
@@ -408,9 +431,15 @@ namespace Ep128Emu {
     defineConfigurationVariable(*this, "videoCapture.frameRate",
                                 videoCapture.frameRate, int(50),
                                 videoCaptureSettingsChanged, 24.0, 60.0);
+    defineConfigurationVariable(*this, "videoCapture.format",
+                                videoCapture.format, int(0),
+                                videoCaptureSettingsChanged, 0.0, 2.0);
+    // for compatibility with configuration files from older versions
     defineConfigurationVariable(*this, "videoCapture.yuvFormat",
                                 videoCapture.yuvFormat, false,
                                 videoCaptureSettingsChanged);
+    (*this)["videoCapture.yuvFormat"].setCallback(
+        &videoCaptureYUVFormatCallback, (void *) this, false);
     // ----------------
     // videoCaptureSettingsChanged is used only as a dummy variable here
     defineConfigurationVariable(*this, "compressFiles",
@@ -426,10 +455,14 @@ namespace Ep128Emu {
       defineConfigurationVariable(*this, "sid.3.volumeR",
                                   sid.volumeR, 1.0,
                                   sidConfigurationChanged, 0.0, 2.0);
+      defineConfigurationVariable(*this, "sid.3.highQuality",
+                                  sid.highQuality, true,
+                                  sidConfigurationChanged);
 #else
       sid.model = 0;
       sid.volumeL = 1.0;
       sid.volumeR = 1.0;
+      sid.highQuality = false;
 #endif
     // set machine specific defaults
     if (typeid(vm_) != typeid(Ep128::Ep128VM)) {
@@ -741,6 +774,7 @@ namespace Ep128Emu {
     if (tapeSettingsChanged) {
       vm_.setDefaultTapeSampleRate(tape.defaultSampleRate);
       vm_.setForceTapeMotorOn(tape.forceMotorOn);
+      vm_.setEnableTurboTape(tape.turboLoad);
       tapeSettingsChanged = false;
     }
     if (tapeFileChanged) {
@@ -758,7 +792,8 @@ namespace Ep128Emu {
       vm_.setTapeSoundFileParameters(tape.soundFileChannel,
                                      tape.enableSoundFileFilter,
                                      float(tape.soundFileFilterMinFreq),
-                                     float(tape.soundFileFilterMaxFreq));
+                                     float(tape.soundFileFilterMaxFreq),
+                                     tape.soundFilePreDecode);
       tapeSoundFileSettingsChanged = false;
     }
     if (fileioSettingsChanged) {
@@ -781,12 +816,15 @@ namespace Ep128Emu {
       debugSettingsChanged = false;
     }
     if (videoCaptureSettingsChanged) {
+      // keep the obsolete variable consistent with the format when saved
+      videoCapture.yuvFormat = (videoCapture.format == 1);
       videoCaptureSettingsChanged = false;
     }
 #ifdef ENABLE_RESID
     if (sidConfigurationChanged) {
       sidConfigurationChanged = false;
-      vm_.setSIDConfiguration(3, sid.model, sid.volumeL, sid.volumeR);
+      vm_.setSIDConfiguration(3, sid.model, sid.volumeL, sid.volumeR,
+                              sid.highQuality);
     }
 #endif
   }
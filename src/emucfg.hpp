@@ -50,6 +50,7 @@ namespace Ep128Emu {
       unsigned int  videoClockFrequency;
       unsigned int  soundClockFrequency;
       unsigned int  speedPercentage;    // NOTE: this uses soundSettingsChanged
+      unsigned int  runAheadFrames;     // uses displaySettingsChanged
       int           processPriority;    // uses vmProcessPriorityChanged
       bool          enableMemoryTimingEmulation;
       bool          enableFileIO;
@@ -206,8 +207,10 @@ namespace Ep128Emu {
       int         soundFileChannel;
       bool        enableSoundFileFilter;
       bool        forceMotorOn;
+      bool        turboLoad;
       double      soundFileFilterMinFreq;
       double      soundFileFilterMaxFreq;
+      bool        soundFilePreDecode;
     };
     TapeConfiguration_    tape;
     bool          tapeFileChanged;
@@ -227,6 +230,8 @@ namespace Ep128Emu {
     // --------
     struct {
       int         frameRate;
+      int         format;
+      // obsolete, only for reading old configuration files
       bool        yuvFormat;
     } videoCapture;
     bool          videoCaptureSettingsChanged;
@@ -237,6 +242,7 @@ namespace Ep128Emu {
       int         model;
       double      volumeL;
       double      volumeR;
+      bool        highQuality;
     } sid;
     bool          sidConfigurationChanged;
     // ----------------
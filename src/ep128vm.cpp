@@ -672,6 +672,8 @@ namespace Ep128 {
   void Ep128VM::Nick_::vsyncStateChange(bool newState,
                                         unsigned int currentSlot_)
   {
+    if (newState)
+      vm.turboTapeVSync();
     if (vm.getIsDisplayEnabled())
       vm.display.vsyncStateChange(newState, currentSlot_);
     if (vm.videoCapture)
@@ -813,7 +815,10 @@ namespace Ep128 {
 
   uint8_t Ep128VM::davePortReadCallback(void *userData, uint16_t addr)
   {
-    return (reinterpret_cast<Ep128VM *>(userData)->dave.readPort(addr));
+    Ep128VM&  vm = *(reinterpret_cast<Ep128VM *>(userData));
+    if ((addr & 0x1F) == 0x16)          // tape input (port B6H)
+      vm.countTapeInputRead();
+    return (vm.dave.readPort(addr));
   }
 
   void Ep128VM::davePortWriteCallback(void *userData,
@@ -1205,7 +1210,11 @@ namespace Ep128 {
       if (EP128EMU_UNLIKELY(!vm.sidEnabled)) {
         vm.setCallback(&Ep128VM::sidCallback, &vm, true);
         vm.sidEnabled = true;
+        vm.sidCyclesPending = 0;
+        for (int32_t i = 0; i < (sidBatchLength * 2); i++)
+          vm.sidOutputBuf[i] = vm.convertSIDOutput(0);
       }
+      vm.runSID();
       vm.sid->write(vm.sidAddressRegister, value);
     }
   }
@@ -1316,20 +1325,54 @@ namespace Ep128 {
     if (tmp >= 0L) {
       do {
         tmp -= (int64_t(1) << 32);
-        vm.sidOutputAccumulator = 0;
-        SID::clockCallback(vm.sid);
-        SID::clockCallback(vm.sid);
-        // FIXME: this is the maximum safe range with all 4 DAVE channels
-        // active, but it can overflow with tape feedback (unlikely in
-        // practice)
-        const int32_t sidOutputMax = (65535 - (63 * 4 * 128)) << 15;
-        const int32_t sidOutputOffs = (65535 - (63 * 4 * 128) + 1) << 14;
-        int32_t outL = vm.sidOutputAccumulator * vm.sidVolumeL + sidOutputOffs;
-        int32_t outR = vm.sidOutputAccumulator * vm.sidVolumeR + sidOutputOffs;
-        outL = (outL >= 0 ? (outL < sidOutputMax ? outL : sidOutputMax) : 0);
-        outR = (outR >= 0 ? (outR < sidOutputMax ? outR : sidOutputMax) : 0);
-        vm.externalDACOutput = uint32_t((outL >> 15) | ((outR >> 15) << 16));
+        vm.sidCyclesPending++;
       } while (EP128EMU_UNLIKELY(tmp >= 0L));
+      if (vm.sidCyclesPending >= sidBatchLength)
+        vm.runSID();
+      // play the output of the cycle sidBatchLength DAVE cycles ago
+      vm.externalDACOutput =
+          vm.sidOutputBuf[(vm.sidOutputWritePos + vm.sidCyclesPending
+                           - (sidBatchLength + 1)) & (sidBatchLength * 2 - 1)];
+    }
+  }
+
+  uint32_t Ep128VM::convertSIDOutput(int32_t sidOutput) const
+  {
+    // FIXME: this is the maximum safe range with all 4 DAVE channels
+    // active, but it can overflow with tape feedback (unlikely in
+    // practice)
+    const int32_t sidOutputMax = (65535 - (63 * 4 * 128)) << 15;
+    const int32_t sidOutputOffs = (65535 - (63 * 4 * 128) + 1) << 14;
+    int32_t outL = sidOutput * sidVolumeL + sidOutputOffs;
+    int32_t outR = sidOutput * sidVolumeR + sidOutputOffs;
+    outL = (outL >= 0 ? (outL < sidOutputMax ? outL : sidOutputMax) : 0);
+    outR = (outR >= 0 ? (outR < sidOutputMax ? outR : sidOutputMax) : 0);
+    return uint32_t((outL >> 15) | ((outR >> 15) << 16));
+  }
+
+  void Ep128VM::runSID()
+  {
+    while (sidCyclesPending > 0) {
+      int32_t n = (sidCyclesPending < sidBatchLength ?
+                   sidCyclesPending : sidBatchLength);
+      int     buf[sidBatchLength * 2];
+      // the SID is clocked at twice the DAVE frequency
+      if (sidHighQuality)
+        sid->clock_block(cycle_count(n) << 1, &(buf[0]));
+      else
+        sid->clock_fast(cycle_count(n) << 1);
+      sidCyclesPending -= n;
+      for (int32_t i = 0; i < n; i++) {
+        // with clock_block(), the output is the sum of the two SID cycles
+        // of each DAVE cycle, like with two clockCallback() calls; with the
+        // faster, but less accurate clock_fast(), the filter output at the
+        // end of the batch is used for all cycles
+        int32_t sidOutput = sidOutputAccumulator;
+        if (sidHighQuality)
+          sidOutput = int32_t(buf[i * 2] + buf[i * 2 + 1]) << 3;
+        sidOutputBuf[sidOutputWritePos] = convertSIDOutput(sidOutput);
+        sidOutputWritePos = (sidOutputWritePos + 1) & (sidBatchLength * 2 - 1);
+      }
     }
   }
 
@@ -1602,10 +1645,13 @@ namespace Ep128 {
       , sid((SID *) 0),
       sidEnabled(false),
       sidModel(0),
+      sidHighQuality(true),
       sidAddressRegister(0x00),
       sidOutputAccumulator(0),
       sidVolumeL(1039),
-      sidVolumeR(1039)
+      sidVolumeR(1039),
+      sidCyclesPending(0),
+      sidOutputWritePos(0)
 #endif
 #ifdef ENABLE_MIDI_PORT
       , midiBufferReadPos(0),
@@ -1760,6 +1806,25 @@ namespace Ep128 {
         } while (EP128EMU_UNLIKELY(daveCyclesRemaining >= 0L));
       }
       cpuCyclesRemaining += cpuCyclesPerNickCycle;
+      if (EP128EMU_UNLIKELY(z80.getIsHalted()) && cpuCyclesRemaining >= 0L) {
+        // the CPU is waiting for an interrupt: if the opcode fetches of the
+        // HALT instruction have no side effects and a fixed number of wait
+        // states, only the cycle counter and the refresh register need to
+        // be updated
+        uint16_t  addr = uint16_t(z80.getReg().PC.W.l);
+        if (!(singleStepMode || (memoryTimingEnabled &&
+                                 pageTable[addr >> 14] >= 0xFC)) &&
+            memory.isSimpleOpcodeRead(addr)) {
+          int64_t m1Cycles = (memoryTimingEnabled ?
+                              memoryWaitCycles_M1 : (int64_t(4) << 32));
+          uint8_t n = 0;
+          do {
+            cpuCyclesRemaining -= m1Cycles;
+            n++;
+          } while (cpuCyclesRemaining >= 0L);
+          z80.getReg().R += n;
+        }
+      }
       while (cpuCyclesRemaining >= 0L)
         z80.executeInstruction();
       nick.runOneSlot();
@@ -1816,6 +1881,7 @@ namespace Ep128 {
         setCallback(&sidCallback, this, false);
         sidEnabled = false;
       }
+      sidCyclesPending = 0;
       sid->reset();
     }
 #endif
@@ -1831,7 +1897,8 @@ namespace Ep128 {
 #ifdef ENABLE_RESID
 
   void Ep128VM::setSIDConfiguration(int n, int model,
-                                    double volumeL, double volumeR)
+                                    double volumeL, double volumeR,
+                                    bool highQuality)
   {
     if (n != 3)
       return;
@@ -1852,6 +1919,7 @@ namespace Ep128 {
       sid->set_chip_model(model == 1 ? MOS6581 : MOS8580);
     sidVolumeL = int32_t(volumeL * 1039.75);
     sidVolumeR = int32_t(volumeR * 1039.75);
+    sidHighQuality = highQuality;
   }
 
 #endif
@@ -1993,20 +2061,28 @@ namespace Ep128 {
 
   void Ep128VM::openVideoCapture(
       int frameRate_,
-      bool yuvFormat_,
+      int videoFormat_,
       void (*errorCallback_)(void *userData, const char *msg),
       void (*fileNameCallback_)(void *userData, std::string& fileName),
       void *userData_)
   {
     if (!videoCapture) {
-      if (yuvFormat_) {
+      if (videoFormat_ == 1) {
         videoCapture = new Ep128Emu::VideoCapture_YV12(&Nick::convertPixelToRGB,
                                                        frameRate_);
       }
+      else if (videoFormat_ == 2) {
+        videoCapture = new Ep128Emu::VideoCapture_ZMBV(&Nick::convertPixelToRGB,
+                                                       frameRate_);
+      }
       else {
         videoCapture = new Ep128Emu::VideoCapture_RLE8(&Nick::convertPixelToRGB,
                                                        frameRate_);
       }
+      if (getIsVideoCaptureThreadEnabled()) {
+        videoCapture = new Ep128Emu::VideoCapture_Async(videoCapture,
+                                                        frameRate_);
+      }
       videoCapture->setClockFrequency(nickFrequency);
       setCallback(&videoCaptureCallback, this, true);
     }
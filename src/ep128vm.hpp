@@ -227,10 +227,20 @@ namespace Ep128 {
     SID       *sid;
     bool      sidEnabled;
     uint8_t   sidModel;                 // 0: disabled, 1: 6581, 2: 8580
+    bool      sidHighQuality;           // use SID::clock_block()
     uint8_t   sidAddressRegister;
     int32_t   sidOutputAccumulator;
     int32_t   sidVolumeL;
     int32_t   sidVolumeR;
+    // number of DAVE cycles the SID has not been clocked for yet; it is
+    // run in batches of up to sidBatchLength cycles, and before each write
+    int32_t   sidCyclesPending;
+    static const int32_t  sidBatchLength = 8;
+    // SID output of each DAVE cycle in externalDACOutput format; it is
+    // delayed by sidBatchLength cycles, so that it is already calculated
+    // when the cycle is played
+    uint32_t  sidOutputBuf[sidBatchLength * 2];
+    int32_t   sidOutputWritePos;
 #endif
 #ifdef ENABLE_MIDI_PORT
     Ep128Emu::Mutex midiBufferMutex;
@@ -294,6 +304,8 @@ namespace Ep128 {
     static void videoCaptureCallback(void *userData);
 #ifdef ENABLE_RESID
     static void sidCallback(void *userData);
+    void runSID();
+    uint32_t convertSIDOutput(int32_t sidOutput) const;
 #endif
     void stopDemoPlayback();
     void stopDemoRecording(bool writeFile_);
@@ -342,9 +354,12 @@ namespace Ep128 {
     /*!
      * Configure SID 'n' (0 to 3, currently only 3 is supported),
      * 'model' can be 0 to disable the emulation, 1 for MOS 6581 or 2 for 8580.
+     * If 'highQuality' is true, the SID is clocked cycle by cycle, otherwise
+     * the faster, but less accurate multi-cycle steps are used.
      */
     virtual void setSIDConfiguration(int n, int model,
-                                     double volumeL, double volumeR);
+                                     double volumeL, double volumeR,
+                                     bool highQuality);
 #endif
     /*!
      * Set CPU clock frequency (in Hz); defaults to 4000000 Hz.
@@ -395,11 +410,11 @@ namespace Ep128 {
      * Create video capture object with the specified frame rate (24 to 60)
      * and format (768x576 RLE8 or 384x288 YV12) if it does not exist yet,
      * and optionally set callbacks for printing error messages and asking
-     * for a new output file on reaching 2 GB file size.
+     * for a new output file when the AVI super index is full.
      */
     virtual void openVideoCapture(
         int frameRate_ = 50,
-        bool yuvFormat_ = false,
+        int videoFormat_ = 0,
         void (*errorCallback_)(void *userData, const char *msg) =
             (void (*)(void *, const char *)) 0,
         void (*fileNameCallback_)(void *userData, std::string& fileName) =
@@ -652,6 +667,26 @@ namespace Ep128 {
      * playing a demo.
      */
     virtual bool getIsPlayingDemo() const;
+    /*!
+     * Save a fast in-memory copy of the state of the emulated machine,
+     * for use by restoreState() on the same object, or on another Ep128VM
+     * with the same memory configuration. The ROM segments, tape, and disk
+     * images are not included, so this returns false while tape or disk I/O,
+     * demo recording or playback, or debugging is in progress, a floppy or
+     * IDE disk image is not read-only or write protected, or SD card, SID,
+     * or MIDI emulation is enabled.
+     */
+    virtual bool cloneState(Ep128Emu::MachineState&);
+    virtual void restoreState(Ep128Emu::MachineState&);
+    /*!
+     * Copy the memory configuration (including the ROM segments), the clock
+     * frequency and timing settings, and the state of the emulated machine
+     * to 'vm', which can then be run independently of this object, and
+     * updated with cloneState() and restoreState(). Tape and disk images,
+     * breakpoints, and display and sound settings are not copied.
+     * Throws Ep128Emu::Exception if cloneState() fails.
+     */
+    virtual void forkState(Ep128VM& vm);
     // ----------------
     virtual void loadState(Ep128Emu::File::Buffer&);
     virtual void loadMachineConfiguration(Ep128Emu::File::Buffer&);
@@ -125,6 +125,28 @@ namespace Ep128Emu {
       return 0x00;
     }
     virtual void reset();
+    // fast in-memory copy of the drive position and motor state; the track
+    // buffer is not included, it is only a cache of the disk image
+    inline void cloneState(MachineState& s) const
+    {
+      s.write(currentTrack);
+      s.write(currentSide);
+      s.write(diskChangeFlag);
+      s.write(motorOnInput);
+      s.write(isMotorOn);
+      s.write(ledStateCounter);
+      s.write(bufPos);
+    }
+    inline void restoreState(MachineState& s)
+    {
+      s.read(currentTrack);
+      s.read(currentSide);
+      s.read(diskChangeFlag);
+      s.read(motorOnInput);
+      s.read(isMotorOn);
+      s.read(ledStateCounter);
+      s.read(bufPos);
+    }
     inline uint8_t getSectorsPerTrack() const
     {
       return nSectorsPerTrack;
@@ -718,5 +718,36 @@ namespace Ep128Emu {
     chunkTypeDB[type] = p;
   }
 
+  // --------------------------------------------------------------------------
+
+  MachineState::MachineState()
+    : buf((unsigned char *) 0),
+      curPos(0),
+      dataSize(0),
+      allocSize(0)
+  {
+  }
+
+  MachineState::~MachineState()
+  {
+    if (buf)
+      delete[] buf;
+  }
+
+  void MachineState::extendBuffer(size_t nBytes)
+  {
+    size_t  newSize = allocSize;
+    do {
+      newSize = ((newSize + (newSize >> 3)) | 4095) + 1;
+    } while (newSize < (curPos + nBytes));
+    unsigned char *newBuf = new unsigned char[newSize];
+    if (buf) {
+      std::memcpy(newBuf, buf, dataSize);
+      delete[] buf;
+    }
+    buf = newBuf;
+    allocSize = newSize;
+  }
+
 }       // namespace Ep128Emu
 
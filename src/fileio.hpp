@@ -153,6 +153,94 @@ namespace Ep128Emu {
                                               size_t nBytes);
   };
 
+  // --------------------------------------------------------------------------
+
+  // In-memory copy of the state of a machine, for fast saving and restoring
+  // of the emulated machine (e.g. for run-ahead). Unlike File::Buffer, the
+  // data is stored in native format, without any conversion, and can only be
+  // restored in the same process, into the object it was saved from or into
+  // another one of the same type and memory configuration. The buffer is not
+  // freed by clear(), so it does not allocate memory after the first use, or
+  // at all if reserve() was called with a large enough size.
+
+  class MachineState {
+   private:
+    unsigned char *buf;
+    size_t  curPos, dataSize, allocSize;
+    void extendBuffer(size_t nBytes);
+    MachineState(const MachineState&);
+    MachineState& operator=(const MachineState&);
+   public:
+    MachineState();
+    ~MachineState();
+    // discard all data, but keep the buffer allocated
+    inline void clear()
+    {
+      curPos = 0;
+      dataSize = 0;
+    }
+    // set read position to the beginning of the data
+    inline void rewind()
+    {
+      curPos = 0;
+    }
+    inline void writeData(const void *p, size_t nBytes)
+    {
+      if ((curPos + nBytes) > allocSize)
+        extendBuffer(nBytes);
+      std::memcpy(buf + curPos, p, nBytes);
+      curPos += nBytes;
+      dataSize = curPos;
+    }
+    inline void readData(void *p, size_t nBytes)
+    {
+      if ((curPos + nBytes) > dataSize)
+        throw Exception("unexpected end of machine state data");
+      std::memcpy(p, buf + curPos, nBytes);
+      curPos += nBytes;
+    }
+    template <typename T>
+    inline void write(const T& n)
+    {
+      writeData(&n, sizeof(T));
+    }
+    template <typename T>
+    inline void read(T& n)
+    {
+      readData(&n, sizeof(T));
+    }
+    // store a pointer as an offset from 'base', so that it can be restored
+    // into a different object; 'p' must be NULL or not less than 'base'
+    inline void writePointer(const void *p, const void *base)
+    {
+      size_t  n = 0;
+      if (p)
+        n = size_t(static_cast<const char *>(p)
+                   - static_cast<const char *>(base)) + 1;
+      write(n);
+    }
+    template <typename T>
+    inline void readPointer(T*& p, void *base)
+    {
+      size_t  n = 0;
+      read(n);
+      if (n)
+        p = reinterpret_cast<T *>(static_cast<char *>(base) + (n - 1));
+      else
+        p = (T *) 0;
+    }
+    // allocate at least 'nBytes' bytes for the data
+    inline void reserve(size_t nBytes)
+    {
+      if (nBytes > allocSize)
+        extendBuffer(nBytes - curPos);
+    }
+    inline size_t getDataSize() const
+    {
+      return dataSize;
+    }
+  };
+
 }       // namespace Ep128Emu
 
 #endif  // EP128EMU_FILEIO_HPP
@@ -778,6 +778,40 @@ namespace Ep128 {
         (ideController.statusRegister & 0x50) | uint8_t(bool(errorCode));
   }
 
+  void IDEInterface::IDEController::IDEDrive::cloneState(
+      Ep128Emu::MachineState& s) const
+  {
+    s.write(nCylinders);
+    s.write(nHeads);
+    s.write(nSectorsPerTrack);
+    s.write(multSectCnt);
+    s.write(currentSector);
+    s.write(readWordCnt);
+    s.write(writeWordCnt);
+    s.write(sectorCnt);
+    s.write(ledStateCounter);
+    s.write(interruptFlag);
+    s.write(diskChangeFlag);
+    s.write(bufPos);
+  }
+
+  void IDEInterface::IDEController::IDEDrive::restoreState(
+      Ep128Emu::MachineState& s)
+  {
+    s.read(nCylinders);
+    s.read(nHeads);
+    s.read(nSectorsPerTrack);
+    s.read(multSectCnt);
+    s.read(currentSector);
+    s.read(readWordCnt);
+    s.read(writeWordCnt);
+    s.read(sectorCnt);
+    s.read(ledStateCounter);
+    s.read(interruptFlag);
+    s.read(diskChangeFlag);
+    s.read(bufPos);
+  }
+
   // --------------------------------------------------------------------------
 
   void IDEInterface::IDEController::softwareReset()
@@ -952,6 +986,48 @@ namespace Ep128 {
     }
   }
 
+  bool IDEInterface::IDEController::getIsBusy() const
+  {
+    return ((statusRegister & 0x88) != 0 ||
+            ideDrive0.isReadCommand() || ideDrive0.isWriteCommand() ||
+            ideDrive1.isReadCommand() || ideDrive1.isWriteCommand());
+  }
+
+  bool IDEInterface::IDEController::haveWritableImageFile() const
+  {
+    return (ideDrive0.haveWritableImageFile() ||
+            ideDrive1.haveWritableImageFile());
+  }
+
+  void IDEInterface::IDEController::cloneState(
+      Ep128Emu::MachineState& s) const
+  {
+    ideDrive0.cloneState(s);
+    ideDrive1.cloneState(s);
+    s.write(dataPort);
+    s.write(commandPort);
+    const char  *p = reinterpret_cast<const char *>(&statusRegister);
+    size_t  nBytes = size_t(
+        reinterpret_cast<const char *>(&deviceControlRegister + 1) - p);
+    s.writeData(p, nBytes);
+    s.write(bool(currentDevice == &ideDrive1));
+  }
+
+  void IDEInterface::IDEController::restoreState(Ep128Emu::MachineState& s)
+  {
+    ideDrive0.restoreState(s);
+    ideDrive1.restoreState(s);
+    s.read(dataPort);
+    s.read(commandPort);
+    char    *p = reinterpret_cast<char *>(&statusRegister);
+    size_t  nBytes =
+        size_t(reinterpret_cast<char *>(&deviceControlRegister + 1) - p);
+    s.readData(p, nBytes);
+    bool    drive1Selected = false;
+    s.read(drive1Selected);
+    currentDevice = (drive1Selected ? &ideDrive1 : &ideDrive0);
+  }
+
   // --------------------------------------------------------------------------
 
   uint32_t IDEInterface::getLEDState_()
@@ -1009,6 +1085,33 @@ namespace Ep128 {
       idePort1.setImageFile(n, fileName);
   }
 
+  bool IDEInterface::getIsBusy() const
+  {
+    return (idePort0.getIsBusy() || idePort1.getIsBusy());
+  }
+
+  bool IDEInterface::haveWritableImageFile() const
+  {
+    return (idePort0.haveWritableImageFile() ||
+            idePort1.haveWritableImageFile());
+  }
+
+  void IDEInterface::cloneState(Ep128Emu::MachineState& s) const
+  {
+    idePort0.cloneState(s);
+    idePort1.cloneState(s);
+    s.write(dataPort);
+    s.write(ledFlashCnt);
+  }
+
+  void IDEInterface::restoreState(Ep128Emu::MachineState& s)
+  {
+    idePort0.restoreState(s);
+    idePort1.restoreState(s);
+    s.read(dataPort);
+    s.read(ledFlashCnt);
+  }
+
   uint8_t IDEInterface::readPort(uint16_t addr)
   {
     switch (addr & 3) {
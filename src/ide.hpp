@@ -88,6 +88,8 @@ namespace Ep128 {
         void writeWord();
         void processCommand();
         void commandDone(uint8_t errorCode);
+        void cloneState(Ep128Emu::MachineState& s) const;
+        void restoreState(Ep128Emu::MachineState& s);
         // set pointer to 64K I/O buffer
         inline void setBuffer(uint8_t *buf_)
         {
@@ -102,6 +104,10 @@ namespace Ep128 {
         {
           return (imageFile != (std::FILE *) 0);
         }
+        inline bool haveWritableImageFile() const
+        {
+          return (imageFile != (std::FILE *) 0 && !readOnlyMode);
+        }
         inline bool isReadCommand() const
         {
           return (readWordCnt > 0);
@@ -144,6 +150,12 @@ namespace Ep128 {
       void setImageFile(int n, const char *fileName);
       void readRegister();
       void writeRegister();
+      // returns true if a command is in progress on any of the drives
+      bool getIsBusy() const;
+      // returns true if any of the drives has a writable disk image
+      bool haveWritableImageFile() const;
+      void cloneState(Ep128Emu::MachineState& s) const;
+      void restoreState(Ep128Emu::MachineState& s);
       inline IDEDrive& getCurrentDevice()
       {
         return (*currentDevice);
@@ -188,6 +200,22 @@ namespace Ep128 {
     void setImageFile(int n, const char *fileName);
     uint8_t readPort(uint16_t addr);
     void writePort(uint16_t addr, uint8_t value);
+    /*!
+     * Returns true if a command is in progress on any of the drives.
+     */
+    bool getIsBusy() const;
+    /*!
+     * Returns true if any of the drives has a disk image file that is not
+     * read-only.
+     */
+    bool haveWritableImageFile() const;
+    /*!
+     * Save (cloneState()) or restore (restoreState()) a fast in-memory copy
+     * of the interface, controller, and drive registers. The I/O buffer is
+     * not included, so this should only be used if getIsBusy() is false.
+     */
+    void cloneState(Ep128Emu::MachineState& s) const;
+    void restoreState(Ep128Emu::MachineState& s);
     inline uint32_t getLEDState()
     {
       ledFlashCnt++;
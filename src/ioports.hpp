@@ -52,6 +52,10 @@ namespace Ep128 {
     void setBreakPointPriorityThreshold(int n);
     int getBreakPointPriorityThreshold();
     Ep128Emu::BreakPointList getBreakPointList();
+    inline bool getHaveBreakPoints() const
+    {
+      return (breakPointCnt > 0);
+    }
     inline uint8_t read(uint16_t addr);
     inline void write(uint16_t addr, uint8_t value);
     uint8_t readDebug(uint16_t addr) const;
@@ -71,6 +75,15 @@ namespace Ep128 {
     void saveState(Ep128Emu::File&);
     void loadState(Ep128Emu::File::Buffer&);
     void registerChunkType(Ep128Emu::File&);
+    // fast in-memory copy of the last values written to the I/O ports
+    inline void cloneState(Ep128Emu::MachineState& s) const
+    {
+      s.writeData(portValues, 256);
+    }
+    inline void restoreState(Ep128Emu::MachineState& s)
+    {
+      s.readData(portValues, 256);
+    }
    protected:
     virtual void breakPointCallback(bool isWrite, uint16_t addr, uint8_t value);
   };
@@ -477,6 +477,40 @@ namespace Ep128 {
     }
   }
 
+  void Memory::cloneState(Ep128Emu::MachineState& s) const
+  {
+    s.write(pageTable);
+    uint16_t  nSegments = 0;
+    for (size_t i = 0; i < 256; i++) {
+      if (isSegmentRAM(uint8_t(i)))
+        nSegments++;
+    }
+    s.write(nSegments);
+    for (size_t i = 0; i < 256; i++) {
+      if (isSegmentRAM(uint8_t(i))) {
+        s.write(uint8_t(i));
+        s.writeData(segmentTable[i], 16384);
+      }
+    }
+  }
+
+  void Memory::restoreState(Ep128Emu::MachineState& s)
+  {
+    uint8_t   tmp[4];
+    s.read(tmp);
+    for (uint8_t i = 0; i < 4; i++)
+      setPage(i, tmp[i]);
+    uint16_t  nSegments = 0;
+    s.read(nSegments);
+    while (nSegments-- > 0) {
+      uint8_t segment = 0;
+      s.read(segment);
+      if (!isSegmentRAM(segment))
+        throw Ep128Emu::Exception("memory configuration has changed");
+      s.readData(segmentTable[segment], 16384);
+    }
+  }
+
   void Memory::registerChunkType(Ep128Emu::File& f)
   {
     ChunkType_MemorySnapshot  *p;
@@ -68,6 +68,9 @@ namespace Ep128 {
     void deleteAllSegments();
     inline uint8_t read(uint16_t addr);
     inline uint8_t readOpcode(uint16_t addr);
+    // returns true if reading an opcode from 'addr' has no side effects
+    // (breakpoints, or memory mapped I/O on the SD card cartridge)
+    inline bool isSimpleOpcodeRead(uint16_t addr) const;
     inline uint8_t readNoDebug(uint16_t addr) const;
     inline uint8_t readRaw(uint32_t addr) const;
     inline void write(uint16_t addr, uint8_t value);
@@ -79,11 +82,18 @@ namespace Ep128 {
     inline bool isSegmentROM(uint8_t segment) const;
     inline bool isSegmentRAM(uint8_t segment) const;
     bool checkIgnoreBreakPoint(uint16_t addr) const;
+    inline bool getHaveBreakPoints() const
+    {
+      return haveBreakPoints;
+    }
     Ep128Emu::BreakPointList getBreakPointList();
     void saveState(Ep128Emu::File::Buffer&);
     void saveState(Ep128Emu::File&);
     void loadState(Ep128Emu::File::Buffer&);
     void registerChunkType(Ep128Emu::File&);
+    // fast in-memory copy of the paging registers and RAM contents
+    void cloneState(Ep128Emu::MachineState&) const;
+    void restoreState(Ep128Emu::MachineState&);
 #ifdef ENABLE_SDEXT
     void setSDExtPtr(SDExt *p)
     {
@@ -122,6 +132,17 @@ namespace Ep128 {
     return value;
   }
 
+  inline bool Memory::isSimpleOpcodeRead(uint16_t addr) const
+  {
+#ifdef ENABLE_SDEXT
+    if (EP128EMU_UNLIKELY(sdext->isSDExtSegment(pageTable[addr >> 14])))
+      return false;
+#else
+    (void) addr;
+#endif
+    return !haveBreakPoints;
+  }
+
   inline uint8_t Memory::readNoDebug(uint16_t addr) const
   {
 #ifdef ENABLE_SDEXT
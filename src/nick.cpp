@@ -1294,6 +1294,31 @@ namespace Ep128 {
     }
   }
 
+  void Nick::cloneState(Ep128Emu::MachineState& s) const
+  {
+    const char  *p = reinterpret_cast<const char *>(&lpb);
+    size_t  nBytes =
+        size_t(reinterpret_cast<const char *>(&port3Value) + 1 - p);
+    s.writeData(p, nBytes);
+    s.writePointer(lineBufPtr, lineBuf);
+    s.writeData(lineBuf, sizeof(uint32_t) * 129);
+  }
+
+  void Nick::restoreState(Ep128Emu::MachineState& s)
+  {
+    // the video memory and line buffer pointers belong to this object,
+    // so that the state can also be restored into a different one
+    const uint8_t *videoMemory_ = videoMemory;
+    uint8_t *lineBuf_ = lineBuf;
+    char    *p = reinterpret_cast<char *>(&lpb);
+    size_t  nBytes = size_t(reinterpret_cast<char *>(&port3Value) + 1 - p);
+    s.readData(p, nBytes);
+    videoMemory = videoMemory_;
+    lineBuf = lineBuf_;
+    s.readPointer(lineBufPtr, lineBuf);
+    s.readData(lineBuf, sizeof(uint32_t) * 129);
+  }
+
   void Nick::registerChunkType(Ep128Emu::File& f)
   {
     ChunkType_NickSnapshot  *p;
@@ -212,6 +212,9 @@ namespace Ep128 {
     void saveState(Ep128Emu::File&);
     void loadState(Ep128Emu::File::Buffer&);
     void registerChunkType(Ep128Emu::File&);
+    // fast in-memory copy of the internal state and line buffer
+    void cloneState(Ep128Emu::MachineState&) const;
+    void restoreState(Ep128Emu::MachineState&);
   };
 
 }       // namespace Ep128
@@ -349,6 +349,100 @@ namespace Ep128Emu {
     }
   }
 
+  void Compressor_ZLib::updateHashChain(const unsigned char *inBuf,
+                                        size_t nBytes)
+  {
+    std::vector< unsigned short > hashTable(32768, 0);
+    hashChain.resize(maxMatchDist);
+    for (size_t i = 0; i < nBytes; i++) {
+      if ((i + minMatchLen) > nBytes) {
+        hashChain[i] = 0;
+        continue;
+      }
+      unsigned int  h = ((unsigned int) inBuf[i] << 10)
+                        ^ ((unsigned int) inBuf[i + 1] << 5)
+                        ^ (unsigned int) inBuf[i + 2];
+      h = h & 0x7FFFU;
+      // positions are stored + 1, so that 0 means no match
+      size_t  prvPos = hashTable[h];
+      hashChain[i] = (unsigned short) (prvPos > 0 ? ((i + 1) - prvPos) : 0);
+      hashTable[h] = (unsigned short) (i + 1);
+    }
+  }
+
+  // returns the length of the longest match at 'offs' (0 if none is found),
+  // and stores its distance in 'd'
+
+  inline size_t Compressor_ZLib::findMatchFast(size_t& d,
+                                               const unsigned char *inBuf,
+                                               size_t offs,
+                                               size_t endPos) const
+  {
+    // maximum number of hash chain entries to check
+    size_t  chainLen = 128;
+    size_t  maxLen = endPos - offs;
+    if (maxLen > maxMatchLen)
+      maxLen = maxMatchLen;
+    size_t  bestLen = 0;
+    d = 0;
+    if (maxLen < minMatchLen)
+      return 0;
+    const unsigned char *p = inBuf + offs;
+    for (size_t pos = offs; chainLen > 0 && hashChain[pos] != 0; chainLen--) {
+      pos = pos - size_t(hashChain[pos]);
+      const unsigned char *q = inBuf + pos;
+      if (q[bestLen] != p[bestLen] || q[0] != p[0] || q[1] != p[1])
+        continue;
+      size_t  len = 2;
+      while (len < maxLen && q[len] == p[len])
+        len++;
+      if (len > bestLen) {
+        bestLen = len;
+        d = offs - pos;
+        if (len >= maxLen)
+          break;
+      }
+    }
+    // short matches with a long distance are not worth encoding
+    if (bestLen < minMatchLen || (bestLen == minMatchLen && d > 4096))
+      return 0;
+    return bestLen;
+  }
+
+  void Compressor_ZLib::findMatchesFast(LZMatchParameters *matchTable,
+                                        const unsigned char *inBuf,
+                                        size_t offs, size_t nBytes)
+  {
+    size_t  endPos = offs + nBytes;
+    size_t  d = 0;
+    size_t  len = findMatchFast(d, inBuf, offs, endPos);
+    for (size_t i = offs; i < endPos; ) {
+      if (len > 0 && len < 32 && (i + 1) < endPos) {
+        // lazy matching: check if there is a longer match at the next byte
+        size_t  nxtD = 0;
+        size_t  nxtLen = findMatchFast(nxtD, inBuf, i + 1, endPos);
+        if (nxtLen > len) {
+          matchTable[i - offs].clear();
+          i++;
+          d = nxtD;
+          len = nxtLen;
+          continue;
+        }
+      }
+      if (len > 0) {
+        matchTable[i - offs].d = (unsigned short) d;
+        matchTable[i - offs].len = (unsigned short) len;
+        i = i + len;
+      }
+      else {
+        matchTable[i - offs].clear();
+        i++;
+      }
+      if (i < endPos)
+        len = findMatchFast(d, inBuf, i, endPos);
+    }
+  }
+
   void Compressor_ZLib::compressData(std::vector< unsigned int >& tmpOutBuf,
                                      const unsigned char *inBuf,
                                      size_t offs, size_t nBytes,
@@ -368,7 +462,10 @@ namespace Ep128Emu {
     // compress data by searching for repeated byte sequences,
     // and replacing them with length/distance codes
     std::vector< LZMatchParameters >  matchTable(nBytes);
-    {
+    if (compressionLevel <= compressionLevelFast) {
+      findMatchesFast(&(matchTable.front()), inBuf, offs, nBytes);
+    }
+    else {
       std::vector< size_t > bitCountTable(nBytes + 1, 0);
       optimizeMatches(&(matchTable.front()), inBuf, &(bitCountTable.front()),
                       offs, nBytes);
@@ -405,8 +502,9 @@ namespace Ep128Emu {
 
   // --------------------------------------------------------------------------
 
-  Compressor_ZLib::Compressor_ZLib()
+  Compressor_ZLib::Compressor_ZLib(int compressionLevel_)
     : searchTable((Ep128Compress::LZSearchTable *) 0),
+      compressionLevel(compressionLevel_),
       huffmanEncoderL(288, 257),
       huffmanEncoderD(32, 1),
       huffmanEncoderC(19, 0)
@@ -434,7 +532,13 @@ namespace Ep128Emu {
     {
       size_t  searchTableStart = (offs / maxMatchDist) * maxMatchDist;
       bool    searchTableNeeded = (offs == searchTableStart);
-      if (searchTableNeeded) {
+      if (searchTableNeeded && compressionLevel <= compressionLevelFast) {
+        size_t  searchTableSize = bufSize - searchTableStart;
+        if (searchTableSize > maxMatchDist)
+          searchTableSize = maxMatchDist;
+        updateHashChain(inBuf + searchTableStart, searchTableSize);
+      }
+      else if (searchTableNeeded) {
         if (!searchTable) {
           searchTable = new Ep128Compress::LZSearchTable(
                                 minMatchLen, maxMatchLen, maxMatchLen,
@@ -453,7 +557,12 @@ namespace Ep128Emu {
     std::vector< unsigned int > tmpBuf;
     size_t  bestSize = 0x7FFFFFFF;
     bool    doneFlag = false;
-    for (size_t i = 0; i < 8; i++) {
+    // number of iterations: with fixed Huffman codes first, and then with
+    // the codes generated from the symbol statistics of the previous pass
+    size_t  nPasses = (compressionLevel <= compressionLevelFast ?
+                       2 : (compressionLevel == compressionLevelDefault ?
+                            3 : 8));
+    for (size_t i = 0; i < nPasses; i++) {
       if (doneFlag)     // if the compression cannot be optimized further,
         continue;       // quit the loop earlier
       tmpBuf.clear();
@@ -503,6 +612,48 @@ namespace Ep128Emu {
     }
   }
 
+  // --------------------------------------------------------------------------
+
+  // pad the bit buffer 'shiftReg' (0x80 = empty) to a byte boundary, and
+  // write it to 'outBuf' if it is not empty
+
+  static inline void flushDeflateBits(std::vector< unsigned char >& outBuf,
+                                      unsigned char& shiftReg)
+  {
+    if (shiftReg != 0x80) {
+      while (!(shiftReg & 0x01))
+        shiftReg = shiftReg >> 1;
+      shiftReg = (shiftReg >> 1) & 0x7F;
+      outBuf.push_back(shiftReg);
+      shiftReg = 0x80;
+    }
+  }
+
+  // pack a word of the output of Compressor_ZLib::compressDataBlock()
+
+  static inline void writeDeflateBits(std::vector< unsigned char >& outBuf,
+                                      unsigned char& shiftReg, unsigned int c)
+  {
+    if (c >= 0x80000000U) {
+      // special case for literal bytes, which are stored byte-aligned
+      flushDeflateBits(outBuf, shiftReg);
+      outBuf.push_back((unsigned char) (c & 0xFFU));
+    }
+    else {
+      unsigned int  nBits = c >> 24;
+      while (nBits-- > 0U) {
+        unsigned char b = (unsigned char) bool(c & 1U);
+        bool          srFull = bool(shiftReg & 0x01);
+        c = c >> 1;
+        shiftReg = ((shiftReg >> 1) & 0x7F) | (b << 7);
+        if (srFull) {
+          outBuf.push_back(shiftReg);
+          shiftReg = 0x80;
+        }
+      }
+    }
+  }
+
   // ==========================================================================
 
   class ZLibCompressorThread : public Thread {
@@ -514,18 +665,21 @@ namespace Ep128Emu {
     size_t  inBufSize;
     size_t  startPos;
     size_t  blockSize;
+    bool    isLastBlock;
     bool    errorFlag;
     // --------
-    ZLibCompressorThread();
+    ZLibCompressorThread(int compressionLevel_);
     virtual ~ZLibCompressorThread();
     virtual void run();
   };
 
-  ZLibCompressorThread::ZLibCompressorThread()
-    : inBuf((unsigned char *) 0),
+  ZLibCompressorThread::ZLibCompressorThread(int compressionLevel_)
+    : compressor(compressionLevel_),
+      inBuf((unsigned char *) 0),
       inBufSize(0),
       startPos(0),
       blockSize(Compressor_ZLib::maxMatchDist),
+      isLastBlock(true),
       errorFlag(false)
   {
   }
@@ -546,7 +700,8 @@ namespace Ep128Emu {
         if ((startPos + nBytes) > inBufSize)
           nBytes = inBufSize - startPos;
         compressor.compressDataBlock(tmpBuf, inBuf, startPos, nBytes, inBufSize,
-                                     ((startPos + nBytes) >= inBufSize));
+                                     (isLastBlock &&
+                                      (startPos + nBytes) >= inBufSize));
         // append compressed data to output buffer
         size_t  prvSize = outBuf.size();
         if ((startPos % Compressor_ZLib::maxMatchDist) == 0) {
@@ -574,15 +729,15 @@ namespace Ep128Emu {
     }
   }
 
-  // --------------------------------------------------------------------------
+  // compress 32K blocks of 'inBuf' in parallel, and append the packed
+  // output to 'outBuf' (without the ZLib header and checksum)
 
-  void Compressor_ZLib::compressData(std::vector< unsigned char >& outBuf,
-                                     const unsigned char *inBuf,
-                                     size_t inBufSize, size_t blockSize)
+  static void compressDataParallel(std::vector< unsigned char >& outBuf,
+                                   unsigned char& shiftReg,
+                                   const unsigned char *inBuf,
+                                   size_t inBufSize, size_t blockSize,
+                                   int compressionLevel, bool isLastBlock)
   {
-    outBuf.clear();
-    if (inBufSize < 1 || !inBuf)
-      return;
     ZLibCompressorThread  *compressorThreads[DEFLATE_MAX_THREADS];
     for (int i = 0; i < DEFLATE_MAX_THREADS; i++)
       compressorThreads[i] = (ZLibCompressorThread *) 0;
@@ -590,54 +745,28 @@ namespace Ep128Emu {
       size_t  startPos = 0;
       int     nThreads = 0;
       while (nThreads < DEFLATE_MAX_THREADS && startPos < inBufSize) {
-        compressorThreads[nThreads] = new ZLibCompressorThread();
+        compressorThreads[nThreads] =
+            new ZLibCompressorThread(compressionLevel);
         compressorThreads[nThreads]->inBuf = inBuf;
         compressorThreads[nThreads]->inBufSize = inBufSize;
         compressorThreads[nThreads]->startPos = startPos;
         compressorThreads[nThreads]->blockSize = blockSize;
+        compressorThreads[nThreads]->isLastBlock = isLastBlock;
         startPos = startPos + Compressor_ZLib::maxMatchDist;
         nThreads++;
       }
       for (int i = 0; i < nThreads; i++)
         compressorThreads[i]->start();
-      // calculate Adler-32 checksum of input data
-      unsigned int  adler32Sum;
-      {
-        unsigned int  tmp1 = 1U;
-        unsigned int  tmp2 = 0U;
-        for (size_t i = 0; i < inBufSize; i++) {
-          tmp1 = tmp1 + (unsigned int) inBuf[i];
-          if (tmp1 >= 65521U)
-            tmp1 -= 65521U;
-          tmp2 = tmp2 + tmp1;
-          if (tmp2 >= 65521U)
-            tmp2 -= 65521U;
-        }
-        adler32Sum = tmp1 | (tmp2 << 16);
-      }
       for (int i = 0; i < nThreads; i++) {
         compressorThreads[i]->join();
         // startPos is now the read position of the output buffer of the thread
         compressorThreads[i]->startPos = 0;
       }
-      unsigned char shiftReg = 0x80;
-      for (int i = 0; true; i++) {
+      for (int i = 0; nThreads > 0; i++) {
         if (i >= nThreads)
           i = 0;
         if (!compressorThreads[i]) {
           // end of compressed data for all threads
-          if (shiftReg != 0x80) {
-            while (!(shiftReg & 0x01))
-              shiftReg = shiftReg >> 1;
-            shiftReg = (shiftReg >> 1) & 0x7F;
-            outBuf.push_back(shiftReg);
-            shiftReg = 0x80;
-          }
-          // store Adler-32 checksum
-          outBuf.push_back((unsigned char) ((adler32Sum >> 24) & 0xFFU));
-          outBuf.push_back((unsigned char) ((adler32Sum >> 16) & 0xFFU));
-          outBuf.push_back((unsigned char) ((adler32Sum >> 8) & 0xFFU));
-          outBuf.push_back((unsigned char) (adler32Sum & 0xFFU));
           break;
         }
         if (compressorThreads[i]->errorFlag)
@@ -650,46 +779,11 @@ namespace Ep128Emu {
           continue;
         }
         // pack output data
-        if (outBuf.size() < 1) {
-          // write ZLib header:
-          //   CINFO = 7 (32K dictionary size)
-          //   CM = 8 (Deflate method)
-          //   FLEVEL = 3 (high compression level)
-          //   FDICT = 0 (no preset dictionary)
-          //   FCHECK = 26 ((0x78DA % 31) == 0)
-          outBuf.push_back(0x78);
-          outBuf.push_back(0xDA);
-        }
         startPos = compressorThreads[i]->startPos + 1;
         compressorThreads[i]->startPos =
             startPos + size_t(compressorThreads[i]->outBuf[startPos - 1]);
-        for (size_t j = startPos; j < compressorThreads[i]->startPos; j++) {
-          unsigned int  c = compressorThreads[i]->outBuf[j];
-          if (c >= 0x80000000U) {
-            // special case for literal bytes, which are stored byte-aligned
-            if (shiftReg != 0x80) {
-              while (!(shiftReg & 0x01))
-                shiftReg = shiftReg >> 1;
-              shiftReg = (shiftReg >> 1) & 0x7F;
-              outBuf.push_back(shiftReg);
-              shiftReg = 0x80;
-            }
-            outBuf.push_back((unsigned char) (c & 0xFFU));
-          }
-          else {
-            unsigned int  nBits = c >> 24;
-            while (nBits-- > 0U) {
-              unsigned char b = (unsigned char) bool(c & 1U);
-              bool          srFull = bool(shiftReg & 0x01);
-              c = c >> 1;
-              shiftReg = ((shiftReg >> 1) & 0x7F) | (b << 7);
-              if (srFull) {
-                outBuf.push_back(shiftReg);
-                shiftReg = 0x80;
-              }
-            }
-          }
-        }
+        for (size_t j = startPos; j < compressorThreads[i]->startPos; j++)
+          writeDeflateBits(outBuf, shiftReg, compressorThreads[i]->outBuf[j]);
       }
     }
     catch (...) {
@@ -697,6 +791,93 @@ namespace Ep128Emu {
         if (compressorThreads[i])
           delete compressorThreads[i];
       }
+      throw;
+    }
+  }
+
+  // --------------------------------------------------------------------------
+
+  void Compressor_ZLib::compressDataSync(std::vector< unsigned char >& outBuf,
+                                         const unsigned char *inBuf,
+                                         size_t inBufSize, bool writeHeader,
+                                         size_t blockSize)
+  {
+    if (writeHeader) {
+      // ZLib header (see compressData() below)
+      outBuf.push_back(0x78);
+      outBuf.push_back(0xDA);
+    }
+    unsigned char shiftReg = 0x80;
+    if (inBuf && inBufSize > maxMatchDist) {
+      compressDataParallel(outBuf, shiftReg, inBuf, inBufSize, blockSize,
+                           compressionLevel, false);
+    }
+    else if (inBuf && inBufSize > 0) {
+      std::vector< unsigned int > tmpBuf;
+      for (size_t startPos = 0; startPos < inBufSize; ) {
+        size_t  nBytes = blockSize;
+        if ((startPos + nBytes) > inBufSize)
+          nBytes = inBufSize - startPos;
+        compressDataBlock(tmpBuf, inBuf, startPos, nBytes, inBufSize, false);
+        for (size_t i = 0; i < tmpBuf.size(); i++)
+          writeDeflateBits(outBuf, shiftReg, tmpBuf[i]);
+        startPos = startPos + nBytes;
+      }
+    }
+    // sync flush: empty stored block, which also aligns the output to a
+    // byte boundary
+    writeDeflateBits(outBuf, shiftReg, 0x03000000U);
+    writeDeflateBits(outBuf, shiftReg, 0x88000000U);
+    writeDeflateBits(outBuf, shiftReg, 0x88000000U);
+    writeDeflateBits(outBuf, shiftReg, 0x880000FFU);
+    writeDeflateBits(outBuf, shiftReg, 0x880000FFU);
+  }
+
+  // --------------------------------------------------------------------------
+
+  void Compressor_ZLib::compressData(std::vector< unsigned char >& outBuf,
+                                     const unsigned char *inBuf,
+                                     size_t inBufSize, size_t blockSize,
+                                     int compressionLevel_)
+  {
+    outBuf.clear();
+    if (inBufSize < 1 || !inBuf)
+      return;
+    try {
+      // write ZLib header:
+      //   CINFO = 7 (32K dictionary size)
+      //   CM = 8 (Deflate method)
+      //   FLEVEL = 3 (high compression level)
+      //   FDICT = 0 (no preset dictionary)
+      //   FCHECK = 26 ((0x78DA % 31) == 0)
+      outBuf.push_back(0x78);
+      outBuf.push_back(0xDA);
+      unsigned char shiftReg = 0x80;
+      compressDataParallel(outBuf, shiftReg, inBuf, inBufSize, blockSize,
+                           compressionLevel_, true);
+      flushDeflateBits(outBuf, shiftReg);
+      // calculate Adler-32 checksum of input data
+      unsigned int  adler32Sum;
+      {
+        unsigned int  tmp1 = 1U;
+        unsigned int  tmp2 = 0U;
+        for (size_t i = 0; i < inBufSize; i++) {
+          tmp1 = tmp1 + (unsigned int) inBuf[i];
+          if (tmp1 >= 65521U)
+            tmp1 -= 65521U;
+          tmp2 = tmp2 + tmp1;
+          if (tmp2 >= 65521U)
+            tmp2 -= 65521U;
+        }
+        adler32Sum = tmp1 | (tmp2 << 16);
+      }
+      // store Adler-32 checksum
+      outBuf.push_back((unsigned char) ((adler32Sum >> 24) & 0xFFU));
+      outBuf.push_back((unsigned char) ((adler32Sum >> 16) & 0xFFU));
+      outBuf.push_back((unsigned char) ((adler32Sum >> 8) & 0xFFU));
+      outBuf.push_back((unsigned char) (adler32Sum & 0xFFU));
+    }
+    catch (...) {
       outBuf.clear();
       throw;
     }
@@ -737,9 +918,74 @@ namespace Ep128Emu {
     }
   }
 
+  void applyPNGFilters(unsigned char *buf, size_t lineBytes, int h,
+                       int filterType)
+  {
+    // the lines are processed in reverse order, so that the previous line
+    // is not filtered yet
+    int     firstType = (filterType >= 0 ? filterType : 0);
+    int     lastType = (filterType >= 0 ? filterType : 4);
+    if (lastType > 4)
+      throw Exception("invalid PNG filter type");
+    std::vector< unsigned char >  filterBuf((lineBytes + 1) * 5, 0);
+    std::vector< unsigned char >  zeroLine(lineBytes, 0);
+    for (int y = h - 1; y >= 0; y--) {
+      unsigned char *linep = buf + (size_t(y) * (lineBytes + 1));
+      const unsigned char *prvLinep = &(zeroLine.front());
+      if (y > 0)
+        prvLinep = linep - lineBytes;
+      linep++;
+      size_t  bestSize = 0x7FFFFFFF;
+      unsigned char bestType = 0;
+      for (int f = firstType; f <= lastType; f++) {
+        unsigned char *bufp = &(filterBuf[(lineBytes + 1) * size_t(f)]) + 1;
+        size_t  nBytes = 0;
+        for (size_t x = 0; x < lineBytes; x++) {
+          int     a = (x >= 3 ? int(linep[x - 3]) : 0);
+          int     b = int(prvLinep[x]);
+          int     c = (x >= 3 ? int(prvLinep[x - 3]) : 0);
+          int     p = 0;
+          switch (f) {
+          case 1:                         // Sub
+            p = a;
+            break;
+          case 2:                         // Up
+            p = b;
+            break;
+          case 3:                         // Average
+            p = (a + b) >> 1;
+            break;
+          case 4:                         // Paeth
+            {
+              int     pa = (b > c ? (b - c) : (c - b));
+              int     pb = (a > c ? (a - c) : (c - a));
+              int     pc = (a + b) - (c + c);
+              pc = (pc >= 0 ? pc : -pc);
+              p = ((pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c));
+            }
+            break;
+          }
+          unsigned char d = (unsigned char) ((int(linep[x]) - p) & 0xFF);
+          bufp[x] = d;
+          nBytes += size_t(d < 0x80 ? d : (0x100 - d));
+        }
+        if (nBytes < bestSize) {
+          bestSize = nBytes;
+          bestType = (unsigned char) f;
+        }
+      }
+      linep[-1] = bestType;
+      if (bestType) {
+        std::memcpy(linep, &(filterBuf[(lineBytes + 1) * bestType]) + 1,
+                    lineBytes);
+      }
+    }
+  }
+
   void writePNGImage(const char *fileName,
                      const unsigned char *inBuf, int w, int h, int nColors,
-                     bool optimizePalette, size_t blockSize)
+                     bool optimizePalette, size_t blockSize,
+                     int compressionLevel)
   {
     static const char *pngSignature = "\211PNG\r\n\032\n";
 #ifdef PNGWRITE_DEBUG
@@ -823,8 +1069,13 @@ namespace Ep128Emu {
           srcp = srcp + lineBytesI;
           dstp = dstp + lineBytesO;
         }
+        if (!nColors) {
+          // RGB format: select the filter type separately for each line
+          applyPNGFilters(&(imgDataBuf.front()), lineBytesO, h);
+        }
         Compressor_ZLib::compressData(outBuf, &(imgDataBuf.front()),
-                                      imgDataBuf.size(), blockSize);
+                                      imgDataBuf.size(), blockSize,
+                                      compressionLevel);
       }
       f = fileOpen(fileName, "wb");
       if (!f)
@@ -865,7 +1116,8 @@ namespace Ep128Emu {
     }
 #ifdef PNGWRITE_DEBUG
     double  t1 = tt.getRealTime();
-    std::fprintf(stderr, "Compression time = %f\n", t1 - t0);
+    std::fprintf(stderr, "Compression level = %d, time = %f\n",
+                 compressionLevel, t1 - t0);
 #endif
   }
 
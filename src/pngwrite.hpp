@@ -32,6 +32,11 @@ namespace Ep128Emu {
     static const size_t maxMatchDist = 32768;
     static const size_t minMatchLen = 3;
     static const size_t maxMatchLen = 258;
+    // compression levels: hash chain search with lazy matching, or optimal
+    // parsing with fewer (default) or more iterations for the Huffman codes
+    static const int    compressionLevelFast = 0;
+    static const int    compressionLevelDefault = 1;
+    static const int    compressionLevelOptimal = 2;
     // --------------------------------
     struct LZMatchParameters {
       unsigned short  d;
@@ -64,6 +69,10 @@ namespace Ep128Emu {
     // --------------------------------
    private:
     Ep128Compress::LZSearchTable  *searchTable;
+    // for compressionLevelFast: distance of the previous position with the
+    // same hash value in the current 32K block (0: none)
+    std::vector< unsigned short > hashChain;
+    int         compressionLevel;
     // for literals and length codes (size = 288)
     Ep128Compress::HuffmanEncoder huffmanEncoderL;
     // for distance codes (size = 32)
@@ -81,30 +90,65 @@ namespace Ep128Emu {
     void optimizeMatches(LZMatchParameters *matchTable,
                          const unsigned char *inBuf, size_t *bitCountTable,
                          size_t offs, size_t nBytes);
+    void updateHashChain(const unsigned char *inBuf, size_t nBytes);
+    inline size_t findMatchFast(size_t& d, const unsigned char *inBuf,
+                                size_t offs, size_t endPos) const;
+    void findMatchesFast(LZMatchParameters *matchTable,
+                         const unsigned char *inBuf, size_t offs,
+                         size_t nBytes);
     void compressData(std::vector< unsigned int >& outBuf,
                       const unsigned char *inBuf, size_t offs, size_t nBytes,
                       bool firstPass);
    public:
-    Compressor_ZLib();
+    Compressor_ZLib(int compressionLevel_ = compressionLevelDefault);
     virtual ~Compressor_ZLib();
     void compressDataBlock(std::vector< unsigned int >& outBuf,
                            const unsigned char *inBuf, size_t offs,
                            size_t nBytes, size_t bufSize, bool isLastBlock);
-    // 'blockSize' must be a power of two and not greater than 32768,
-    // the optimal value depends on the input data
+    /*!
+     * Compress 'inBufSize' bytes of data as non-final Deflate blocks
+     * followed by a sync flush (empty stored block), and append the output
+     * to 'outBuf'. Matches are not searched in data from previous calls,
+     * but the output can be used to continue an existing Deflate stream.
+     * If 'writeHeader' is true, a ZLib header is written first. There is
+     * no Adler-32 checksum at the end of the data.
+     * Data longer than 32K is compressed in parallel on multiple threads.
+     */
+    void compressDataSync(std::vector< unsigned char >& outBuf,
+                          const unsigned char *inBuf, size_t inBufSize,
+                          bool writeHeader, size_t blockSize = 16384);
+    /*!
+     * Compress 'inBufSize' bytes of data in ZLib format. 32K blocks of the
+     * input data are compressed independently on multiple threads.
+     * 'blockSize' must be a power of two and not greater than 32768,
+     * the optimal value depends on the input data.
+     */
     static void compressData(std::vector< unsigned char >& outBuf,
                              const unsigned char *inBuf, size_t inBufSize,
-                             size_t blockSize = 16384);
+                             size_t blockSize = 16384,
+                             int compressionLevel_ = compressionLevelDefault);
   };
 
   // ==========================================================================
 
+  /*!
+   * Apply PNG filters to 'h' lines of 24-bit RGB image data in 'buf'. Each
+   * line is a filter type byte followed by 'lineBytes' bytes of pixel data,
+   * and the filter type is stored in the first byte. 'filterType' is 0 to 4
+   * to use the same filter on all lines, or -1 to select the filter with the
+   * smallest sum of absolute differences separately for each line.
+   */
+  void applyPNGFilters(unsigned char *buf, size_t lineBytes, int h,
+                       int filterType = -1);
+
   /*!
    * Save a PNG format image to 'fileName' from the data in 'inBuf'.
    * 'w' and 'h' are the image width and height in pixels, 'nColors' is the
    * palette size (0 to 256, 0 means RGB format), and 'blockSize' is the block
    * size to be used by Compressor_ZLib::compressData(). If 'optimizePalette'
-   * is true, unused colors are removed from the palette.
+   * is true, unused colors are removed from the palette. 'compressionLevel'
+   * is one of the Compressor_ZLib::compressionLevel* constants. For RGB
+   * images, the PNG filter type is selected separately for each line.
    * The size of 'inBuf' should be nColors * 3 + w * h bytes if a palette is
    * used, and w * h * 3 in the case of RGB format. If a palette is present,
    * it is expected to be at the beginning of 'inBuf' as nColors * 3
@@ -112,7 +156,9 @@ namespace Ep128Emu {
    */
   void writePNGImage(const char *fileName,
                      const unsigned char *inBuf, int w, int h, int nColors,
-                     bool optimizePalette = false, size_t blockSize = 16384);
+                     bool optimizePalette = false, size_t blockSize = 16384,
+                     int compressionLevel =
+                         Compressor_ZLib::compressionLevelDefault);
 
 }       // namespace Ep128Emu
 
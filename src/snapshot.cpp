@@ -169,6 +169,182 @@ namespace Ep128 {
     return isPlayingDemo;
   }
 
+  bool Ep128VM::cloneState(Ep128Emu::MachineState& s)
+  {
+    if (isRecordingDemo || isPlayingDemo ||
+        demoFile != (Ep128Emu::File *) 0 || singleStepMode ||
+        videoCapture != (Ep128Emu::VideoCapture *) 0 || fileIOEnabled ||
+        getTapeButtonState() != 0 ||
+        memory.getHaveBreakPoints() || ioPorts.getHaveBreakPoints()) {
+      return false;
+    }
+    // the state of a disk I/O command in progress is not included
+    if ((wd177x.readStatusRegisterDebug() & 0x01) != 0 ||
+        ideInterface->getIsBusy()) {
+      return false;
+    }
+    for (int i = 0; i < 4; i++) {
+      if (floppyDrives[i].isDataTransfer())
+        return false;
+    }
+    // restoreState() cannot undo sectors written to the disk image files
+    if (ideInterface->haveWritableImageFile())
+      return false;
+    for (int i = 0; i < 4; i++) {
+      if (floppyDrives[i].haveDisk() && !floppyDrives[i].getIsWriteProtected())
+        return false;
+    }
+#ifdef ENABLE_SDEXT
+    if (sdext.isSDExtSegment(0x07))
+      return false;
+#endif
+#ifdef ENABLE_RESID
+    if (sidModel)
+      return false;
+#endif
+#ifdef ENABLE_MIDI_PORT
+    if (midiDevFlags != 0xFF)
+      return false;
+#endif
+    z80.cloneState(s);
+    memory.cloneState(s);
+    ioPorts.cloneState(s);
+    dave.cloneState(s);
+    nick.cloneState(s);
+    {
+      int8_t  n = -1;
+      for (int i = 0; i < 4; i++) {
+        if (&(wd177x.getFloppyDrive()) == &(floppyDrives[i]))
+          n = int8_t(i);
+      }
+      s.write(n);
+    }
+    wd177x.cloneState(s);
+    for (int i = 0; i < 4; i++)
+      floppyDrives[i].cloneState(s);
+    ideInterface->cloneState(s);
+    s.write(pageTable);
+    s.write(nickCyclesRemainingL);
+    s.write(nickCyclesRemainingH);
+    s.write(cpuCyclesRemaining);
+    s.write(daveCyclesRemaining);
+    s.write(memoryWaitCycles_M1);
+    s.write(memoryWaitCycles);
+    s.write(memoryWaitMode);
+    s.write(tapeCallbackFlag);
+    s.write(remoteControlState);
+    s.write(soundOutputSignal);
+    s.write(externalDACOutput);
+    s.write(cmosMemoryRegisterSelect);
+    s.write(spectrumEmulatorEnabled);
+    s.write(spectrumEmulatorIOPorts);
+    s.write(cmosMemory);
+    s.write(prvRTCTime);
+    // the callback list is stored with offsets instead of pointers, and the
+    // user data pointer of all callbacks is either NULL or this object
+    for (int i = 0; i < 16; i++) {
+      s.write(callbacks[i].func);
+      s.writePointer(callbacks[i].userData, this);
+      s.writePointer(callbacks[i].nxt, &(callbacks[0]));
+    }
+    s.writePointer(firstCallback, &(callbacks[0]));
+    s.write(externalDACIOPorts);
+    s.write(tapeSamplesRemaining);
+    s.write(mouseEmulationEnabled);
+    s.write(prvB7PortState);
+    s.write(mouseTimer);
+    s.write(mouseData);
+    s.write(mouseDeltaX);
+    s.write(mouseDeltaY);
+    s.write(mouseButtonState);
+    s.write(mouseWheelDelta);
+    return true;
+  }
+
+  void Ep128VM::restoreState(Ep128Emu::MachineState& s)
+  {
+    z80.restoreState(s);
+    memory.restoreState(s);
+    ioPorts.restoreState(s);
+    dave.restoreState(s);
+    nick.restoreState(s);
+    {
+      int8_t  n = -1;
+      s.read(n);
+      wd177x.setFloppyDrive(n >= 0 ? &(floppyDrives[n & 3])
+                                   : (Ep128Emu::FloppyDrive *) 0);
+    }
+    wd177x.restoreState(s);
+    for (int i = 0; i < 4; i++)
+      floppyDrives[i].restoreState(s);
+    ideInterface->restoreState(s);
+    s.read(pageTable);
+    s.read(nickCyclesRemainingL);
+    s.read(nickCyclesRemainingH);
+    s.read(cpuCyclesRemaining);
+    s.read(daveCyclesRemaining);
+    s.read(memoryWaitCycles_M1);
+    s.read(memoryWaitCycles);
+    s.read(memoryWaitMode);
+    s.read(tapeCallbackFlag);
+    s.read(remoteControlState);
+    s.read(soundOutputSignal);
+    s.read(externalDACOutput);
+    s.read(cmosMemoryRegisterSelect);
+    s.read(spectrumEmulatorEnabled);
+    s.read(spectrumEmulatorIOPorts);
+    s.read(cmosMemory);
+    s.read(prvRTCTime);
+    for (int i = 0; i < 16; i++) {
+      s.read(callbacks[i].func);
+      s.readPointer(callbacks[i].userData, this);
+      s.readPointer(callbacks[i].nxt, &(callbacks[0]));
+    }
+    s.readPointer(firstCallback, &(callbacks[0]));
+    s.read(externalDACIOPorts);
+    s.read(tapeSamplesRemaining);
+    s.read(mouseEmulationEnabled);
+    s.read(prvB7PortState);
+    s.read(mouseTimer);
+    s.read(mouseData);
+    s.read(mouseDeltaX);
+    s.read(mouseDeltaY);
+    s.read(mouseButtonState);
+    s.read(mouseWheelDelta);
+    setTapeMotorState(bool(remoteControlState));
+  }
+
+  void Ep128VM::forkState(Ep128VM& vm)
+  {
+    if (&vm == this)
+      return;
+    Ep128Emu::MachineState  s;
+    if (!cloneState(s)) {
+      throw Ep128Emu::Exception("cannot copy the machine state while tape or "
+                                "disk I/O, demo recording, or debugging "
+                                "is in progress, or a disk image is "
+                                "writable");
+    }
+    vm.stopDemo();
+    vm.setCPUFrequency(cpuFrequency);
+    vm.setSoundClockFrequency(daveFrequency);
+    vm.setVideoFrequency(nickFrequency);
+    vm.waitCycleCnt = waitCycleCnt;
+    vm.videoMemoryLatency = videoMemoryLatency;
+    vm.videoMemoryLatency_M1 = videoMemoryLatency_M1;
+    vm.videoMemoryLatency_IO = videoMemoryLatency_IO;
+    vm.updateTimingParameters();
+    vm.setEnableMemoryTimingEmulation(memoryTimingEnabled);
+    {
+      // copy all ROM and RAM segments
+      Ep128Emu::File::Buffer  buf;
+      memory.saveState(buf);
+      vm.memory.loadState(buf);
+    }
+    s.rewind();
+    vm.restoreState(s);
+  }
+
   // --------------------------------------------------------------------------
 
   void Ep128VM::loadState(Ep128Emu::File::Buffer& buf)
@@ -197,6 +197,13 @@ namespace Ep128Emu {
     outputSampleRate = sampleRate_;
   }
 
+  void AudioConverter::sendHeldInputSignal(uint32_t audioInput,
+                                           size_t nSamples)
+  {
+    for ( ; nSamples > 0; nSamples--)
+      sendInputSignal(audioInput);
+  }
+
   void AudioConverter::setDCBlockFilters(float frq1, float frq2)
   {
     dcBlock1L.setCutoffFrequency(frq1);
@@ -352,6 +359,33 @@ namespace Ep128Emu {
     } while (winPosInt < windowSize);
   }
 
+  inline void AudioConverterHighQuality::ResampleWindow::processStep(
+      float inL, float inR, float *outBufL, float *outBufR,
+      int outBufSize, float bufPos, const float *stepTable)
+  {
+    // the first input sample after the step is at bufPos, the output
+    // samples before bufPos - 5 have already been read, and the window is
+    // zero there
+    int      writePos = int(bufPos);
+    float    posFrac = bufPos - writePos;
+    float    winPos = (1.0f - posFrac) * float(windowSize / 12);
+    int      winPosInt = int(winPos);
+    float    winPosFrac = winPos - winPosInt;
+    writePos -= 5;
+    while (writePos < 0)
+      writePos += outBufSize;
+    do {
+      float   w = stepTable[winPosInt]
+                  + ((stepTable[winPosInt + 1] - stepTable[winPosInt])
+                     * winPosFrac);
+      outBufL[writePos] += inL * w;
+      outBufR[writePos] += inR * w;
+      if (++writePos >= outBufSize)
+        writePos = 0;
+      winPosInt += (windowSize / 12);
+    } while (winPosInt < windowSize);
+  }
+
   AudioConverterHighQuality::ResampleWindow::ResampleWindow()
   {
     double  pi = std::atan(1.0) * 4.0;
@@ -365,12 +399,52 @@ namespace Ep128Emu {
                                * (std::sin(phs) / phs));
       phs += phsInc;
     }
+    // integrate the window (in output sample units)
+    double  sum = 0.0;
+    for (int i = 1; i <= windowSize; i++) {
+      sum += ((double(windowTable[i - 1]) + double(windowTable[i])) * 0.5
+              / double(windowSize / 12));
+    }
+    stepAmplitude = float(sum);
+  }
+
+  void AudioConverterHighQuality::ResampleWindow::calculateStepTable(
+      float *stepTable, float resampleRatio) const
+  {
+    // the window is interpolated in the same way as in processSample(),
+    // rather than integrated, so that the step matches the output of
+    // sending the samples one at a time, also at low input sample rates
+    double  winPosInc = double(resampleRatio) * double(windowSize / 12);
+    for (int i = 0; i <= windowSize; i++) {
+      double  sum = 0.0;
+      for (double winPos = double(i); winPos >= 0.0; winPos -= winPosInc) {
+        int     winPosInt = int(winPos);
+        double  w = windowTable[winPosInt];
+        if (winPosInt < windowSize) {
+          w += ((double(windowTable[winPosInt + 1]) - w)
+                * (winPos - double(winPosInt)));
+        }
+        sum += w;
+      }
+      stepTable[i] = float(sum * double(resampleRatio) - stepAmplitude);
+    }
   }
 
   AudioConverterHighQuality::ResampleWindow AudioConverterHighQuality::window;
 
+  void AudioConverterHighQuality::endHeldInputSignal()
+  {
+    window.processStep(-(heldInputL / resampleRatio),
+                       -(heldInputR / resampleRatio),
+                       bufL, bufR, bufSize, bufPos, stepTable);
+    heldInputL = 0.0f;
+    heldInputR = 0.0f;
+  }
+
   void AudioConverterHighQuality::sendInputSignal(uint32_t audioInput)
   {
+    if (EP128EMU_UNLIKELY(heldInputL != 0.0f || heldInputR != 0.0f))
+      endHeldInputSignal();
     float   left = float(int(audioInput & 0xFFFF));
     float   right = float(int(audioInput >> 16));
     window.processSample(left, right, bufL, bufR, bufSize, bufPos);
@@ -394,6 +468,8 @@ namespace Ep128Emu {
 
   void AudioConverterHighQuality::sendMonoInputSignal(int32_t audioInput)
   {
+    if (EP128EMU_UNLIKELY(heldInputL != 0.0f || heldInputR != 0.0f))
+      endHeldInputSignal();
     float   left = float(audioInput);
     window.processSample(left, bufL, bufSize, bufPos);
     bufPos += resampleRatio;
@@ -411,6 +487,48 @@ namespace Ep128Emu {
     }
   }
 
+  void AudioConverterHighQuality::sendHeldInputSignal(uint32_t audioInput,
+                                                      size_t nSamples)
+  {
+    if (nSamples < 1)
+      return;
+    // instead of resampling each input sample, only the changes in the
+    // input level are added as band-limited steps to the output buffer
+    float   left = float(int(audioInput & 0xFFFF));
+    float   right = float(int(audioInput >> 16));
+    if (left != heldInputL || right != heldInputR) {
+      window.processStep((left - heldInputL) / resampleRatio,
+                         (right - heldInputR) / resampleRatio,
+                         bufL, bufR, bufSize, bufPos, stepTable);
+      heldInputL = left;
+      heldInputR = right;
+    }
+    left = left * window.stepAmplitude;
+    right = right * window.stepAmplitude;
+    // the position is still advanced one input sample at a time, exactly
+    // as in sendInputSignal(), because adding the time of multiple samples
+    // at once rounds differently, and the output would drift away from the
+    // per sample resampling over time
+    do {
+      bufPos += resampleRatio;
+      if (bufPos >= nxtPos) {
+        if (bufPos >= float(bufSize))
+          bufPos -= float(bufSize);
+        nxtPos = float(int(bufPos) + 1);
+        int     readPos = int(bufPos) - 6;
+        while (readPos < 0)
+          readPos += bufSize;
+        float   outL = bufL[readPos] * resampleRatio + left;
+        bufL[readPos] = 0.0f;
+        float   outR = bufR[readPos] * resampleRatio + right;
+        bufR[readPos] = 0.0f;
+        sendOutputSignal(
+            eqL.process(dcBlock2L.process(dcBlock1L.process(outL))),
+            eqR.process(dcBlock2R.process(dcBlock1R.process(outR))));
+      }
+    } while (--nSamples);
+  }
+
   AudioConverterHighQuality::AudioConverterHighQuality(float inputSampleRate_,
                                                        float outputSampleRate_,
                                                        float dcBlockFreq1,
@@ -426,6 +544,9 @@ namespace Ep128Emu {
     bufPos = 0.0f;
     nxtPos = 1.0f;
     resampleRatio = outputSampleRate_ / inputSampleRate_;
+    heldInputL = 0.0f;
+    heldInputR = 0.0f;
+    window.calculateStepTable(&(stepTable[0]), resampleRatio);
   }
 
   AudioConverterHighQuality::~AudioConverterHighQuality()
@@ -436,12 +557,14 @@ namespace Ep128Emu {
   {
     inputSampleRate = sampleRate_;
     resampleRatio = outputSampleRate / inputSampleRate;
+    window.calculateStepTable(&(stepTable[0]), resampleRatio);
   }
 
   void AudioConverterHighQuality::setOutputSampleRate(float sampleRate_)
   {
     outputSampleRate = sampleRate_;
     resampleRatio = outputSampleRate / inputSampleRate;
+    window.calculateStepTable(&(stepTable[0]), resampleRatio);
   }
 
 }       // namespace Ep128Emu
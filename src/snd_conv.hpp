@@ -61,6 +61,8 @@ namespace Ep128Emu {
     virtual ~AudioConverter();
     virtual void sendInputSignal(uint32_t audioInput) = 0;
     virtual void sendMonoInputSignal(int32_t audioInput) = 0;
+    // send 'nSamples' input samples with the same value
+    virtual void sendHeldInputSignal(uint32_t audioInput, size_t nSamples);
     virtual void setInputSampleRate(float sampleRate_);
     virtual void setOutputSampleRate(float sampleRate_);
     void setDCBlockFilters(float frq1, float frq2);
@@ -93,16 +95,28 @@ namespace Ep128Emu {
   class AudioConverterHighQuality : public AudioConverter {
    private:
     class ResampleWindow {
-     private:
+     public:
       static const int windowSize = 12 * 128;
+     private:
       float   windowTable[12 * 128 + 1];
      public:
+      // total area of the window in output sample units
+      float   stepAmplitude;
       ResampleWindow();
       inline void processSample(float inL, float inR,
                                 float *outBufL, float *outBufR,
                                 int outBufSize, float bufPos);
       inline void processSample(float inL, float *outBufL,
                                 int outBufSize, float bufPos);
+      inline void processStep(float inL, float inR,
+                              float *outBufL, float *outBufR,
+                              int outBufSize, float bufPos,
+                              const float *stepTable);
+      // calculate the band-limited step for 'resampleRatio': the sum of the
+      // window (multiplied by 'resampleRatio') at the positions of all input
+      // samples from the step, minus stepAmplitude; this is the same as
+      // calling processSample() for each sample
+      void calculateStepTable(float *stepTable, float resampleRatio) const;
     };
     static ResampleWindow window;
     static const int bufSize = 16;
@@ -110,7 +124,13 @@ namespace Ep128Emu {
     float   bufR[16];
     float   bufPos, nxtPos;
     float   resampleRatio;
+    // input level sent with sendHeldInputSignal(), which is synthesized
+    // from band-limited steps at the output sample rate
+    float   heldInputL, heldInputR;
+    // band-limited step for the current resampleRatio
+    float   stepTable[ResampleWindow::windowSize + 1];
     // ----------------
+    void endHeldInputSignal();
    public:
     AudioConverterHighQuality(float inputSampleRate_,
                               float outputSampleRate_,
@@ -120,6 +140,7 @@ namespace Ep128Emu {
     virtual ~AudioConverterHighQuality();
     virtual void sendInputSignal(uint32_t audioInput);
     virtual void sendMonoInputSignal(int32_t audioInput);
+    virtual void sendHeldInputSignal(uint32_t audioInput, size_t nSamples);
     virtual void setInputSampleRate(float sampleRate_);
     virtual void setOutputSampleRate(float sampleRate_);
   };
@@ -29,8 +29,12 @@
 #  include <sys/time.h>
 #  include <unistd.h>
 #  include <pthread.h>
+#  include <time.h>
 #  if defined(__linux) || defined(__linux__)
 #    include <sys/resource.h>
+#    if defined(CLOCK_MONOTONIC) && defined(TIMER_ABSTIME)
+#      define HAVE_CLOCK_NANOSLEEP  1
+#    endif
 #  endif
 #endif
 
@@ -262,6 +266,10 @@ namespace Ep128Emu {
     LARGE_INTEGER   tmp;
     QueryPerformanceCounter(&tmp);
     return (uint64_t(tmp.u.LowPart) + (uint64_t(tmp.u.HighPart) << 32));
+#elif defined(HAVE_CLOCK_NANOSLEEP)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t(ts.tv_nsec) + (uint64_t(ts.tv_sec) * 1000000000U));
 #else
     struct timeval  tv;
     gettimeofday(&tv, NULL);
@@ -276,6 +284,8 @@ namespace Ep128Emu {
     QueryPerformanceFrequency(&tmp);
     secondsPerTick = 1.0 / double(int64_t(tmp.u.LowPart)
                                   + (int64_t(tmp.u.HighPart) << 32));
+#elif defined(HAVE_CLOCK_NANOSLEEP)
+    secondsPerTick = 0.000000001;
 #else
     secondsPerTick = 0.000001;
 #endif
@@ -313,6 +323,26 @@ namespace Ep128Emu {
 #endif
   }
 
+  void Timer::waitUntil(double t)
+  {
+#ifdef HAVE_CLOCK_NANOSLEEP
+    if (!(t > 0.0))
+      return;
+    uint64_t  endTime = startTime + uint64_t(t / secondsPerTick + 0.5);
+    struct timespec ts;
+    ts.tv_sec = time_t(endTime / 1000000000U);
+    ts.tv_nsec = long(endTime % 1000000000U);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)
+           == EINTR) {
+      ;
+    }
+#else
+    t = t - getRealTime();
+    if (t > 0.0)
+      wait(t);
+#endif
+  }
+
   uint32_t Timer::getRandomSeedFromTime()
   {
     uint32_t  tmp1 = uint32_t(getRealTime_() & 0xFFFFFFFFUL);
@@ -155,6 +155,12 @@ namespace Ep128Emu {
     void reset();
     void reset(double t);
     static void wait(double t);
+    /*!
+     * Wait until getRealTime() reaches 't' seconds. Where available, this
+     * sleeps until an absolute deadline on the monotonic clock, so the
+     * error does not accumulate over many calls.
+     */
+    void waitUntil(double t);
     static uint32_t getRandomSeedFromTime();
   };
 
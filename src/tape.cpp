@@ -22,6 +22,7 @@
 #include "system.hpp"
 
 #include <cmath>
+#include <algorithm>
 #include <sndfile.h>
 
 static const char *epteFileMagic = "ENTERPRISE 128K TAPE FILE       ";
@@ -1651,6 +1652,173 @@ namespace Ep128Emu {
 
   // --------------------------------------------------------------------------
 
+  class Tape_SoundFile::PulseDecoder : public Thread {
+   private:
+    // limit the size of the pulse tables to about 100 MB; files with more
+    // pulses than this (e.g. noisy input at high sample resolution) are
+    // streamed instead
+    static const size_t maxPulses = 0x02000000;
+    std::string fileName;
+    size_t      nSamples;
+    int         channel;
+    int         bitsPerSample;
+    bool        enableFIRFilter;
+    TapeFilter  firFilter;
+    Mutex       mutex;
+    bool        abortFlag;
+    bool        isFinished;
+    bool        isValid;
+    size_t      pulseStart;
+    // ----------------
+    bool addPulse(size_t len, int level);
+    bool decodeFile(SNDFILE *f, int nChannels);
+   public:
+    std::vector< uint16_t > pulseLengths;
+    std::vector< uint8_t >  pulseLevels;
+    std::vector< uint32_t > pulseIndex;
+    // ----------------
+    PulseDecoder(const std::string& fileName_, size_t nSamples_,
+                 long sampleRate_, int channel_, int bitsPerSample_,
+                 bool enableFIRFilter_,
+                 float filterMinFreq_, float filterMaxFreq_);
+    virtual ~PulseDecoder();
+    // returns true if the thread has finished, and stores in 'isValid_'
+    // if the pulse tables are complete
+    bool getStatus(bool& isValid_);
+   protected:
+    virtual void run();
+  };
+
+  Tape_SoundFile::PulseDecoder::PulseDecoder(const std::string& fileName_,
+                                             size_t nSamples_,
+                                             long sampleRate_, int channel_,
+                                             int bitsPerSample_,
+                                             bool enableFIRFilter_,
+                                             float filterMinFreq_,
+                                             float filterMaxFreq_)
+    : Thread(),
+      fileName(fileName_),
+      nSamples(nSamples_),
+      channel(channel_),
+      bitsPerSample(bitsPerSample_),
+      enableFIRFilter(enableFIRFilter_),
+      firFilter(2048),
+      abortFlag(false),
+      isFinished(false),
+      isValid(false),
+      pulseStart(0)
+  {
+    if (enableFIRFilter) {
+      firFilter.setFilterParameters(float(sampleRate_),
+                                    filterMinFreq_, filterMaxFreq_);
+    }
+  }
+
+  Tape_SoundFile::PulseDecoder::~PulseDecoder()
+  {
+    mutex.lock();
+    abortFlag = true;
+    mutex.unlock();
+    join();
+  }
+
+  bool Tape_SoundFile::PulseDecoder::getStatus(bool& isValid_)
+  {
+    mutex.lock();
+    bool    retval = isFinished;
+    isValid_ = isValid;
+    mutex.unlock();
+    return retval;
+  }
+
+  bool Tape_SoundFile::PulseDecoder::addPulse(size_t len, int level)
+  {
+    size_t  n = pulseLengths.size();
+    if (n >= maxPulses)
+      return false;
+    if (!(n & 0xFF))
+      pulseIndex.push_back(uint32_t(pulseStart));
+    pulseLengths.push_back(uint16_t(len));
+    pulseLevels.push_back(uint8_t(level));
+    pulseStart = pulseStart + len;
+    return true;
+  }
+
+  bool Tape_SoundFile::PulseDecoder::decodeFile(SNDFILE *f, int nChannels)
+  {
+    if (nSamples < 1 || channel >= nChannels)
+      return false;
+    std::vector< short >  inBuf(size_t(nChannels) << 14);
+    size_t  pos = 0;
+    size_t  curLen = 0;
+    int     curLevel = -1;
+    while (pos < nSamples) {
+      mutex.lock();
+      bool    abortFlag_ = abortFlag;
+      mutex.unlock();
+      if (abortFlag_)
+        return false;
+      size_t  n = nSamples - pos;
+      n = (n < 16384 ? n : 16384);
+      if (sf_readf_short(f, &(inBuf.front()), sf_count_t(n)) != sf_count_t(n))
+        return false;
+      const short *p = &(inBuf.front()) + channel;
+      for (size_t i = 0; i < n; i++, p = p + nChannels) {
+        // same conversion as in Tape_SoundFile::runOneSample_()
+        int     tmp = *p;
+        if (enableFIRFilter) {
+          float   tmp2 = firFilter.processSample(float(tmp));
+          tmp = int(tmp2 + (tmp2 >= 0.0f ? 0.5f : -0.5f));
+        }
+        tmp = tmp + 32768;
+        tmp = (tmp >= 0 ? (tmp <= 65535 ? tmp : 65535) : 0);
+        int     level = tmp >> (16 - bitsPerSample);
+        if (level == curLevel && curLen < 65535) {
+          curLen++;
+          continue;
+        }
+        if (curLen > 0) {
+          if (!addPulse(curLen, curLevel))
+            return false;
+        }
+        curLevel = level;
+        curLen = 1;
+      }
+      pos = pos + n;
+    }
+    return addPulse(curLen, curLevel);
+  }
+
+  void Tape_SoundFile::PulseDecoder::run()
+  {
+    bool    retval = false;
+    SF_INFO sfinfo;
+    std::memset(&sfinfo, 0, sizeof(SF_INFO));
+    SNDFILE *f = sf_open(fileName.c_str(), SFM_READ, &sfinfo);
+    if (f) {
+      try {
+        if (sfinfo.frames == sf_count_t(nSamples))
+          retval = decodeFile(f, sfinfo.channels);
+      }
+      catch (std::exception&) {
+        // not enough memory: fall back to streaming
+        retval = false;
+      }
+      (void) sf_close(f);
+    }
+    if (!retval) {
+      std::vector< uint16_t >().swap(pulseLengths);
+      std::vector< uint8_t >().swap(pulseLevels);
+      std::vector< uint32_t >().swap(pulseIndex);
+    }
+    mutex.lock();
+    isFinished = true;
+    isValid = retval;
+    mutex.unlock();
+  }
+
+  // --------------------------------------------------------------------------
+
   bool Tape_SoundFile::writeBuffer_()
   {
     sf_count_t  filePos = sf_count_t((tapePosition >> 10) << 10);
@@ -1662,13 +1830,102 @@ namespace Ep128Emu {
     size_t  endPos = filePos + size_t(n);
     if (endPos > tapeLength)
       tapeLength = endPos;
+    isFileChanged = true;
     return (n == 1024L);
   }
 
+  void Tape_SoundFile::readBuffer_(short fillValue)
+  {
+    // FIXME: should check for errors ?
+    (void) sf_seek(sf, sf_count_t((tapePosition >> 10) << 10), SEEK_SET);
+    // fill buffer
+    int   n = int(sf_readf_short(sf, &(buf.front()), sf_count_t(1024)));
+    n = (n >= 0 ? n : 0) * nChannels;
+    for ( ; n < int(buf.size()); n++)
+      buf[n] = fillValue;
+  }
+
+  void Tape_SoundFile::seekPulse_(size_t pos)
+  {
+    if (pos >= tapeLength) {
+      pulseNum = pulseLevels.size() - 1;
+      pulseSamplesLeft = 1;
+      return;
+    }
+    size_t  i = size_t(std::upper_bound(pulseIndex.begin(), pulseIndex.end(),
+                                        uint32_t(pos))
+                       - pulseIndex.begin()) - 1;
+    size_t  startPos = pulseIndex[i];
+    pulseNum = i << 8;
+    while ((startPos + pulseLengths[pulseNum]) <= pos) {
+      startPos = startPos + pulseLengths[pulseNum];
+      pulseNum++;
+    }
+    pulseSamplesLeft = (startPos + pulseLengths[pulseNum]) - pos;
+  }
+
+  void Tape_SoundFile::startPulseDecoder_()
+  {
+    stopPulseDecoder_();
+    isFileChanged = false;
+    if (!enablePreDecode || tapeLength < 1)
+      return;
+    try {
+      pulseDecoder = new PulseDecoder(fileName, tapeLength, sampleRate,
+                                      requestedChannel, requestedBitsPerSample,
+                                      enableFIRFilter,
+                                      filterMinFreq, filterMaxFreq);
+      pulseDecoder->start();
+    }
+    catch (std::exception&) {
+      // pre-decoding is optional, continue with streaming
+      pulseDecoder = (PulseDecoder *) 0;
+    }
+  }
+
+  void Tape_SoundFile::stopPulseDecoder_()
+  {
+    if (pulseDecoder) {
+      delete pulseDecoder;
+      pulseDecoder = (PulseDecoder *) 0;
+    }
+    if (havePulseData) {
+      // switch back to streaming from the current position
+      havePulseData = false;
+      std::vector< uint16_t >().swap(pulseLengths);
+      std::vector< uint8_t >().swap(pulseLevels);
+      std::vector< uint32_t >().swap(pulseIndex);
+      readBuffer_(0);
+    }
+  }
+
+  bool Tape_SoundFile::checkPulseDecoder_()
+  {
+    bool    isValid = false;
+    if (isRecordOn || !pulseDecoder->getStatus(isValid))
+      return false;
+    // the tables are not used if the file has been written in the meantime
+    if (isValid && !(isBufferDirty || isFileChanged)) {
+      pulseLengths.swap(pulseDecoder->pulseLengths);
+      pulseLevels.swap(pulseDecoder->pulseLevels);
+      pulseIndex.swap(pulseDecoder->pulseIndex);
+      havePulseData = true;
+      seekPulse_(tapePosition);
+    }
+    delete pulseDecoder;
+    pulseDecoder = (PulseDecoder *) 0;
+    return havePulseData;
+  }
+
   void Tape_SoundFile::seek_(size_t pos_)
   {
     // clamp position to tape length
     size_t  pos = (pos_ < tapeLength ? pos_ : tapeLength);
+    if (havePulseData) {
+      tapePosition = pos;
+      seekPulse_(pos);
+      return;
+    }
     size_t  oldBlockNum = (tapePosition >> 10);
     size_t  newBlockNum = (pos >> 10);
 
@@ -1685,13 +1942,8 @@ namespace Ep128Emu {
       err = true;
     }
     tapePosition = pos;
-    // FIXME: should check for errors ?
-    (void) sf_seek(sf, sf_count_t(newBlockNum << 10), SEEK_SET);
-    // fill buffer
-    int   n = int(sf_readf_short(sf, &(buf.front()), sf_count_t(1024)));
-    n = (n >= 0 ? n : 0) * nChannels;
-    for ( ; n < int(buf.size()); n++)
-      buf[n] = 0;
+    if (!(pulseDecoder && checkPulseDecoder_()))
+      readBuffer_(0);
     if (err)
       throw Exception("error writing tape file - is the disk full ?");
   }
@@ -1714,10 +1966,19 @@ namespace Ep128Emu {
       requestedChannel(0),
       enableFIRFilter(false),
       isBufferDirty(false),
-      firFilter(2048)
+      isFileChanged(false),
+      enablePreDecode(false),
+      havePulseData(false),
+      firFilter(2048),
+      filterMinFreq(500.0f),
+      filterMaxFreq(5000.0f),
+      pulseDecoder((PulseDecoder *) 0),
+      pulseNum(0),
+      pulseSamplesLeft(0)
   {
     if (fileName == (char *) 0 || fileName[0] == '\0')
       throw Exception("invalid tape file name");
+    this->fileName = fileName;
     if (!(mode >= 0 && mode <= 2))
       throw Exception("invalid tape open mode parameter");
     isReadOnly = (mode == 2);
@@ -1797,6 +2058,8 @@ namespace Ep128Emu {
 
   Tape_SoundFile::~Tape_SoundFile()
   {
+    if (pulseDecoder)
+      delete pulseDecoder;
     // flush any pending file changes, and close file
     // FIXME: errors are not handled here
     try {
@@ -1809,6 +2072,25 @@ namespace Ep128Emu {
 
   void Tape_SoundFile::runOneSample_()
   {
+    if (havePulseData) {
+      if (EP128EMU_EXPECT(!isRecordOn)) {
+        if (EP128EMU_EXPECT(tapePosition < tapeLength)) {
+          outputState = pulseLevels[pulseNum];
+          tapePosition++;
+          if (--pulseSamplesLeft == 0 && (pulseNum + 1) < pulseLevels.size()) {
+            pulseNum++;
+            pulseSamplesLeft = pulseLengths[pulseNum];
+          }
+        }
+        else {
+          // end of tape: same level as the padding in streaming mode
+          outputState = 32767 >> (16 - requestedBitsPerSample);
+        }
+        return;
+      }
+      // recording overwrites the file, so continue with streaming
+      stopPulseDecoder_();
+    }
     int   bufPos = (int(tapePosition & 0x03FF) * nChannels) + requestedChannel;
     int   tmp = buf[bufPos];
     if (isRecordOn) {
@@ -1857,13 +2139,9 @@ namespace Ep128Emu {
       err = true;
     }
     tapePosition = pos;
-    // FIXME: should check for errors ?
-    (void) sf_seek(sf, sf_count_t(newBlockNum << 10), SEEK_SET);
-    // fill buffer
-    int   n = int(sf_readf_short(sf, &(buf.front()), sf_count_t(1024)));
-    n = (n >= 0 ? n : 0) * nChannels;
-    for ( ; n < int(buf.size()); n++)
-      buf[n] = short(-1);
+    // switch to the pulse tables if the pre-decoding has finished
+    if (!(pulseDecoder && checkPulseDecoder_()))
+      readBuffer_(short(-1));
     if (err)
       throw Exception("error writing tape file - is the disk full ?");
   }
@@ -1880,6 +2158,9 @@ namespace Ep128Emu {
     isPlaybackOn = false;
     isRecordOn = false;
     flushBuffer_();
+    // decode the file again if it has been recorded to
+    if (isFileChanged && enablePreDecode)
+      startPulseDecoder_();
   }
 
   void Tape_SoundFile::seek(double t)
@@ -1910,17 +2191,30 @@ namespace Ep128Emu {
   void Tape_SoundFile::setParameters(int requestedChannel_,
                                      bool enableFIRFilter_,
                                      float filterMinFreq_,
-                                     float filterMaxFreq_)
+                                     float filterMaxFreq_,
+                                     bool enablePreDecode_)
   {
-    requestedChannel =
+    requestedChannel_ =
         (requestedChannel_ >= 0 ?
          (requestedChannel_ < nChannels ? requestedChannel_ : (nChannels - 1))
          : 0);
+    bool    isChanged =
+        (requestedChannel_ != requestedChannel ||
+         enableFIRFilter_ != enableFIRFilter ||
+         (enableFIRFilter_ && (filterMinFreq_ != filterMinFreq ||
+                               filterMaxFreq_ != filterMaxFreq)) ||
+         enablePreDecode_ != enablePreDecode);
+    requestedChannel = requestedChannel_;
     enableFIRFilter = enableFIRFilter_;
+    filterMinFreq = filterMinFreq_;
+    filterMaxFreq = filterMaxFreq_;
+    enablePreDecode = enablePreDecode_;
     if (enableFIRFilter) {
       firFilter.setFilterParameters(float(sampleRate),
                                     filterMinFreq_, filterMaxFreq_);
     }
+    if (isChanged || !(pulseDecoder || havePulseData))
+      startPulseDecoder_();
   }
 
   // --------------------------------------------------------------------------
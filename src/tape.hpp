@@ -417,6 +417,9 @@ namespace Ep128Emu {
       static void fft(float *buf, size_t n, bool isInverse);
     };
    private:
+    // thread that decodes the whole file to pulses in the background
+    class PulseDecoder;
+    // ----------------
     SNDFILE     *sf;            // tape image file
     std::vector<short>  buf;    // 1024 interleaved sample frames
     int         nChannels;
@@ -424,11 +427,32 @@ namespace Ep128Emu {
     bool        enableFIRFilter;
     bool        isBufferDirty;  // true if 'buf' has been changed,
                                 // and not written to file yet
+    bool        isFileChanged;  // true if the file has been written since
+                                // the pre-decoding was started
+    bool        enablePreDecode;
+    bool        havePulseData;  // true if playing from the pulse tables
     TapeFilter  firFilter;
+    float       filterMinFreq;
+    float       filterMaxFreq;
+    std::string fileName;
+    PulseDecoder  *pulseDecoder;
+    // pre-decoded file: each pulse is a run of 1 to 65535 samples with the
+    // same output level
+    std::vector< uint16_t > pulseLengths;
+    std::vector< uint8_t >  pulseLevels;
+    // start position (in samples) of every 256th pulse
+    std::vector< uint32_t > pulseIndex;
+    size_t      pulseNum;       // current pulse, and the number of samples
+    size_t      pulseSamplesLeft;   // remaining from it
     // ----------------
     void seek_(size_t pos_);
     bool writeBuffer_();
     void flushBuffer_();
+    void readBuffer_(short fillValue);
+    void seekPulse_(size_t pos);
+    void startPulseDecoder_();
+    void stopPulseDecoder_();
+    bool checkPulseDecoder_();
    public:
     /*!
      * Open tape file 'fileName'.
@@ -478,10 +502,15 @@ namespace Ep128Emu {
      */
     virtual void deleteAllCuePoints();
     /*!
-     * Set parameters for sound file reading.
+     * Set parameters for sound file reading. If 'enablePreDecode_' is true,
+     * the file is decoded to a compact table of pulse lengths on a
+     * background thread, and played from memory once that is finished.
+     * Streaming from the file is used until then, while recording, and if
+     * there is not enough memory for the pulse tables.
      */
     void setParameters(int requestedChannel_, bool enableFIRFilter_,
-                       float filterMinFreq_, float filterMaxFreq_);
+                       float filterMinFreq_, float filterMaxFreq_,
+                       bool enablePreDecode_ = true);
   };
 
   /*!
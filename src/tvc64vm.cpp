@@ -639,6 +639,8 @@ namespace TVC64 {
   void TVC64VM::TVCVideo_::vsyncStateChange(bool newState,
                                             unsigned int currentSlot_)
   {
+    if (newState)
+      vm.turboTapeVSync();
     if (vm.getIsDisplayEnabled())
       vm.display.vsyncStateChange(newState, currentSlot_);
     if (vm.videoCapture)
@@ -753,6 +755,8 @@ namespace TVC64 {
     case 0x5D:
       // bit 7: printer ready (unimplemented)
       // bit 6: color output enabled (1 = yes)
+      // bit 5: tape input
+      vm.countTapeInputRead();
       retval = (~vm.irqState & 0x1F) | ((vm.tapeInputSignal & 1) << 5) | 0xC0;
       break;
     case 0x5A:                          // extension card ID byte
@@ -1573,20 +1577,28 @@ namespace TVC64 {
 
   void TVC64VM::openVideoCapture(
       int frameRate_,
-      bool yuvFormat_,
+      int videoFormat_,
       void (*errorCallback_)(void *userData, const char *msg),
       void (*fileNameCallback_)(void *userData, std::string& fileName),
       void *userData_)
   {
     if (!videoCapture) {
-      if (yuvFormat_) {
+      if (videoFormat_ == 1) {
         videoCapture = new Ep128Emu::VideoCapture_YV12(
                                &TVCVideo::convertPixelToRGB, frameRate_);
       }
+      else if (videoFormat_ == 2) {
+        videoCapture = new Ep128Emu::VideoCapture_ZMBV(
+                               &TVCVideo::convertPixelToRGB, frameRate_);
+      }
       else {
         videoCapture = new Ep128Emu::VideoCapture_RLE8(
                                &TVCVideo::convertPixelToRGB, frameRate_);
       }
+      if (getIsVideoCaptureThreadEnabled()) {
+        videoCapture = new Ep128Emu::VideoCapture_Async(videoCapture,
+                                                        frameRate_);
+      }
       videoCapture->setClockFrequency(crtcFrequency);
       setCallback(&videoCaptureCallback, this, true);
     }
@@ -59,6 +59,9 @@ namespace TVC64 {
       vSyncCnt(0),
       videoMemory(videoMemory_),
       lineBuf((uint8_t *) 0),
+      outputBuf((uint32_t *) 0),
+      outputBufReadPos(0),
+      outputBufWritePos(0),
       borderColor(0x00),
       videoMode(0),
       hSyncLen(8),
@@ -68,10 +71,14 @@ namespace TVC64 {
     videoDelayBuf[1] = 0U;
     for (size_t i = 0; i < 4; i++)
       palette[i] = 0x00;
-    lineBuf = reinterpret_cast<uint8_t *>(new uint32_t[112]);
+    // line buffer and output buffer
+    lineBuf = reinterpret_cast<uint8_t *>(new uint32_t[112 + 96]);
     for (size_t i = 0; i < 448; i++)
       lineBuf[i] = uint8_t((~i) & 0x01);
     lineBufPtr = lineBuf;
+    outputBuf = reinterpret_cast<uint32_t *>(lineBuf) + 112;
+    for (size_t i = 0; i < 96; i++)
+      outputBuf[i] = 0U;
   }
 
   TVCVideo::~TVCVideo()
@@ -92,14 +99,6 @@ namespace TVC64 {
     }
   }
 
-  void TVCVideo::setColor(uint8_t penNum, uint8_t c)
-  {
-    if (penNum & 0x04)
-      borderColor = c & 0xAA;
-    else
-      palette[penNum & 0x03] = c & 0x55;
-  }
-
   uint8_t TVCVideo::getColor(uint8_t penNum) const
   {
     if (penNum & 0x04)
@@ -113,8 +112,12 @@ namespace TVC64 {
     if (EP128EMU_UNLIKELY(crtcHSyncCnt)) {      // horizontal sync
       if (crtcHSyncCnt == hSyncPos) {
         if (hSyncCnt >= 96) {
+          if (outputBufReadPos < outputBufWritePos)
+            renderLine();
           drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
           lineBufPtr = lineBuf;
+          outputBufReadPos = 0;
+          outputBufWritePos = 0;
           hSyncCnt = -2;
         }
       }
@@ -132,9 +135,44 @@ namespace TVC64 {
       crtcHSyncCnt++;
     }
     if (EP128EMU_EXPECT((unsigned int) hSyncCnt < 96U)) {
+      // the pixels are only rendered at the end of the line, or before
+      // a color is changed
+      outputBuf[hSyncCnt] = videoDelayBuf[0];
+      outputBufWritePos = hSyncCnt + 1;
+    }
+    else if (EP128EMU_UNLIKELY(hSyncCnt >= 101)) {
+      if (outputBufReadPos < outputBufWritePos)
+        renderLine();
+      drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
+      lineBufPtr = lineBuf;
+      outputBufReadPos = 0;
+      outputBufWritePos = 0;
+      hSyncCnt = -2;
+    }
+    videoDelayBuf[0] = videoDelayBuf[1];
+    (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[0] =
+        crtcHSyncCnt | vSyncCnt;
+    bool    displayEnabled = crtc.getDisplayEnabled();
+    (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[5] =
+        uint8_t(displayEnabled);
+    (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[2] =
+        uint8_t(videoMode);
+    if (displayEnabled) {
+      unsigned int  videoAddr =
+          ((unsigned int) (crtc.getRowAddress() & 0x03) << 6)
+          | (unsigned int) (crtc.getMemoryAddress() & 0x003F)
+          | ((unsigned int) (crtc.getMemoryAddress() & 0x0FC0) << 2);
+      (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[7] =
+          videoMemory[videoAddr];
+    }
+  }
+
+  EP128EMU_REGPARM1 void TVCVideo::renderLine()
+  {
+    for (int i = outputBufReadPos; i < outputBufWritePos; i++) {
       const unsigned char *delayPtr =
-          reinterpret_cast< unsigned char * >(&(videoDelayBuf[0]));
-      if (!(hSyncCnt & 1U)) {
+          reinterpret_cast< const unsigned char * >(&(outputBuf[i]));
+      if (!(i & 1)) {
         if (delayPtr[1] > delayPtr[0]) {
           uint8_t videoByte = delayPtr[3];
           switch (delayPtr[2]) {
@@ -280,31 +318,13 @@ namespace TVC64 {
         lineBufPtr = lineBufPtr + (lineBufPtr[0] + 1);
       }
     }
-    else if (EP128EMU_UNLIKELY(hSyncCnt >= 101)) {
-      drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
-      lineBufPtr = lineBuf;
-      hSyncCnt = -2;
-    }
-    videoDelayBuf[0] = videoDelayBuf[1];
-    (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[0] =
-        crtcHSyncCnt | vSyncCnt;
-    bool    displayEnabled = crtc.getDisplayEnabled();
-    (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[5] =
-        uint8_t(displayEnabled);
-    (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[2] =
-        uint8_t(videoMode);
-    if (displayEnabled) {
-      unsigned int  videoAddr =
-          ((unsigned int) (crtc.getRowAddress() & 0x03) << 6)
-          | (unsigned int) (crtc.getMemoryAddress() & 0x003F)
-          | ((unsigned int) (crtc.getMemoryAddress() & 0x0FC0) << 2);
-      (reinterpret_cast<unsigned char *>(&(videoDelayBuf[0])))[7] =
-          videoMemory[videoAddr];
-    }
+    outputBufReadPos = outputBufWritePos;
   }
 
   void TVCVideo::reset()
   {
+    if (outputBufReadPos < outputBufWritePos)
+      renderLine();
     videoDelayBuf[0] = 0U;
     videoDelayBuf[1] = 0U;
     for (size_t i = 0; i < 4; i++)
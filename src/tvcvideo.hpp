@@ -39,6 +39,11 @@ namespace TVC64 {
     uint32_t  videoDelayBuf[2];
     const uint8_t *videoMemory;
     uint8_t   *lineBuf;         // 448 bytes (112 uint32_t's) for 49 characters
+    // copies of videoDelayBuf[0] at the output positions of the current
+    // line (hSyncCnt = 0 to 95) that are not rendered to lineBuf yet
+    uint32_t  *outputBuf;       // 96 uint32_t's after lineBuf
+    int       outputBufReadPos;
+    int       outputBufWritePos;
     uint8_t   palette[4];
     uint8_t   borderColor;
     uint8_t   videoMode;
@@ -85,9 +90,22 @@ namespace TVC64 {
     {
       return videoMode;
     }
-    void setColor(uint8_t penNum, uint8_t c);   // penNum >= 4 is border
+    // penNum >= 4 is border
+    EP128EMU_INLINE void setColor(uint8_t penNum, uint8_t c)
+    {
+      if (outputBufReadPos < outputBufWritePos)
+        renderLine();
+      if (penNum & 0x04)
+        borderColor = c & 0xAA;
+      else
+        palette[penNum & 0x03] = c & 0x55;
+    }
     uint8_t getColor(uint8_t penNum) const;
     EP128EMU_REGPARM1 void runOneCycle();
+   protected:
+    // converts the pixels stored by runOneCycle() to lineBuf
+    EP128EMU_REGPARM1 void renderLine();
+   public:
     EP128EMU_INLINE void crtcHSyncStateChange(bool newState)
     {
       if (newState)
@@ -29,188 +29,109 @@ namespace ZX128 {
     45590, 55590, 45590, 55590, 45590, 55590, 45590, 55590
   };
 
-  void EP128EMU_REGPARM1 ULA::videoFunc_TBorder(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = ula.borderColor;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 40)) {
-      ula.runOneSlot_ = &ULA::videoFunc_TBorderHBlank;
-      ula.drawLine(ula.lineBuf, size_t(ula.lineBufPtr - ula.lineBuf));
-    }
-    else if (EP128EMU_UNLIKELY(ula.currentSlot == ula.slotsPerLine)) {
-      ula.currentSlot = 0;
-    }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_TBorderHBlank(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.hSyncEndSlot)) {
-      ula.currentLine++;
-      if (EP128EMU_UNLIKELY(ula.currentLine == ula.linesPerFrame)) {
-        ula.currentLine = 0;
-        ula.ld1Ptr = &(ula.videoRAMPtr[0x1800]);
-        ula.ld2Ptr = ula.videoRAMPtr;
-        ula.runOneSlot_ = &ULA::videoFunc_DisplayLBorder;
+  EP128EMU_REGPARM1 void ULA::lineEvent()
+  {
+    if (renderSlot < currentSlot)
+      renderSlots();
+    if (currentSlot == slotsPerLine) {
+      // end of left border
+      currentSlot = 0;
+      renderSlot = 0;
+      if (currentLine < 192) {
+        renderMode = 2;
+        eventSlot = 32;
       }
       else {
-        ula.runOneSlot_ = &ULA::videoFunc_TBorder;
+        eventSlot = 40;
       }
-      ula.lineBufPtr = ula.lineBuf;
     }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_DisplayLBorder(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = ula.borderColor;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.slotsPerLine)) {
-      ula.currentSlot = 0;
-      ula.runOneSlot_ = &ULA::videoFunc_Display;
+    else if (currentSlot == 32) {
+      // end of display area, continue with the right border
+      renderMode = 1;
+      lineBufPtr = &(lineBuf[144]);
+      eventSlot = 40;
     }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_Display(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    uint8_t a = ula.ld1Ptr[ula.currentSlot];
-    uint8_t b = ula.ld2Ptr[ula.currentSlot];
-    uint8_t c0 = (a & 0x78) >> 3;
-    uint8_t c1 = (a & 0x07) | ((a & 0x40) >> 3);
-    if (EP128EMU_UNLIKELY((a & ula.flashCnt) & 0x80)) {
-      uint8_t tmp = c0;
-      c0 = c1;
-      c1 = tmp;
+    else if (currentSlot == 40) {
+      // start of horizontal blanking
+      renderSlot = 0xFF;
+      eventSlot = hSyncEndSlot;
+      drawLine(lineBuf, size_t(lineBufPtr - lineBuf));
     }
-    ula.lineBufPtr[0] = 0x03;
-    ula.lineBufPtr[1] = c0;
-    ula.lineBufPtr[2] = c1;
-    ula.lineBufPtr[3] = b;
-    ula.lineBufPtr = ula.lineBufPtr + 4;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 32))
-      ula.runOneSlot_ = &ULA::videoFunc_DisplayRBorder;
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_DisplayRBorder(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = ula.borderColor;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 40)) {
-      ula.runOneSlot_ = &ULA::videoFunc_DisplayHBlank;
-      ula.drawLine(ula.lineBuf, size_t(ula.lineBufPtr - ula.lineBuf));
-    }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_DisplayHBlank(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.hSyncEndSlot)) {
-      ula.currentLine++;
-      if (EP128EMU_UNLIKELY(ula.currentLine == 192)) {
-        ula.runOneSlot_ = &ULA::videoFunc_BBorder;
-      }
-      else {
-        if (EP128EMU_EXPECT((ula.currentLine & 7) != 0)) {
-          ula.ld2Ptr = ula.ld2Ptr + 0x0100;
+    else {
+      // end of HSYNC: start new line
+      currentLine++;
+      if (currentLine < 192) {
+        if (EP128EMU_EXPECT((currentLine & 7) != 0)) {
+          ld2Ptr = ld2Ptr + 0x0100;
         }
-        else if (EP128EMU_EXPECT((ula.currentLine & 63) != 0)) {
-          ula.ld1Ptr = ula.ld1Ptr + 0x0020;
-          ula.ld2Ptr = ula.ld2Ptr - 0x06E0;
+        else if (EP128EMU_EXPECT((currentLine & 63) != 0)) {
+          ld1Ptr = ld1Ptr + 0x0020;
+          ld2Ptr = ld2Ptr - 0x06E0;
         }
         else {
-          ula.ld1Ptr = ula.ld1Ptr + 0x0020;
-          ula.ld2Ptr = ula.ld2Ptr + 0x0020;
+          ld1Ptr = ld1Ptr + 0x0020;
+          ld2Ptr = ld2Ptr + 0x0020;
         }
-        ula.runOneSlot_ = &ULA::videoFunc_DisplayLBorder;
       }
-      ula.lineBufPtr = ula.lineBuf;
-    }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_BBorder(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = ula.borderColor;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 40)) {
-      ula.runOneSlot_ = &ULA::videoFunc_BBorderHBlank;
-      ula.drawLine(ula.lineBuf, size_t(ula.lineBufPtr - ula.lineBuf));
-    }
-    else if (EP128EMU_UNLIKELY(ula.currentSlot == ula.slotsPerLine)) {
-      ula.currentSlot = 0;
-    }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_BBorderHBlank(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.hSyncEndSlot)) {
-      ula.currentLine++;
-      if (EP128EMU_UNLIKELY(ula.currentLine == 241))
-        ula.runOneSlot_ = &ULA::videoFunc_VBlank;
-      else
-        ula.runOneSlot_ = &ULA::videoFunc_BBorder;
-      ula.lineBufPtr = ula.lineBuf;
+      else if (currentLine == linesPerFrame) {
+        currentLine = 0;
+        ld1Ptr = &(videoRAMPtr[0x1800]);
+        ld2Ptr = videoRAMPtr;
+      }
+      else if (currentLine >= 241 && currentLine < 258) {
+        if (currentLine == 243 && !vsyncFlag) {
+          vsyncFlag = true;
+          vsyncStateChange(true, 7);
+        }
+        else if (currentLine == 246 && vsyncFlag) {
+          vsyncFlag = false;
+          vsyncStateChange(false, 7);
+          flashCnt = (flashCnt + 8) & 0xF8;
+        }
+        else if (currentLine == 247) {
+          irqPollEnableCallback(true);
+        }
+        else if (currentLine == 249) {
+          irqPollEnableCallback(false);
+        }
+      }
+      renderSlot = currentSlot;
+      renderMode = uint8_t(currentLine < 241 || currentLine >= 258);
+      eventSlot = slotsPerLine;
+      lineBufPtr = lineBuf;
+      updateContentionTablePtr();
     }
   }
 
-  void EP128EMU_REGPARM1 ULA::videoFunc_VBlank(void *userData)
+  EP128EMU_REGPARM1 void ULA::renderSlots()
   {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.lineBufPtr[0] = 0x01;
-    ula.lineBufPtr[1] = 0x00;
-    ula.lineBufPtr = ula.lineBufPtr + 2;
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == 40)) {
-      ula.runOneSlot_ = &ULA::videoFunc_VBlankHBlank;
-      ula.drawLine(ula.lineBuf, size_t(ula.lineBufPtr - ula.lineBuf));
+    if (renderMode < 2) {
+      uint8_t c = (renderMode != 0 ? borderColor : uint8_t(0x00));
+      uint8_t *p = lineBufPtr;
+      do {
+        p[0] = 0x01;
+        p[1] = c;
+        p = p + 2;
+      } while (++renderSlot < currentSlot);
+      lineBufPtr = p;
     }
-    else if (EP128EMU_UNLIKELY(ula.currentSlot == ula.slotsPerLine)) {
-      ula.currentSlot = 0;
-    }
-  }
-
-  void EP128EMU_REGPARM1 ULA::videoFunc_VBlankHBlank(void *userData)
-  {
-    ULA&    ula = *(reinterpret_cast<ULA *>(userData));
-    ula.currentSlot++;
-    if (EP128EMU_UNLIKELY(ula.currentSlot == ula.hSyncEndSlot)) {
-      ula.currentLine++;
-      if (EP128EMU_UNLIKELY(ula.currentLine == 258))
-        ula.runOneSlot_ = &ULA::videoFunc_TBorder;
-      else
-        ula.runOneSlot_ = &ULA::videoFunc_VBlank;
-      if (ula.currentLine == 243 && !ula.vsyncFlag) {
-        ula.vsyncFlag = true;
-        ula.vsyncStateChange(true, 7);
-      }
-      else if (ula.currentLine == 246 && ula.vsyncFlag) {
-        ula.vsyncFlag = false;
-        ula.vsyncStateChange(false, 7);
-        ula.flashCnt = (ula.flashCnt + 8) & 0xF8;
-      }
-      else if (ula.currentLine == 247) {
-        ula.irqPollEnableCallback(true);
-      }
-      else if (ula.currentLine == 249) {
-        ula.irqPollEnableCallback(false);
-      }
-      ula.lineBufPtr = ula.lineBuf;
+    else {
+      uint8_t *p = &(lineBuf[(int(renderSlot) << 2) + 16]);
+      do {
+        uint8_t a = ld1Ptr[renderSlot];
+        uint8_t c0 = (a & 0x78) >> 3;
+        uint8_t c1 = (a & 0x07) | ((a & 0x40) >> 3);
+        if (EP128EMU_UNLIKELY((a & flashCnt) & 0x80)) {
+          uint8_t tmp = c0;
+          c0 = c1;
+          c1 = tmp;
+        }
+        p[0] = 0x03;
+        p[1] = c0;
+        p[2] = c1;
+        p[3] = ld2Ptr[renderSlot];
+        p = p + 4;
+      } while (++renderSlot < currentSlot);
     }
   }
 
@@ -226,24 +147,29 @@ namespace ZX128 {
     lineBufPtr = lineBuf;
   }
 
-  EP128EMU_REGPARM2 bool ULA::getInterruptFlag_(int timeOffs) const
+  void ULA::initContentionTable()
   {
-    int     x = 0;
-    int     y = 0;
-    getVideoPosition(x, y, timeOffs + 6 - (int(spectrum128Mode) << 2));
-    return (y == 248 && x < ((int(spectrum128Mode) + 8) << 3));
+    // the first display T-state is 32 cycles after the end of HSYNC
+    int     lineLength = int(slotsPerLine) << 2;
+    for (int i = 0; i < 456; i++) {
+      uint8_t waitHalfCycles = 0;
+      int     x = (i < lineLength ? i : (i - lineLength)) - 32;
+      if (x >= 0 && x < 128 && (x & 7) < 6)
+        waitHalfCycles = uint8_t(12 - ((x & 7) << 1));
+      contentionTable[i] = 0;
+      contentionTable[456 + i] = (i >= lineLength ? waitHalfCycles : 0);
+      contentionTable[912 + i] = (i < lineLength ? waitHalfCycles : 0);
+      contentionTable[1368 + i] = waitHalfCycles;
+    }
+    updateContentionTablePtr();
   }
 
-  EP128EMU_REGPARM2 int ULA::getWaitHalfCycles_(int timeOffs) const
+  EP128EMU_REGPARM2 bool ULA::getInterruptFlag_(int timeOffs) const
   {
     int     x = 0;
     int     y = 0;
-    getVideoPosition(x, y, timeOffs + 6);
-    if (EP128EMU_UNLIKELY(y < 0 || y >= 192))
-      return 0;         // this was already checked in getWaitHalfCycles()
-    if (x >= 256)
-      return 0;
-    return ((x & 14) < 12 ? (12 - (x & 14)) : 0);
+    getVideoPosition(x, y, timeOffs + 6 - (int(spectrum128Mode) << 2));
+    return (y == 248 && x < ((int(spectrum128Mode) + 8) << 3));
   }
 
   EP128EMU_REGPARM2 uint8_t ULA::idleDataBusRead_(int timeOffs) const
@@ -267,42 +193,32 @@ namespace ZX128 {
   {
     irqPollEnableCallback(currentLine >= 247 && currentLine < 249);
     clearLineBuffer();
-    if (currentLine >= 258) {
-      if (currentSlot < 40 || currentSlot >= hSyncEndSlot)
-        runOneSlot_ = &videoFunc_TBorder;
-      else
-        runOneSlot_ = &videoFunc_TBorderHBlank;
+    renderSlot = currentSlot;
+    renderMode = uint8_t(currentLine < 241 || currentLine >= 258);
+    if (currentSlot >= hSyncEndSlot) {
+      eventSlot = slotsPerLine;
+      lineBufPtr = &(lineBuf[(currentSlot - hSyncEndSlot) << 1]);
     }
-    else if (currentLine < 192) {
-      if (currentSlot >= hSyncEndSlot)
-        runOneSlot_ = &videoFunc_DisplayLBorder;
-      else if (currentSlot < 32)
-        runOneSlot_ = &videoFunc_Display;
-      else if (currentSlot < 40)
-        runOneSlot_ = &videoFunc_DisplayRBorder;
-      else
-        runOneSlot_ = &videoFunc_DisplayHBlank;
+    else if (currentSlot < 32) {
+      if (currentLine < 192) {
+        renderMode = 2;
+        eventSlot = 32;
+      }
+      else {
+        eventSlot = 40;
+      }
+      lineBufPtr = &(lineBuf[(currentSlot << 2) + 16]);
     }
-    else if (currentLine < 241) {
-      if (currentSlot < 40 || currentSlot >= hSyncEndSlot)
-        runOneSlot_ = &videoFunc_BBorder;
-      else
-        runOneSlot_ = &videoFunc_BBorderHBlank;
+    else if (currentSlot < 40) {
+      eventSlot = 40;
+      lineBufPtr = &(lineBuf[(currentSlot << 1) + 80]);
     }
     else {
-      if (currentSlot < 40 || currentSlot >= hSyncEndSlot)
-        runOneSlot_ = &videoFunc_VBlank;
-      else
-        runOneSlot_ = &videoFunc_VBlankHBlank;
-    }
-    if (currentSlot >= hSyncEndSlot)
-      lineBufPtr = &(lineBuf[(currentSlot - hSyncEndSlot) << 1]);
-    else if (currentSlot < 32)
-      lineBufPtr = &(lineBuf[(currentSlot << 2) + 16]);
-    else if (currentSlot < 40)
-      lineBufPtr = &(lineBuf[(currentSlot << 1) + 80]);
-    else
+      renderSlot = 0xFF;
+      eventSlot = hSyncEndSlot;
       lineBufPtr = &(lineBuf[160]);
+    }
+    updateContentionTablePtr();
     ld1Ptr = videoRAMPtr + 0x1800;
     ld2Ptr = videoRAMPtr;
     if (currentLine < 192) {
@@ -321,8 +237,10 @@ namespace ZX128 {
   // --------------------------------------------------------------------------
 
   ULA::ULA(const uint8_t *videoRAMPtr_)
-    : runOneSlot_(&videoFunc_TBorder),
-      currentSlot(48),
+    : currentSlot(48),
+      eventSlot(56),
+      renderSlot(48),
+      renderMode(1),
       hSyncEndSlot(48),
       slotsPerLine(56),
       ioPortValue(0x00),
@@ -337,6 +255,7 @@ namespace ZX128 {
       lineBuf((uint8_t *) 0),
       lineBufPtr((uint8_t *) 0),
       videoRAMPtr(videoRAMPtr_),
+      contentionTablePtr((uint8_t *) 0),
       audioOutput(0),
       tapeInput(0),
       tapeOutput(0)
@@ -346,6 +265,7 @@ namespace ZX128 {
     uint32_t  *p = new uint32_t[48];    // for 192 bytes (48 * 4)
     lineBuf = reinterpret_cast<uint8_t *>(p);
     clearLineBuffer();
+    initContentionTable();
   }
 
   ULA::~ULA()
@@ -358,7 +278,6 @@ namespace ZX128 {
 
   void ULA::reset()
   {
-    runOneSlot_ = &videoFunc_TBorder;
     currentSlot = hSyncEndSlot;
     flashCnt = 0x00;
     currentLine = 258;
@@ -407,6 +326,7 @@ namespace ZX128 {
 
   void ULA::writePort(uint8_t value)
   {
+    updateDisplay();
     int     tmp = int(value & 0x18) - int(ioPortValue & 0x18);
     if (tmp != 0)
       tapeOutput = uint8_t(tmp >= 0);
@@ -442,6 +362,16 @@ namespace ZX128 {
     linesPerFrame = 312 - int(isSpectrum128);
     if (currentLine >= linesPerFrame)
       currentLine = linesPerFrame - 1;
+    if (renderSlot == 0xFF) {
+      eventSlot = hSyncEndSlot;
+    }
+    else {
+      if (renderSlot > currentSlot)
+        renderSlot = currentSlot;
+      if (currentSlot >= hSyncEndSlot)
+        eventSlot = slotsPerLine;
+    }
+    initContentionTable();
   }
 
   void ULA::drawLine(const uint8_t *buf, size_t nBytes)
@@ -517,6 +447,7 @@ namespace ZX128 {
     }
     try {
       // load saved state
+      renderSlot = 0xFF;                // the line buffer is cleared below
       currentSlot = buf.readByte() & 0x3F;
       writePort(buf.readByte());
       flashCnt = buf.readByte() & 0xF8;
@@ -27,8 +27,11 @@ namespace ZX128 {
   class ULA {
    private:
     static const uint16_t audioOutputLevelTable[32];
-    EP128EMU_REGPARM1 void (*runOneSlot_)(void *userData);
     uint8_t   currentSlot;
+    uint8_t   eventSlot;                // next slot to call lineEvent() at
+    uint8_t   renderSlot;               // first slot not rendered yet to the
+                                        // line buffer, 0xFF if none pending
+    uint8_t   renderMode;               // 0: blank, 1: border, 2: display
     uint8_t   hSyncEndSlot;             // 48K: 48, 128K: 49
     uint8_t   slotsPerLine;             // 48K: 56, 128K: 57
     uint8_t   ioPortValue;              // last value written to I/O port 0xFE
@@ -43,24 +46,31 @@ namespace ZX128 {
     uint8_t   *lineBuf;                 // 48 slots = 384 pixels
     uint8_t   *lineBufPtr;
     const uint8_t *videoRAMPtr;         // pointer to video RAM segment
+    // memory contention wait half cycles for the current and the next line,
+    // indexed by the T-state within the line (starting at the end of HSYNC)
+    const uint8_t *contentionTablePtr;
     uint16_t  audioOutput;
     uint8_t   tapeInput;
     uint8_t   tapeOutput;
     uint8_t   keyboardState[8];
+    // contention tables for no display line, next line only, current line
+    // only, and both lines, 2 * 57 * 4 T-states each
+    uint8_t   contentionTable[4 * 456];
     // --------
-    static EP128EMU_REGPARM1 void videoFunc_TBorder(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_TBorderHBlank(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_DisplayLBorder(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_Display(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_DisplayRBorder(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_DisplayHBlank(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_BBorder(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_BBorderHBlank(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_VBlank(void *userData);
-    static EP128EMU_REGPARM1 void videoFunc_VBlankHBlank(void *userData);
+    EP128EMU_REGPARM1 void lineEvent();
+    EP128EMU_REGPARM1 void renderSlots();
     void clearLineBuffer();
+    void initContentionTable();
+    inline void updateContentionTablePtr()
+    {
+      int     n = 0;
+      if (currentLine < 192)
+        n = (currentLine < 191 ? 3 : 2);
+      else if (currentLine == (linesPerFrame - 1))
+        n = 1;
+      contentionTablePtr = &(contentionTable[n * 456]);
+    }
     EP128EMU_REGPARM2 bool getInterruptFlag_(int timeOffs) const;
-    EP128EMU_REGPARM2 int getWaitHalfCycles_(int timeOffs) const;
     EP128EMU_REGPARM2 uint8_t idleDataBusRead_(int timeOffs) const;
     void setVideoPosition_();
     inline void updateAudioOutput()
@@ -75,9 +85,20 @@ namespace ZX128 {
     {
       videoRAMPtr = videoRAMPtr_;
     }
-    inline void runOneSlot()
+    EP128EMU_INLINE void runOneSlot()
     {
-      runOneSlot_((void *) this);
+      // the line buffer is only updated at the end of each area of the line
+      if (EP128EMU_UNLIKELY(++currentSlot == eventSlot))
+        lineEvent();
+    }
+    /*!
+     * Render the pending slots of the current line up to the current
+     * position. This needs to be called before writing to video memory.
+     */
+    EP128EMU_INLINE void updateDisplay()
+    {
+      if (EP128EMU_UNLIKELY(renderSlot < currentSlot))
+        renderSlots();
     }
     inline uint16_t getSoundOutput() const
     {
@@ -126,11 +147,13 @@ namespace ZX128 {
         return false;
       return getInterruptFlag_(timeOffs);
     }
+    // 'timeOffs' is expected to be in the range 0 to 255
     EP128EMU_INLINE int getWaitHalfCycles(int timeOffs = 0) const
     {
-      if (currentLine >= 193 && currentLine < 310)
-        return 0;
-      return getWaitHalfCycles_(timeOffs);
+      int     tmp = int(currentSlot) + 8;
+      if (currentSlot >= hSyncEndSlot)
+        tmp = tmp - int(slotsPerLine);
+      return int(contentionTablePtr[((tmp << 3) + timeOffs + 6) >> 1]);
     }
     EP128EMU_INLINE uint8_t idleDataBusRead(int timeOffs = 0) const
     {
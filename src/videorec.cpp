@@ -21,12 +21,59 @@
 #include "display.hpp"
 #include "snd_conv.hpp"
 #include "videorec.hpp"
+#include "pngwrite.hpp"
 #include "system.hpp"
 
 #include <cmath>
 
-static const size_t aviHeaderSize_RLE8 = 0x0546;
-static const size_t aviHeaderSize_YV12 = 0x0146;
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#  include <emmintrin.h>
+#  define EP128EMU_VIDEOREC_USE_SSE2    1
+#endif
+
+// number of OpenDML super index entries reserved in the header for each
+// stream; a new standard index is written every 20 seconds, and at the end
+// of each RIFF chunk
+static const size_t aviSuperIndexEntries = 2048;
+// size of the 'indx' chunk, including the chunk header
+static const size_t aviSuperIndexSize = 32 + (aviSuperIndexEntries * 16);
+// size of the 'odml' LIST chunk
+static const size_t aviODMLHeaderSize = 0x010C;
+static const size_t aviHeaderSize_RLE8 =
+    0x0546 + (aviSuperIndexSize * 2) + aviODMLHeaderSize;
+static const size_t aviHeaderSize_YV12 =
+    0x0146 + (aviSuperIndexSize * 2) + aviODMLHeaderSize;
+// a new 'AVIX' RIFF chunk is started when the size of the current one
+// reaches this limit (slightly less than 1 GB)
+static const uint64_t aviMaxRIFFSize = 0x3F000000U;
+
+static void aviFileSeek(std::FILE *f, uint64_t pos)
+{
+#ifdef WIN32
+  if (_fseeki64(f, __int64(pos), SEEK_SET) != 0)
+#else
+  if (uint64_t(off_t(pos)) != pos || fseeko(f, off_t(pos), SEEK_SET) != 0)
+#endif
+  {
+    throw Ep128Emu::Exception("error seeking AVI file");
+  }
+}
+
+#ifdef EP128EMU_VIDEOREC_USE_SSE2
+
+// SSE2 has no 32-bit multiply with 32-bit result (pmulld is SSE4.1),
+// so it is emulated with two 32x32->64 bit unsigned multiplies
+
+static EP128EMU_INLINE __m128i mulLow32_SSE2(__m128i a, __m128i b)
+{
+  __m128i tmp0 = _mm_mul_epu32(a, b);
+  __m128i tmp1 = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(tmp0, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(tmp1, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+#endif  // EP128EMU_VIDEOREC_USE_SSE2
 
 namespace Ep128Emu {
 
@@ -91,6 +138,12 @@ namespace Ep128Emu {
     bufp = bufp + 4;
   }
 
+  void VideoCapture::aviHeader_writeUInt64(uint8_t*& bufp, uint64_t n)
+  {
+    aviHeader_writeUInt32(bufp, uint32_t(n & 0xFFFFFFFFUL));
+    aviHeader_writeUInt32(bufp, uint32_t(n >> 32));
+  }
+
   void VideoCapture::defaultErrorCallback(void *userData, const char *msg)
   {
     (void) userData;
@@ -127,7 +180,11 @@ namespace Ep128Emu {
       errorCallback(&defaultErrorCallback),
       errorCallbackUserData((void *) this),
       fileNameCallback(&defaultFileNameCallback),
-      fileNameCallbackUserData((void *) this)
+      fileNameCallbackUserData((void *) this),
+      riffStartPos(0U),
+      firstRIFFSize(0U),
+      firstMoviSize(0U),
+      firstRIFFFrames(0)
   {
     try {
       frameRate = (frameRate > 24 ? (frameRate < 60 ? frameRate : 60) : 24);
@@ -184,8 +241,8 @@ namespace Ep128Emu {
     if (aviFile) {
       // FIXME: file I/O errors are ignored here
       try {
+        finishRIFFChunk();
         writeAVIHeader();
-        writeAVIIndex();
       }
       catch (...) {
       }
@@ -196,6 +253,332 @@ namespace Ep128Emu {
       duplicateFrames = 0;
       fileSize = 0;
     }
+    stdIndex.clear();
+    std::vector< AVIIndexEntry >().swap(legacyIndex);
+    superIndex.clear();
+    riffStartPos = 0U;
+    firstRIFFSize = 0U;
+    firstMoviSize = 0U;
+    firstRIFFFrames = 0;
+  }
+
+  uint32_t VideoCapture::aviHeader_getRIFFSize() const
+  {
+    if (firstRIFFSize)
+      return firstRIFFSize;
+    return uint32_t(fileSize - 8U);
+  }
+
+  uint32_t VideoCapture::aviHeader_getMoviSize() const
+  {
+    if (firstRIFFSize)
+      return firstMoviSize;
+    return uint32_t((fileSize - aviHeaderSize) + 4U);
+  }
+
+  size_t VideoCapture::aviHeader_getTotalFrames() const
+  {
+    // the main AVI header contains the number of frames in the first
+    // RIFF chunk only
+    if (firstRIFFSize)
+      return firstRIFFFrames;
+    return framesWritten;
+  }
+
+  void VideoCapture::aviHeader_writeSuperIndex(uint8_t*& bufp,
+                                               int streamNum) const
+  {
+    aviHeader_writeFourCC(bufp, "indx");
+    aviHeader_writeUInt32(bufp, uint32_t(aviSuperIndexSize - 8));
+    // entry size in 32-bit words
+    aviHeader_writeUInt16(bufp, 0x0004);
+    // index sub-type (0), index type (AVI_INDEX_OF_INDEXES)
+    aviHeader_writeUInt16(bufp, 0x0000);
+    // number of entries in use
+    aviHeader_writeUInt32(bufp, uint32_t(superIndex.size()));
+    aviHeader_writeFourCC(bufp, (streamNum == 0 ? "00dc" : "01wb"));
+    // reserved
+    aviHeader_writeUInt32(bufp, 0x00000000U);
+    aviHeader_writeUInt32(bufp, 0x00000000U);
+    aviHeader_writeUInt32(bufp, 0x00000000U);
+    for (size_t i = 0; i < aviSuperIndexEntries; i++) {
+      if (i >= superIndex.size()) {
+        std::memset(bufp, 0x00, 16);
+        bufp = bufp + 16;
+        continue;
+      }
+      const AVISuperIndexEntry& e = superIndex[i];
+      uint32_t  stdIndexSize = (e.nFrames << 3) + 32U;
+      // offset of standard index chunk, 'ix01' is stored after 'ix00'
+      if (streamNum == 0)
+        aviHeader_writeUInt64(bufp, e.filePos);
+      else
+        aviHeader_writeUInt64(bufp, e.filePos + stdIndexSize);
+      aviHeader_writeUInt32(bufp, stdIndexSize);
+      // duration in stream time units
+      if (streamNum == 0)
+        aviHeader_writeUInt32(bufp, e.nFrames);
+      else
+        aviHeader_writeUInt32(bufp, e.nFrames * uint32_t(audioBufSize));
+    }
+  }
+
+  void VideoCapture::aviHeader_writeODMLHeader(uint8_t*& bufp) const
+  {
+    aviHeader_writeFourCC(bufp, "LIST");
+    aviHeader_writeUInt32(bufp, uint32_t(aviODMLHeaderSize - 8));
+    aviHeader_writeFourCC(bufp, "odml");
+    aviHeader_writeFourCC(bufp, "dmlh");
+    aviHeader_writeUInt32(bufp, uint32_t(aviODMLHeaderSize - 20));
+    // total frames in all RIFF chunks
+    aviHeader_writeUInt32(bufp, uint32_t(framesWritten));
+    // reserved
+    std::memset(bufp, 0x00, aviODMLHeaderSize - 24);
+    bufp = bufp + (aviODMLHeaderSize - 24);
+  }
+
+  void VideoCapture::updateRIFFChunkHeader()
+  {
+    // update the sizes of the current RIFF chunk and its 'movi' list
+    // (the first RIFF chunk is not changed after it has been finished)
+    if (!aviFile || (riffStartPos == 0U && firstRIFFSize))
+      return;
+    uint64_t  moviListPos = riffStartPos + 16U;
+    if (riffStartPos == 0U)
+      moviListPos = aviHeaderSize - 8;
+    uint8_t   tmpBuf[4];
+    uint8_t   *bufp = &(tmpBuf[0]);
+    aviFileSeek(aviFile, riffStartPos + 4U);
+    aviHeader_writeUInt32(bufp, uint32_t(fileSize - (riffStartPos + 8U)));
+    if (std::fwrite(&(tmpBuf[0]), 1, 4, aviFile) != 4)
+      throw Exception("error writing AVI file header");
+    aviFileSeek(aviFile, moviListPos);
+    bufp = &(tmpBuf[0]);
+    aviHeader_writeUInt32(bufp, uint32_t(fileSize - (moviListPos + 4U)));
+    if (std::fwrite(&(tmpBuf[0]), 1, 4, aviFile) != 4)
+      throw Exception("error writing AVI file header");
+    if (std::fflush(aviFile) != 0)
+      throw Exception("error writing AVI file header");
+  }
+
+  void VideoCapture::writeStandardIndex()
+  {
+    if (!aviFile || stdIndex.size() < 1)
+      return;
+    if (superIndex.size() >= aviSuperIndexEntries)
+      throw Exception("internal error: AVI super index is full");
+    if (std::fseek(aviFile, 0L, SEEK_END) < 0)
+      throw Exception("error seeking AVI file");
+    size_t    nFrames = stdIndex.size();
+    size_t    stdIndexSize = (nFrames << 3) + 32;
+    std::vector< uint8_t >  tmpBuf(stdIndexSize * 2);
+    uint8_t   *bufp = &(tmpBuf[0]);
+    // use the position of the first chunk as base offset, so that the
+    // 32-bit offsets are always small enough
+    uint64_t  baseOffset = stdIndex[0].filePos;
+    for (int streamNum = 0; streamNum < 2; streamNum++) {
+      aviHeader_writeFourCC(bufp, (streamNum == 0 ? "ix00" : "ix01"));
+      aviHeader_writeUInt32(bufp, uint32_t(stdIndexSize - 8));
+      // entry size in 32-bit words
+      aviHeader_writeUInt16(bufp, 0x0002);
+      // index sub-type (0), index type (AVI_INDEX_OF_CHUNKS)
+      aviHeader_writeUInt16(bufp, 0x0100);
+      // number of entries in use
+      aviHeader_writeUInt32(bufp, uint32_t(nFrames));
+      aviHeader_writeFourCC(bufp, (streamNum == 0 ? "00dc" : "01wb"));
+      aviHeader_writeUInt64(bufp, baseOffset);
+      // reserved
+      aviHeader_writeUInt32(bufp, 0x00000000U);
+      for (size_t i = 0; i < nFrames; i++) {
+        const AVIIndexEntry&  e = stdIndex[i];
+        // offsets point to the chunk data, after the 8 byte header
+        uint32_t  offs = uint32_t(e.filePos - baseOffset) + 8U;
+        if (streamNum == 0) {
+          aviHeader_writeUInt32(bufp, offs);
+          // bit 31 is set for non-key frames
+          if (e.keyFrame)
+            aviHeader_writeUInt32(bufp, e.videoBytes);
+          else
+            aviHeader_writeUInt32(bufp, e.videoBytes | 0x80000000U);
+        }
+        else {
+          // odd sized chunks are followed by a padding byte
+          aviHeader_writeUInt32(bufp,
+                                offs + ((e.videoBytes + 1U) & (~1U)) + 8U);
+          aviHeader_writeUInt32(bufp, uint32_t(audioBufSize) << 2);
+        }
+      }
+    }
+    if (std::fwrite(&(tmpBuf[0]), 1, tmpBuf.size(), aviFile) != tmpBuf.size())
+      throw Exception("error writing AVI file index");
+    AVISuperIndexEntry  e;
+    e.filePos = fileSize;
+    e.nFrames = uint32_t(nFrames);
+    superIndex.push_back(e);
+    fileSize = fileSize + tmpBuf.size();
+    stdIndex.clear();
+  }
+
+  void VideoCapture::writeLegacyIndex()
+  {
+    if (!aviFile)
+      return;
+    if (std::fseek(aviFile, 0L, SEEK_END) < 0)
+      throw Exception("error seeking AVI file");
+    size_t    nFrames = legacyIndex.size();
+    uint8_t   tmpBuf[1024];
+    uint8_t   *bufp = &(tmpBuf[0]);
+    aviHeader_writeFourCC(bufp, "idx1");
+    aviHeader_writeUInt32(bufp, uint32_t(nFrames << 5));
+    fileSize = fileSize + 8;
+    if (std::fwrite(&(tmpBuf[0]), 1, 8, aviFile) != 8)
+      throw Exception("error writing AVI file index");
+    for (size_t i = 0; i < nFrames; ) {
+      bufp = &(tmpBuf[0]);
+      do {
+        const AVIIndexEntry&  e = legacyIndex[i];
+        // offsets are relative to the 'movi' FourCC
+        uint32_t  filePos = uint32_t(e.filePos - (aviHeaderSize - 4));
+        aviHeader_writeFourCC(bufp, "00dc");
+        if (e.keyFrame)
+          aviHeader_writeUInt32(bufp, 0x00000010U);     // AVIIF_KEYFRAME
+        else
+          aviHeader_writeUInt32(bufp, 0x00000000U);
+        aviHeader_writeUInt32(bufp, filePos);
+        aviHeader_writeUInt32(bufp, e.videoBytes);
+        filePos = filePos + ((e.videoBytes + 1U) & (~1U)) + 8U;
+        aviHeader_writeFourCC(bufp, "01wb");
+        aviHeader_writeUInt32(bufp, 0x00000010U);       // AVIIF_KEYFRAME
+        aviHeader_writeUInt32(bufp, filePos);
+        aviHeader_writeUInt32(bufp, uint32_t(audioBufSize) << 2);
+      } while (++i < nFrames && bufp < &(tmpBuf[1024]));
+      size_t  nBytes = size_t(bufp - (&(tmpBuf[0])));
+      fileSize = fileSize + nBytes;
+      if (std::fwrite(&(tmpBuf[0]), 1, nBytes, aviFile) != nBytes)
+        throw Exception("error writing AVI file index");
+    }
+  }
+
+  void VideoCapture::finishRIFFChunk()
+  {
+    writeStandardIndex();
+    if (riffStartPos == 0U && !firstRIFFSize) {
+      // first RIFF chunk: also write legacy index for compatibility with
+      // AVI 1.0 readers
+      firstMoviSize = uint32_t((fileSize - aviHeaderSize) + 4U);
+      writeLegacyIndex();
+      firstRIFFSize = uint32_t(fileSize - 8U);
+      firstRIFFFrames = framesWritten;
+      std::vector< AVIIndexEntry >().swap(legacyIndex);
+    }
+    else {
+      updateRIFFChunkHeader();
+    }
+  }
+
+  void VideoCapture::beginRIFFChunk()
+  {
+    if (std::fseek(aviFile, 0L, SEEK_END) < 0)
+      throw Exception("error seeking AVI file");
+    uint8_t   tmpBuf[24];
+    uint8_t   *bufp = &(tmpBuf[0]);
+    aviHeader_writeFourCC(bufp, "RIFF");
+    aviHeader_writeUInt32(bufp, 0x00000010U);
+    aviHeader_writeFourCC(bufp, "AVIX");
+    aviHeader_writeFourCC(bufp, "LIST");
+    aviHeader_writeUInt32(bufp, 0x00000004U);
+    aviHeader_writeFourCC(bufp, "movi");
+    if (std::fwrite(&(tmpBuf[0]), 1, 24, aviFile) != 24)
+      throw Exception("error writing AVI file");
+    riffStartPos = fileSize;
+    fileSize = fileSize + 24;
+  }
+
+  bool VideoCapture::beginFrame()
+  {
+    // reserve super index entries for starting a new RIFF chunk, and for
+    // closing the file
+    if ((superIndex.size() + 3) > aviSuperIndexEntries) {
+      closeFile();
+      try {
+        errorMessage("AVI file is too large, starting new output file");
+      }
+      catch (...) {
+      }
+      std::string fileName = "";
+      fileNameCallback(fileNameCallbackUserData, fileName);
+      if (fileName.length() < 1)
+        return false;
+      openFile(fileName.c_str());
+    }
+    else if ((fileSize - riffStartPos) >= aviMaxRIFFSize) {
+      finishRIFFChunk();
+      beginRIFFChunk();
+    }
+    return bool(aviFile);
+  }
+
+  void VideoCapture::writeFrameChunks(const uint8_t *videoBuf,
+                                      size_t videoBytes, bool isKeyFrame)
+  {
+    if (std::fseek(aviFile, 0L, SEEK_END) < 0)
+      throw Exception("error seeking AVI file");
+    AVIIndexEntry e;
+    e.filePos = fileSize;
+    e.videoBytes = uint32_t(videoBytes);
+    e.keyFrame = (isKeyFrame && videoBytes > 0);
+    uint8_t headerBuf[8];
+    uint8_t *bufp = &(headerBuf[0]);
+    aviHeader_writeFourCC(bufp, "00dc");
+    aviHeader_writeUInt32(bufp, uint32_t(videoBytes));
+    fileSize = fileSize + 8;
+    if (std::fwrite(&(headerBuf[0]), 1, 8, aviFile) != 8)
+      throw Exception("error writing AVI file");
+    if (videoBytes > 0) {
+      fileSize = fileSize + videoBytes;
+      if (std::fwrite(videoBuf, 1, videoBytes, aviFile) != videoBytes)
+        throw Exception("error writing AVI file");
+    }
+    // audio buffer size is at most 2000 stereo sample frames (24 FPS)
+    uint8_t audioData[1 + 8 + 8000];
+    bufp = &(audioData[0]);
+    if (videoBytes & 1)
+      *(bufp++) = 0x00;         // padding byte after odd sized video chunk
+    aviHeader_writeFourCC(bufp, "01wb");
+    aviHeader_writeUInt32(bufp, uint32_t(audioBufSize * 4));
+    int     bufPos = audioBufReadPos;
+    for (int i = 0; i < (audioBufSize * 2); i++) {
+      if (bufPos >= (audioBufSize * audioBuffers * 2))
+        bufPos = 0;
+      aviHeader_writeUInt16(bufp, uint16_t(audioBuf[bufPos++]));
+    }
+    size_t  nBytes = size_t(bufp - (&(audioData[0])));
+    fileSize = fileSize + nBytes;
+    if (std::fwrite(&(audioData[0]), 1, nBytes, aviFile) != nBytes)
+      throw Exception("error writing AVI file");
+    stdIndex.push_back(e);
+    if (riffStartPos == 0U)
+      legacyIndex.push_back(e);
+  }
+
+  void VideoCapture::endFrame()
+  {
+    framesWritten++;
+    try {
+      // the complete header (including the super indexes) is only
+      // rewritten when a new standard index is added, otherwise only the
+      // RIFF and 'movi' chunk sizes are updated
+      if (stdIndex.size() >= size_t(frameRate * 20)) {
+        writeStandardIndex();
+        writeAVIHeader();
+      }
+      if (!(framesWritten & 31))
+        updateRIFFChunkHeader();
+    }
+    catch (std::exception& e) {
+      closeFile();
+      errorMessage(e.what());
+    }
   }
 
   void VideoCapture::errorMessage(const char *msg)
@@ -317,16 +700,15 @@ namespace Ep128Emu {
     : VideoCapture(frameRate_),
       tmpFrameBuf(videoWidth, videoHeight),
       outputFrameBuf(videoWidth, videoHeight),
-      frameSizes((uint32_t *) 0),
+      rleFrameBuf((uint8_t *) 0),
       cycleCnt(2),
       prvOddFrame(false),
-      colormap((uint8_t *) 0)
+      colormap((uint8_t *) 0),
+      videoCodec(0x00000001U)           // BI_RLE8
   {
     try {
       aviHeaderSize = aviHeaderSize_RLE8;
-      size_t  maxFrames = 0x20000000 / size_t(audioBufSize);
-      frameSizes = new uint32_t[maxFrames];
-      std::memset(frameSizes, 0x00, maxFrames * sizeof(uint32_t));
+      rleFrameBuf = new uint8_t[1024 * videoHeight];
       // initialize colormap
       colormap = new uint8_t[256 * 4];
       for (int i = 0; i < 256; i++) {
@@ -345,8 +727,8 @@ namespace Ep128Emu {
       }
     }
     catch (...) {
-      if (frameSizes)
-        delete[] frameSizes;
+      if (rleFrameBuf)
+        delete[] rleFrameBuf;
       if (colormap)
         delete[] colormap;
       throw;
@@ -357,7 +739,7 @@ namespace Ep128Emu {
   VideoCapture_RLE8::~VideoCapture_RLE8()
   {
     closeFile();
-    delete[] frameSizes;
+    delete[] rleFrameBuf;
     delete[] colormap;
   }
 
@@ -623,93 +1005,33 @@ namespace Ep128Emu {
     if (frameChanged)
       duplicateFrames = 0;
     try {
-      if (fileSize >= 0x7F800000) {
-        closeFile();
-        try {
-          errorMessage("AVI file is too large, starting new output file");
-        }
-        catch (...) {
-        }
-        std::string fileName = "";
-        fileNameCallback(fileNameCallbackUserData, fileName);
-        if (fileName.length() < 1)
-          return;
-        openFile(fileName.c_str());
-      }
-      if (std::fseek(aviFile, 0L, SEEK_END) < 0)
-        throw Exception("error seeking AVI file");
-      uint8_t headerBuf[8];
-      uint8_t *bufp = &(headerBuf[0]);
+      if (!beginFrame())
+        return;
       size_t  nBytes = 0;
-      frameSizes[framesWritten] = 0U;
-      aviHeader_writeFourCC(bufp, "00dc");
-      aviHeader_writeUInt32(bufp, 0x00000000U);
-      fileSize = fileSize + 8;
-      if (std::fwrite(&(headerBuf[0]), 1, 8, aviFile) != 8)
-        throw Exception("error writing AVI file");
       if (frameChanged) {
-        long    savedFilePos = std::ftell(aviFile);
-        if (savedFilePos < 4L)
-          throw Exception("error seeking AVI file");
-        savedFilePos = savedFilePos - 4L;
         uint8_t lineBuf[1024];
-        uint8_t rleBuf[1024];
         size_t  n = 0;
         for (int i = (videoHeight - 1); i >= 0; i--) {
           if (i == (videoHeight - 1) ||
               !outputFrameBuf.compareLine(i, outputFrameBuf, i + 1)) {
             decodeLine(&(lineBuf[0]), outputFrameBuf[i]);
-            n = rleCompressLine(&(rleBuf[0]), &(lineBuf[0]));
+            n = rleCompressLine(&(rleFrameBuf[nBytes]), &(lineBuf[0]));
+          }
+          else {
+            // same as the previous line
+            std::memcpy(&(rleFrameBuf[nBytes]), &(rleFrameBuf[nBytes - n]), n);
           }
           nBytes += n;
-          fileSize += n;
-          if (std::fwrite(&(rleBuf[0]), 1, n, aviFile) != n)
-            throw Exception("error writing AVI file");
         }
-        if (std::fseek(aviFile, savedFilePos, SEEK_SET) < 0)
-          throw Exception("error seeking AVI file");
-        bufp = &(headerBuf[4]);
-        frameSizes[framesWritten] = uint32_t(nBytes);
-        aviHeader_writeUInt32(bufp, uint32_t(nBytes));
-        if (std::fwrite(&(headerBuf[4]), 1, 4, aviFile) != 4)
-          throw Exception("error writing AVI file");
-        if (std::fseek(aviFile, 0L, SEEK_END) < 0)
-          throw Exception("error seeking AVI file");
-      }
-      bufp = &(headerBuf[0]);
-      nBytes = size_t(audioBufSize * 4);
-      aviHeader_writeFourCC(bufp, "01wb");
-      aviHeader_writeUInt32(bufp, uint32_t(nBytes));
-      fileSize = fileSize + 8;
-      if (std::fwrite(&(headerBuf[0]), 1, 8, aviFile) != 8)
-        throw Exception("error writing AVI file");
-      int     bufPos = audioBufReadPos;
-      for (int i = 0; i < (audioBufSize * 2); i++) {
-        if (bufPos >= (audioBufSize * audioBuffers * 2))
-          bufPos = 0;
-        int16_t tmp = audioBuf[bufPos++];
-        fileSize++;
-        if (std::fputc(int(uint16_t(tmp) & 0xFF), aviFile) == EOF)
-          throw Exception("error writing AVI file");
-        fileSize++;
-        if (std::fputc(int((uint16_t(tmp) >> 8) & 0xFF), aviFile) == EOF)
-          throw Exception("error writing AVI file");
       }
+      writeFrameChunks(rleFrameBuf, nBytes);
     }
     catch (std::exception& e) {
       closeFile();
       errorMessage(e.what());
       return;
     }
-    framesWritten++;
-    if (!(framesWritten & 31)) {
-      try {
-        writeAVIHeader();
-      }
-      catch (std::exception& e) {
-        errorMessage(e.what());
-      }
-    }
+    endFrame();
   }
 
   void VideoCapture_RLE8::writeAVIHeader()
@@ -719,16 +1041,17 @@ namespace Ep128Emu {
     try {
       if (std::fseek(aviFile, 0L, SEEK_SET) < 0)
         throw Exception("error seeking AVI file");
-      uint8_t   headerBuf[1536];
+      std::vector< uint8_t >  headerBuf(aviHeaderSize);
       uint8_t   *bufp = &(headerBuf[0]);
       size_t    maxVideoFrameSize = size_t((videoWidth + 16) * videoHeight);
       size_t    maxFrameSize = size_t(maxVideoFrameSize + (audioBufSize * 4)
                                       + 16);
       aviHeader_writeFourCC(bufp, "RIFF");
-      aviHeader_writeUInt32(bufp, uint32_t(fileSize - 8));
+      aviHeader_writeUInt32(bufp, aviHeader_getRIFFSize());
       aviHeader_writeFourCC(bufp, "AVI ");
       aviHeader_writeFourCC(bufp, "LIST");
-      aviHeader_writeUInt32(bufp, 0x00000526U);
+      aviHeader_writeUInt32(bufp, uint32_t(0x00000526U + (aviSuperIndexSize * 2)
+                                           + aviODMLHeaderSize));
       aviHeader_writeFourCC(bufp, "hdrl");
       aviHeader_writeFourCC(bufp, "avih");
       aviHeader_writeUInt32(bufp, 0x00000038U);
@@ -741,8 +1064,8 @@ namespace Ep128Emu {
       aviHeader_writeUInt32(bufp, 0x00000001U);
       // flags (AVIF_HASINDEX | AVIF_ISINTERLEAVED | AVIF_TRUSTCKTYPE)
       aviHeader_writeUInt32(bufp, 0x00000910U);
-      // total frames
-      aviHeader_writeUInt32(bufp, uint32_t(framesWritten));
+      // total frames (in the first RIFF chunk)
+      aviHeader_writeUInt32(bufp, uint32_t(aviHeader_getTotalFrames()));
       // initial frames
       aviHeader_writeUInt32(bufp, 0x00000000U);
       // number of streams
@@ -759,13 +1082,13 @@ namespace Ep128Emu {
       aviHeader_writeUInt32(bufp, 0x00000000U);
       aviHeader_writeUInt32(bufp, 0x00000000U);
       aviHeader_writeFourCC(bufp, "LIST");
-      aviHeader_writeUInt32(bufp, 0x00000474U);
+      aviHeader_writeUInt32(bufp, uint32_t(0x00000474U + aviSuperIndexSize));
       aviHeader_writeFourCC(bufp, "strl");
       aviHeader_writeFourCC(bufp, "strh");
       aviHeader_writeUInt32(bufp, 0x00000038U);
       aviHeader_writeFourCC(bufp, "vids");
       // video codec
-      aviHeader_writeUInt32(bufp, 0x00000001U); // BI_RLE8
+      aviHeader_writeUInt32(bufp, videoCodec);
       // flags
       aviHeader_writeUInt32(bufp, 0x00000000U);
       // priority
@@ -808,7 +1131,7 @@ namespace Ep128Emu {
       // bits per pixel
       aviHeader_writeUInt16(bufp, 0x0008);
       // compression
-      aviHeader_writeUInt32(bufp, 0x00000001U); // BI_RLE8
+      aviHeader_writeUInt32(bufp, videoCodec);
       // image size in bytes
       aviHeader_writeUInt32(bufp, uint32_t(videoWidth * videoHeight));
       // X resolution
@@ -822,8 +1145,9 @@ namespace Ep128Emu {
       // colormap (256 entries)
       std::memcpy(bufp, colormap, 1024);
       bufp = bufp + 1024;
+      aviHeader_writeSuperIndex(bufp, 0);
       aviHeader_writeFourCC(bufp, "LIST");
-      aviHeader_writeUInt32(bufp, 0x0000005EU);
+      aviHeader_writeUInt32(bufp, uint32_t(0x0000005EU + aviSuperIndexSize));
       aviHeader_writeFourCC(bufp, "strl");
       aviHeader_writeFourCC(bufp, "strh");
       aviHeader_writeUInt32(bufp, 0x00000038U);
@@ -877,8 +1201,10 @@ namespace Ep128Emu {
       aviHeader_writeUInt16(bufp, 0x0010);
       // additional format information size
       aviHeader_writeUInt16(bufp, 0x0000);
+      aviHeader_writeSuperIndex(bufp, 1);
+      aviHeader_writeODMLHeader(bufp);
       aviHeader_writeFourCC(bufp, "LIST");
-      aviHeader_writeUInt32(bufp, uint32_t((fileSize - aviHeaderSize) + 4));
+      aviHeader_writeUInt32(bufp, aviHeader_getMoviSize());
       aviHeader_writeFourCC(bufp, "movi");
       size_t  nBytes = size_t(bufp - (&(headerBuf[0])));
       if (std::fwrite(&(headerBuf[0]), 1, nBytes, aviFile) != nBytes)
@@ -896,64 +1222,361 @@ namespace Ep128Emu {
     }
   }
 
-  void VideoCapture_RLE8::writeAVIIndex()
+
+
+  // --------------------------------------------------------------------------
+
+  VideoCapture_ZMBV::VideoCapture_ZMBV(
+      void (*indexToRGBFunc)(uint8_t color, float& r, float& g, float& b),
+      int frameRate_)
+    : VideoCapture_RLE8(indexToRGBFunc, frameRate_),
+      curFrame((uint8_t *) 0),
+      prvFrame((uint8_t *) 0),
+      prvVectors((int8_t *) 0),
+      compressor((Compressor_ZLib *) 0),
+      framesSinceKeyFrame(0)
+  {
+    videoCodec = 0x564D425AU;           // 'ZMBV'
+    try {
+      curFrame = new uint8_t[videoWidth * videoHeight];
+      prvFrame = new uint8_t[videoWidth * videoHeight];
+      prvVectors = new int8_t[blocksX * blocksY * 2];
+      std::memset(curFrame, 0, size_t(videoWidth * videoHeight));
+      std::memset(prvFrame, 0, size_t(videoWidth * videoHeight));
+      std::memset(prvVectors, 0, size_t(blocksX * blocksY * 2));
+      compressor = new Compressor_ZLib(Compressor_ZLib::compressionLevelFast);
+    }
+    catch (...) {
+      if (curFrame)
+        delete[] curFrame;
+      if (prvFrame)
+        delete[] prvFrame;
+      if (prvVectors)
+        delete[] prvVectors;
+      throw;
+    }
+  }
+
+  VideoCapture_ZMBV::~VideoCapture_ZMBV()
+  {
+    closeFile();
+    delete[] curFrame;
+    delete[] prvFrame;
+    delete[] prvVectors;
+    delete compressor;
+  }
+
+  // returns the number of different pixels between the block at x, y in
+  // the current frame, and the block at x + dx, y + dy in the previous one,
+  // or a value greater than 'maxDiff' if it is exceeded
+
+  int VideoCapture_ZMBV::compareBlock(int x, int y, int w, int h,
+                                      int dx, int dy, int maxDiff) const
+  {
+    if ((x + dx) < 0 || (x + dx + w) > videoWidth ||
+        (y + dy) < 0 || (y + dy + h) > videoHeight) {
+      return (maxDiff + 1);
+    }
+    const uint8_t *p1 = &(curFrame[y * videoWidth + x]);
+    const uint8_t *p2 = &(prvFrame[(y + dy) * videoWidth + (x + dx)]);
+    int     nDiff = 0;
+    for (int yc = 0; yc < h; yc++) {
+      if (std::memcmp(p1, p2, size_t(w)) != 0) {
+        for (int xc = 0; xc < w; xc++)
+          nDiff += int(p1[xc] != p2[xc]);
+        if (nDiff > maxDiff)
+          break;
+      }
+      p1 = p1 + videoWidth;
+      p2 = p2 + videoWidth;
+    }
+    return nDiff;
+  }
+
+  void VideoCapture_ZMBV::encodeKeyFrame()
+  {
+    deltaBuf.resize(768 + size_t(videoWidth * videoHeight));
+    // palette in R, G, B order
+    for (int i = 0; i < 256; i++) {
+      deltaBuf[i * 3 + 0] = colormap[(i * 4) + 2];
+      deltaBuf[i * 3 + 1] = colormap[(i * 4) + 1];
+      deltaBuf[i * 3 + 2] = colormap[(i * 4) + 0];
+    }
+    std::memcpy(&(deltaBuf[768]), curFrame, size_t(videoWidth * videoHeight));
+    std::memset(prvVectors, 0, size_t(blocksX * blocksY * 2));
+    frameBuf.resize(7);
+    frameBuf[0] = 0x01;                 // keyframe
+    frameBuf[1] = 0x00;                 // major version
+    frameBuf[2] = 0x01;                 // minor version
+    frameBuf[3] = 0x01;                 // compression (1 = deflate)
+    frameBuf[4] = 0x04;                 // format (4 = 8 bits per pixel)
+    frameBuf[5] = uint8_t(blockWidth);
+    frameBuf[6] = uint8_t(blockHeight);
+    // start a new deflate stream
+    compressor->compressDataSync(frameBuf, &(deltaBuf.front()),
+                                 deltaBuf.size(), true);
+  }
+
+  void VideoCapture_ZMBV::encodeDeltaFrame()
+  {
+    // motion vectors to try (in pixels), in addition to the vectors of the
+    // left and the previous block
+    static const int8_t searchTable[24][2] = {
+      {   0,  -2 }, {   0,   2 }, {  -2,   0 }, {   2,   0 },
+      {   0,  -4 }, {   0,   4 }, {  -4,   0 }, {   4,   0 },
+      {   0,  -8 }, {   0,   8 }, {  -8,   0 }, {   8,   0 },
+      {   0, -16 }, {   0,  16 }, { -16,   0 }, {  16,   0 },
+      {  -2,  -2 }, {   2,  -2 }, {  -2,   2 }, {   2,   2 },
+      {   0,  -1 }, {   0,   1 }, {  -1,   0 }, {   1,   0 }
+    };
+    size_t  vectorBytes = size_t(((blocksX * blocksY * 2) + 3) & (~3));
+    deltaBuf.resize(vectorBytes);
+    std::memset(&(deltaBuf.front()), 0, vectorBytes);
+    for (int by = 0; by < blocksY; by++) {
+      int     y = by * blockHeight;
+      int     h = (videoHeight - y) < blockHeight ? (videoHeight - y)
+                                                    : blockHeight;
+      for (int bx = 0; bx < blocksX; bx++) {
+        int     x = bx * blockWidth;
+        int     w = (videoWidth - x) < blockWidth ? (videoWidth - x)
+                                                  : blockWidth;
+        int     blockNum = by * blocksX + bx;
+        int     bestDX = 0;
+        int     bestDY = 0;
+        int     bestDiff = compareBlock(x, y, w, h, 0, 0, w * h);
+        for (int i = -2; i < 24 && bestDiff > 0; i++) {
+          int     dx, dy;
+          if (i == -2) {
+            if (bx < 1)
+              continue;
+            dx = int(int8_t(deltaBuf[blockNum * 2 - 2]) >> 1);
+            dy = int(int8_t(deltaBuf[blockNum * 2 - 1]) >> 1);
+          }
+          else if (i == -1) {
+            dx = prvVectors[blockNum * 2];
+            dy = prvVectors[blockNum * 2 + 1];
+          }
+          else {
+            dx = searchTable[i][0];
+            dy = searchTable[i][1];
+          }
+          if (dx == 0 && dy == 0)
+            continue;
+          int     nDiff = compareBlock(x, y, w, h, dx, dy, bestDiff - 1);
+          if (nDiff < bestDiff) {
+            bestDX = dx;
+            bestDY = dy;
+            bestDiff = nDiff;
+          }
+        }
+        prvVectors[blockNum * 2] = int8_t(bestDX);
+        prvVectors[blockNum * 2 + 1] = int8_t(bestDY);
+        deltaBuf[blockNum * 2] = uint8_t(((bestDX * 2) & 0xFE)
+                                         | int(bestDiff > 0));
+        deltaBuf[blockNum * 2 + 1] = uint8_t((bestDY * 2) & 0xFE);
+        if (bestDiff > 0) {
+          // store XOR of the new and the moved old block
+          const uint8_t *p1 = &(curFrame[y * videoWidth + x]);
+          const uint8_t *p2 =
+              &(prvFrame[(y + bestDY) * videoWidth + (x + bestDX)]);
+          size_t  bufPos = deltaBuf.size();
+          deltaBuf.resize(bufPos + size_t(w * h));
+          uint8_t *bufp = &(deltaBuf[bufPos]);
+          for (int yc = 0; yc < h; yc++) {
+            for (int xc = 0; xc < w; xc++)
+              bufp[xc] = p1[xc] ^ p2[xc];
+            bufp = bufp + w;
+            p1 = p1 + videoWidth;
+            p2 = p2 + videoWidth;
+          }
+        }
+      }
+    }
+    frameBuf.resize(1);
+    frameBuf[0] = 0x00;
+    // continue the deflate stream of the previous frame
+    compressor->compressDataSync(frameBuf, &(deltaBuf.front()),
+                                 deltaBuf.size(), false);
+  }
+
+  void VideoCapture_ZMBV::writeFrame(bool frameChanged)
   {
     if (!aviFile)
       return;
     try {
-      if (std::fseek(aviFile, 0L, SEEK_END) < 0)
-        throw Exception("error seeking AVI file");
-      uint8_t   tmpBuf[32];
-      uint8_t   *bufp = &(tmpBuf[0]);
-      aviHeader_writeFourCC(bufp, "idx1");
-      aviHeader_writeUInt32(bufp, uint32_t(framesWritten << 5));
-      fileSize = fileSize + 8;
-      if (std::fwrite(&(tmpBuf[0]), 1, 8, aviFile) != 8)
-        throw Exception("error writing AVI file index");
-      size_t    filePos = 4;
-      for (size_t i = 0; i < framesWritten; i++) {
-        bufp = &(tmpBuf[0]);
-        aviHeader_writeFourCC(bufp, "00dc");
-        size_t    frameBytes = size_t(frameSizes[i]);
-        if (frameBytes > 0)
-          aviHeader_writeUInt32(bufp, 0x00000010U);     // AVIIF_KEYFRAME
+      if (!beginFrame())
+        return;
+      // the first frame of a new output file is always a keyframe
+      bool    isKeyFrame = (framesWritten == 0 ||
+                            framesSinceKeyFrame
+                            >= size_t(frameRate * keyFrameInterval));
+      if (!frameChanged) {
+        if (isKeyFrame || duplicateFrames >= size_t(frameRate))
+          frameChanged = true;
         else
-          aviHeader_writeUInt32(bufp, 0x00000000U);
-        aviHeader_writeUInt32(bufp, uint32_t(filePos));
-        filePos = filePos + frameBytes + 8;
-        aviHeader_writeUInt32(bufp, uint32_t(frameBytes));
-        aviHeader_writeFourCC(bufp, "01wb");
-        aviHeader_writeUInt32(bufp, 0x00000010U);       // AVIIF_KEYFRAME
-        aviHeader_writeUInt32(bufp, uint32_t(filePos));
-        frameBytes = size_t(audioBufSize) << 2;
-        filePos = filePos + frameBytes + 8;
-        aviHeader_writeUInt32(bufp, uint32_t(frameBytes));
-        fileSize = fileSize + 32;
-        if (std::fwrite(&(tmpBuf[0]), 1, 32, aviFile) != 32)
-          throw Exception("error writing AVI file index");
+          duplicateFrames++;
       }
-      if (std::fseek(aviFile, 0L, SEEK_SET) < 0)
-        throw Exception("error seeking AVI file");
-      bufp = &(tmpBuf[0]);
-      aviHeader_writeFourCC(bufp, "RIFF");
-      aviHeader_writeUInt32(bufp, uint32_t(fileSize - 8));
-      if (std::fwrite(&(tmpBuf[0]), 1, 8, aviFile) != 8)
-        throw Exception("error writing AVI file index");
-      if (std::fflush(aviFile) != 0)
-        throw Exception("error writing AVI file index");
+      if (frameChanged) {
+        duplicateFrames = 0;
+        for (int i = (videoHeight - 1); i >= 0; i--) {
+          if (i == (videoHeight - 1) ||
+              !outputFrameBuf.compareLine(i, outputFrameBuf, i + 1)) {
+            decodeLine(&(curFrame[i * videoWidth]), outputFrameBuf[i]);
+          }
+          else {
+            // same as the previous line
+            std::memcpy(&(curFrame[i * videoWidth]),
+                        &(curFrame[(i + 1) * videoWidth]), videoWidth);
+          }
+        }
+        if (isKeyFrame) {
+          encodeKeyFrame();
+          framesSinceKeyFrame = 0;
+        }
+        else {
+          encodeDeltaFrame();
+        }
+        uint8_t *tmp = prvFrame;
+        prvFrame = curFrame;
+        curFrame = tmp;
+        writeFrameChunks(&(frameBuf.front()), frameBuf.size(), isKeyFrame);
+      }
+      else {
+        writeFrameChunks((uint8_t *) 0, 0, false);
+      }
+      framesSinceKeyFrame++;
     }
-    catch (...) {
-      std::fclose(aviFile);
-      aviFile = (std::FILE *) 0;
-      framesWritten = 0;
-      duplicateFrames = 0;
-      fileSize = 0;
-      throw;
+    catch (std::exception& e) {
+      closeFile();
+      errorMessage(e.what());
+      return;
     }
+    endFrame();
   }
 
   // --------------------------------------------------------------------------
 
+  void VideoCapture_YV12::averageChromaLine(uint8_t *buf, const uint8_t *inBuf,
+                                            int nBytes)
+  {
+    int     i = 0;
+#ifdef EP128EMU_VIDEOREC_USE_SSE2
+    for ( ; (i + 16) <= nBytes; i += 16) {
+      __m128i tmp =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf + i));
+      tmp = _mm_avg_epu8(
+                tmp,
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(inBuf + i)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(buf + i), tmp);
+    }
+#endif
+    for ( ; i < nBytes; i++)
+      buf[i] = uint8_t((uint32_t(buf[i]) + uint32_t(inBuf[i]) + 1U) >> 1);
+  }
+
+  void VideoCapture_YV12::accumulateFrame(int32_t *interpBuf,
+                                          const uint8_t *buf0,
+                                          const uint8_t *buf1,
+                                          int32_t scaleFac, int n)
+  {
+    int     i = 0;
+#ifdef EP128EMU_VIDEOREC_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i scaleFac_ = _mm_set1_epi32(scaleFac);
+    for ( ; (i + 16) <= n; i += 16) {
+      __m128i tmp0 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf0 + i));
+      __m128i tmp1 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf1 + i));
+      // 16-bit sums of the two input frames
+      __m128i sumL = _mm_add_epi16(_mm_unpacklo_epi8(tmp0, zero),
+                                   _mm_unpacklo_epi8(tmp1, zero));
+      __m128i sumH = _mm_add_epi16(_mm_unpackhi_epi8(tmp0, zero),
+                                   _mm_unpackhi_epi8(tmp1, zero));
+      __m128i sum[4];
+      sum[0] = _mm_unpacklo_epi16(sumL, zero);
+      sum[1] = _mm_unpackhi_epi16(sumL, zero);
+      sum[2] = _mm_unpacklo_epi16(sumH, zero);
+      sum[3] = _mm_unpackhi_epi16(sumH, zero);
+      for (int j = 0; j < 4; j++) {
+        __m128i *p = reinterpret_cast<__m128i *>(interpBuf + (i + (j << 2)));
+        _mm_storeu_si128(p, _mm_add_epi32(_mm_loadu_si128(p),
+                                          mulLow32_SSE2(sum[j], scaleFac_)));
+      }
+    }
+#endif
+    for ( ; i < n; i++)
+      interpBuf[i] += ((int32_t(buf0[i]) + int32_t(buf1[i])) * scaleFac);
+  }
+
+  bool VideoCapture_YV12::interpolateFrame(uint8_t *outBuf, int32_t *interpBuf,
+                                           const uint8_t *buf0,
+                                           const uint8_t *buf1,
+                                           int32_t scaleFac0,
+                                           int32_t scaleFac1,
+                                           int32_t outScale, int n)
+  {
+    int     i = 0;
+    uint8_t frameChanged = 0x00;
+#ifdef EP128EMU_VIDEOREC_USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i scaleFac0_ = _mm_set1_epi32(scaleFac0);
+    const __m128i scaleFac1_ = _mm_set1_epi32(scaleFac1);
+    const __m128i outScale_ = _mm_set1_epi32(outScale);
+    const __m128i roundOffs = _mm_set1_epi32(0x00200000);
+    const __m128i byteMask = _mm_set1_epi32(0x000000FF);
+    __m128i changedMask = zero;
+    for ( ; (i + 16) <= n; i += 16) {
+      __m128i tmp0 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf0 + i));
+      __m128i tmp1 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(buf1 + i));
+      __m128i in0[4];
+      __m128i in1[4];
+      __m128i out[4];
+      in0[0] = _mm_unpacklo_epi8(tmp0, zero);
+      in0[2] = _mm_unpackhi_epi8(tmp0, zero);
+      in0[1] = _mm_unpackhi_epi16(in0[0], zero);
+      in0[0] = _mm_unpacklo_epi16(in0[0], zero);
+      in0[3] = _mm_unpackhi_epi16(in0[2], zero);
+      in0[2] = _mm_unpacklo_epi16(in0[2], zero);
+      in1[0] = _mm_unpacklo_epi8(tmp1, zero);
+      in1[2] = _mm_unpackhi_epi8(tmp1, zero);
+      in1[1] = _mm_unpackhi_epi16(in1[0], zero);
+      in1[0] = _mm_unpacklo_epi16(in1[0], zero);
+      in1[3] = _mm_unpackhi_epi16(in1[2], zero);
+      in1[2] = _mm_unpacklo_epi16(in1[2], zero);
+      for (int j = 0; j < 4; j++) {
+        __m128i *p = reinterpret_cast<__m128i *>(interpBuf + (i + (j << 2)));
+        __m128i tmp = _mm_add_epi32(mulLow32_SSE2(in0[j], scaleFac0_),
+                                    mulLow32_SSE2(in1[j], scaleFac1_));
+        __m128i d = _mm_srai_epi32(_mm_sub_epi32(_mm_loadu_si128(p), tmp), 8);
+        d = _mm_add_epi32(mulLow32_SSE2(d, outScale_), roundOffs);
+        out[j] = _mm_and_si128(_mm_srai_epi32(d, 22), byteMask);
+        _mm_storeu_si128(p, tmp);
+      }
+      __m128i tmp2 = _mm_packus_epi16(_mm_packs_epi32(out[0], out[1]),
+                                      _mm_packs_epi32(out[2], out[3]));
+      __m128i *outp = reinterpret_cast<__m128i *>(outBuf + i);
+      changedMask = _mm_or_si128(changedMask,
+                                 _mm_xor_si128(tmp2, _mm_loadu_si128(outp)));
+      _mm_storeu_si128(outp, tmp2);
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(changedMask, zero)) != 0xFFFF)
+      frameChanged = 0x01;
+#endif
+    for ( ; i < n; i++) {
+      int32_t tmp = (int32_t(buf0[i]) * scaleFac0)
+                    + (int32_t(buf1[i]) * scaleFac1);
+      uint8_t tmp2 = uint8_t(((((interpBuf[i] - tmp) >> 8) * outScale)
+                              + 0x00200000) >> 22);
+      interpBuf[i] = tmp;
+      frameChanged |= (tmp2 ^ outBuf[i]);
+      outBuf[i] = tmp2;
+    }
+    return bool(frameChanged);
+  }
+
   VideoCapture_YV12::VideoCapture_YV12(
       void (*indexToRGBFunc)(uint8_t color, float& r, float& g, float& b),
       int frameRate_)
@@ -971,7 +1594,6 @@ namespace Ep128Emu {
       outBufY((uint8_t *) 0),
       outBufV((uint8_t *) 0),
       outBufU((uint8_t *) 0),
-      duplicateFrameBitmap((uint8_t *) 0),
       timesliceLength(0L),
       curTime(0L),
       frame0Time(-1L),
@@ -1033,9 +1655,6 @@ namespace Ep128Emu {
       totalSize += bufSize4;
       outBufU = reinterpret_cast<uint8_t *>(&(videoBuf[totalSize]));
       std::memset(outBufU, 0x80, bufSize3);
-      size_t  nBytes = 0x04000000 / size_t(audioBufSize);
-      duplicateFrameBitmap = new uint8_t[nBytes];
-      std::memset(duplicateFrameBitmap, 0x00, nBytes);
       // initialize colormap
       colormap = new uint32_t[256];
       for (int i = 0; i < 256; i++) {
@@ -1063,8 +1682,6 @@ namespace Ep128Emu {
     catch (...) {
       if (lineBuf)
         delete[] reinterpret_cast<uint32_t *>(lineBuf);
-      if (duplicateFrameBitmap)
-        delete[] duplicateFrameBitmap;
       if (colormap)
         delete[] colormap;
       throw;
@@ -1076,7 +1693,6 @@ namespace Ep128Emu {
   {
     closeFile();
     delete[] reinterpret_cast<uint32_t *>(lineBuf);
-    delete[] duplicateFrameBitmap;
     delete[] colormap;
   }
 
@@ -1134,496 +1750,234 @@ namespace Ep128Emu {
   void VideoCapture_YV12::decodeLine()
   {
     int       lineNum = curLine >> 1;
-    int       offs = lineNum * videoWidth;
-    uint8_t   *yPtr = &(frameBuf1Y[offs]);
-    offs = (lineNum >> 1) * (videoWidth >> 1);
-    uint8_t   *vPtr = &(frameBuf1V[offs]);
-    uint8_t   *uPtr = &(frameBuf1U[offs]);
+    uint8_t   *yPtr = &(frameBuf1Y[lineNum * videoWidth]);
+    // chroma is decoded to the end of the line buffer first, and then
+    // copied (even lines) or averaged (odd lines) into the frame buffer
+    uint8_t   *vBuf = &(lineBuf[512]);
+    uint8_t   *uBuf = &(lineBuf[768]);
+    uint8_t   *vPtr = vBuf;
+    uint8_t   *uPtr = uBuf;
     const uint8_t   *bufp = lineBuf;
 
-    if (!(lineNum & 1)) {
-      for (size_t i = 0; i < 48; i++) {
-        uint8_t c = *(bufp++);
-        switch (c) {
-        case 0x01:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
-            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] =
-                uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] =
-                uint8_t((tmp >> 10) & 0xFFU);
-          }
-          break;
-        case 0x02:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            vPtr[1] = vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[1] = uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
-            tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
-            vPtr[3] = vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[3] = uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
-          }
-          break;
-        case 0x03:
-          {
-            unsigned char c0 = *(bufp++);
-            unsigned char c1 = *(bufp++);
-            unsigned char b = *(bufp++);
-            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
-            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
-            yPtr[0] = uint8_t(p0 & 0xFFU);
-            yPtr[1] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[((b &  32) ? c1 : c0)];
-            p1 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[2] = uint8_t(p0 & 0xFFU);
-            yPtr[3] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            yPtr[4] = uint8_t(p0 & 0xFFU);
-            yPtr[5] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[((b &   2) ? c1 : c0)];
-            p1 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[6] = uint8_t(p0 & 0xFFU);
-            yPtr[7] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
-          }
-          break;
-        case 0x04:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
-            tmp = colormap[*(bufp++)];
-            yPtr[3] = yPtr[2] = uint8_t(tmp & 0xFFU);
-            vPtr[1] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[1] = uint8_t((tmp >> 10) & 0xFFU);
-            tmp = colormap[*(bufp++)];
-            yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
-            vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
-            tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = uint8_t(tmp & 0xFFU);
-            vPtr[3] = uint8_t((tmp >> 20) & 0xFFU);
-            uPtr[3] = uint8_t((tmp >> 10) & 0xFFU);
-          }
-          break;
-        case 0x06:
-          {
-            unsigned char c0 = *(bufp++);
-            unsigned char c1 = *(bufp++);
-            unsigned char b = *(bufp++);
-            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
-            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
-            uint32_t  p2 = colormap[((b &  32) ? c1 : c0)];
-            uint32_t  p3 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            p2 = colormap[((b &   2) ? c1 : c0)];
-            p3 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
-            c0 = *(bufp++);
-            c1 = *(bufp++);
-            b = *(bufp++);
-            p0 = colormap[((b & 128) ? c1 : c0)];
-            p1 = colormap[((b &  64) ? c1 : c0)];
-            p2 = colormap[((b &  32) ? c1 : c0)];
-            p3 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            p2 = colormap[((b &   2) ? c1 : c0)];
-            p3 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
-          }
-          break;
-        case 0x08:
-          {
-            uint32_t  p0 = colormap[*(bufp++)];
-            uint32_t  p1 = colormap[*(bufp++)];
-            yPtr[0] = uint8_t(p0 & 0xFFU);
-            yPtr[1] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[2] = uint8_t(p0 & 0xFFU);
-            yPtr[3] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[4] = uint8_t(p0 & 0xFFU);
-            yPtr[5] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[6] = uint8_t(p0 & 0xFFU);
-            yPtr[7] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
-            uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
-          }
-          break;
-        case 0x10:
-          {
-            uint32_t  p0 = colormap[*(bufp++)];
-            uint32_t  p1 = colormap[*(bufp++)];
-            uint32_t  p2 = colormap[*(bufp++)];
-            uint32_t  p3 = colormap[*(bufp++)];
-            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
-            uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
-          }
-          break;
-        default:
+    for (size_t i = 0; i < 48; i++) {
+      uint8_t c = *(bufp++);
+      switch (c) {
+      case 0x01:
+        {
+          uint32_t  tmp = colormap[*(bufp++)];
           yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
-          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = 0x00;
-          vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] = 0x00;
-          uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] = 0x00;
-          break;
+          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+          vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] =
+              uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] =
+              uint8_t((tmp >> 10) & 0xFFU);
         }
-        yPtr = yPtr + 8;
-        vPtr = vPtr + 4;
-        uPtr = uPtr + 4;
+        break;
+      case 0x02:
+        {
+          uint32_t  tmp = colormap[*(bufp++)];
+          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+          vPtr[1] = vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[1] = uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
+          tmp = colormap[*(bufp++)];
+          yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
+          vPtr[3] = vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[3] = uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
+        }
+        break;
+      case 0x03:
+        {
+          unsigned char c0 = *(bufp++);
+          unsigned char c1 = *(bufp++);
+          unsigned char b = *(bufp++);
+          uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
+          uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
+          yPtr[0] = uint8_t(p0 & 0xFFU);
+          yPtr[1] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[((b &  32) ? c1 : c0)];
+          p1 = colormap[((b &  16) ? c1 : c0)];
+          yPtr[2] = uint8_t(p0 & 0xFFU);
+          yPtr[3] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[((b &   8) ? c1 : c0)];
+          p1 = colormap[((b &   4) ? c1 : c0)];
+          yPtr[4] = uint8_t(p0 & 0xFFU);
+          yPtr[5] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[((b &   2) ? c1 : c0)];
+          p1 = colormap[((b &   1) ? c1 : c0)];
+          yPtr[6] = uint8_t(p0 & 0xFFU);
+          yPtr[7] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
+        }
+        break;
+      case 0x04:
+        {
+          uint32_t  tmp = colormap[*(bufp++)];
+          yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
+          vPtr[0] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[0] = uint8_t((tmp >> 10) & 0xFFU);
+          tmp = colormap[*(bufp++)];
+          yPtr[3] = yPtr[2] = uint8_t(tmp & 0xFFU);
+          vPtr[1] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[1] = uint8_t((tmp >> 10) & 0xFFU);
+          tmp = colormap[*(bufp++)];
+          yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
+          vPtr[2] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[2] = uint8_t((tmp >> 10) & 0xFFU);
+          tmp = colormap[*(bufp++)];
+          yPtr[7] = yPtr[6] = uint8_t(tmp & 0xFFU);
+          vPtr[3] = uint8_t((tmp >> 20) & 0xFFU);
+          uPtr[3] = uint8_t((tmp >> 10) & 0xFFU);
+        }
+        break;
+      case 0x06:
+        {
+          unsigned char c0 = *(bufp++);
+          unsigned char c1 = *(bufp++);
+          unsigned char b = *(bufp++);
+          uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
+          uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
+          uint32_t  p2 = colormap[((b &  32) ? c1 : c0)];
+          uint32_t  p3 = colormap[((b &  16) ? c1 : c0)];
+          yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[((b &   8) ? c1 : c0)];
+          p1 = colormap[((b &   4) ? c1 : c0)];
+          p2 = colormap[((b &   2) ? c1 : c0)];
+          p3 = colormap[((b &   1) ? c1 : c0)];
+          yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
+          c0 = *(bufp++);
+          c1 = *(bufp++);
+          b = *(bufp++);
+          p0 = colormap[((b & 128) ? c1 : c0)];
+          p1 = colormap[((b &  64) ? c1 : c0)];
+          p2 = colormap[((b &  32) ? c1 : c0)];
+          p3 = colormap[((b &  16) ? c1 : c0)];
+          yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[((b &   8) ? c1 : c0)];
+          p1 = colormap[((b &   4) ? c1 : c0)];
+          p2 = colormap[((b &   2) ? c1 : c0)];
+          p3 = colormap[((b &   1) ? c1 : c0)];
+          yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
+        }
+        break;
+      case 0x08:
+        {
+          uint32_t  p0 = colormap[*(bufp++)];
+          uint32_t  p1 = colormap[*(bufp++)];
+          yPtr[0] = uint8_t(p0 & 0xFFU);
+          yPtr[1] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[0] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[0] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          yPtr[2] = uint8_t(p0 & 0xFFU);
+          yPtr[3] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[1] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[1] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          yPtr[4] = uint8_t(p0 & 0xFFU);
+          yPtr[5] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[2] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[2] = uint8_t((p0 >> 11) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          yPtr[6] = uint8_t(p0 & 0xFFU);
+          yPtr[7] = uint8_t(p1 & 0xFFU);
+          p0 = (p0 + p1) + 0x00100400U;
+          vPtr[3] = uint8_t((p0 >> 21) & 0xFFU);
+          uPtr[3] = uint8_t((p0 >> 11) & 0xFFU);
+        }
+        break;
+      case 0x10:
+        {
+          uint32_t  p0 = colormap[*(bufp++)];
+          uint32_t  p1 = colormap[*(bufp++)];
+          uint32_t  p2 = colormap[*(bufp++)];
+          uint32_t  p3 = colormap[*(bufp++)];
+          yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[0] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[0] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          p2 = colormap[*(bufp++)];
+          p3 = colormap[*(bufp++)];
+          yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[1] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[1] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          p2 = colormap[*(bufp++)];
+          p3 = colormap[*(bufp++)];
+          yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[2] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[2] = uint8_t((p0 >> 12) & 0xFFU);
+          p0 = colormap[*(bufp++)];
+          p1 = colormap[*(bufp++)];
+          p2 = colormap[*(bufp++)];
+          p3 = colormap[*(bufp++)];
+          yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
+          yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
+          p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
+          vPtr[3] = uint8_t((p0 >> 22) & 0xFFU);
+          uPtr[3] = uint8_t((p0 >> 12) & 0xFFU);
+        }
+        break;
+      default:
+        yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
+        yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = 0x00;
+        vPtr[3] = vPtr[2] = vPtr[1] = vPtr[0] = 0x00;
+        uPtr[3] = uPtr[2] = uPtr[1] = uPtr[0] = 0x00;
+        break;
       }
+      yPtr = yPtr + 8;
+      vPtr = vPtr + 4;
+      uPtr = uPtr + 4;
+    }
+
+    int       offs = (lineNum >> 1) * (videoWidth >> 1);
+    if (!(lineNum & 1)) {
+      std::memcpy(&(frameBuf1V[offs]), vBuf, size_t(videoWidth >> 1));
+      std::memcpy(&(frameBuf1U[offs]), uBuf, size_t(videoWidth >> 1));
     }
     else {
-      for (size_t i = 0; i < 48; i++) {
-        uint8_t c = *(bufp++);
-        switch (c) {
-        case 0x01:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
-            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            uint32_t  v = (tmp >> 20) & 0xFFU;
-            uint32_t  u = (tmp >> 10) & 0xFFU;
-            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
-            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
-            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
-            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
-            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
-            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
-            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
-            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
-          }
-          break;
-        case 0x02:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            uint32_t  v = (tmp >> 20) & 0xFFU;
-            uint32_t  u = (tmp >> 10) & 0xFFU;
-            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
-            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
-            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
-            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
-            tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
-            v = (tmp >> 20) & 0xFFU;
-            u = (tmp >> 10) & 0xFFU;
-            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
-            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
-            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
-            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
-          }
-          break;
-        case 0x03:
-          {
-            unsigned char c0 = *(bufp++);
-            unsigned char c1 = *(bufp++);
-            unsigned char b = *(bufp++);
-            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
-            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
-            yPtr[0] = uint8_t(p0 & 0xFFU);
-            yPtr[1] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[0] =
-                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[0] =
-                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &  32) ? c1 : c0)];
-            p1 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[2] = uint8_t(p0 & 0xFFU);
-            yPtr[3] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[1] =
-                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[1] =
-                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            yPtr[4] = uint8_t(p0 & 0xFFU);
-            yPtr[5] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[2] =
-                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[2] =
-                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &   2) ? c1 : c0)];
-            p1 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[6] = uint8_t(p0 & 0xFFU);
-            yPtr[7] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[3] =
-                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[3] =
-                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-          }
-          break;
-        case 0x04:
-          {
-            uint32_t  tmp = colormap[*(bufp++)];
-            yPtr[1] = yPtr[0] = uint8_t(tmp & 0xFFU);
-            uint32_t  v = (tmp >> 20) & 0xFFU;
-            uint32_t  u = (tmp >> 10) & 0xFFU;
-            vPtr[0] = uint8_t((uint32_t(vPtr[0]) + v + 1U) >> 1);
-            uPtr[0] = uint8_t((uint32_t(uPtr[0]) + u + 1U) >> 1);
-            tmp = colormap[*(bufp++)];
-            yPtr[3] = yPtr[2] = uint8_t(tmp & 0xFFU);
-            v = (tmp >> 20) & 0xFFU;
-            u = (tmp >> 10) & 0xFFU;
-            vPtr[1] = uint8_t((uint32_t(vPtr[1]) + v + 1U) >> 1);
-            uPtr[1] = uint8_t((uint32_t(uPtr[1]) + u + 1U) >> 1);
-            tmp = colormap[*(bufp++)];
-            yPtr[5] = yPtr[4] = uint8_t(tmp & 0xFFU);
-            v = (tmp >> 20) & 0xFFU;
-            u = (tmp >> 10) & 0xFFU;
-            vPtr[2] = uint8_t((uint32_t(vPtr[2]) + v + 1U) >> 1);
-            uPtr[2] = uint8_t((uint32_t(uPtr[2]) + u + 1U) >> 1);
-            tmp = colormap[*(bufp++)];
-            yPtr[7] = yPtr[6] = uint8_t(tmp & 0xFFU);
-            v = (tmp >> 20) & 0xFFU;
-            u = (tmp >> 10) & 0xFFU;
-            vPtr[3] = uint8_t((uint32_t(vPtr[3]) + v + 1U) >> 1);
-            uPtr[3] = uint8_t((uint32_t(uPtr[3]) + u + 1U) >> 1);
-          }
-          break;
-        case 0x06:
-          {
-            unsigned char c0 = *(bufp++);
-            unsigned char c1 = *(bufp++);
-            unsigned char b = *(bufp++);
-            uint32_t  p0 = colormap[((b & 128) ? c1 : c0)];
-            uint32_t  p1 = colormap[((b &  64) ? c1 : c0)];
-            uint32_t  p2 = colormap[((b &  32) ? c1 : c0)];
-            uint32_t  p3 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[0] =
-                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[0] =
-                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            p2 = colormap[((b &   2) ? c1 : c0)];
-            p3 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[1] =
-                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[1] =
-                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            c0 = *(bufp++);
-            c1 = *(bufp++);
-            b = *(bufp++);
-            p0 = colormap[((b & 128) ? c1 : c0)];
-            p1 = colormap[((b &  64) ? c1 : c0)];
-            p2 = colormap[((b &  32) ? c1 : c0)];
-            p3 = colormap[((b &  16) ? c1 : c0)];
-            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[2] =
-                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[2] =
-                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[((b &   8) ? c1 : c0)];
-            p1 = colormap[((b &   4) ? c1 : c0)];
-            p2 = colormap[((b &   2) ? c1 : c0)];
-            p3 = colormap[((b &   1) ? c1 : c0)];
-            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[3] =
-                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[3] =
-                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-          }
-          break;
-        case 0x08:
-          {
-            uint32_t  p0 = colormap[*(bufp++)];
-            uint32_t  p1 = colormap[*(bufp++)];
-            yPtr[0] = uint8_t(p0 & 0xFFU);
-            yPtr[1] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[0] =
-                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[0] =
-                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[2] = uint8_t(p0 & 0xFFU);
-            yPtr[3] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[1] =
-                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[1] =
-                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[4] = uint8_t(p0 & 0xFFU);
-            yPtr[5] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[2] =
-                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[2] =
-                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            yPtr[6] = uint8_t(p0 & 0xFFU);
-            yPtr[7] = uint8_t(p1 & 0xFFU);
-            p0 = (p0 + p1) + 0x00100400U;
-            vPtr[3] =
-                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 21) & 0xFFU) + 1U) >> 1);
-            uPtr[3] =
-                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 11) & 0xFFU) + 1U) >> 1);
-          }
-          break;
-        case 0x10:
-          {
-            uint32_t  p0 = colormap[*(bufp++)];
-            uint32_t  p1 = colormap[*(bufp++)];
-            uint32_t  p2 = colormap[*(bufp++)];
-            uint32_t  p3 = colormap[*(bufp++)];
-            yPtr[0] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[1] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[0] =
-                uint8_t((uint32_t(vPtr[0]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[0] =
-                uint8_t((uint32_t(uPtr[0]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[2] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[3] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[1] =
-                uint8_t((uint32_t(vPtr[1]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[1] =
-                uint8_t((uint32_t(uPtr[1]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[4] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[5] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[2] =
-                uint8_t((uint32_t(vPtr[2]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[2] =
-                uint8_t((uint32_t(uPtr[2]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-            p0 = colormap[*(bufp++)];
-            p1 = colormap[*(bufp++)];
-            p2 = colormap[*(bufp++)];
-            p3 = colormap[*(bufp++)];
-            yPtr[6] = uint8_t(((p0 + p1 + 1U) >> 1) & 0xFFU);
-            yPtr[7] = uint8_t(((p2 + p3 + 1U) >> 1) & 0xFFU);
-            p0 = (p0 + p1 + p2 + p3) + 0x00200800U;
-            vPtr[3] =
-                uint8_t((uint32_t(vPtr[3]) + ((p0 >> 22) & 0xFFU) + 1U) >> 1);
-            uPtr[3] =
-                uint8_t((uint32_t(uPtr[3]) + ((p0 >> 12) & 0xFFU) + 1U) >> 1);
-          }
-          break;
-        default:
-          yPtr[7] = yPtr[6] = yPtr[5] = yPtr[4] =
-          yPtr[3] = yPtr[2] = yPtr[1] = yPtr[0] = 0x00;
-          vPtr[0] = uint8_t((uint32_t(vPtr[0]) + 1U) >> 1);
-          vPtr[1] = uint8_t((uint32_t(vPtr[1]) + 1U) >> 1);
-          vPtr[2] = uint8_t((uint32_t(vPtr[2]) + 1U) >> 1);
-          vPtr[3] = uint8_t((uint32_t(vPtr[3]) + 1U) >> 1);
-          uPtr[0] = uint8_t((uint32_t(uPtr[0]) + 1U) >> 1);
-          uPtr[1] = uint8_t((uint32_t(uPtr[1]) + 1U) >> 1);
-          uPtr[2] = uint8_t((uint32_t(uPtr[2]) + 1U) >> 1);
-          uPtr[3] = uint8_t((uint32_t(uPtr[3]) + 1U) >> 1);
-          break;
-        }
-        yPtr = yPtr + 8;
-        vPtr = vPtr + 4;
-        uPtr = uPtr + 4;
-      }
+      averageChromaLine(&(frameBuf1V[offs]), vBuf, videoWidth >> 1);
+      averageChromaLine(&(frameBuf1U[offs]), uBuf, videoWidth >> 1);
     }
   }
 
@@ -1646,29 +2000,11 @@ namespace Ep128Emu {
       int32_t   scaleFac1 = int32_t(double(t1) * (2.0 - tt) + 0.5);
       int32_t   outScale = int32_t(0x20000000) / (interpTime - t1);
       interpTime = t1;
-      int       n = (videoWidth * videoHeight * 3) / 2;
-      int       i = 0;
-      uint8_t   frameChanged = 0x00;
-      do {
-        int32_t   tmp;
-        uint8_t   tmp2;
-        tmp = (int32_t(frameBuf0Y[i]) * scaleFac0)
-              + (int32_t(frameBuf1Y[i]) * scaleFac1);
-        tmp2 = uint8_t(((((interpBufY[i] - tmp) >> 8) * outScale)
-                        + 0x00200000) >> 22);
-        interpBufY[i] = tmp;
-        frameChanged |= (tmp2 ^ outBufY[i]);
-        outBufY[i] = tmp2;
-        i++;
-        tmp = (int32_t(frameBuf0Y[i]) * scaleFac0)
-              + (int32_t(frameBuf1Y[i]) * scaleFac1);
-        tmp2 = uint8_t(((((interpBufY[i] - tmp) >> 8) * outScale)
-                        + 0x00200000) >> 22);
-        interpBufY[i] = tmp;
-        frameChanged |= (tmp2 ^ outBufY[i]);
-        outBufY[i] = tmp2;
-      } while (++i < n);
-      writeFrame(bool(frameChanged));
+      bool      frameChanged =
+          interpolateFrame(outBufY, interpBufY, frameBuf0Y, frameBuf1Y,
+                           scaleFac0, scaleFac1, outScale,
+                           (videoWidth * videoHeight * 3) / 2);
+      writeFrame(frameChanged);
       audioBufReadPos += (audioBufSize * 2);
       while (audioBufReadPos >= (audioBufSize * audioBuffers * 2))
         audioBufReadPos -= (audioBufSize * audioBuffers * 2);
@@ -1705,15 +2041,8 @@ namespace Ep128Emu {
     int32_t   scaleFac =
         int32_t(((frame1Time - frame0Time) + int64_t(0x80000000UL)) >> 32);
     interpTime += scaleFac;
-    int       n = (videoWidth * videoHeight * 3) / 2;
-    int       i = 0;
-    do {
-      interpBufY[i] +=
-          ((int32_t(frameBuf0Y[i]) + int32_t(frameBuf1Y[i])) * scaleFac);
-      i++;
-      interpBufY[i] +=
-          ((int32_t(frameBuf0Y[i]) + int32_t(frameBuf1Y[i])) * scaleFac);
-    } while (++i < n);
+    accumulateFrame(interpBufY, frameBuf0Y, frameBuf1Y, scaleFac,
+                    (videoWidth * videoHeight * 3) / 2);
   }
 
   void VideoCapture_YV12::writeFrame(bool frameChanged)
@@ -1726,80 +2055,22 @@ namespace Ep128Emu {
       else
         duplicateFrames++;
     }
-    if (frameChanged) {
+    if (frameChanged)
       duplicateFrames = 0;
-      duplicateFrameBitmap[framesWritten >> 3] &=
-          uint8_t((1 << (framesWritten & 7)) ^ 0xFF);
-    }
-    else {
-      duplicateFrameBitmap[framesWritten >> 3] |=
-          uint8_t(1 << (framesWritten & 7));
-    }
     try {
-      if (fileSize >= 0x7F800000) {
-        closeFile();
-        try {
-          errorMessage("AVI file is too large, starting new output file");
-        }
-        catch (...) {
-        }
-        std::string fileName = "";
-        fileNameCallback(fileNameCallbackUserData, fileName);
-        if (fileName.length() < 1)
-          return;
-        openFile(fileName.c_str());
-      }
-      if (std::fseek(aviFile, 0L, SEEK_END) < 0)
-        throw Exception("error seeking AVI file");
-      uint8_t headerBuf[8];
-      uint8_t *bufp = &(headerBuf[0]);
+      if (!beginFrame())
+        return;
       size_t  nBytes = 0;
       if (frameChanged)
         nBytes = size_t((videoWidth * videoHeight * 3) / 2);
-      aviHeader_writeFourCC(bufp, "00dc");
-      aviHeader_writeUInt32(bufp, uint32_t(nBytes));
-      fileSize = fileSize + 8;
-      if (std::fwrite(&(headerBuf[0]), 1, 8, aviFile) != 8)
-        throw Exception("error writing AVI file");
-      if (nBytes > 0) {
-        fileSize = fileSize + nBytes;
-        if (std::fwrite(&(outBufY[0]), 1, nBytes, aviFile) != nBytes)
-          throw Exception("error writing AVI file");
-      }
-      bufp = &(headerBuf[0]);
-      nBytes = size_t(audioBufSize * 4);
-      aviHeader_writeFourCC(bufp, "01wb");
-      aviHeader_writeUInt32(bufp, uint32_t(nBytes));
-      fileSize = fileSize + 8;
-      if (std::fwrite(&(headerBuf[0]), 1, 8, aviFile) != 8)
-        throw Exception("error writing AVI file");
-      int     bufPos = audioBufReadPos;
-      for (int i = 0; i < (audioBufSize * 2); i++) {
-        if (bufPos >= (audioBufSize * audioBuffers * 2))
-          bufPos = 0;
-        int16_t tmp = audioBuf[bufPos++];
-        fileSize++;
-        if (std::fputc(int(uint16_t(tmp) & 0xFF), aviFile) == EOF)
-          throw Exception("error writing AVI file");
-        fileSize++;
-        if (std::fputc(int((uint16_t(tmp) >> 8) & 0xFF), aviFile) == EOF)
-          throw Exception("error writing AVI file");
-      }
+      writeFrameChunks(outBufY, nBytes);
     }
     catch (std::exception& e) {
       closeFile();
       errorMessage(e.what());
       return;
     }
-    framesWritten++;
-    if (!(framesWritten & 31)) {
-      try {
-        writeAVIHeader();
-      }
-      catch (std::exception& e) {
-        errorMessage(e.what());
-      }
-    }
+    endFrame();
   }
 
   void VideoCapture_YV12::writeAVIHeader()
@@ -1809,15 +2080,16 @@ namespace Ep128Emu {
     try {
       if (std::fseek(aviFile, 0L, SEEK_SET) < 0)
         throw Exception("error seeking AVI file");
-      uint8_t   headerBuf[512];
+      std::vector< uint8_t >  headerBuf(aviHeaderSize);
       uint8_t   *bufp = &(headerBuf[0]);
       size_t    frameSize = size_t(((videoWidth * videoHeight * 3) / 2)
                                    + (audioBufSize * 4) + 16);
       aviHeader_writeFourCC(bufp, "RIFF");
-      aviHeader_writeUInt32(bufp, uint32_t(fileSize - 8));
+      aviHeader_writeUInt32(bufp, aviHeader_getRIFFSize());
       aviHeader_writeFourCC(bufp, "AVI ");
       aviHeader_writeFourCC(bufp, "LIST");
-      aviHeader_writeUInt32(bufp, 0x00000126U);
+      aviHeader_writeUInt32(bufp, uint32_t(0x00000126U + (aviSuperIndexSize * 2)
+                                           + aviODMLHeaderSize));
       aviHeader_writeFourCC(bufp, "hdrl");
       aviHeader_writeFourCC(bufp, "avih");
       aviHeader_writeUInt32(bufp, 0x00000038U);
@@ -1830,8 +2102,8 @@ namespace Ep128Emu {
       aviHeader_writeUInt32(bufp, 0x00000001U);
       // flags (AVIF_HASINDEX | AVIF_ISINTERLEAVED | AVIF_TRUSTCKTYPE)
       aviHeader_writeUInt32(bufp, 0x00000910U);
-      // total frames
-      aviHeader_writeUInt32(bufp, uint32_t(framesWritten));
+      // total frames (in the first RIFF chunk)
+      aviHeader_writeUInt32(bufp, uint32_t(aviHeader_getTotalFrames()));
       // initial frames
       aviHeader_writeUInt32(bufp, 0x00000000U);
       // number of streams
@@ -1848,7 +2120,7 @@ namespace Ep128Emu {
       aviHeader_writeUInt32(bufp, 0x00000000U);
       aviHeader_writeUInt32(bufp, 0x00000000U);
       aviHeader_writeFourCC(bufp, "LIST");
-      aviHeader_writeUInt32(bufp, 0x00000074U);
+      aviHeader_writeUInt32(bufp, uint32_t(0x00000074U + aviSuperIndexSize));
       aviHeader_writeFourCC(bufp, "strl");
       aviHeader_writeFourCC(bufp, "strh");
       aviHeader_writeUInt32(bufp, 0x00000038U);
@@ -1908,8 +2180,9 @@ namespace Ep128Emu {
       aviHeader_writeUInt32(bufp, 0x00000000U);
       // color indexes required
       aviHeader_writeUInt32(bufp, 0x00000000U);
+      aviHeader_writeSuperIndex(bufp, 0);
       aviHeader_writeFourCC(bufp, "LIST");
-      aviHeader_writeUInt32(bufp, 0x0000005EU);
+      aviHeader_writeUInt32(bufp, uint32_t(0x0000005EU + aviSuperIndexSize));
       aviHeader_writeFourCC(bufp, "strl");
       aviHeader_writeFourCC(bufp, "strh");
       aviHeader_writeUInt32(bufp, 0x00000038U);
@@ -1963,8 +2236,10 @@ namespace Ep128Emu {
       aviHeader_writeUInt16(bufp, 0x0010);
       // additional format information size
       aviHeader_writeUInt16(bufp, 0x0000);
+      aviHeader_writeSuperIndex(bufp, 1);
+      aviHeader_writeODMLHeader(bufp);
       aviHeader_writeFourCC(bufp, "LIST");
-      aviHeader_writeUInt32(bufp, uint32_t((fileSize - aviHeaderSize) + 4));
+      aviHeader_writeUInt32(bufp, aviHeader_getMoviSize());
       aviHeader_writeFourCC(bufp, "movi");
       size_t  nBytes = size_t(bufp - (&(headerBuf[0])));
       if (std::fwrite(&(headerBuf[0]), 1, nBytes, aviFile) != nBytes)
@@ -1982,63 +2257,263 @@ namespace Ep128Emu {
     }
   }
 
-  void VideoCapture_YV12::writeAVIIndex()
+
+
+
+  // --------------------------------------------------------------------------
+
+  // event types stored in the upper 8 bits of the first word of each event
+
+  // audio samples, the lower 24 bits are the number of samples (1 to 128)
+  // that follow
+  static const uint32_t videoCaptureEvent_Audio       = 0x01000000U;
+  // line data, the lower 24 bits are the number of bytes, which are stored
+  // in the following words
+  static const uint32_t videoCaptureEvent_HSync       = 0x02000000U;
+  // bit 8 = new VSYNC state, bits 0 to 7 = current slot
+  static const uint32_t videoCaptureEvent_VSync       = 0x03000000U;
+  // the new clock frequency is stored in the next word
+  static const uint32_t videoCaptureEvent_ClockFreq   = 0x04000000U;
+  // the capture thread signals syncLock when reaching this event
+  static const uint32_t videoCaptureEvent_Sync        = 0x05000000U;
+  // the capture thread returns after processing this event
+  static const uint32_t videoCaptureEvent_Quit        = 0x06000000U;
+
+  VideoCapture_Async::VideoCapture_Async(VideoCapture *videoCapture_,
+                                         int frameRate_)
+    : VideoCapture(frameRate_),
+      Thread(),
+      videoCapture(videoCapture_),
+      writeBuf((uint32_t *) 0),
+      writePos(0),
+      audioBlockHeader((uint32_t *) 0),
+      writeBufIndex(0),
+      readBufIndex(0),
+      syncLock(false),
+      pendingError(""),
+      pendingErrorFlag(false),
+      reportedError("")
+  {
+    try {
+      for (int i = 0; i < nBuffers; i++)
+        buffers[i].buf = new uint32_t[bufferSize];
+    }
+    catch (...) {
+      for (int i = 0; i < nBuffers; i++) {
+        if (buffers[i].buf)
+          delete[] buffers[i].buf;
+      }
+      delete videoCapture;
+      throw;
+    }
+    buffers[0].writeLock.wait();
+    writeBuf = buffers[0].buf;
+    this->start();
+  }
+
+  VideoCapture_Async::~VideoCapture_Async()
   {
-    if (!aviFile)
-      return;
+    // post the Quit event without beginEvent(), because checkError() may
+    // throw an exception, and any error not reported yet is ignored
+    if (writePos >= bufferSize)
+      flushBuffer();
+    writeBuf[writePos++] = videoCaptureEvent_Quit;
+    flushBuffer();
+    this->join();
+    delete videoCapture;
+    for (int i = 0; i < nBuffers; i++)
+      delete[] buffers[i].buf;
+  }
+
+  void VideoCapture_Async::flushBuffer()
+  {
+    buffers[writeBufIndex].nWords = writePos;
+    buffers[writeBufIndex].readLock.notify();
+    writeBufIndex = (writeBufIndex + 1) & (nBuffers - 1);
+    // wait until the capture thread has finished reading the next buffer
+    buffers[writeBufIndex].writeLock.wait();
+    writeBuf = buffers[writeBufIndex].buf;
+    writePos = 0;
+    audioBlockHeader = (uint32_t *) 0;
+  }
+
+  inline void VideoCapture_Async::beginEvent(uint32_t eventHeader,
+                                             size_t nWords)
+  {
+    audioBlockHeader = (uint32_t *) 0;
+    if ((writePos + nWords) > bufferSize) {
+      flushBuffer();
+      checkError();
+    }
+    writeBuf[writePos++] = eventHeader;
+  }
+
+  void VideoCapture_Async::waitForCaptureThread()
+  {
+    beginEvent(videoCaptureEvent_Sync, 1);
+    flushBuffer();
+    syncLock.wait();
+    checkError();
+  }
+
+  void VideoCapture_Async::checkError()
+  {
+    bool    errorFlag = false;
+    pendingErrorMutex.lock();
     try {
-      if (std::fseek(aviFile, 0L, SEEK_END) < 0)
-        throw Exception("error seeking AVI file");
-      uint8_t   tmpBuf[32];
-      uint8_t   *bufp = &(tmpBuf[0]);
-      aviHeader_writeFourCC(bufp, "idx1");
-      aviHeader_writeUInt32(bufp, uint32_t(framesWritten << 5));
-      fileSize = fileSize + 8;
-      if (std::fwrite(&(tmpBuf[0]), 1, 8, aviFile) != 8)
-        throw Exception("error writing AVI file index");
-      size_t    filePos = 4;
-      for (size_t i = 0; i < framesWritten; i++) {
-        bufp = &(tmpBuf[0]);
-        aviHeader_writeFourCC(bufp, "00dc");
-        size_t    frameBytes = 0;
-        if (!(duplicateFrameBitmap[i >> 3] & uint8_t(1 << (i & 7)))) {
-          aviHeader_writeUInt32(bufp, 0x00000010U);     // AVIIF_KEYFRAME
-          frameBytes = size_t((videoWidth * videoHeight * 3) / 2);
-        }
-        else {
-          aviHeader_writeUInt32(bufp, 0x00000000U);
-        }
-        aviHeader_writeUInt32(bufp, uint32_t(filePos));
-        filePos = filePos + frameBytes + 8;
-        aviHeader_writeUInt32(bufp, uint32_t(frameBytes));
-        aviHeader_writeFourCC(bufp, "01wb");
-        aviHeader_writeUInt32(bufp, 0x00000010U);       // AVIIF_KEYFRAME
-        aviHeader_writeUInt32(bufp, uint32_t(filePos));
-        frameBytes = size_t(audioBufSize) << 2;
-        filePos = filePos + frameBytes + 8;
-        aviHeader_writeUInt32(bufp, uint32_t(frameBytes));
-        fileSize = fileSize + 32;
-        if (std::fwrite(&(tmpBuf[0]), 1, 32, aviFile) != 32)
-          throw Exception("error writing AVI file index");
+      if (pendingErrorFlag) {
+        reportedError = pendingError;
+        pendingErrorFlag = false;
+        errorFlag = true;
       }
-      if (std::fseek(aviFile, 0L, SEEK_SET) < 0)
-        throw Exception("error seeking AVI file");
-      bufp = &(tmpBuf[0]);
-      aviHeader_writeFourCC(bufp, "RIFF");
-      aviHeader_writeUInt32(bufp, uint32_t(fileSize - 8));
-      if (std::fwrite(&(tmpBuf[0]), 1, 8, aviFile) != 8)
-        throw Exception("error writing AVI file index");
-      if (std::fflush(aviFile) != 0)
-        throw Exception("error writing AVI file index");
     }
     catch (...) {
-      std::fclose(aviFile);
-      aviFile = (std::FILE *) 0;
-      framesWritten = 0;
-      duplicateFrames = 0;
-      fileSize = 0;
+      pendingErrorMutex.unlock();
       throw;
     }
+    pendingErrorMutex.unlock();
+    if (errorFlag)
+      errorMessage(reportedError.c_str());
+  }
+
+  void VideoCapture_Async::run()
+  {
+    bool    quitFlag = false;
+    do {
+      Buffer& b = buffers[readBufIndex];
+      b.readLock.wait();
+      const uint32_t  *bufp = b.buf;
+      const uint32_t  *endp = b.buf + b.nWords;
+      while (bufp < endp) {
+        uint32_t  eventHeader = *(bufp++);
+        uint32_t  n = eventHeader & 0x00FFFFFFU;
+        // find the next event first, so that the rest of the buffer is
+        // still processed (including Sync and Quit) if there is an error
+        const uint32_t  *nextp = bufp;
+        switch (eventHeader & 0xFF000000U) {
+        case videoCaptureEvent_Audio:
+          nextp = bufp + n;
+          break;
+        case videoCaptureEvent_HSync:
+          nextp = bufp + ((n + 3U) >> 2);
+          break;
+        case videoCaptureEvent_ClockFreq:
+          nextp = bufp + 1;
+          break;
+        }
+        try {
+          switch (eventHeader & 0xFF000000U) {
+          case videoCaptureEvent_Audio:
+            do {
+              videoCapture->runOneCycle(*(bufp++));
+            } while (--n);
+            break;
+          case videoCaptureEvent_HSync:
+            videoCapture->horizontalSync(
+                reinterpret_cast<const uint8_t *>(bufp), size_t(n));
+            break;
+          case videoCaptureEvent_VSync:
+            videoCapture->vsyncStateChange(bool(n & 0x0100U),
+                                           (unsigned int) (n & 0xFFU));
+            break;
+          case videoCaptureEvent_ClockFreq:
+            videoCapture->setClockFrequency(size_t(*bufp));
+            break;
+          case videoCaptureEvent_Sync:
+            syncLock.notify();
+            break;
+          case videoCaptureEvent_Quit:
+            quitFlag = true;
+            break;
+          }
+        }
+        catch (std::exception& e) {
+          // forward the error to the emulation thread (see checkError())
+          pendingErrorMutex.lock();
+          try {
+            if (!pendingErrorFlag) {
+              pendingError = e.what();
+              pendingErrorFlag = true;
+            }
+          }
+          catch (...) {
+          }
+          pendingErrorMutex.unlock();
+        }
+        bufp = nextp;
+      }
+      b.writeLock.notify();
+      readBufIndex = (readBufIndex + 1) & (nBuffers - 1);
+    } while (!quitFlag);
+  }
+
+  void VideoCapture_Async::writeAVIHeader()
+  {
+  }
+
+  void VideoCapture_Async::runOneCycle(uint32_t audioInput)
+  {
+    if (EP128EMU_UNLIKELY(!audioBlockHeader)) {
+      if ((writePos + 129) > bufferSize) {
+        flushBuffer();
+        checkError();
+      }
+      audioBlockHeader = &(writeBuf[writePos++]);
+      *audioBlockHeader = videoCaptureEvent_Audio;
+    }
+    writeBuf[writePos++] = audioInput;
+    if (EP128EMU_UNLIKELY(++(*audioBlockHeader)
+                          >= (videoCaptureEvent_Audio + 128U))) {
+      audioBlockHeader = (uint32_t *) 0;
+    }
+  }
+
+  void VideoCapture_Async::setClockFrequency(size_t freq_)
+  {
+    if (freq_ == clockFrequency)
+      return;
+    clockFrequency = freq_;
+    beginEvent(videoCaptureEvent_ClockFreq, 2);
+    writeBuf[writePos++] = uint32_t(freq_);
+  }
+
+  void VideoCapture_Async::horizontalSync(const uint8_t *buf, size_t nBytes)
+  {
+    size_t  nWords = (nBytes + 3) >> 2;
+    beginEvent(videoCaptureEvent_HSync | uint32_t(nBytes), nWords + 1);
+    if (nWords > 0) {
+      writeBuf[writePos + nWords - 1] = 0U;
+      std::memcpy(&(writeBuf[writePos]), buf, nBytes);
+      writePos = writePos + nWords;
+    }
+  }
+
+  void VideoCapture_Async::vsyncStateChange(bool newState,
+                                            unsigned int currentSlot_)
+  {
+    beginEvent(videoCaptureEvent_VSync
+               | (uint32_t(newState) << 8) | uint32_t(currentSlot_ & 0xFFU),
+               1);
+  }
+
+  void VideoCapture_Async::openFile(const char *fileName)
+  {
+    waitForCaptureThread();
+    videoCapture->openFile(fileName);
+  }
+
+  void VideoCapture_Async::setErrorCallback(
+      void (*func)(void *userData, const char *msg), void *userData_)
+  {
+    waitForCaptureThread();
+    videoCapture->setErrorCallback(func, userData_);
+  }
+
+  void VideoCapture_Async::setFileNameCallback(
+      void (*func)(void *userData, std::string& fileName), void *userData_)
+  {
+    waitForCaptureThread();
+    videoCapture->setFileNameCallback(func, userData_);
   }
 
 }       // namespace Ep128Emu
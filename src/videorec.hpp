@@ -23,9 +23,14 @@
 #include "ep128emu.hpp"
 #include "display.hpp"
 #include "snd_conv.hpp"
+#include "system.hpp"
+
+#include <vector>
 
 namespace Ep128Emu {
 
+  class Compressor_ZLib;
+
   class VideoCapture {
    public:
     static const int  sampleRate = 48000;
@@ -60,21 +65,75 @@ namespace Ep128Emu {
     bool        oddFrame;
     size_t      framesWritten;
     size_t      duplicateFrames;
-    size_t      fileSize;
+    uint64_t    fileSize;
     AudioConverter  *audioConverter;
     size_t      aviHeaderSize;
     void        (*errorCallback)(void *userData, const char *msg);
     void        *errorCallbackUserData;
     void        (*fileNameCallback)(void *userData, std::string& fileName);
     void        *fileNameCallbackUserData;
+   private:
+    // OpenDML (AVI 2.0) index data
+    struct AVIIndexEntry {
+      uint64_t  filePos;        // position of the '00dc' chunk header
+      uint32_t  videoBytes;     // size of video data (0: duplicate frame)
+      bool      keyFrame;
+    };
+    struct AVISuperIndexEntry {
+      uint64_t  filePos;        // position of 'ix00' ('ix01' follows it)
+      uint32_t  nFrames;
+    };
+    // frames not indexed yet in the current RIFF chunk
+    std::vector< AVIIndexEntry >  stdIndex;
+    // all frames of the first RIFF chunk, for the legacy 'idx1' index
+    std::vector< AVIIndexEntry >  legacyIndex;
+    std::vector< AVISuperIndexEntry > superIndex;
+    // start position of the current RIFF chunk (0: first 'AVI ' chunk)
+    uint64_t    riffStartPos;
+    // size of the first RIFF and 'movi' LIST chunks, or zero if the first
+    // RIFF chunk is not finished yet
+    uint32_t    firstRIFFSize;
+    uint32_t    firstMoviSize;
+    size_t      firstRIFFFrames;
+   protected:
     // ----------------
     static void aviHeader_writeFourCC(uint8_t*& bufp, const char *s);
     static void aviHeader_writeUInt16(uint8_t*& bufp, uint16_t n);
     static void aviHeader_writeUInt32(uint8_t*& bufp, uint32_t n);
+    static void aviHeader_writeUInt64(uint8_t*& bufp, uint64_t n);
     static void defaultErrorCallback(void *userData, const char *msg);
     static void defaultFileNameCallback(void *userData, std::string& fileName);
     virtual void writeAVIHeader() = 0;
-    virtual void writeAVIIndex() = 0;
+    // helper functions for writeAVIHeader()
+    uint32_t aviHeader_getRIFFSize() const;
+    uint32_t aviHeader_getMoviSize() const;
+    size_t aviHeader_getTotalFrames() const;
+    void aviHeader_writeSuperIndex(uint8_t*& bufp, int streamNum) const;
+    void aviHeader_writeODMLHeader(uint8_t*& bufp) const;
+    void updateRIFFChunkHeader();
+    void writeStandardIndex();
+    void writeLegacyIndex();
+    void finishRIFFChunk();
+    void beginRIFFChunk();
+    /*!
+     * Should be called before writeFrameChunks(); starts a new RIFF chunk
+     * or output file if needed. Returns false if there is no file to write.
+     */
+    bool beginFrame();
+    /*!
+     * Write a video frame of 'videoBytes' bytes ('videoBytes' = 0 for
+     * duplicate frames) and the corresponding audio data, and store them
+     * in the index. 'isKeyFrame' should be false for frames that depend on
+     * the previous one.
+     */
+    void writeFrameChunks(const uint8_t *videoBuf, size_t videoBytes,
+                          bool isKeyFrame = true);
+    /*!
+     * Should be called after writing each frame; updates the AVI header
+     * and writes the index periodically, so that the file is playable
+     * even if it is not closed.
+     */
+    void endFrame();
     void closeFile();
     void errorMessage(const char *msg);
    public:
@@ -107,13 +166,14 @@ namespace Ep128Emu {
      * of VSYNC. 'currentSlot_' is the position within the current line
      * (0 to 56).
      */
-    void vsyncStateChange(bool newState, unsigned int currentSlot_);
-    void openFile(const char *fileName);
-    void setErrorCallback(void (*func)(void *userData, const char *msg),
-                          void *userData_);
-    void setFileNameCallback(void (*func)(void *userData,
-                                          std::string& fileName),
-                             void *userData_);
+    virtual void vsyncStateChange(bool newState, unsigned int currentSlot_);
+    virtual void openFile(const char *fileName);
+    virtual void setErrorCallback(void (*func)(void *userData,
+                                               const char *msg),
+                                  void *userData_);
+    virtual void setFileNameCallback(void (*func)(void *userData,
+                                                  std::string& fileName),
+                                     void *userData_);
   };
 
   // --------------------------------------------------------------------------
@@ -122,7 +182,7 @@ namespace Ep128Emu {
    public:
     static const int  videoWidth = 768;
     static const int  videoHeight = 576;
-   private:
+   protected:
     class VideoCaptureFrameBuffer {
      private:
       uint32_t  *buf;
@@ -158,17 +218,18 @@ namespace Ep128Emu {
     // --------
     VideoCaptureFrameBuffer tmpFrameBuf;    // 768x576
     VideoCaptureFrameBuffer outputFrameBuf; // 768x576
-    uint32_t    *frameSizes;
+    uint8_t     *rleFrameBuf;           // 1024 * 576 bytes
     int         cycleCnt;
     bool        prvOddFrame;
     uint8_t     *colormap;
+    // video codec ID in the AVI header
+    uint32_t    videoCodec;
     // ----------------
     void frameDone();
     void decodeLine(uint8_t *outBuf, const uint8_t *inBuf);
     size_t rleCompressLine(uint8_t *outBuf, const uint8_t *inBuf);
-    void writeFrame(bool frameChanged);
+    virtual void writeFrame(bool frameChanged);
     virtual void writeAVIHeader();
-    virtual void writeAVIIndex();
    public:
     VideoCapture_RLE8(void indexToRGBFunc(uint8_t color,
                                           float& r, float& g, float& b) =
@@ -182,6 +243,45 @@ namespace Ep128Emu {
 
   // --------------------------------------------------------------------------
 
+  /*!
+   * Lossless video capture in ZMBV (DOSBox capture codec) format: the
+   * first frame and every keyFrameInterval seconds are stored as deflate
+   * compressed 768x576 8-bit images, while the other frames only encode
+   * the 16x16 pixel blocks that have changed, as a motion vector and the
+   * XOR of the new and the moved previous block.
+   */
+  class VideoCapture_ZMBV : public VideoCapture_RLE8 {
+   public:
+    static const int  blockWidth = 16;
+    static const int  blockHeight = 16;
+    static const int  keyFrameInterval = 10;
+   private:
+    static const int  blocksX = (videoWidth + blockWidth - 1) / blockWidth;
+    static const int  blocksY = (videoHeight + blockHeight - 1) / blockHeight;
+    uint8_t     *curFrame;              // 768x576
+    uint8_t     *prvFrame;              // 768x576
+    // block motion vectors of the previous frame
+    int8_t      *prvVectors;            // blocksX * blocksY * 2
+    Compressor_ZLib *compressor;
+    std::vector< uint8_t >  deltaBuf;   // uncompressed frame data
+    std::vector< uint8_t >  frameBuf;   // compressed frame data
+    size_t      framesSinceKeyFrame;
+    // ----------------
+    int compareBlock(int x, int y, int w, int h, int dx, int dy,
+                     int maxDiff) const;
+    void encodeKeyFrame();
+    void encodeDeltaFrame();
+    virtual void writeFrame(bool frameChanged);
+   public:
+    VideoCapture_ZMBV(void indexToRGBFunc(uint8_t color,
+                                          float& r, float& g, float& b) =
+                          (void (*)(uint8_t, float&, float&, float&)) 0,
+                      int frameRate_ = 50);
+    virtual ~VideoCapture_ZMBV();
+  };
+
+  // --------------------------------------------------------------------------
+
   class VideoCapture_YV12 : public VideoCapture {
    public:
     static const int  videoWidth = 384;
@@ -200,7 +300,6 @@ namespace Ep128Emu {
     uint8_t     *outBufY;               // 384x288
     uint8_t     *outBufV;               // 192x144
     uint8_t     *outBufU;               // 192x144
-    uint8_t     *duplicateFrameBitmap;
     int64_t     timesliceLength;
     int64_t     curTime;
     int64_t     frame0Time;
@@ -215,7 +314,21 @@ namespace Ep128Emu {
     void resampleFrame();
     void writeFrame(bool frameChanged);
     virtual void writeAVIHeader();
-    virtual void writeAVIIndex();
+   protected:
+    // buf[i] = (buf[i] + inBuf[i] + 1) >> 1, for i = 0 to nBytes - 1
+    static void averageChromaLine(uint8_t *buf, const uint8_t *inBuf,
+                                  int nBytes);
+    // interpBuf[i] += ((buf0[i] + buf1[i]) * scaleFac), for i = 0 to n - 1
+    static void accumulateFrame(int32_t *interpBuf,
+                                const uint8_t *buf0, const uint8_t *buf1,
+                                int32_t scaleFac, int n);
+    // calculates a new interpolated output frame from the accumulated input
+    // frames; returns true if the output is different from the previous
+    // frame
+    static bool interpolateFrame(uint8_t *outBuf, int32_t *interpBuf,
+                                 const uint8_t *buf0, const uint8_t *buf1,
+                                 int32_t scaleFac0, int32_t scaleFac1,
+                                 int32_t outScale, int n);
    public:
     VideoCapture_YV12(void indexToRGBFunc(uint8_t color,
                                           float& r, float& g, float& b) =
@@ -227,6 +340,84 @@ namespace Ep128Emu {
     virtual void horizontalSync(const uint8_t *buf, size_t nBytes);
   };
 
+  // --------------------------------------------------------------------------
+
+  /*!
+   * Runs another video capture object on a separate thread. The emulation
+   * thread only stores the audio samples and line data in a queue, while
+   * the encoding and file output are done by the capture thread.
+   * NOTE: the error and file name callbacks are called from the capture
+   * thread. If the default error callback is used, the exception thrown by
+   * the capture thread is thrown again on the emulation thread by the next
+   * call that waits for the capture thread.
+   */
+  class VideoCapture_Async : public VideoCapture, private Thread {
+   private:
+    // buffer size in 32-bit words
+    static const size_t bufferSize = 32768;
+    static const int    nBuffers = 16;
+    struct Buffer {
+      // signaled when the buffer is ready to be processed by the capture
+      // thread
+      ThreadLock  readLock;
+      // signaled when the capture thread has finished reading the buffer
+      ThreadLock  writeLock;
+      uint32_t    *buf;
+      size_t      nWords;
+      Buffer()
+        : readLock(false),
+          writeLock(true),
+          buf((uint32_t *) 0),
+          nWords(0)
+      {
+      }
+    };
+    VideoCapture  *videoCapture;
+    Buffer      buffers[nBuffers];
+    uint32_t    *writeBuf;
+    size_t      writePos;
+    // pointer to the header of the audio block currently being written,
+    // or NULL if a new block needs to be started
+    uint32_t    *audioBlockHeader;
+    int         writeBufIndex;
+    int         readBufIndex;
+    ThreadLock  syncLock;
+    // error message from the capture thread that has not been reported yet,
+    // valid if pendingErrorFlag is true (both are protected by the mutex)
+    std::string pendingError;
+    bool        pendingErrorFlag;
+    Mutex       pendingErrorMutex;
+    // copy of the last error reported by checkError(), which is kept until
+    // the next error, because Exception stores only a pointer to the message
+    std::string reportedError;
+    // ----------------
+    void flushBuffer();
+    inline void beginEvent(uint32_t eventHeader, size_t nWords);
+    void waitForCaptureThread();
+    // report any error from the capture thread on the calling thread
+    void checkError();
+    virtual void run();
+    virtual void writeAVIHeader();
+   public:
+    /*!
+     * Create asynchronous video capture object, taking ownership of
+     * 'videoCapture_' which will be deleted by the destructor.
+     */
+    VideoCapture_Async(VideoCapture *videoCapture_, int frameRate_ = 50);
+    virtual ~VideoCapture_Async();
+    virtual void runOneCycle(uint32_t audioInput);
+    virtual void setClockFrequency(size_t freq_);
+    virtual void horizontalSync(const uint8_t *buf, size_t nBytes);
+    virtual void vsyncStateChange(bool newState, unsigned int currentSlot_);
+    virtual void openFile(const char *fileName);
+    virtual void setErrorCallback(void (*func)(void *userData,
+                                               const char *msg),
+                                  void *userData_);
+    virtual void setFileNameCallback(void (*func)(void *userData,
+                                                  std::string& fileName),
+                                     void *userData_);
+  };
+
 }       // namespace Ep128Emu
 
 #endif  // EP128EMU_VIDEOREC_HPP
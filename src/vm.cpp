@@ -121,6 +121,7 @@ namespace Ep128Emu {
       audioOutputEnabled(true),
       audioOutputHighQuality(false),
       displayEnabled(true),
+      videoCaptureThreadEnabled(false),
       audioConverterSampleRate(0.0f),
       audioOutputSampleRate(0.0f),
       audioOutputVolume(0.7071f),
@@ -140,6 +141,13 @@ namespace Ep128Emu {
       tapeEnableSoundFileFilter(false),
       tapeSoundFileFilterMinFreq(500.0f),
       tapeSoundFileFilterMaxFreq(5000.0f),
+      tapeSoundFilePreDecode(true),
+      turboTapeEnabled(false),
+      turboTapeActive(false),
+      turboTapeSkipFrame(false),
+      tapeInputReadCnt(0),
+      turboTapeSliceLength(0),
+      runAheadActive(false),
       breakPointCallback(&defaultBreakPointCallback),
       breakPointCallbackUserData((void *) 0),
       fileIOEnabled(false),
@@ -167,7 +175,15 @@ namespace Ep128Emu {
 
   void VirtualMachine::run(size_t microseconds)
   {
-    (void) microseconds;
+    // turbo tape loading is active if the tape input was read at least once
+    // every 250 microseconds on average in the previous time slice
+    turboTapeActive =
+        (turboTapeEnabled &&
+         tape && tapeMotorOn && tapePlaybackOn && !tapeRecordOn &&
+         tapeInputReadCnt > 0 &&
+         (tapeInputReadCnt * 250) >= turboTapeSliceLength);
+    tapeInputReadCnt = 0;
+    turboTapeSliceLength = microseconds;
     if (audioConverter == (AudioConverter *) 0) {
       if (audioOutputEnabled) {
         // open audio converter if needed
@@ -197,11 +213,70 @@ namespace Ep128Emu {
       audioConverter->setOutputSampleRate(audioOutputSampleRate);
     }
     writingAudioOutput =
-        (audioConverter != (AudioConverter *) 0 && audioOutputEnabled);
+        (audioConverter != (AudioConverter *) 0 && audioOutputEnabled &&
+         !turboTapeActive);
     if (haveTape() && getIsTapeMotorOn() && getTapeButtonState() != 0)
       stopDemo();
   }
 
+  bool VirtualMachine::runAhead(size_t microseconds, size_t runAheadTime)
+  {
+    bool    displayEnabled_ = displayEnabled;
+    displayEnabled = displayEnabled_ && !runAheadActive;
+    try {
+      this->run(microseconds);
+    }
+    catch (...) {
+      displayEnabled = displayEnabled_;
+      throw;
+    }
+    displayEnabled = displayEnabled_;
+    if (runAheadTime < 1)
+      return runAheadActive;
+    runAheadActive = false;
+    runAheadState.clear();
+    if (!(displayEnabled && this->cloneState(runAheadState)))
+      return false;
+    // emulate ahead with the audio output disabled, and without updating
+    // the turbo tape state
+    bool    audioOutputEnabled_ = audioOutputEnabled;
+    bool    turboTapeActive_ = turboTapeActive;
+    bool    turboTapeSkipFrame_ = turboTapeSkipFrame;
+    size_t  tapeInputReadCnt_ = tapeInputReadCnt;
+    size_t  turboTapeSliceLength_ = turboTapeSliceLength;
+    audioOutputEnabled = false;
+    try {
+      this->run(runAheadTime);
+    }
+    catch (...) {
+      audioOutputEnabled = audioOutputEnabled_;
+      runAheadState.rewind();
+      this->restoreState(runAheadState);
+      throw;
+    }
+    audioOutputEnabled = audioOutputEnabled_;
+    turboTapeActive = turboTapeActive_;
+    turboTapeSkipFrame = turboTapeSkipFrame_;
+    tapeInputReadCnt = tapeInputReadCnt_;
+    turboTapeSliceLength = turboTapeSliceLength_;
+    runAheadState.rewind();
+    this->restoreState(runAheadState);
+    runAheadActive = true;
+    return true;
+  }
+
+  bool VirtualMachine::cloneState(MachineState& s)
+  {
+    (void) s;
+    return false;
+  }
+
+  void VirtualMachine::restoreState(MachineState& s)
+  {
+    (void) s;
+    throw Exception("restoring the machine state is not supported");
+  }
+
   void VirtualMachine::reset(bool isColdReset)
   {
     (void) isColdReset;
@@ -236,12 +311,14 @@ namespace Ep128Emu {
 
 #ifdef ENABLE_RESID
   void VirtualMachine::setSIDConfiguration(int n, int model,
-                                           double volumeL, double volumeR)
+                                           double volumeL, double volumeR,
+                                           bool highQuality)
   {
     (void) n;
     (void) model;
     (void) volumeL;
     (void) volumeR;
+    (void) highQuality;
   }
 #endif
 
@@ -328,7 +405,8 @@ namespace Ep128Emu {
   {
     audioOutputEnabled = isEnabled;
     writingAudioOutput =
-        (audioConverter != (AudioConverter *) 0 && audioOutputEnabled);
+        (audioConverter != (AudioConverter *) 0 && audioOutputEnabled &&
+         !turboTapeActive);
   }
 
   void VirtualMachine::setEnableDisplay(bool isEnabled)
@@ -336,6 +414,11 @@ namespace Ep128Emu {
     displayEnabled = isEnabled;
   }
 
+  void VirtualMachine::setEnableVideoCaptureThread(bool isEnabled)
+  {
+    videoCaptureThreadEnabled = isEnabled;
+  }
+
   void VirtualMachine::setCPUFrequency(size_t freq_)
   {
     (void) freq_;
@@ -385,13 +468,13 @@ namespace Ep128Emu {
 
   void VirtualMachine::openVideoCapture(
       int frameRate_,
-      bool yuvFormat_,
+      int videoFormat_,
       void (*errorCallback_)(void *userData, const char *msg),
       void (*fileNameCallback_)(void *userData, std::string& fileName),
       void *userData_)
   {
     (void) frameRate_;
-    (void) yuvFormat_;
+    (void) videoFormat_;
     (void) errorCallback_;
     (void) fileNameCallback_;
     (void) userData_;
@@ -596,24 +679,28 @@ namespace Ep128Emu {
   void VirtualMachine::setTapeSoundFileParameters(int requestedChannel_,
                                                   bool enableFilter_,
                                                   float filterMinFreq_,
-                                                  float filterMaxFreq_)
+                                                  float filterMaxFreq_,
+                                                  bool enablePreDecode_)
   {
     if (requestedChannel_ == tapeSoundFileChannel &&
         enableFilter_ == tapeEnableSoundFileFilter &&
         filterMinFreq_ == tapeSoundFileFilterMinFreq &&
-        filterMaxFreq_ == tapeSoundFileFilterMaxFreq)
+        filterMaxFreq_ == tapeSoundFileFilterMaxFreq &&
+        enablePreDecode_ == tapeSoundFilePreDecode)
       return;
     tapeSoundFileChannel = requestedChannel_;
     tapeEnableSoundFileFilter = enableFilter_;
     tapeSoundFileFilterMinFreq = filterMinFreq_;
     tapeSoundFileFilterMaxFreq = filterMaxFreq_;
+    tapeSoundFilePreDecode = enablePreDecode_;
     if (tape) {
       if (typeid(*tape) == typeid(Tape_SoundFile)) {
         Tape_SoundFile& tape_ = *(dynamic_cast<Tape_SoundFile *>(tape));
         tape_.setParameters(tapeSoundFileChannel,
                             tapeEnableSoundFileFilter,
                             tapeSoundFileFilterMinFreq,
-                            tapeSoundFileFilterMaxFreq);
+                            tapeSoundFileFilterMaxFreq,
+                            tapeSoundFilePreDecode);
       }
     }
   }
@@ -626,6 +713,13 @@ namespace Ep128Emu {
       tape->setIsMotorOn(tapeMotorOn);
   }
 
+  void VirtualMachine::setEnableTurboTape(bool isEnabled)
+  {
+    turboTapeEnabled = isEnabled;
+    if (!turboTapeEnabled)
+      turboTapeActive = false;
+  }
+
   void VirtualMachine::setBreakPoints(const BreakPointList& bpList)
   {
     for (size_t i = 0; i < bpList.getBreakPointCnt(); i++)
@@ -835,7 +929,8 @@ namespace Ep128Emu {
       tape_.setParameters(tapeSoundFileChannel,
                           tapeEnableSoundFileFilter,
                           tapeSoundFileFilterMinFreq,
-                          tapeSoundFileFilterMaxFreq);
+                          tapeSoundFileFilterMaxFreq,
+                          tapeSoundFilePreDecode);
     }
     if (tapeRecordOn)
       tape->record();
@@ -852,6 +947,18 @@ namespace Ep128Emu {
       tape->setIsMotorOn(tapeMotorOn);
   }
 
+  void VirtualMachine::turboTapeVSync_()
+  {
+    if (!turboTapeActive) {
+      turboTapeSkipFrame = false;
+      return;
+    }
+    // display about 25 frames per second of real time
+    turboTapeSkipFrame = (turboTapeFrameTimer.getRealTime() < 0.04);
+    if (!turboTapeSkipFrame)
+      turboTapeFrameTimer.reset();
+  }
+
   void VirtualMachine::setAudioConverterSampleRate(float sampleRate_)
   {
     if (sampleRate_ != audioConverterSampleRate) {
@@ -44,6 +44,7 @@ namespace Ep128Emu {
     bool            audioOutputEnabled;
     bool            audioOutputHighQuality;
     bool            displayEnabled;
+    bool            videoCaptureThreadEnabled;
     float           audioConverterSampleRate;
     float           audioOutputSampleRate;
     float           audioOutputVolume;
@@ -66,6 +67,21 @@ namespace Ep128Emu {
     bool            tapeEnableSoundFileFilter;
     float           tapeSoundFileFilterMinFreq;
     float           tapeSoundFileFilterMaxFreq;
+    bool            tapeSoundFilePreDecode;
+    bool            turboTapeEnabled;
+    // true if the emulation is not limited to real time speed, because the
+    // emulated program is reading the tape input in a loop
+    bool            turboTapeActive;
+    // true if the current video frame is not sent to the display
+    bool            turboTapeSkipFrame;
+    // number of tape input port reads in the last time slice
+    size_t          tapeInputReadCnt;
+    size_t          turboTapeSliceLength;
+    Timer           turboTapeFrameTimer;
+    // in-memory copy of the machine state used by runAhead()
+    MachineState    runAheadState;
+    // true if the display shows the frames emulated ahead by runAhead()
+    bool            runAheadActive;
    protected:
     void            (*breakPointCallback)(void *userData, int type,
                                           uint16_t addr, uint8_t value);
@@ -124,6 +140,30 @@ namespace Ep128Emu {
      * Run emulation for the specified number of microseconds.
      */
     virtual void run(size_t microseconds);
+    /*!
+     * Run emulation for the specified number of microseconds without video
+     * output, and then, if 'runAheadTime' is non-zero, save the state of the
+     * machine, continue emulation for 'runAheadTime' microseconds with audio
+     * output disabled, and restore the saved state. The display shows only
+     * the frames emulated ahead, so the effect of any input appears on the
+     * screen sooner. If the state cannot be saved with cloneState(), the
+     * run-ahead is skipped, and the display is updated normally until the
+     * next successful run-ahead. Returns true if run-ahead is active.
+     */
+    virtual bool runAhead(size_t microseconds, size_t runAheadTime);
+    /*!
+     * Save a fast in-memory copy of the state of the emulated machine to 's',
+     * which can be restored with restoreState() into the same object, or
+     * into another one of the same type and memory configuration.
+     * Returns false if this is not possible in the current state of the
+     * machine (e.g. tape or disk I/O, demo recording, or debugging is in
+     * progress). The default implementation always returns false.
+     */
+    virtual bool cloneState(MachineState& s);
+    /*!
+     * Restore machine state saved with cloneState().
+     */
+    virtual void restoreState(MachineState& s);
     /*!
      * Reset emulated machine; if 'isColdReset' is true, RAM is cleared.
      */
@@ -153,9 +193,13 @@ namespace Ep128Emu {
     /*!
      * Configure SID 'n' (0 to 3, currently only 3 is supported),
      * 'model' can be 0 to disable the emulation, 1 for MOS 6581 or 2 for 8580.
+     * If 'highQuality' is true, the SID is clocked cycle by cycle, otherwise
+     * the faster multi-cycle steps are used, and the output is only sampled
+     * at the end of each step, at 62.5 kHz.
      */
     virtual void setSIDConfiguration(int n, int model,
-                                     double volumeL, double volumeR);
+                                     double volumeL, double volumeR,
+                                     bool highQuality);
 #endif
     /*!
      * Set audio output quality.
@@ -187,6 +231,12 @@ namespace Ep128Emu {
      * Set if video data is sent to the associated VideoDisplay object.
      */
     virtual void setEnableDisplay(bool isEnabled);
+    /*!
+     * Set if video capture (encoding and writing the AVI file) is done on
+     * a separate thread. This only takes effect when openVideoCapture() is
+     * called next time.
+     */
+    virtual void setEnableVideoCaptureThread(bool isEnabled);
     /*!
      * Set CPU clock frequency (in Hz).
      */
@@ -234,13 +284,14 @@ namespace Ep128Emu {
     virtual void getVMStatus(VMStatus& vmStatus_);
     /*!
      * Create video capture object with the specified frame rate (24 to 60)
-     * and format (768x576 RLE8 or 384x288 YV12) if it does not exist yet,
-     * and optionally set callbacks for printing error messages and asking
-     * for a new output file on reaching 2 GB file size.
+     * and format (0: 768x576 RLE8, 1: 384x288 YV12, 2: 768x576 ZMBV) if it
+     * does not exist yet, and optionally set callbacks for printing error
+     * messages and asking for a new output file when the AVI super index is
+     * full.
      */
     virtual void openVideoCapture(
         int frameRate_ = 50,
-        bool yuvFormat_ = false,
+        int videoFormat_ = 0,
         void (*errorCallback_)(void *userData, const char *msg) =
             (void (*)(void *, const char *)) 0,
         void (*fileNameCallback_)(void *userData, std::string& fileName) =
@@ -405,12 +456,27 @@ namespace Ep128Emu {
     virtual void setTapeSoundFileParameters(int requestedChannel_,
                                             bool enableFilter_,
                                             float filterMinFreq_,
-                                            float filterMaxFreq_);
+                                            float filterMaxFreq_,
+                                            bool enablePreDecode_ = true);
     /*!
      * If enabled, then the tape motor is always on, ignoring software remote
      * control from the emulated machine.
      */
     virtual void setForceTapeMotorOn(bool isEnabled);
+    /*!
+     * If enabled, the emulation runs as fast as possible, without audio
+     * output and with most video frames skipped, while the tape is playing
+     * and the emulated program is reading the tape input in a loop.
+     */
+    virtual void setEnableTurboTape(bool isEnabled);
+    /*!
+     * Returns true if turbo tape loading is currently active, and the
+     * emulation should not be limited to real time speed.
+     */
+    inline bool getIsTurboTapeActive() const
+    {
+      return this->turboTapeActive;
+    }
     // ------------------------------ DEBUGGING -------------------------------
     /*!
      * Add breakpoints from the specified breakpoint list (see also
@@ -634,6 +700,16 @@ namespace Ep128Emu {
       if (this->writingAudioOutput)
         this->audioConverter->sendInputSignal(audioData);
     }
+    /*!
+     * Send 'nSamples' audio samples with the same value at once. This is
+     * faster than calling sendAudioOutput(audioData) 'nSamples' times, and
+     * the high quality audio converter synthesizes only the level changes.
+     */
+    inline void sendHeldAudioOutput(uint32_t audioData, size_t nSamples)
+    {
+      if (this->writingAudioOutput)
+        this->audioConverter->sendHeldInputSignal(audioData, nSamples);
+    }
     inline void sendAudioOutput(uint16_t left, uint16_t right)
     {
       if (this->writingAudioOutput)
@@ -653,6 +729,7 @@ namespace Ep128Emu {
     void setTapeFileName(const std::string& fileName, int bitsPerSample);
    private:
     void setTapeMotorState_(bool newState);
+    void turboTapeVSync_();
    protected:
     inline void setTapeMotorState(bool newState)
     {
@@ -693,9 +770,30 @@ namespace Ep128Emu {
       }
       return 0;
     }
+    /*!
+     * Derived classes should call this function on every read of the I/O
+     * port that returns the tape input signal.
+     */
+    inline void countTapeInputRead()
+    {
+      this->tapeInputReadCnt++;
+    }
+    /*!
+     * Should be called at the beginning of vertical sync. While turbo tape
+     * loading is active, most video frames are not displayed.
+     */
+    inline void turboTapeVSync()
+    {
+      if (EP128EMU_UNLIKELY(this->turboTapeActive | this->turboTapeSkipFrame))
+        this->turboTapeVSync_();
+    }
     inline bool getIsDisplayEnabled() const
     {
-      return this->displayEnabled;
+      return (this->displayEnabled & !this->turboTapeSkipFrame);
+    }
+    inline bool getIsVideoCaptureThreadEnabled() const
+    {
+      return this->videoCaptureThreadEnabled;
     }
     void setAudioConverterSampleRate(float sampleRate_);
    public:
@@ -51,6 +51,9 @@ namespace Ep128Emu {
       pauseFlag(true),
       timesliceLength(0.0f),
       avgTimesliceLength(0.002f),
+      avgRunTime(0.0f),
+      runAheadFrames(0),
+      runAheadSliceCnt(0),
       prvTime(0.0),
       nxtTime(0.0),
       userData(userData_),
@@ -156,17 +159,32 @@ namespace Ep128Emu {
       freeMessageStack = m;
     }
     nxtTime += double(timesliceLength);
+    int     runAheadFrames_ = runAheadFrames;
     mutex_.unlock();
     // run emulation, or wait if paused
     double  curTime = prvTime;
+    double  runTime = 0.0;
     try {
       if (processCallback)
         processCallback(userData);
       if (!pauseFlag) {
-        vm.run(2000);
+        runTime = speedTimer.getRealTime();
+        if (runAheadFrames_ < 1) {
+          vm.run(2000);
+        }
+        else {
+          // emulate ahead at the end of every 20 ms (one video frame)
+          if (++runAheadSliceCnt >= 10)
+            runAheadSliceCnt = 0;
+          vm.runAhead(2000, (runAheadSliceCnt == 0 ?
+                             (size_t(runAheadFrames_) * 20000) : 0));
+        }
         curTime = speedTimer.getRealTime();
-        if (curTime < nxtTime)
-          Timer::wait(nxtTime - curTime);
+        runTime = curTime - runTime;
+        if (vm.getIsTurboTapeActive())
+          nxtTime = curTime;            // loading from tape at full speed
+        else if (curTime < nxtTime)
+          speedTimer.waitUntil(nxtTime);
         else if (curTime > (nxtTime + 0.25))
           nxtTime = curTime;
       }
@@ -196,6 +214,7 @@ namespace Ep128Emu {
     deltaTime = (deltaTime > 0.0f ? deltaTime : 0.0f);
     deltaTime = (deltaTime < 1.0f ? deltaTime : 1.0f);
     avgTimesliceLength = (avgTimesliceLength * 0.995f) + (deltaTime * 0.005f);
+    avgRunTime = (avgRunTime * 0.995f) + (float(runTime) * 0.005f);
     try {
       vm.getVMStatus(vmStatus);
     }
@@ -229,10 +248,15 @@ namespace Ep128Emu {
     : threadStatus(0)
   {
     vmThread_.mutex_.lock();
-    if (vmThread_.avgTimesliceLength > 0.0000002f)
+    if (vmThread_.avgTimesliceLength > 0.0000002f) {
       speedPercentage = 0.2f / vmThread_.avgTimesliceLength;
-    else
+      cpuUsagePercentage =
+          vmThread_.avgRunTime * 100.0f / vmThread_.avgTimesliceLength;
+    }
+    else {
       speedPercentage = 1000000.0f;
+      cpuUsagePercentage = 100.0f;
+    }
     isPaused = vmThread_.pauseFlag;
     isRecordingDemo = vmThread_.vmStatus.isRecordingDemo;
     isPlayingDemo = vmThread_.vmStatus.isPlayingDemo;
@@ -402,6 +426,13 @@ namespace Ep128Emu {
     mutex_.unlock();
   }
 
+  void VMThread::setRunAheadFrames(int n)
+  {
+    mutex_.lock();
+    runAheadFrames = (n > 0 ? (n < 10 ? n : 10) : 0);
+    mutex_.unlock();
+  }
+
   VMThread::Message * VMThread::allocateMessage_()
   {
     mutex_.lock();
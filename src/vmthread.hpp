@@ -35,6 +35,9 @@ namespace Ep128Emu {
       // occured due to an error).
       int       threadStatus;
       float     speedPercentage;
+      // host time spent running the emulation as a percentage of the real
+      // time (100 = one CPU core is fully used by this VM)
+      float     cpuUsagePercentage;
       bool      isPaused;
       // --------
       VMThreadStatus(VMThread& vmThread_);
@@ -56,6 +59,9 @@ namespace Ep128Emu {
     bool            pauseFlag;
     float           timesliceLength;
     float           avgTimesliceLength;
+    float           avgRunTime;         // host time used per timeslice
+    int             runAheadFrames;     // number of frames to emulate ahead
+    int             runAheadSliceCnt;   // timeslices until the next run-ahead
     double          prvTime;
     double          nxtTime;
     VirtualMachine::VMStatus  vmStatus;
@@ -177,6 +183,11 @@ namespace Ep128Emu {
      * A zero or negative value means no limit.
      */
     void setSpeedPercentage(int speedPercentage_);
+    /*!
+     * Set the number of video frames (0 to 10) to emulate ahead to reduce
+     * input latency, see VirtualMachine::runAhead(). Zero disables run-ahead.
+     */
+    void setRunAheadFrames(int n);
   // --------------------------------------------------------------------------
    private:
     virtual void run();
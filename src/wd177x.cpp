@@ -641,6 +641,23 @@ namespace Ep128Emu {
     writeTrackState = 0xFF;
   }
 
+  void WD177x::cloneState(MachineState& s) const
+  {
+    // the selected drive is not included, use setFloppyDrive() to restore it
+    const char  *p = reinterpret_cast<const char *>(&commandRegister);
+    size_t  nBytes =
+        size_t(reinterpret_cast<const char *>(&writeTrackState) + 1 - p);
+    s.writeData(p, nBytes);
+  }
+
+  void WD177x::restoreState(MachineState& s)
+  {
+    char    *p = reinterpret_cast<char *>(&commandRegister);
+    size_t  nBytes =
+        size_t(reinterpret_cast<char *>(&writeTrackState) + 1 - p);
+    s.readData(p, nBytes);
+  }
+
   void WD177x::interruptRequest()
   {
   }
@@ -101,6 +101,10 @@ namespace Ep128Emu {
     }
     void setEnableBusyFlagHack(bool isEnabled);
     virtual void reset(bool isColdReset);
+    // fast in-memory copy of the registers, see Ep128Emu::MachineState;
+    // the selected drive is not included
+    void cloneState(MachineState& s) const;
+    void restoreState(MachineState& s);
    protected:
     virtual void interruptRequest();
     virtual void clearInterruptRequest();
@@ -137,19 +137,11 @@ namespace ZX128 {
     }
     if (--ayCycleCnt == 0) {
       ayCycleCnt = 4;
-      uint32_t  tmp = soundOutputAccumulator;
+      ayBeeperBuf[ayCyclesPending++] = soundOutputAccumulator;
       soundOutputAccumulator = 0U;
-      if (spectrum128Mode) {
-        uint16_t  tmpA = 0;
-        uint16_t  tmpB = 0;
-        uint16_t  tmpC = 0;
-        ay3.runOneCycle(tmpA, tmpB, tmpC);
-        tmp = tmp + (uint32_t(tmpA + tmpB + tmpC) << 2);
-      }
-      tmp = (tmp * 8864U + 0x8000U) & 0xFFFF0000U;
-      tmp = tmp | (tmp >> 16);
-      soundOutputSignal = tmp;
-      sendAudioOutput(tmp);
+      // video capture needs the sound output on every cycle
+      if (ayCyclesPending >= ayBatchLength || videoCapture)
+        runAY();
     }
     ula.runOneSlot();
     soundOutputAccumulator += uint32_t(ula.getSoundOutput());
@@ -157,6 +149,34 @@ namespace ZX128 {
     z80OpcodeHalfCycles = z80OpcodeHalfCycles - 8;
   }
 
+  void ZX128VM::runAY()
+  {
+    if (ayCyclesPending < 1)
+      return;
+    size_t  nCycles = size_t(ayCyclesPending);
+    ayCyclesPending = 0;
+    if (spectrum128Mode) {
+      ay3.runCycles(&(ayOutputBuf[0]), nCycles);
+      for (size_t i = 0; i < nCycles; i++) {
+        ayBeeperBuf[i] += (uint32_t(ayOutputBuf[i * 3] + ayOutputBuf[i * 3 + 1]
+                                    + ayOutputBuf[i * 3 + 2]) << 2);
+      }
+    }
+    // send runs of identical samples to the audio converter at once
+    size_t  runLength = 0;
+    for (size_t i = 0; i < nCycles; i++) {
+      uint32_t  tmp = (ayBeeperBuf[i] * 8864U + 0x8000U) & 0xFFFF0000U;
+      tmp = tmp | (tmp >> 16);
+      if (tmp != soundOutputSignal) {
+        sendHeldAudioOutput(soundOutputSignal, runLength);
+        soundOutputSignal = tmp;
+        runLength = 0;
+      }
+      runLength++;
+    }
+    sendHeldAudioOutput(soundOutputSignal, runLength);
+  }
+
   // --------------------------------------------------------------------------
 
   ZX128VM::Z80_::Z80_(ZX128VM& vm_)
@@ -273,6 +293,8 @@ namespace ZX128 {
     vm.memoryWait(addr);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    if (vm.isContendedAddress(addr))
+      vm.ula.updateDisplay();
     vm.memory.write(addr, value);
     vm.updateCPUHalfCycles(1);
   }
@@ -283,6 +305,8 @@ namespace ZX128 {
     vm.memoryWait(addr);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    if (vm.isContendedAddress(addr))
+      vm.ula.updateDisplay();
     vm.memory.write(addr, uint8_t(value) & 0xFF);
     vm.updateCPUHalfCycles(1);
     addr = (addr + 1) & 0xFFFF;
@@ -290,6 +314,8 @@ namespace ZX128 {
     vm.memoryWait(addr);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    if (vm.isContendedAddress(addr))
+      vm.ula.updateDisplay();
     vm.memory.write(addr, uint8_t(value >> 8));
     vm.updateCPUHalfCycles(1);
   }
@@ -306,11 +332,15 @@ namespace ZX128 {
     vm.memoryWait((addr + 1) & 0xFFFF);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    if (vm.isContendedAddress((addr + 1) & 0xFFFF))
+      vm.ula.updateDisplay();
     vm.memory.write((addr + 1) & 0xFFFF, uint8_t(value >> 8));
     vm.updateCPUHalfCycles(1);
     vm.memoryWait(addr);
     while (vm.z80OpcodeHalfCycles >= 8)
       vm.runOneCycle();
+    if (vm.isContendedAddress(addr))
+      vm.ula.updateDisplay();
     vm.memory.write(addr, uint8_t(value) & 0xFF);
     vm.updateCPUHalfCycles(1);
   }
@@ -519,6 +549,8 @@ namespace ZX128 {
 
   void ZX128VM::ULA_::vsyncStateChange(bool newState, unsigned int currentSlot_)
   {
+    if (newState)
+      vm.turboTapeVSync();
     if (vm.getIsDisplayEnabled())
       vm.display.vsyncStateChange(newState, currentSlot_);
     if (vm.videoCapture)
@@ -579,8 +611,10 @@ namespace ZX128 {
     uint8_t   retval = 0xFF;
     if ((addr & 0xE0) == 0)
       retval = vm.joystickState;
-    else if ((addr & 0x01) == 0)
+    else if ((addr & 0x01) == 0) {
+      vm.countTapeInputRead();
       retval = vm.ula.readPort(addr);
+    }
     else if ((addr & 0xC002) == 0xC000 && vm.spectrum128Mode)
       retval = vm.ay3.readRegister(vm.ayRegisterSelected & 0x0F);
     else
@@ -617,6 +651,7 @@ namespace ZX128 {
         vm.ayRegisterSelected = value;
       }
       else {
+        vm.runAY();
         vm.ay3.writeRegister(vm.ayRegisterSelected & 0x0F, value);
       }
     }
@@ -910,6 +945,7 @@ namespace ZX128 {
       singleStepModeNextAddr(int32_t(-1)),
       soundOutputAccumulator(0U),
       soundOutputSignal(0U),
+      ayCyclesPending(0),
       demoFile((Ep128Emu::File *) 0),
       demoBuffer(),
       isRecordingDemo(false),
@@ -1002,6 +1038,7 @@ namespace ZX128 {
     spectrum128PageRegister = 0x00;
     ayRegisterSelected = 0x00;
     initializeMemoryPaging();
+    runAY();
     ay3.reset();
     ula.reset();
     if (isColdReset) {
@@ -1013,6 +1050,7 @@ namespace ZX128 {
   void ZX128VM::resetMemoryConfiguration(size_t memSize)
   {
     stopDemo();
+    runAY();
     // calculate new number of RAM segments
     size_t  nSegments = 3;
     spectrum128Mode = false;
@@ -1079,6 +1117,7 @@ namespace ZX128 {
     ulaFrequency = freq;
     stopDemoPlayback();         // changing configuration implies stopping
     stopDemoRecording(false);   // any demo playback or recording
+    runAY();
     setAudioConverterSampleRate(float(long(ulaFrequency >> 2)));
     if (haveTape()) {
       tapeSamplesPerULACycle =
@@ -1128,20 +1167,28 @@ namespace ZX128 {
 
   void ZX128VM::openVideoCapture(
       int frameRate_,
-      bool yuvFormat_,
+      int videoFormat_,
       void (*errorCallback_)(void *userData, const char *msg),
       void (*fileNameCallback_)(void *userData, std::string& fileName),
       void *userData_)
   {
     if (!videoCapture) {
-      if (yuvFormat_) {
+      if (videoFormat_ == 1) {
         videoCapture = new Ep128Emu::VideoCapture_YV12(&ULA::convertPixelToRGB,
                                                        frameRate_);
       }
+      else if (videoFormat_ == 2) {
+        videoCapture = new Ep128Emu::VideoCapture_ZMBV(&ULA::convertPixelToRGB,
+                                                       frameRate_);
+      }
       else {
         videoCapture = new Ep128Emu::VideoCapture_RLE8(&ULA::convertPixelToRGB,
                                                        frameRate_);
       }
+      if (getIsVideoCaptureThreadEnabled()) {
+        videoCapture = new Ep128Emu::VideoCapture_Async(videoCapture,
+                                                        frameRate_);
+      }
       videoCapture->setClockFrequency(ulaFrequency);
       setCallback(&videoCaptureCallback, this, true);
     }
@@ -1356,6 +1403,7 @@ namespace ZX128 {
               | (addr & uint32_t(0x3FFF)));
     else
       addr &= uint32_t(0x003FFFFF);
+    ula.updateDisplay();
     memory.writeRaw(addr, value);
   }
 
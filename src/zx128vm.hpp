@@ -126,6 +126,13 @@ namespace ZX128 {
     int32_t   singleStepModeNextAddr;
     uint32_t  soundOutputAccumulator;
     uint32_t  soundOutputSignal;
+    // number of AY cycles that have not been run yet; the AY is run in
+    // batches of up to ayBatchLength cycles, and before each register write
+    int32_t   ayCyclesPending;
+    static const int32_t  ayBatchLength = 64;
+    // ULA sound output for each pending AY cycle
+    uint32_t  ayBeeperBuf[ayBatchLength];
+    uint16_t  ayOutputBuf[ayBatchLength * 3];
     Ep128Emu::File  *demoFile;
     // contains demo data, which is the emulator version number as a 32-bit
     // integer ((MAJOR << 16) + (MINOR << 8) + PATCHLEVEL), followed by a
@@ -172,6 +179,7 @@ namespace ZX128 {
     EP128EMU_INLINE void memoryWaitM1(uint16_t addr);
     EP128EMU_INLINE void ioPortWait(uint16_t addr);
     EP128EMU_REGPARM1 void runOneCycle();
+    void runAY();
     static uint8_t ioPortReadCallback(void *userData, uint16_t addr);
     static void ioPortWriteCallback(void *userData,
                                     uint16_t addr, uint8_t value);
@@ -228,11 +236,11 @@ namespace ZX128 {
      * Create video capture object with the specified frame rate (24 to 60)
      * and format (768x576 RLE8 or 384x288 YV12) if it does not exist yet,
      * and optionally set callbacks for printing error messages and asking
-     * for a new output file on reaching 2 GB file size.
+     * for a new output file when the AVI super index is full.
      */
     virtual void openVideoCapture(
         int frameRate_ = 50,
-        bool yuvFormat_ = false,
+        int videoFormat_ = 0,
         void (*errorCallback_)(void *userData, const char *msg) =
             (void (*)(void *, const char *)) 0,
         void (*fileNameCallback_)(void *userData, std::string& fileName) =
@@ -29,6 +29,7 @@ namespace ZX128 {
 
   void ZX128VM::saveState(Ep128Emu::File& f)
   {
+    runAY();
     memory.saveState(f);
     ula.saveState(f);
     ay3.saveState(f);
@@ -108,6 +109,9 @@ namespace ZX128 {
     stopDemo();
     snapshotLoadFlag = true;
     z80.closeTapeFile();
+    // the AY state has already been loaded from its own chunk, so the
+    // cycles pending from before the snapshot are discarded
+    ayCyclesPending = 0;
     try {
       spectrum128PageRegister = buf.readByte();
       for (uint8_t i = 0x08; i < 0x80; i++)
@@ -0,0 +1,251 @@
+
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2019 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// command line front end for the tape image reader/writer of the tape editor
+
+#include "ep128emu.hpp"
+#include "system.hpp"
+#include "tapeio.hpp"
+
+#include <vector>
+
+// sound file channel to read (0: left, 1: right)
+static int    soundFileChannel = 0;
+// sound file filter frequency range
+static float  soundFileMinFreq = 600.0f;
+static float  soundFileMaxFreq = 3000.0f;
+// number of threads to decode long sound files on
+static int    nThreads = 1;
+// directory to extract files to (empty: list files only)
+static std::string  outputDirectory = "";
+// ep128emu tape file to write all files to (empty: none)
+static std::string  outputFileName = "";
+// allow overwriting existing output files
+static bool   allowOverwrite = false;
+// print progress while reading tape images
+static bool   verboseMode = false;
+
+static void progressCallback(void *userData, int n)
+{
+  std::fprintf(stderr, "\r  %s: %3d%%",
+               reinterpret_cast<const char *>(userData), n);
+}
+
+// read all tape images, and extract or list the files found;
+// returns true if there were any errors
+static bool convertTapeImages(Ep128Emu::TapeFiles& tapeFiles,
+                              const std::vector< std::string >& fileNames)
+{
+  bool    errorFlag = false;
+  for (size_t i = 0; i < fileNames.size(); i++) {
+    size_t  firstFile = tapeFiles.getFileCnt();
+    if (verboseMode) {
+      tapeFiles.setProgressCallback(
+          &progressCallback,
+          const_cast<void *>(reinterpret_cast<const void *>(
+                                 fileNames[i].c_str())));
+    }
+    try {
+      tapeFiles.readTapeImage(fileNames[i].c_str(), soundFileChannel,
+                              soundFileMinFreq, soundFileMaxFreq, nThreads);
+    }
+    catch (std::exception& e) {
+      if (verboseMode)
+        std::fprintf(stderr, "\n");
+      std::fprintf(stderr, " *** %s: %s\n", fileNames[i].c_str(), e.what());
+      errorFlag = true;
+      continue;
+    }
+    if (verboseMode)
+      std::fprintf(stderr, "\n");
+    std::printf("%s:\n", fileNames[i].c_str());
+    for (size_t j = firstFile; j < tapeFiles.getFileCnt(); j++) {
+      const Ep128Emu::TapeFile& tf = *(tapeFiles[j]);
+      std::printf("  %-28s %7u%s%s\n",
+                  tf.getFileName().c_str(), (unsigned int) tf.fileData.size(),
+                  (tf.isCopyProtected ? "  (copy protected)" : ""),
+                  (tf.hasErrors ?
+                   "  (ERRORS)" : (tf.isComplete ? "" : "  (incomplete)")));
+      if (tf.hasErrors)
+        errorFlag = true;
+      if (outputDirectory.empty())
+        continue;
+      std::string outFileName(outputDirectory);
+      outFileName += tf.getFileName();
+      try {
+        if (!tapeFiles.exportFile(int(j), outFileName.c_str(),
+                                  allowOverwrite)) {
+          throw Ep128Emu::Exception("file already exists "
+                                    "(use -y to overwrite)");
+        }
+      }
+      catch (std::exception& e) {
+        std::fprintf(stderr, " *** %s: %s\n", outFileName.c_str(), e.what());
+        errorFlag = true;
+      }
+    }
+  }
+  return errorFlag;
+}
+
+int main(int argc, char **argv)
+{
+  const char  *programName = argv[0];
+  if (programName == (char *) 0)
+    programName = "";
+  for (size_t i = std::strlen(programName); i > 0; ) {
+    i--;
+    if (programName[i] == '/' || programName[i] == '\\' ||
+        programName[i] == ':') {
+      programName = programName + (i + 1);
+      break;
+    }
+  }
+  if (programName[0] == '\0')
+    programName = "tapeconv";
+  std::vector< std::string >  fileNames;
+  bool    printUsageFlag = false;
+  bool    helpFlag = false;
+  bool    endOfOptions = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string tmp = argv[i];
+      if (tmp.length() < 1)
+        continue;
+      if (endOfOptions || tmp[0] != '-') {
+        fileNames.push_back(tmp);
+        continue;
+      }
+      if (tmp == "--") {
+        endOfOptions = true;
+        continue;
+      }
+      if (tmp.length() >= 4) {
+        // allow GNU-style long options
+        if (tmp[1] == '-')
+          tmp.erase(0, 1);
+      }
+      if (tmp == "-h" || tmp == "-help") {
+        printUsageFlag = true;
+        helpFlag = true;
+        throw Ep128Emu::Exception("");
+      }
+      else if (tmp == "-x") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -x");
+        outputDirectory = argv[i];
+        if (outputDirectory.length() < 1)
+          throw Ep128Emu::Exception("invalid output directory name");
+        char    c = outputDirectory[outputDirectory.length() - 1];
+        if (c != '/' && c != '\\' && c != ':')
+          outputDirectory += '/';
+      }
+      else if (tmp == "-o") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -o");
+        outputFileName = argv[i];
+        if (outputFileName.length() < 1)
+          throw Ep128Emu::Exception("invalid output file name");
+      }
+      else if (tmp == "-y") {
+        allowOverwrite = true;
+      }
+      else if (tmp == "-v") {
+        verboseMode = true;
+      }
+      else if (tmp == "-c") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -c");
+        soundFileChannel = int(std::atoi(argv[i]));
+        if (soundFileChannel < 0 || soundFileChannel > 15)
+          throw Ep128Emu::Exception("sound file channel is out of range");
+      }
+      else if (tmp == "-f") {
+        if ((i + 2) >= argc)
+          throw Ep128Emu::Exception("missing argument for -f");
+        soundFileMinFreq = float(std::atof(argv[++i]));
+        soundFileMaxFreq = float(std::atof(argv[++i]));
+        if (!(soundFileMinFreq >= 0.0f && soundFileMaxFreq > soundFileMinFreq
+              && soundFileMaxFreq <= 20000.0f)) {
+          throw Ep128Emu::Exception("invalid filter frequency range");
+        }
+      }
+      else if (tmp == "-t") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -t");
+        nThreads = int(std::atoi(argv[i]));
+        if (nThreads < 1 || nThreads > 64)
+          throw Ep128Emu::Exception("number of threads is out of range");
+      }
+      else {
+        printUsageFlag = true;
+        throw Ep128Emu::Exception("invalid command line option");
+      }
+    }
+    if (fileNames.size() < 1) {
+      printUsageFlag = true;
+      throw Ep128Emu::Exception("missing file name");
+    }
+    Ep128Emu::TapeFiles tapeFiles;
+    bool    errorFlag = convertTapeImages(tapeFiles, fileNames);
+    if (!outputFileName.empty()) {
+      if (!tapeFiles.writeTapeImage(outputFileName.c_str(), allowOverwrite)) {
+        throw Ep128Emu::Exception("output file already exists "
+                                  "(use -y to overwrite)");
+      }
+    }
+    return (errorFlag ? -1 : 0);
+  }
+  catch (std::exception& e) {
+    if (printUsageFlag || helpFlag) {
+      std::printf("Usage:\n");
+      std::printf("    %s [OPTIONS...] <infile...>\n", programName);
+      std::printf("        list files in tape images (ep128emu tape files, "
+                  "sound files, or\n"
+                  "        EPTE/TAPir tape files)\n");
+      std::printf("Options:\n");
+      std::printf("    --\n");
+      std::printf("        interpret all remaining arguments as file names\n");
+      std::printf("    -h | -help | --help\n");
+      std::printf("        print usage information\n");
+      std::printf("    -x <DIR>\n");
+      std::printf("        extract files to directory DIR\n");
+      std::printf("    -o <FILE>\n");
+      std::printf("        write all files to ep128emu tape file FILE\n");
+      std::printf("    -y\n");
+      std::printf("        allow overwriting existing output files\n");
+      std::printf("    -c <N>\n");
+      std::printf("        sound file channel to read (0: left, 1: right; "
+                  "default: 0)\n");
+      std::printf("    -f <MIN> <MAX>\n");
+      std::printf("        sound file filter frequency range in Hz "
+                  "(default: 600 3000)\n");
+      std::printf("    -t <N>\n");
+      std::printf("        decode long tapes on N threads (default: 1)\n");
+      std::printf("    -v\n");
+      std::printf("        print progress while reading tape images\n");
+      if (helpFlag)
+        return 0;
+    }
+    std::fprintf(stderr, " *** %s: %s\n", programName, e.what());
+    return -1;
+  }
+  return 0;
+}
+
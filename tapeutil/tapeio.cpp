@@ -26,7 +26,18 @@
 #include <vector>
 #include <typeinfo>
 
-#include <FL/Fl.H>
+static Ep128Emu::Tape *openTapeImage(const char *fileName_, int channel_,
+                                     float minFreq_, float maxFreq_)
+{
+  Ep128Emu::Tape  *f = Ep128Emu::openTapeFile(fileName_, 2, 24000L, 1);
+  if (typeid(*f) == typeid(Ep128Emu::Tape_SoundFile)) {
+    // the file is only read once, so it is streamed instead of building
+    // the pulse tables in memory
+    dynamic_cast<Ep128Emu::Tape_SoundFile *>(f)->setParameters(
+        channel_, true, minFreq_, maxFreq_, false);
+  }
+  return f;
+}
 
 namespace Ep128Emu {
 
@@ -70,26 +81,26 @@ namespace Ep128Emu {
 
   // --------------------------------------------------------------------------
 
-  TapeInput::TapeInput(Tape *f_, Fl_Progress *disp)
+  TapeInput::TapeInput(Tape *f_, size_t startPos_, size_t endPos_)
     : f(f_),
-      sampleCnt(0),
+      sampleCnt(startPos_),
+      startPos(startPos_),
+      endPos(endPos_),
+      chunkPos(startPos_),
       percentsDone(0),
-      progressDisplay(disp),
+      progressCallback((void (*)(void *, int)) 0),
+      progressCallbackUserData((void *) 0),
       prvState(-1),
       crcValue(0),
       periodLength(1.0),
       totalSamples(0)
   {
-    if (disp) {
-      disp->minimum(0.0f);
-      disp->maximum(100.0f);
-      disp->value(0.0f);
-      Fl::wait(0.0);
-    }
     if (f) {
       totalSamples = size_t(uint32_t(f->getLength() * double(f->getSampleRate())
                                      + 4096.5));
-      f->seek(0.0);
+      if (endPos > 0 && endPos < totalSamples)
+        totalSamples = endPos;
+      f->seek(double(long(startPos)) / double(f->getSampleRate()));
       f->play();
       f->setIsMotorOn(true);
     }
@@ -101,6 +112,13 @@ namespace Ep128Emu {
       delete f;
   }
 
+  void TapeInput::setProgressCallback(void (*func)(void *userData, int n),
+                                      void *userData_)
+  {
+    progressCallback = func;
+    progressCallbackUserData = userData_;
+  }
+
   int TapeInput::getSample()
   {
     if (f == (Tape *) 0 || sampleCnt >= totalSamples)
@@ -108,17 +126,17 @@ namespace Ep128Emu {
     if (!(sampleCnt & 31)) {
       totalSamples = size_t(uint32_t(f->getLength() * double(f->getSampleRate())
                                      + 4096.5));
-      long    percentsDone_ = long(100.0 * double(long(sampleCnt))
-                                         / double(long(totalSamples))
+      if (endPos > 0 && endPos < totalSamples)
+        totalSamples = endPos;
+      long    percentsDone_ = long(100.0 * double(long(sampleCnt - startPos))
+                                         / double(long(totalSamples - startPos))
                                    + 0.5);
       percentsDone_ = (percentsDone_ > 0L ?
                        (percentsDone_ < 100L ? percentsDone_ : 100L) : 0L);
-      if (size_t(percentsDone_) != percentsDone) {
-        percentsDone = size_t(percentsDone_);
-        if (progressDisplay) {
-          progressDisplay->value(float(percentsDone_));
-          Fl::wait(0.0);
-        }
+      if (int(percentsDone_) != percentsDone) {
+        percentsDone = int(percentsDone_);
+        if (progressCallback)
+          progressCallback(progressCallbackUserData, percentsDone);
       }
     }
     sampleCnt++;
@@ -256,7 +274,9 @@ namespace Ep128Emu {
       buf[i] = 0;
     nBytes = 0;
     isHeader = false;
-    if (!this->search())
+    bool    foundChunk = this->search();
+    chunkPos = sampleCnt;
+    if (!foundChunk)
       return -1;
     int   n = readByte();
     if (n < 0)
@@ -418,7 +438,121 @@ namespace Ep128Emu {
 
   // --------------------------------------------------------------------------
 
+  class TapeFiles::ChunkDecoder : public Thread {
+   private:
+    std::string fileName;
+    int     channel;
+    float   minFreq;
+    float   maxFreq;
+    size_t  startPos;
+    size_t  endPos;
+    Mutex   mutex_;
+    int     percentsDone;
+    bool    abortFlag;
+    bool    doneFlag;
+    std::string errorMessage;
+    // --------
+    static void progressCallback(void *userData, int n);
+   public:
+    std::vector<TapeChunk>  chunks;
+    // --------
+    ChunkDecoder(const char *fileName_, int channel_,
+                 float minFreq_, float maxFreq_,
+                 size_t startPos_, size_t endPos_);
+    virtual ~ChunkDecoder();
+    // returns true if the thread has finished; 'n' is set to the
+    // percentage done, and 'errMsg' to the error message, if any
+    bool getStatus(int& n, std::string& errMsg);
+   protected:
+    virtual void run();
+  };
+
+  TapeFiles::ChunkDecoder::ChunkDecoder(const char *fileName_, int channel_,
+                                        float minFreq_, float maxFreq_,
+                                        size_t startPos_, size_t endPos_)
+    : Thread(),
+      fileName(fileName_),
+      channel(channel_),
+      minFreq(minFreq_),
+      maxFreq(maxFreq_),
+      startPos(startPos_),
+      endPos(endPos_),
+      percentsDone(0),
+      abortFlag(false),
+      doneFlag(false),
+      errorMessage("")
+  {
+  }
+
+  TapeFiles::ChunkDecoder::~ChunkDecoder()
+  {
+    mutex_.lock();
+    abortFlag = true;
+    mutex_.unlock();
+    this->join();
+  }
+
+  void TapeFiles::ChunkDecoder::progressCallback(void *userData, int n)
+  {
+    ChunkDecoder&   decoder = *(reinterpret_cast<ChunkDecoder *>(userData));
+    decoder.mutex_.lock();
+    decoder.percentsDone = n;
+    bool    abortFlag_ = decoder.abortFlag;
+    decoder.mutex_.unlock();
+    if (abortFlag_)
+      throw Exception("tape decoding aborted");
+  }
+
+  bool TapeFiles::ChunkDecoder::getStatus(int& n, std::string& errMsg)
+  {
+    mutex_.lock();
+    n = percentsDone;
+    errMsg = errorMessage;
+    bool    retval = doneFlag;
+    mutex_.unlock();
+    return retval;
+  }
+
+  void TapeFiles::ChunkDecoder::run()
+  {
+    std::string errMsg("");
+    try {
+      Tape      *f = openTapeImage(fileName.c_str(), channel, minFreq, maxFreq);
+      TapeInput *t = (TapeInput *) 0;
+      try {
+        t = new TapeInput(f, startPos, endPos);
+      }
+      catch (...) {
+        delete f;
+        throw;
+      }
+      try {
+        t->setProgressCallback(&progressCallback, (void *) this);
+        readChunks(chunks, *t);
+      }
+      catch (...) {
+        delete t;
+        throw;
+      }
+      delete t;
+    }
+    catch (std::exception& e) {
+      errMsg = e.what();
+      if (errMsg.length() < 1)
+        errMsg = "error decoding tape image";
+    }
+    mutex_.lock();
+    errorMessage = errMsg;
+    percentsDone = 100;
+    doneFlag = true;
+    mutex_.unlock();
+  }
+
+  // --------------------------------------------------------------------------
+
   TapeFiles::TapeFiles()
+    : progressCallback((void (*)(void *, int)) 0),
+      progressCallbackUserData((void *) 0)
   {
   }
 
@@ -433,42 +567,178 @@ namespace Ep128Emu {
     tapeFiles_.clear();
   }
 
-  void TapeFiles::readTapeImage(const char *fileName_, Fl_Progress *disp,
-                                int channel_, float minFreq_, float maxFreq_)
+  void TapeFiles::setProgressCallback(void (*func)(void *userData, int n),
+                                      void *userData_)
   {
-    if (fileName_ == (char *) 0 || fileName_[0] == '\0')
-      throw Exception("invalid file name");
-    Tape      *f = openTapeFile(fileName_, 2, 24000L, 1);
-    if (typeid(*f) == typeid(Tape_SoundFile)) {
-      dynamic_cast<Tape_SoundFile *>(f)->setParameters(channel_, true,
-                                                       minFreq_, maxFreq_);
+    progressCallback = func;
+    progressCallbackUserData = userData_;
+  }
+
+  void TapeFiles::readChunks(std::vector<TapeChunk>& chunks, TapeInput& t)
+  {
+    std::vector<uint8_t>  buf;
+    buf.resize(4096);
+    while (true) {
+      size_t  nBytes = 0;
+      bool    isHeader = false;
+      int     retval = t.readChunk(&(buf.front()), nBytes, isHeader);
+      chunks.resize(chunks.size() + 1);
+      TapeChunk&  c = chunks.back();
+      c.data.assign(buf.begin(), buf.begin() + nBytes);
+      c.startPos = t.getChunkPosition();
+      c.endPos = t.getPosition();
+      c.status = retval;
+      c.isHeader = isHeader;
+      if (retval < 0)
+        break;
+    }
+  }
+
+  bool TapeFiles::readChunksParallel(std::vector<TapeChunk>& chunks,
+                                     const char *fileName_, int channel_,
+                                     float minFreq_, float maxFreq_,
+                                     int nThreads)
+  {
+    // chunk positions found by different decoders may differ by a few
+    // samples when reading sound files, because of the filter state
+    const size_t  maxPositionError = 16;
+    size_t  nSamples = 0;
+    // each part is decoded past its end by 'overlapLength' samples (60
+    // seconds), so that the decoders of two adjacent parts find the same
+    // chunks there; this needs to be longer than the longest chunk (4096
+    // bytes, ~14 seconds)
+    size_t  overlapLength = 0;
+    {
+      Tape    *f = openTapeImage(fileName_, channel_, minFreq_, maxFreq_);
+      nSamples = size_t(uint32_t(f->getLength() * double(f->getSampleRate())
+                                 + 0.5));
+      overlapLength = size_t(f->getSampleRate()) * 60;
+      delete f;
     }
-    TapeInput *t = (TapeInput *) 0;
+    size_t  nParts = nSamples / (overlapLength * 2);
+    nParts = (nParts < size_t(nThreads) ? nParts : size_t(nThreads));
+    if (nParts < 2)
+      return false;
+    std::vector<size_t> partStartPos(nParts + 1);
+    for (size_t i = 0; i <= nParts; i++)
+      partStartPos[i] = size_t((uint64_t(nSamples) * i) / nParts);
+    std::vector<ChunkDecoder *> decoders(nParts, (ChunkDecoder *) 0);
     try {
-      t = new TapeInput(f, disp);
+      for (size_t i = 0; i < nParts; i++) {
+        size_t  endPos = 0;
+        if ((i + 1) < nParts)
+          endPos = partStartPos[i + 1] + overlapLength;
+        decoders[i] = new ChunkDecoder(fileName_, channel_, minFreq_, maxFreq_,
+                                       partStartPos[i], endPos);
+        decoders[i]->start();
+      }
+      std::string errMsg("");
+      int     prvPercentsDone = -1;
+      while (true) {
+        bool    doneFlag = true;
+        int     percentsDone = 0;
+        for (size_t i = 0; i < nParts; i++) {
+          int     n = 0;
+          std::string tmp;
+          doneFlag = decoders[i]->getStatus(n, tmp) && doneFlag;
+          percentsDone += n;
+          if (tmp.length() > 0 && errMsg.length() < 1)
+            errMsg = tmp;
+        }
+        if (errMsg.length() > 0)
+          throw Exception(errMsg.c_str());
+        percentsDone = percentsDone / int(nParts);
+        if (percentsDone != prvPercentsDone) {
+          prvPercentsDone = percentsDone;
+          if (progressCallback)
+            progressCallback(progressCallbackUserData, percentsDone);
+        }
+        if (doneFlag)
+          break;
+        Timer::wait(0.05);
+      }
+      // merge the chunk lists at the part boundaries
+      chunks.swap(decoders[0]->chunks);
+      for (size_t i = 1; i < nParts; i++) {
+        std::vector<TapeChunk>& nxtChunks = decoders[i]->chunks;
+        size_t  partStartPos_ = partStartPos[i];
+        size_t  partEndPos_ = partStartPos_ + overlapLength;
+        // the last entry is the end of the previous part, with any
+        // incomplete chunk that was being read there
+        TapeChunk&  endChunk = chunks.back();
+        bool    foundChunk = false;
+        for (size_t j = 0; (j + 1) < chunks.size() && !foundChunk; j++) {
+          if (chunks[j].startPos < partStartPos_)
+            continue;
+          // find the first complete chunk in the overlapping area that was
+          // also found by the decoder of the next part
+          for (size_t k = 0; k < nxtChunks.size(); k++) {
+            if (nxtChunks[k].status < 0)
+              break;
+            size_t  d = (nxtChunks[k].startPos >= chunks[j].startPos ?
+                         (nxtChunks[k].startPos - chunks[j].startPos)
+                         : (chunks[j].startPos - nxtChunks[k].startPos));
+            if (d <= maxPositionError) {
+              chunks.resize(j);
+              chunks.insert(chunks.end(), nxtChunks.begin() + k,
+                            nxtChunks.end());
+              foundChunk = true;
+              break;
+            }
+          }
+        }
+        if (foundChunk)
+          continue;
+        for (size_t j = 0; (j + 1) < chunks.size(); j++) {
+          if (chunks[j].startPos >= partStartPos_)
+            return false;
+        }
+        // no chunks after the boundary: if the previous part did not end in
+        // a chunk either, then there was only silence or noise in the
+        // overlapping area, and the parts can be joined there
+        if (endChunk.startPos < partEndPos_)
+          return false;
+        chunks.pop_back();
+        for (size_t k = 0; k < nxtChunks.size(); k++) {
+          if (nxtChunks[k].startPos >= partEndPos_ ||
+              nxtChunks[k].status < 0) {
+            chunks.insert(chunks.end(), nxtChunks.begin() + k,
+                          nxtChunks.end());
+            break;
+          }
+        }
+      }
     }
     catch (...) {
-      delete f;
+      for (size_t i = 0; i < nParts; i++) {
+        if (decoders[i])
+          delete decoders[i];
+      }
       throw;
     }
+    for (size_t i = 0; i < nParts; i++)
+      delete decoders[i];
+    return true;
+  }
+
+  void TapeFiles::addChunks(const std::vector<TapeChunk>& chunks)
+  {
     TapeFile  *tf = (TapeFile *) 0;
     try {
       bool    readingFile = false;
       bool    isCompleteFile = false;
-      std::vector<uint8_t>  buf;
-      buf.resize(4096);
-      size_t  nBytes = 0;
-      bool    isHeader = false;
-      int     retval;
       tf = new TapeFile;
       tf->hasErrors = false;
       tf->isComplete = false;
       tf->isCopyProtected = false;
-      while (true) {
-        retval = t->readChunk(&(buf.front()), nBytes, isHeader);
+      for (size_t i = 0; i < chunks.size(); i++) {
+        const std::vector<uint8_t>& buf = chunks[i].data;
+        size_t  nBytes = buf.size();
+        bool    isHeader = chunks[i].isHeader;
+        int     retval = chunks[i].status;
         if (!isHeader) {
-          for (size_t i = 0; i < nBytes; i++)
-            tf->fileData.push_back(buf[i]);
+          for (size_t j = 0; j < nBytes; j++)
+            tf->fileData.push_back(buf[j]);
         }
         if (readingFile && retval == 0 && nBytes == 4096 && !isHeader)
           continue;
@@ -500,7 +770,10 @@ namespace Ep128Emu {
         if (retval == 0 && isHeader) {
           readingFile = true;
           isCompleteFile = true;
-          tf->setFileName(reinterpret_cast<char *>(&(buf.front()) + 2));
+          std::string fname("");
+          for (size_t j = 2; j < nBytes && buf[j] != 0; j++)
+            fname += char(buf[j]);
+          tf->setFileName(fname);
           tf->isCopyProtected = (buf[0] == 0x00);
         }
       }
@@ -508,12 +781,48 @@ namespace Ep128Emu {
     catch (...) {
       if (tf)
         delete tf;
-      delete t;
       throw;
     }
     if (tf)
       delete tf;
-    delete t;
+  }
+
+  void TapeFiles::readTapeImage(const char *fileName_,
+                                int channel_, float minFreq_, float maxFreq_,
+                                int nThreads)
+  {
+    if (fileName_ == (char *) 0 || fileName_[0] == '\0')
+      throw Exception("invalid file name");
+    if (progressCallback)
+      progressCallback(progressCallbackUserData, 0);
+    std::vector<TapeChunk>  chunks;
+    if (nThreads > 1) {
+      if (!readChunksParallel(chunks, fileName_, channel_,
+                              minFreq_, maxFreq_, nThreads)) {
+        chunks.clear();
+      }
+    }
+    if (chunks.size() < 1) {
+      Tape      *f = openTapeImage(fileName_, channel_, minFreq_, maxFreq_);
+      TapeInput *t = (TapeInput *) 0;
+      try {
+        t = new TapeInput(f);
+      }
+      catch (...) {
+        delete f;
+        throw;
+      }
+      try {
+        t->setProgressCallback(progressCallback, progressCallbackUserData);
+        readChunks(chunks, *t);
+      }
+      catch (...) {
+        delete t;
+        throw;
+      }
+      delete t;
+    }
+    addChunks(chunks);
   }
 
   bool TapeFiles::writeTapeImage(const char *fileName_, bool allowOverwrite_)
@@ -24,7 +24,6 @@
 #include "tape.hpp"
 
 #include <vector>
-#include <FL/Fl_Progress.H>
 
 namespace Ep128Emu {
 
@@ -32,16 +31,45 @@ namespace Ep128Emu {
    private:
     Tape      *f;
     size_t    sampleCnt;
-    size_t    percentsDone;
-    Fl_Progress *progressDisplay;
+    size_t    startPos;
+    size_t    endPos;
+    size_t    chunkPos;
+    int       percentsDone;
+    void      (*progressCallback)(void *userData, int n);
+    void      *progressCallbackUserData;
     int       prvState;
     uint16_t  crcValue;
     double    periodLength;
    protected:
     size_t    totalSamples;
    public:
-    TapeInput(Tape *f_, Fl_Progress *disp);
+    /*!
+     * Read samples 'startPos_' to 'endPos_' - 1 from 'f_', or until the end
+     * of the tape if 'endPos_' is zero. 'f_' is deleted by the destructor.
+     */
+    TapeInput(Tape *f_, size_t startPos_ = 0, size_t endPos_ = 0);
     virtual ~TapeInput();
+    /*!
+     * Set function to be called when the percentage of samples read
+     * changes.
+     */
+    void setProgressCallback(void (*func)(void *userData, int n),
+                             void *userData_);
+    /*!
+     * Returns the current sample position.
+     */
+    inline size_t getPosition() const
+    {
+      return sampleCnt;
+    }
+    /*!
+     * Returns the sample position where the last chunk was found by
+     * readChunk().
+     */
+    inline size_t getChunkPosition() const
+    {
+      return chunkPos;
+    }
     /*!
      * Returns tape signal (0 or 1), or -1 on end of file.
      */
@@ -121,7 +149,25 @@ namespace Ep128Emu {
 
   class TapeFiles {
    private:
+    struct TapeChunk {
+      std::vector<uint8_t>  data;
+      size_t  startPos;         // sample position where the chunk was found
+      size_t  endPos;           // sample position after the end of the chunk
+      int     status;           // return value of TapeInput::readChunk()
+      bool    isHeader;
+    };
+    class ChunkDecoder;
     std::vector<TapeFile *> tapeFiles_;
+    void    (*progressCallback)(void *userData, int n);
+    void    *progressCallbackUserData;
+    // --------
+    static void readChunks(std::vector<TapeChunk>& chunks, TapeInput& t);
+    // decode 'fileName_' on 'nThreads' threads, returns false if the chunks
+    // at the boundaries of the parts could not be matched
+    bool readChunksParallel(std::vector<TapeChunk>& chunks,
+                            const char *fileName_, int channel_,
+                            float minFreq_, float maxFreq_, int nThreads);
+    void addChunks(const std::vector<TapeChunk>& chunks);
    public:
     TapeFiles();
     virtual ~TapeFiles();
@@ -135,9 +181,21 @@ namespace Ep128Emu {
     {
       return tapeFiles_.size();
     }
-    void readTapeImage(const char *fileName_, Fl_Progress *disp,
+    /*!
+     * Set function to be called with the percentage done (0 to 100) while
+     * reading tape images.
+     */
+    void setProgressCallback(void (*func)(void *userData, int n),
+                             void *userData_);
+    /*!
+     * Read all files from a tape image, and append them to the list.
+     * Long sound files are split into parts at the chunk leaders, and
+     * decoded on up to 'nThreads' threads.
+     */
+    void readTapeImage(const char *fileName_,
                        int channel_ = 0,
-                       float minFreq_ = 600.0f, float maxFreq_ = 3000.0f);
+                       float minFreq_ = 600.0f, float maxFreq_ = 3000.0f,
+                       int nThreads = 1);
     bool writeTapeImage(const char *fileName_, bool allowOverwrite_ = false);
     void importFile(const char *fileName_);
     bool exportFile(int n, const char *fileName_, bool allowOverwrite_ = false);
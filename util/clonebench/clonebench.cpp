@@ -0,0 +1,180 @@
+
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2017 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Measures the speed of saving and restoring the state of an emulated
+// Enterprise 128 (without ROM) with Ep128VM::cloneState() and restoreState(),
+// restoring it into a second machine created with Ep128VM::forkState(), and
+// compares the results with a snapshot saved with Ep128VM::saveState().
+
+#include "ep128emu.hpp"
+#include "display.hpp"
+#include "soundio.hpp"
+#include "demorender.hpp"
+#include "ep128vm.hpp"
+#include "system.hpp"
+
+#include <cstdlib>
+
+// run each test for at least this many seconds
+static const double minTestTime = 0.5;
+
+// Z80 code at 0000H (the low 16K of segment F8H): increment the byte at
+// 4000H in a loop, so that the state changes while the machine is running
+
+static const unsigned char testCode[] = {
+  0xF3,                 // DI
+  0x21, 0x00, 0x40,     // LD HL, 4000H
+  0x34,                 // INC (HL)
+  0x18, 0xFD            // JR $-1
+};
+
+static void printResult(const char *name, size_t n, double t)
+{
+  if (t <= 0.0)
+    t = 1.0e-9;
+  std::printf("%-24s %10.3f us, %12.1f per second\n",
+              name, t * 1000000.0 / double(n), double(n) / t);
+}
+
+int main(int argc, char **argv)
+{
+  size_t  ramSize = 128;
+  bool    printUsageFlag = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string tmp = argv[i];
+      if (tmp.length() < 1)
+        continue;
+      if (tmp == "-m") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -m");
+        int     n = int(std::atoi(argv[i]));
+        if (n < 64 || n > 3712)
+          throw Ep128Emu::Exception("RAM size is out of range");
+        ramSize = size_t(n);
+      }
+      else {
+        printUsageFlag = true;
+        if (tmp == "-h" || tmp == "-help" || tmp == "--help")
+          throw Ep128Emu::Exception("");
+        throw Ep128Emu::Exception("invalid command line option");
+      }
+    }
+    Ep128Emu::NullVideoDisplay  display;
+    Ep128Emu::AudioOutput   audioOutput;
+    Ep128::Ep128VM  vm(display, audioOutput);
+    Ep128::Ep128VM  vm2(display, audioOutput);
+    vm.setEnableDisplay(false);
+    vm.setEnableAudioOutput(false);
+    vm2.setEnableDisplay(false);
+    vm2.setEnableAudioOutput(false);
+    vm.resetMemoryConfiguration(ramSize);
+    for (uint16_t i = 0; i < 4; i++)
+      vm.writeIOPort(0xB0 + i, uint8_t(0xF8 + i));
+    for (size_t i = 0; i < sizeof(testCode); i++)
+      vm.writeMemory(uint16_t(i), testCode[i], true);
+    vm.setProgramCounter(0x0000);
+    vm.run(20000);
+    Ep128Emu::MachineState  s;
+    if (!vm.cloneState(s))
+      throw Ep128Emu::Exception("cloneState() failed");
+    // preallocate the buffer, so that the tests do not allocate any memory
+    s.reserve(s.getDataSize());
+    std::printf("RAM size: %luK, machine state size: %lu bytes\n",
+                (unsigned long) ramSize, (unsigned long) s.getDataSize());
+    Ep128Emu::Timer timer;
+    size_t  n = 0;
+    double  t = 0.0;
+    do {
+      for (int i = 0; i < 100; i++) {
+        s.clear();
+        (void) vm.cloneState(s);
+      }
+      n += 100;
+      t = timer.getRealTime();
+    } while (t < minTestTime);
+    printResult("cloneState()", n, t);
+    timer.reset();
+    n = 0;
+    do {
+      for (int i = 0; i < 100; i++) {
+        s.rewind();
+        vm.restoreState(s);
+      }
+      n += 100;
+      t = timer.getRealTime();
+    } while (t < minTestTime);
+    printResult("restoreState()", n, t);
+    vm.forkState(vm2);
+    timer.reset();
+    n = 0;
+    do {
+      for (int i = 0; i < 100; i++) {
+        s.rewind();
+        vm2.restoreState(s);
+      }
+      n += 100;
+      t = timer.getRealTime();
+    } while (t < minTestTime);
+    printResult("restoreState() (fork)", n, t);
+    timer.reset();
+    n = 0;
+    do {
+      vm.forkState(vm2);
+      n++;
+      t = timer.getRealTime();
+    } while (t < minTestTime);
+    printResult("forkState()", n, t);
+    timer.reset();
+    n = 0;
+    do {
+      Ep128Emu::File  f;
+      vm.saveState(f);
+      n++;
+      t = timer.getRealTime();
+    } while (t < minTestTime);
+    printResult("saveState()", n, t);
+    // check that the forked machine runs the same way as the original
+    vm.forkState(vm2);
+    vm.run(20000);
+    vm2.run(20000);
+    for (uint32_t i = 0; i < 0x10000U; i++) {
+      uint16_t  addr = uint16_t(i);
+      if (vm.readMemory(addr, true) != vm2.readMemory(addr, true))
+        throw Ep128Emu::Exception("forked machine state does not match");
+    }
+    if (vm.getProgramCounter() != vm2.getProgramCounter())
+      throw Ep128Emu::Exception("forked machine state does not match");
+  }
+  catch (std::exception& e) {
+    if (printUsageFlag) {
+      std::printf("Usage: %s [OPTIONS...]\n", argv[0]);
+      std::printf("Options:\n");
+      std::printf("    -m <N>\n");
+      std::printf("        RAM size in kilobytes (64 to 3712, "
+                  "default: 128)\n");
+      if (e.what()[0] == '\0')
+        return 0;
+    }
+    std::fprintf(stderr, " *** %s: %s\n", argv[0], e.what());
+    return -1;
+  }
+  return 0;
+}
+
@@ -19,8 +19,10 @@
 #include "ep128emu.hpp"
 #include "compress.hpp"
 #include "compress3.hpp"
+#include "compress4.hpp"
 #include "decompm2.hpp"
 #include "decompress3.hpp"
+#include "decompress4.hpp"
 
 static void defaultProgressMessageCb(void *userData, const char *msg)
 {
@@ -65,6 +67,8 @@ namespace Ep128Compress {
       blockSize = 16;
     if (blockSize > 65536)
       blockSize = 65536;
+    if (byteCost > 1024)
+      byteCost = 1024;
   }
 
   Compressor::CompressionParameters::CompressionParameters()
@@ -72,7 +76,8 @@ namespace Ep128Compress {
       splitOptimizationDepth(1),
       minLength(1),
       maxOffset(65536),
-      blockSize(0)
+      blockSize(0),
+      byteCost(64)
   {
   }
 
@@ -84,6 +89,7 @@ namespace Ep128Compress {
     minLength = r.minLength;
     maxOffset = r.maxOffset;
     blockSize = r.blockSize;
+    byteCost = r.byteCost;
     this->limitParameters();
   }
 
@@ -96,6 +102,7 @@ namespace Ep128Compress {
     minLength = r.minLength;
     maxOffset = r.maxOffset;
     blockSize = r.blockSize;
+    byteCost = r.byteCost;
     this->limitParameters();
     return (*this);
   }
@@ -204,6 +211,8 @@ namespace Ep128Compress {
     switch (compressionType) {
     case 3:
       return new Compressor_M3(outBuf);
+    case 4:
+      return new Compressor_M4(outBuf);
     }
     throw Ep128Emu::Exception("internal error: invalid compression type");
   }
@@ -213,6 +222,8 @@ namespace Ep128Compress {
     switch (compressionType) {
     case 3:
       return new Decompressor_M3();
+    case 4:
+      return new Decompressor_M4();
     }
     throw Ep128Emu::Exception("internal error: invalid compression type");
   }
@@ -221,10 +232,17 @@ namespace Ep128Compress {
                      const std::vector< unsigned char >& inBuf,
                      int compressionType)
   {
-    if (compressionType >= 0 && compressionType != 3)
+    if (compressionType >= 0 && (compressionType < 3 || compressionType > 4))
       throw Ep128Emu::Exception("internal error: invalid compression type");
     if (compressionType < 0) {
       // auto-detect compression type
+      try {
+        Decompressor_M4 decomp;
+        decomp.decompressData(outBuf, inBuf);
+        return 4;
+      }
+      catch (const Ep128Emu::Exception&) {
+      }
       compressionType = 3;
     }
     Decompressor  *decomp = createDecompressor(compressionType);
@@ -243,7 +261,7 @@ namespace Ep128Compress {
                      const std::vector< unsigned char >& inBuf,
                      int compressionType)
   {
-    if (compressionType >= 0 && (compressionType < 2 || compressionType > 3))
+    if (compressionType >= 0 && (compressionType < 2 || compressionType > 4))
       throw Ep128Emu::Exception("internal error: invalid compression type");
     if (compressionType < 0) {
       // auto-detect compression type
@@ -251,7 +269,15 @@ namespace Ep128Compress {
         Ep128Emu::decompressData(outBuf, &(inBuf.front()), inBuf.size());
         return 2;
       }
-      catch (Ep128Emu::Exception) {
+      catch (const Ep128Emu::Exception&) {
+      }
+      try {
+        // the size header of type 4 data never matches type 3
+        Decompressor_M4 decomp;
+        decomp.decompressData(outBuf, inBuf);
+        return 4;
+      }
+      catch (const Ep128Emu::Exception&) {
       }
       compressionType = 3;
     }
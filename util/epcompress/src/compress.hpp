@@ -35,6 +35,9 @@ namespace Ep128Compress {
       size_t  minLength;
       size_t  maxOffset;
       size_t  blockSize;
+      // cost of one byte of compressed data in Z80 cycles, used by
+      // compression type 4 to trade size for decompression speed
+      size_t  byteCost;
       CompressionParameters();
       CompressionParameters(const CompressionParameters& r);
       ~CompressionParameters()
@@ -0,0 +1,209 @@
+
+// compressor utility for Enterprise 128 programs
+// Copyright (C) 2007-2017 Istvan Varga <istvanv@users.sourceforge.net>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "ep128emu.hpp"
+#include "compress.hpp"
+#include "comprlib.hpp"
+#include "compress4.hpp"
+
+namespace Ep128Compress {
+
+  // The cost of each command is the size in bytes multiplied by
+  // config.byteCost, plus the number of Z80 cycles needed to decode it.
+
+  inline size_t Compressor_M4::getMatchCost(size_t d, size_t n) const
+  {
+    if (d <= maxShortRepeatDist && n <= maxShortRepeatLen) {
+      return ((config.byteCost << 1) + shortMatchCycles
+              + (n * cyclesPerByteCopied));
+    }
+    if (n < 3)
+      return 0x7FFFFFFF;
+    return ((config.byteCost * 3) + longMatchCycles
+            + (n * cyclesPerByteCopied));
+  }
+
+  inline size_t Compressor_M4::getLiteralSequenceCost(size_t n) const
+  {
+    return ((config.byteCost * (n + 1)) + literalSequenceCycles
+            + (n * cyclesPerByteCopied));
+  }
+
+  void Compressor_M4::optimizeMatches(LZMatchParameters *matchTable,
+                                      size_t *costTable, size_t nBytes)
+  {
+    size_t  minLen = (config.minLength > 2 ? config.minLength : 2);
+    costTable[nBytes] = 0;
+    for (size_t i = nBytes; i-- > 0; ) {
+      size_t  bestCost = 0x7FFFFFFF;
+      size_t  bestLen = 1;
+      size_t  bestOffs = 0;
+      // check all possible literal sequence lengths
+      for (size_t k = 1; k <= maxLiteralSequenceLen && (i + k) <= nBytes;
+           k++) {
+        size_t  c = getLiteralSequenceCost(k) + costTable[i + k];
+        if (c < bestCost) {
+          bestCost = c;
+          bestLen = k;
+        }
+      }
+      // and all possible LZ77 match lengths; for each length, only the
+      // shortest offset is stored in the search table
+      const unsigned int  *matchPtr = searchTable->getMatches(i);
+      for (size_t len = (*matchPtr & 0x03FFU); len >= minLen;
+           len = (*matchPtr & 0x03FFU)) {
+        size_t  d = *matchPtr >> 10;
+        size_t  nxtLen = *(++matchPtr) & 0x03FFU;
+        nxtLen = (nxtLen >= minLen ? nxtLen : (minLen - 1));
+        for ( ; len > nxtLen; len--) {
+          size_t  c = getMatchCost(d, len) + costTable[i + len];
+          if (c < bestCost) {
+            bestCost = c;
+            bestOffs = d;
+            bestLen = len;
+          }
+        }
+      }
+      matchTable[i].d = (unsigned short) bestOffs;
+      matchTable[i].len = (unsigned short) bestLen;
+      costTable[i] = bestCost;
+    }
+  }
+
+  bool Compressor_M4::compressData_(std::vector< unsigned char >& tmpOutBuf,
+                                    const std::vector< unsigned char >& inBuf)
+  {
+    size_t  nBytes = inBuf.size();
+    tmpOutBuf.clear();
+    std::vector< LZMatchParameters >  matchTable(nBytes);
+    std::vector< size_t >   costTable(nBytes + 1, 0);
+    optimizeMatches(&(matchTable.front()), &(costTable.front()), nBytes);
+    // reserve space for compressed data size
+    tmpOutBuf.push_back(0x00);
+    tmpOutBuf.push_back(0x00);
+    for (size_t i = 0; i < nBytes; ) {
+      const LZMatchParameters&  tmp = matchTable[i];
+      size_t  n = tmp.len;
+      if (tmp.d > 0) {
+        // write LZ77 match
+        size_t  d = tmp.d;
+        if (d <= maxShortRepeatDist && n <= maxShortRepeatLen) {
+          tmpOutBuf.push_back((unsigned char) (0x80 | (n - 2)));
+          tmpOutBuf.push_back((unsigned char) ((256 - d) & 0xFF));
+        }
+        else {
+          if (n < 3 || n > maxRepeatLen)
+            throw Ep128Emu::Exception("internal error: invalid match length");
+          d = 65536 - d;
+          tmpOutBuf.push_back((unsigned char) (0xC0 | (n - 3)));
+          tmpOutBuf.push_back((unsigned char) (d & 0xFF));
+          tmpOutBuf.push_back((unsigned char) (d >> 8));
+        }
+      }
+      else {
+        // write literal sequence
+        tmpOutBuf.push_back((unsigned char) n);
+        for (size_t j = 0; j < n; j++)
+          tmpOutBuf.push_back(inBuf[i + j]);
+      }
+      i = i + n;
+    }
+    tmpOutBuf.push_back(0x00);          // end of data
+    size_t  compressedSize = tmpOutBuf.size() - 2;
+    if (compressedSize > 65535)
+      return false;
+    tmpOutBuf[0] = (unsigned char) (compressedSize & 0xFF);
+    tmpOutBuf[1] = (unsigned char) (compressedSize >> 8);
+    return true;
+  }
+
+  Compressor_M4::Compressor_M4(std::vector< unsigned char >& outBuf_)
+    : Compressor(outBuf_),
+      searchTable((LZSearchTable *) 0)
+  {
+  }
+
+  Compressor_M4::~Compressor_M4()
+  {
+    if (searchTable)
+      delete searchTable;
+  }
+
+  bool Compressor_M4::compressData(const std::vector< unsigned char >& inBuf,
+                                   unsigned int startAddr, bool isLastBlock,
+                                   bool enableProgressDisplay)
+  {
+    (void) enableProgressDisplay;
+    // allow start address 0100H (program with EXOS 5 header) for compatibility
+    if ((startAddr != 0x0100U && startAddr != 0xFFFFFFFFU) || !isLastBlock) {
+      throw Ep128Emu::Exception("Compressor_M4::compressData(): "
+                                "internal error: "
+                                "unsupported output format parameters");
+    }
+    if (searchTable) {
+      delete searchTable;
+      searchTable = (LZSearchTable *) 0;
+    }
+    size_t  nBytes = inBuf.size();
+    if (nBytes < 1)
+      return true;
+    if (nBytes > 65535)
+      throw Ep128Emu::Exception("input data size is too large");
+    std::vector< unsigned char >  tmpOutBuf;
+    try {
+      searchTable =
+          new LZSearchTable(
+              (config.minLength > minRepeatLen ?
+               config.minLength : minRepeatLen),
+              maxRepeatLen, maxRepeatLen, 0, maxShortRepeatDist,
+              (config.maxOffset < maxRepeatDist ?
+               config.maxOffset : maxRepeatDist));
+      searchTable->findMatches(&(inBuf.front()), 0, nBytes);
+      bool    sizeOK = compressData_(tmpOutBuf, inBuf);
+      if (!sizeOK && config.byteCost < 16384) {
+        // with a low byte cost, the output may be too large even if the
+        // data could be compressed; try again optimizing mainly for size
+        size_t  savedByteCost = config.byteCost;
+        config.byteCost = 16384;
+        try {
+          sizeOK = compressData_(tmpOutBuf, inBuf);
+        }
+        catch (...) {
+          config.byteCost = savedByteCost;
+          throw;
+        }
+        config.byteCost = savedByteCost;
+      }
+      delete searchTable;
+      searchTable = (LZSearchTable *) 0;
+      if (!sizeOK)
+        return false;
+    }
+    catch (...) {
+      if (searchTable) {
+        delete searchTable;
+        searchTable = (LZSearchTable *) 0;
+      }
+      throw;
+    }
+    outBuf.insert(outBuf.end(), tmpOutBuf.begin(), tmpOutBuf.end());
+    return true;
+  }
+
+}       // namespace Ep128Compress
+
@@ -0,0 +1,94 @@
+
+// compressor utility for Enterprise 128 programs
+// Copyright (C) 2007-2017 Istvan Varga <istvanv@users.sourceforge.net>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef EPCOMPRESS_COMPRESS4_HPP
+#define EPCOMPRESS_COMPRESS4_HPP
+
+#include "ep128emu.hpp"
+#include "compress.hpp"
+#include "comprlib.hpp"
+
+#include <vector>
+
+namespace Ep128Compress {
+
+  // Compression type 4 is a simple byte-aligned LZ77 format optimized for
+  // decompression speed on the Z80. The compressed data begins with the
+  // 16-bit size of the remaining data, followed by a sequence of commands:
+  //   00H:         end of data
+  //   01H to 7FH:  literal sequence of 1 to 127 bytes, followed by the bytes
+  //   80H to BFH:  match of 2 to 65 bytes (b0..b5 + 2), followed by
+  //                (256 - offset) & 0FFH (offset = 1 to 256)
+  //   C0H to FFH:  match of 3 to 66 bytes (b0..b5 + 3), followed by the
+  //                16-bit value 65536 - offset (offset = 1 to 65535)
+  // See z80_asm/decompress_m4.s for the decompressor.
+
+  class Compressor_M4 : public Compressor {
+   public:
+    static const size_t minRepeatDist = 1;
+    static const size_t maxRepeatDist = 65535;
+    static const size_t maxShortRepeatDist = 256;
+    static const size_t minRepeatLen = 2;
+    static const size_t maxRepeatLen = 66;
+    static const size_t maxShortRepeatLen = 65;
+    static const size_t maxLiteralSequenceLen = 127;
+    // Z80 cycles (T-states) used by the decompressor; each command takes
+    // a fixed number of cycles plus 21 for each byte copied with LDIR
+    static const size_t literalSequenceCycles = 42;
+    static const size_t shortMatchCycles = 111;
+    static const size_t longMatchCycles = 128;
+    static const size_t cyclesPerByteCopied = 21;
+   private:
+    struct LZMatchParameters {
+      unsigned short  d;
+      unsigned short  len;
+      LZMatchParameters()
+        : d(0),
+          len(1)
+      {
+      }
+    };
+    // --------
+    LZSearchTable   *searchTable;
+    // --------
+    inline size_t getMatchCost(size_t d, size_t n) const;
+    inline size_t getLiteralSequenceCost(size_t n) const;
+    void optimizeMatches(LZMatchParameters *matchTable, size_t *costTable,
+                         size_t nBytes);
+    // returns false if the compressed data is larger than 65535 bytes
+    bool compressData_(std::vector< unsigned char >& tmpOutBuf,
+                       const std::vector< unsigned char >& inBuf);
+   public:
+    Compressor_M4(std::vector< unsigned char >& outBuf_);
+    virtual ~Compressor_M4();
+    // 'startAddr' must be 0xFFFFFFFF, or 0x0100 (program with EXOS 5 header,
+    // accepted for compatibility, but the output is the same)
+    // 'isLastBlock' must be true
+    // 'enableProgressDisplay' is ignored
+    // returns false, and does not write any output, if the data does not
+    // compress to 65535 bytes or less (this can happen with input that is
+    // close to 64K and cannot be compressed)
+    virtual bool compressData(const std::vector< unsigned char >& inBuf,
+                              unsigned int startAddr, bool isLastBlock,
+                              bool enableProgressDisplay = false);
+  };
+
+}       // namespace Ep128Compress
+
+#endif  // EPCOMPRESS_COMPRESS4_HPP
+
@@ -0,0 +1,588 @@
+
+// compressor utility for Enterprise 128 programs
+// Copyright (C) 2007-2017 Istvan Varga <istvanv@users.sourceforge.net>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Runs the Z80 decompressors in an emulated Enterprise 128 (without ROM),
+// verifies the decompressed data against the host side decompressor, and
+// reports the number of CPU cycles, the emulation time, and the number of
+// bytes decompressed per video frame (80000 cycles at 4 MHz / 50 Hz).
+// The following decompressors are tested:
+//   m3:  z80_asm/decompress_m3.s (raw compressed data in 16K blocks)
+//   m4:  z80_asm/decompress_m4.s (raw compressed data in 16K blocks)
+//   sfx: self-extracting program (z80_asm/decompress_sfx_m3.s, sfxcode.cpp),
+//        loaded at 0100H like an EXOS 5 file, in blocks of up to 47.5K
+
+#include "ep128emu.hpp"
+#include "compress.hpp"
+#include "display.hpp"
+#include "soundio.hpp"
+#include "demorender.hpp"
+#include "ep128vm.hpp"
+#include "system.hpp"
+
+#include <vector>
+
+// z80_asm/decompress_m3.s (NO_BORDER_FX = 1), assembled at FF60H
+
+static const unsigned char decompressorCode_M3[] = {
+  0xF3, 0xE5, 0xAF, 0x6F, 0x67, 0xED, 0x52, 0x22, 0xC9, 0xFF, 0xE1, 0x4E,
+  0x23, 0x46, 0xED, 0x4A, 0xE5, 0xD9, 0xE1, 0xD9, 0xEB, 0x09, 0x1A, 0x13,
+  0x4F, 0x1A, 0x47, 0x09, 0xEB, 0xB1, 0x28, 0x50, 0xD5, 0x1B, 0x01, 0x01,
+  0x10, 0xCD, 0xE0, 0xFF, 0xCD, 0xC8, 0xFF, 0xD9, 0x78, 0x41, 0x2B, 0x4E,
+  0xD9, 0x30, 0x03, 0x1F, 0x4F, 0xC9, 0x12, 0x1B, 0x2B, 0x7D, 0xB4, 0x20,
+  0xEE, 0xCD, 0xC8, 0xFF, 0xE5, 0x68, 0x06, 0x04, 0x28, 0x18, 0xCD, 0xE0,
+  0xFF, 0x45, 0xCD, 0xDA, 0xFF, 0x19, 0x79, 0xED, 0xA8, 0xC1, 0xED, 0xB8,
+  0x4F, 0xCB, 0x39, 0xCC, 0x8B, 0xFF, 0x30, 0xCC, 0x18, 0xDF, 0xCD, 0xE7,
+  0xFF, 0x45, 0xCD, 0xDB, 0xFF, 0x2B, 0x18, 0xE5, 0x21, 0x00, 0x00, 0x19,
+  0x38, 0x05, 0xD1, 0xD1, 0xFB, 0xC9, 0x04, 0xCB, 0x39, 0xCC, 0x8B, 0xFF,
+  0x38, 0xF8, 0x05, 0x21, 0x01, 0x00, 0x04, 0xC8, 0xCB, 0x39, 0xCC, 0x8B,
+  0xFF, 0xED, 0x6A, 0x10, 0xF7, 0xC9
+};
+
+// z80_asm/decompress_m4.s, assembled at FF00H
+
+static const unsigned char decompressorCode_M4[] = {
+  0x23, 0x23, 0x06, 0x00, 0x7E, 0x23, 0x87, 0x38, 0x08, 0xC8, 0x0F, 0x4F,
+  0xED, 0xB0, 0xC3, 0x04, 0xFF, 0xFA, 0x24, 0xFF, 0x0F, 0xC6, 0x02, 0x4F,
+  0xE5, 0x6E, 0x26, 0xFF, 0x19, 0xED, 0xB0, 0xE1, 0x23, 0xC3, 0x04, 0xFF,
+  0xE6, 0x7E, 0x0F, 0xC6, 0x03, 0x4F, 0x7E, 0x23, 0xE5, 0x66, 0x6F, 0x19,
+  0xED, 0xB0, 0xE1, 0x23, 0xC3, 0x04, 0xFF
+};
+
+// replacement for the EXOS entry point at 0030H: the SFX loader only uses
+// EXOS 24 (allocate segment), which returns the next segment number from
+// the table at BFFCH-BFFFH (HL points to the previous entry)
+
+static const unsigned char exosCallCode[] = {
+  0xE3,                 // EX (SP), HL
+  0x23,                 // INC HL           skip function code
+  0xE3,                 // EX (SP), HL
+  0x23,                 // INC HL
+  0x4E,                 // LD C, (HL)
+  0x2B,                 // DEC HL
+  0xAF,                 // XOR A
+  0xC9                  // RET
+};
+
+static const uint16_t decompressorAddr_M3 = 0xFF60;
+static const uint16_t decompressorAddr_M4 = 0xFF00;
+// the decompressor returns to an infinite loop ('JR $') at this address
+static const uint16_t returnAddr = 0xFEFE;
+// decompressed data is written to 0100H, and the compressed data is
+// loaded to page 2 (the M3 decompressor does not allow an output address
+// of 0000H)
+static const uint16_t outputAddr = 0x0100;
+static const uint16_t inputAddr = 0x8000;
+static const size_t   blockSize = 16384;
+// SFX programs are loaded at 0100H, and jump to 'JR $' at 0040H instead of
+// the decompressed program when done
+static const uint16_t exosCallAddr = 0x0030;
+static const uint16_t sfxReturnAddr = 0x0040;
+static const uint16_t sfxLoadAddr = 0x0100;
+static const size_t   sfxBlockSize = 0xBE00;
+// 4 MHz CPU clock, 50 Hz frame rate
+static const double   cyclesPerFrame = 80000.0;
+
+class DecompressorBenchmark {
+ private:
+  Ep128Emu::NullVideoDisplay  display;
+  Ep128Emu::AudioOutput   audioOutput;
+  Ep128::Ep128VM          *vm;
+ public:
+  // 'memoryWaitMode' is the memory wait mode set in bits 2 and 3 of port BFH
+  // (0: wait on all memory accesses, 1: wait on M1 only, 2: no wait)
+  DecompressorBenchmark(int memoryWaitMode);
+  ~DecompressorBenchmark();
+  // map segments F8H to FBH to pages 0..3
+  void resetMemoryPaging();
+  // if 'isCPUAddress' is false, 'addr' is a physical address (see vm.hpp)
+  void writeMemory(uint32_t addr, const unsigned char *buf, size_t nBytes,
+                   bool isCPUAddress = true);
+  void readMemory(std::vector< unsigned char >& buf,
+                  uint32_t addr, size_t nBytes,
+                  bool isCPUAddress = true) const;
+  // run the Z80 code at 'addr' until the program counter reaches 'stopAddr',
+  // and return the number of CPU cycles used
+  size_t runCode(uint16_t addr, uint16_t stopAddr,
+                 size_t maxCycles = 100000000);
+  // call the Z80 routine at 'addr' with the specified HL and DE values,
+  // and return the number of CPU cycles until it returns
+  size_t callRoutine(uint16_t addr, uint16_t hl, uint16_t de,
+                     size_t maxCycles = 100000000);
+};
+
+DecompressorBenchmark::DecompressorBenchmark(int memoryWaitMode)
+  : display(),
+    audioOutput(),
+    vm((Ep128::Ep128VM *) 0)
+{
+  vm = new Ep128::Ep128VM(display, audioOutput);
+  try {
+    vm->setEnableDisplay(false);
+    vm->setEnableAudioOutput(false);
+    vm->setCPUFrequency(4000000);
+    vm->setEnableMemoryTimingEmulation(true);
+    // 128K RAM at segments F8H to FFH
+    vm->resetMemoryConfiguration(128);
+    resetMemoryPaging();
+    vm->writeIOPort(0xBF, uint8_t((memoryWaitMode & 3) << 2));
+    // disable and clear all interrupts, there is no ROM to handle them
+    // if a decompressor enables interrupts on return
+    vm->writeIOPort(0xB4, 0xAA);
+  }
+  catch (...) {
+    delete vm;
+    throw;
+  }
+}
+
+DecompressorBenchmark::~DecompressorBenchmark()
+{
+  delete vm;
+}
+
+void DecompressorBenchmark::resetMemoryPaging()
+{
+  for (uint16_t i = 0; i < 4; i++)
+    vm->writeIOPort(0xB0 + i, uint8_t(0xF8 + i));
+}
+
+void DecompressorBenchmark::writeMemory(uint32_t addr,
+                                        const unsigned char *buf,
+                                        size_t nBytes, bool isCPUAddress)
+{
+  for (size_t i = 0; i < nBytes; i++)
+    vm->writeMemory(uint32_t(addr + i), buf[i], isCPUAddress);
+}
+
+void DecompressorBenchmark::readMemory(std::vector< unsigned char >& buf,
+                                       uint32_t addr, size_t nBytes,
+                                       bool isCPUAddress) const
+{
+  buf.resize(nBytes);
+  for (size_t i = 0; i < nBytes; i++)
+    buf[i] = vm->readMemory(uint32_t(addr + i), isCPUAddress);
+}
+
+size_t DecompressorBenchmark::runCode(uint16_t addr, uint16_t stopAddr,
+                                      size_t maxCycles)
+{
+  uint16_t  prvAddr = vm->getProgramCounter();
+  if (prvAddr != addr) {
+    // the instruction at the current address is still executed before
+    // jumping to the new one, so temporarily replace it with 'JR $'
+    uint8_t savedBytes[2];
+    for (uint16_t i = 0; i < 2; i++) {
+      savedBytes[i] = vm->readMemory(uint16_t(prvAddr + i), true);
+      vm->writeMemory(uint16_t(prvAddr + i), uint8_t(i == 0 ? 0x18 : 0xFE),
+                      true);
+    }
+    vm->setProgramCounter(addr);
+    do {
+      vm->run(1);
+    } while (vm->getZ80Registers().Flags & Z80_SET_PC_FLAG);
+    for (uint16_t i = 0; i < 2; i++)
+      vm->writeMemory(uint16_t(prvAddr + i), savedBytes[i], true);
+  }
+  // run emulation in 1 us steps (4 cycles at 4 MHz) until the code
+  // reaches the stop address
+  size_t  t = 0;
+  while (vm->getProgramCounter() != stopAddr) {
+    if (t >= (maxCycles >> 2))
+      throw Ep128Emu::Exception("Z80 code did not finish");
+    vm->run(1);
+    t++;
+  }
+  return (t << 2);
+}
+
+size_t DecompressorBenchmark::callRoutine(uint16_t addr,
+                                          uint16_t hl, uint16_t de,
+                                          size_t maxCycles)
+{
+  // push return address
+  uint16_t  sp = returnAddr - 2;
+  const unsigned char tmp[4] = {
+    (unsigned char) (returnAddr & 0xFF), (unsigned char) (returnAddr >> 8),
+    0x18, 0xFE                                          // JR $
+  };
+  writeMemory(sp, &(tmp[0]), 4);
+  Ep128::Z80_REGISTERS& r = vm->getZ80Registers();
+  r.HL.W = hl;
+  r.DE.W = de;
+  r.SP.W = sp;
+  return runCode(addr, returnAddr, maxCycles);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool readFile(std::vector< unsigned char >& buf, const char *fileName)
+{
+  buf.clear();
+  std::FILE *f = Ep128Emu::fileOpen(fileName, "rb");
+  if (!f)
+    return false;
+  while (true) {
+    int     c = std::fgetc(f);
+    if (c == EOF)
+      break;
+    buf.push_back((unsigned char) c);
+  }
+  std::fclose(f);
+  return true;
+}
+
+// read a list of file names from a text file (one name per line)
+
+static void readFileList(std::vector< std::string >& fileNames,
+                         const char *listFileName)
+{
+  std::FILE *f = Ep128Emu::fileOpen(listFileName, "rb");
+  if (!f)
+    throw Ep128Emu::Exception("error opening file list");
+  std::string s;
+  while (true) {
+    int     c = std::fgetc(f);
+    if (c == EOF || c == '\n' || c == '\r') {
+      Ep128Emu::stripString(s);
+      if (s.length() > 0)
+        fileNames.push_back(s);
+      s.clear();
+      if (c == EOF)
+        break;
+      continue;
+    }
+    s += char(c);
+  }
+  std::fclose(f);
+}
+
+static void compressBlock(std::vector< unsigned char >& outBuf,
+                          const std::vector< unsigned char >& inBuf,
+                          int compressionType, int byteCost)
+{
+  outBuf.clear();
+  Ep128Compress::Compressor *compressor =
+      Ep128Compress::createCompressor(compressionType, outBuf);
+  try {
+    Ep128Compress::Compressor::CompressionParameters  config;
+    compressor->getCompressionParameters(config);
+    config.setCompressionLevel(10);     // same as the epcompress default
+    config.minLength = 2;
+    config.maxOffset = 65535;
+    config.blockSize = 65536;
+    config.byteCost = size_t(byteCost);
+    compressor->setCompressionParameters(config);
+    if (!compressor->compressData(inBuf, 0xFFFFFFFFU, true))
+      throw Ep128Emu::Exception("compressed data size is too large");
+  }
+  catch (...) {
+    delete compressor;
+    throw;
+  }
+  delete compressor;
+}
+
+struct BenchmarkResult {
+  size_t  uncompressedSize;
+  size_t  compressedSize;
+  size_t  nCycles;
+  double  wallTime;
+  BenchmarkResult()
+    : uncompressedSize(0),
+      compressedSize(0),
+      nCycles(0),
+      wallTime(0.0)
+  {
+  }
+  void add(const BenchmarkResult& r)
+  {
+    uncompressedSize += r.uncompressedSize;
+    compressedSize += r.compressedSize;
+    nCycles += r.nCycles;
+    wallTime += r.wallTime;
+  }
+};
+
+// decompress one block of data with a raw (m3 or m4) decompressor,
+// and return false if the output does not match the original data or the
+// host side decompressor
+
+static bool testRawDecompressor(DecompressorBenchmark& bench,
+                                BenchmarkResult& result,
+                                const std::vector< unsigned char >& inBuf,
+                                int compressionType, int byteCost)
+{
+  std::vector< unsigned char >  compressedData;
+  compressBlock(compressedData, inBuf, compressionType, byteCost);
+  std::vector< unsigned char >  hostBuf;
+  {
+    Ep128Compress::Decompressor *decompressor =
+        Ep128Compress::createDecompressor(compressionType);
+    try {
+      decompressor->decompressData(hostBuf, compressedData);
+    }
+    catch (...) {
+      delete decompressor;
+      throw;
+    }
+    delete decompressor;
+  }
+  uint16_t  decompressorAddr = decompressorAddr_M4;
+  uint16_t  addr = outputAddr;
+  bench.resetMemoryPaging();
+  if (compressionType == 3) {
+    bench.writeMemory(decompressorAddr_M3, &(decompressorCode_M3[0]),
+                      sizeof(decompressorCode_M3));
+    decompressorAddr = decompressorAddr_M3;
+    // uncompressed M3 data is expected to be stored in place
+    if (compressedData.size() >= 4 &&
+        compressedData[compressedData.size() - 2] == 0x00 &&
+        compressedData[compressedData.size() - 1] == 0x00) {
+      addr = inputAddr + 2;
+    }
+  }
+  else {
+    bench.writeMemory(decompressorAddr_M4, &(decompressorCode_M4[0]),
+                      sizeof(decompressorCode_M4));
+  }
+  // fill output buffer, load compressed data, and run decompressor
+  std::vector< unsigned char >  outBuf(blockSize, 0xA5);
+  bench.writeMemory(outputAddr, &(outBuf.front()), blockSize);
+  bench.writeMemory(inputAddr, &(compressedData.front()),
+                    compressedData.size());
+  Ep128Emu::Timer timer;
+  result.nCycles += bench.callRoutine(decompressorAddr, inputAddr, addr);
+  result.wallTime += timer.getRealTime();
+  result.uncompressedSize += inBuf.size();
+  result.compressedSize += compressedData.size();
+  bench.readMemory(outBuf, addr, inBuf.size());
+  return (outBuf == inBuf && hostBuf == inBuf);
+}
+
+// create a self-extracting program from one block of data, run it, and
+// return false if the output does not match the original data or the host
+// side decompressor
+
+static bool testSFXDecompressor(DecompressorBenchmark& bench,
+                                BenchmarkResult& result,
+                                const std::vector< unsigned char >& inBuf,
+                                int byteCost)
+{
+  std::vector< unsigned char >  sfxBuf;
+  {
+    std::vector< unsigned char >  compressedData;
+    compressBlock(compressedData, inBuf, 3, byteCost);
+    Ep128Compress::addSFXModule(sfxBuf, compressedData, 3, false, true, true);
+  }
+  std::vector< unsigned char >  hostBuf;
+  Ep128Compress::decompressSFXProgram(hostBuf, sfxBuf, 3);
+  // remove EXOS header
+  hostBuf.erase(hostBuf.begin(), hostBuf.begin() + 16);
+  // redirect the jump to the decompressed program at the end of the
+  // decompressor code (the last 'JP 0100H' in the file)
+  size_t  i = sfxBuf.size() - 3;
+  while (!(sfxBuf[i] == 0xC3 && sfxBuf[i + 1] == 0x00 &&
+           sfxBuf[i + 2] == 0x01)) {
+    if (i <= 16)
+      throw Ep128Emu::Exception("invalid SFX program");
+    i--;
+  }
+  sfxBuf[i + 1] = (unsigned char) (sfxReturnAddr & 0xFF);
+  sfxBuf[i + 2] = (unsigned char) (sfxReturnAddr >> 8);
+  // fill memory, and set up the segment table at BFFCH-BFFFH of the
+  // system segment (FFH), as it would be for a program loaded by EXOS
+  std::vector< unsigned char >  outBuf(0x10000, 0xA5);
+  bench.resetMemoryPaging();
+  bench.writeMemory(0x00000000U, &(outBuf.front()), 0x10000);
+  const unsigned char segmentTable[4] = { 0xF8, 0xF9, 0xFA, 0xFB };
+  bench.writeMemory((uint32_t(0xFF) << 14) | 0x3FFCU, &(segmentTable[0]), 4,
+                    false);
+  bench.writeMemory(exosCallAddr, &(exosCallCode[0]), sizeof(exosCallCode));
+  const unsigned char returnCode[2] = { 0x18, 0xFE };   // JR $
+  bench.writeMemory(sfxReturnAddr, &(returnCode[0]), 2);
+  // skip EXOS header, and load program
+  bench.writeMemory(sfxLoadAddr, &(sfxBuf.front()) + 16, sfxBuf.size() - 16);
+  Ep128Emu::Timer timer;
+  result.nCycles += bench.runCode(sfxLoadAddr, sfxReturnAddr);
+  result.wallTime += timer.getRealTime();
+  result.uncompressedSize += inBuf.size();
+  result.compressedSize += sfxBuf.size();
+  // read decompressed data from segments F8H to FBH
+  bench.readMemory(outBuf, (uint32_t(0xF8) << 14) + sfxLoadAddr, inBuf.size(),
+                   false);
+  return (outBuf == inBuf && hostBuf == inBuf);
+}
+
+static void printResult(const char *name, const char *decompressorName,
+                        const BenchmarkResult& r)
+{
+  std::printf("%s [%s]: %lu -> %lu bytes, %lu cycles, "
+              "%.2f cycles per byte, %.1f bytes per frame, %.3f s\n",
+              name, decompressorName,
+              (unsigned long) r.uncompressedSize,
+              (unsigned long) r.compressedSize, (unsigned long) r.nCycles,
+              double(r.nCycles) / double(r.uncompressedSize > 0 ?
+                                         r.uncompressedSize : size_t(1)),
+              double(r.uncompressedSize) * cyclesPerFrame
+              / double(r.nCycles > 0 ? r.nCycles : size_t(1)),
+              r.wallTime);
+}
+
+int main(int argc, char **argv)
+{
+  static const char *decompressorNames[3] = { "m3", "m4", "sfx" };
+  std::vector< std::string >  fileNames;
+  std::vector< int >  decompressorTypes;
+  int     byteCost = 64;
+  int     memoryWaitMode = 1;
+  bool    printUsageFlag = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string tmp = argv[i];
+      if (tmp.length() < 1)
+        continue;
+      if (tmp[0] == '@') {
+        readFileList(fileNames, tmp.c_str() + 1);
+      }
+      else if (tmp[0] != '-') {
+        fileNames.push_back(tmp);
+      }
+      else if (tmp == "-c") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -c");
+        byteCost = int(std::atoi(argv[i]));
+        if (byteCost < 0 || byteCost > 1024)
+          throw Ep128Emu::Exception("byte cost is out of range");
+      }
+      else if (tmp == "-d") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -d");
+        tmp = argv[i];
+        int     n = 0;
+        while (n < 3 && tmp != decompressorNames[n])
+          n++;
+        if (n >= 3)
+          throw Ep128Emu::Exception("invalid decompressor type");
+        decompressorTypes.push_back(n);
+      }
+      else if (tmp == "-w") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -w");
+        memoryWaitMode = int(std::atoi(argv[i]));
+        if (memoryWaitMode < 0 || memoryWaitMode > 2)
+          throw Ep128Emu::Exception("invalid memory wait mode");
+      }
+      else {
+        printUsageFlag = true;
+        if (tmp == "-h" || tmp == "-help" || tmp == "--help")
+          throw Ep128Emu::Exception("");
+        throw Ep128Emu::Exception("invalid command line option");
+      }
+    }
+    if (fileNames.size() < 1) {
+      printUsageFlag = true;
+      throw Ep128Emu::Exception("missing file name");
+    }
+    if (decompressorTypes.size() < 1) {
+      for (int i = 0; i < 3; i++)
+        decompressorTypes.push_back(i);
+    }
+    DecompressorBenchmark   bench(memoryWaitMode);
+    std::vector< BenchmarkResult >  totals(decompressorTypes.size());
+    bool    errorFlag = false;
+    for (size_t i = 0; i < fileNames.size(); i++) {
+      std::vector< unsigned char >  inBuf;
+      if (!readFile(inBuf, fileNames[i].c_str())) {
+        std::printf("%s: error opening file\n", fileNames[i].c_str());
+        errorFlag = true;
+        continue;
+      }
+      for (size_t j = 0; j < decompressorTypes.size(); j++) {
+        int     decompressorType = decompressorTypes[j];
+        BenchmarkResult r;
+        bool    verifyError = false;
+        // compress and decompress the file in blocks
+        size_t  maxBlockSize =
+            (decompressorType < 2 ? blockSize : sfxBlockSize);
+        for (size_t k = 0; k < inBuf.size(); k = k + maxBlockSize) {
+          size_t  n = inBuf.size() - k;
+          n = (n < maxBlockSize ? n : maxBlockSize);
+          std::vector< unsigned char >  tmpBuf(inBuf.begin() + k,
+                                               inBuf.begin() + (k + n));
+          bool    isValid = false;
+          try {
+            if (decompressorType < 2) {
+              isValid = testRawDecompressor(bench, r, tmpBuf,
+                                            decompressorType + 3, byteCost);
+            }
+            else {
+              isValid = testSFXDecompressor(bench, r, tmpBuf, byteCost);
+            }
+          }
+          catch (Ep128Emu::Exception& e) {
+            std::printf("%s [%s]: %s\n", fileNames[i].c_str(),
+                        decompressorNames[decompressorType], e.what());
+          }
+          if (!isValid)
+            verifyError = true;
+        }
+        if (verifyError) {
+          std::printf("%s [%s]: FAILED (decompressed data does not match)\n",
+                      fileNames[i].c_str(),
+                      decompressorNames[decompressorType]);
+          errorFlag = true;
+          continue;
+        }
+        printResult(fileNames[i].c_str(), decompressorNames[decompressorType],
+                    r);
+        totals[j].add(r);
+      }
+    }
+    if (fileNames.size() > 1) {
+      for (size_t j = 0; j < decompressorTypes.size(); j++) {
+        printResult("total", decompressorNames[decompressorTypes[j]],
+                    totals[j]);
+      }
+    }
+    return (errorFlag ? -1 : 0);
+  }
+  catch (std::exception& e) {
+    if (printUsageFlag) {
+      std::printf("Usage: %s [OPTIONS...] <infile...|@listfile...>\n",
+                  argv[0]);
+      std::printf("Options:\n");
+      std::printf("    -c <N>\n");
+      std::printf("        cost of one byte of compressed data in Z80 cycles "
+                  "for type 4\n"
+                  "        (0 to 1024, default: 64)\n");
+      std::printf("    -d <m3|m4|sfx>\n");
+      std::printf("        decompressor to test (can be used multiple times, "
+                  "default: all)\n");
+      std::printf("    -w <N>\n");
+      std::printf("        memory wait mode (0: all memory accesses, "
+                  "1: M1 only, 2: none;\n"
+                  "        default: 1)\n");
+      if (e.what()[0] == '\0')
+        return 0;
+    }
+    std::fprintf(stderr, " *** %s: %s\n", argv[0], e.what());
+    return -1;
+  }
+  return 0;
+}
+
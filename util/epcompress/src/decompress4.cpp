@@ -0,0 +1,120 @@
+
+// compressor utility for Enterprise 128 programs
+// Copyright (C) 2007-2017 Istvan Varga <istvanv@users.sourceforge.net>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "ep128emu.hpp"
+#include "compress.hpp"
+#include "decompress4.hpp"
+#include <vector>
+
+namespace Ep128Compress {
+
+  unsigned char Decompressor_M4::readByte()
+  {
+    if (inBufPos >= inBufSize) {
+      throw Ep128Emu::Exception("Decompressor_M4::readByte(): "
+                                "unexpected end of input data");
+    }
+    return inBufPtr[inBufPos++];
+  }
+
+  Decompressor_M4::Decompressor_M4()
+    : Decompressor(),
+      inBufPtr((unsigned char *) 0),
+      inBufPos(0),
+      inBufSize(0)
+  {
+  }
+
+  Decompressor_M4::~Decompressor_M4()
+  {
+  }
+
+  void Decompressor_M4::decompressData(
+      std::vector< std::vector< unsigned char > >& outBuf,
+      const std::vector< unsigned char >& inBuf)
+  {
+    outBuf.clear();
+    std::vector< unsigned char >  tmpOutBuf;
+    decompressData(tmpOutBuf, inBuf);
+    // NOTE: this format does not support start addresses,
+    // so use a fixed value of 0100H (program with EXOS 5 header)
+    tmpOutBuf.insert(tmpOutBuf.begin(), 2, (unsigned char) 0x00);
+    tmpOutBuf[1] = 0x01;
+    outBuf.push_back(tmpOutBuf);
+  }
+
+  void Decompressor_M4::decompressData(
+      std::vector< unsigned char >& outBuf,
+      const std::vector< unsigned char >& inBuf)
+  {
+    outBuf.clear();
+    if (inBuf.size() < 3) {
+      throw Ep128Emu::Exception("Decompressor_M4::decompressData(): "
+                                "insufficient input data size");
+    }
+    size_t  compressedSize = size_t(inBuf[0]) | (size_t(inBuf[1]) << 8);
+    if (compressedSize != (inBuf.size() - 2)) {
+      throw Ep128Emu::Exception("Decompressor_M4::decompressData(): "
+                                "invalid compressed data size");
+    }
+    inBufPtr = &(inBuf.front());
+    inBufPos = 2;
+    inBufSize = inBuf.size();
+    while (true) {
+      unsigned int  c = readByte();
+      if (c < 0x80U) {
+        if (c == 0U)                                    // end of data
+          break;
+        // literal sequence
+        for ( ; c > 0U; c--)
+          outBuf.push_back(readByte());
+        continue;
+      }
+      // LZ77 match
+      size_t  n = 0;
+      size_t  d = 0;
+      if (c < 0xC0U) {
+        n = size_t(c & 0x3FU) + 2;
+        d = 256 - size_t(readByte());
+      }
+      else {
+        n = size_t(c & 0x3FU) + 3;
+        d = size_t(readByte());
+        d = 65536 - (d | (size_t(readByte()) << 8));
+      }
+      if (d > outBuf.size()) {
+        throw Ep128Emu::Exception("Decompressor_M4::decompressData(): "
+                                  "error in compressed data");
+      }
+      for ( ; n > 0; n--) {
+        unsigned char b = outBuf[outBuf.size() - d];
+        outBuf.push_back(b);
+      }
+    }
+    if (inBufPos < inBufSize) {
+      throw Ep128Emu::Exception("Decompressor_M4::decompressData(): "
+                                "more input data than expected");
+    }
+    if (outBuf.size() > 65535) {
+      throw Ep128Emu::Exception("Decompressor_M4::decompressData(): "
+                                "invalid uncompressed data size");
+    }
+  }
+
+}       // namespace Ep128Compress
+
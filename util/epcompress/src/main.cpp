@@ -20,6 +20,7 @@
 #include "compress.hpp"
 #include "decompm2.hpp"
 #include "pngwrite.hpp"
+#include "system.hpp"
 
 #include <vector>
 
@@ -29,10 +30,12 @@ static bool   extractMode = false;
 static bool   testMode = false;
 // assume archive format (implies forceRawMode)
 static bool   archiveFormat = false;
-// compression type (2 or 3; default: 3, or auto-detect when decompressing)
+// compression type (2 to 4; default: 3, or auto-detect when decompressing)
 static int    compressionType = -1;
 // compression level (1: fast, low compression ... 9: slow, high compression)
 static int    compressionLevel = 10;
+// cost of one byte of compressed data in Z80 cycles (compression type 4 only)
+static int    byteCost = 64;
 // disable decompressor border effects
 static bool   noBorderFX = false;
 // do not reset memory paging and stack pointer after decompression
@@ -41,6 +44,10 @@ static bool   noCleanup = true;
 static bool   forceRawMode = false;
 // volume size for compressed files (0: no volumes)
 static size_t volumeSize = 0;
+// output directory for compressing multiple files (empty: single file mode)
+static std::string  outputDirectory = "";
+// number of files to compress in parallel if an output directory is set
+static int    nJobs = 1;
 
 static int readInputFile(std::vector< unsigned char >& inBuf,
                          const char *fileName)
@@ -241,6 +248,7 @@ static size_t compressFile(std::vector< unsigned char >& outBuf,
 {
   size_t  startPos = outBuf.size();
   Ep128Compress::Compressor *compress = (Ep128Compress::Compressor *) 0;
+  int     compressionType_ = compressionType;
   try {
     std::vector< unsigned char >  tmpBuf;
     std::vector< unsigned char >  tmpBuf2;
@@ -255,28 +263,39 @@ static size_t compressFile(std::vector< unsigned char >& outBuf,
       tmpBuf.insert(tmpBuf.end(),
                     inBuf.begin() + skipBytes,
                     inBuf.begin() + skipBytes + length);
-      compress = Ep128Compress::createCompressor(compressionType, tmpBuf2);
-      Ep128Compress::Compressor::CompressionParameters  config;
-      compress->getCompressionParameters(config);
-      config.setCompressionLevel(compressionLevel);
-      config.minLength = 2;
-      config.maxOffset = 65535;
-      config.blockSize = 65536;
-      compress->setCompressionParameters(config);
-      compress->compressData(tmpBuf, startAddr, true, true);
-      delete compress;
-      compress = (Ep128Compress::Compressor *) 0;
+      while (true) {
+        compress = Ep128Compress::createCompressor(compressionType_, tmpBuf2);
+        Ep128Compress::Compressor::CompressionParameters  config;
+        compress->getCompressionParameters(config);
+        config.setCompressionLevel(compressionLevel);
+        config.minLength = 2;
+        config.maxOffset = 65535;
+        config.blockSize = 65536;
+        config.byteCost = size_t(byteCost);
+        compress->setCompressionParameters(config);
+        bool    compressedOK =
+            compress->compressData(tmpBuf, startAddr, true, true);
+        delete compress;
+        compress = (Ep128Compress::Compressor *) 0;
+        if (compressedOK || compressionType_ != 4)
+          break;
+        // the compressed data does not fit in the 16-bit size of the type 4
+        // format, use type 3 instead, which can store uncompressed blocks
+        std::fprintf(stderr, "WARNING: the compressed data is too large for "
+                             "compression type 4, using type 3\n");
+        compressionType_ = 3;
+      }
     }
     tmpBuf.clear();
     // verify compressed data
     if (startAddr < 0x80000000U) {
       std::vector< std::vector< unsigned char > > tmpBufs;
-      Ep128Compress::decompressData(tmpBufs, tmpBuf2, compressionType);
+      Ep128Compress::decompressData(tmpBufs, tmpBuf2, compressionType_);
       for (size_t i = 0; i < tmpBufs.size(); i++)
         tmpBuf.insert(tmpBuf.end(), tmpBufs[i].begin() + 2, tmpBufs[i].end());
     }
     else {
-      decompressRawData(tmpBuf, tmpBuf2);
+      Ep128Compress::decompressData(tmpBuf, tmpBuf2, compressionType_);
     }
     if (tmpBuf.size() != length)
       throw Ep128Emu::Exception("internal error compressing data");
@@ -294,6 +313,192 @@ static size_t compressFile(std::vector< unsigned char >& outBuf,
   return (outBuf.size() - startPos);
 }
 
+// compress 'inFileNames' (a single file, or multiple files in archive format)
+// to 'outFileName'
+static void compressFiles(const std::vector< std::string >& inFileNames,
+                          const std::string& outFileName)
+{
+  std::vector< unsigned char >  outBuf;
+  std::vector< unsigned char >  inBuf;
+  // read input file
+  int     exosFileType = 0;
+  if (archiveFormat)
+    Ep128Compress::createArchive(inBuf, inFileNames);
+  else
+    exosFileType = readInputFile(inBuf, inFileNames[0].c_str());
+  bool    isImageFile = false;
+  // compression type 4 is not supported by image files, so these are
+  // compressed as raw data
+  if (exosFileType == 0 && compressionType != 4) {
+    size_t  imageDataSize1 = 0;
+    size_t  imageDataSize2 = 0;
+    bool    imageCompressedFlag = false;
+    if (isEPImageFile(inBuf, &imageDataSize1, &imageDataSize2,
+                      &imageCompressedFlag)) {
+      if (imageCompressedFlag) {
+        // compressed image file: decompress it first
+        std::vector< unsigned char >  tmpBuf;
+        tmpBuf.insert(tmpBuf.end(), inBuf.begin(), inBuf.end());
+        inBuf.clear();
+        decompressFile(inBuf, tmpBuf, false);
+        if (!isEPImageFile(inBuf, &imageDataSize1, &imageDataSize2,
+                           &imageCompressedFlag)) {
+          throw Ep128Emu::Exception("internal error loading "
+                                    "compressed image file");
+        }
+      }
+      // copy image header, and set compression type
+      outBuf.insert(outBuf.end(), inBuf.begin(), inBuf.begin() + 16);
+      outBuf[10] = (unsigned char) (compressionType == 2 ? 0x01 : 0x03);
+      // compress video mode, bias, and palette data
+      outBuf.push_back((unsigned char) (imageDataSize1 & 0xFF));
+      outBuf.push_back((unsigned char) (imageDataSize1 >> 8));
+      outBuf.push_back(0x00); // reserve space for compressed data size
+      outBuf.push_back(0x00);
+      size_t  compressedSize1 =
+          compressFile(outBuf, inBuf, 0xFFFFFFFFU, 16, imageDataSize1);
+      outBuf[18] = (unsigned char) (compressedSize1 & 0xFF);
+      outBuf[19] = (unsigned char) (compressedSize1 >> 8);
+      // compress attribute and pixel data
+      outBuf.push_back((unsigned char) (imageDataSize2 & 0xFF));
+      outBuf.push_back((unsigned char) (imageDataSize2 >> 8));
+      outBuf.push_back(0x00); // reserve space for compressed data size
+      outBuf.push_back(0x00);
+      size_t  compressedSize2 =
+          compressFile(outBuf, inBuf, 0xFFFFFFFFU,
+                       imageDataSize1 + 16, imageDataSize2);
+      outBuf[compressedSize1 + 22] = (unsigned char) (compressedSize2 & 0xFF);
+      outBuf[compressedSize1 + 23] = (unsigned char) (compressedSize2 >> 8);
+      isImageFile = true;
+    }
+  }
+  unsigned int  startAddr = (exosFileType == 5 ? 0x0100U : 0xFFFFFFFFU);
+  // compress data
+  if (!isImageFile) {
+    if (compressionType != 3 && exosFileType != 0 && !forceRawMode)
+      throw Ep128Emu::Exception("output format requires -a or -raw");
+    compressFile(outBuf, inBuf, startAddr);
+    if (exosFileType != 0) {
+      std::vector< unsigned char >  sfxBuf;
+      Ep128Compress::addSFXModule(sfxBuf, outBuf, compressionType,
+                                  noBorderFX, noCleanup, noCleanup,
+                                  (exosFileType == 6));
+      outBuf = sfxBuf;
+    }
+  }
+  // write output file
+  Ep128Compress::CompressedFileVolume f(outFileName.c_str(), true, volumeSize);
+  for (size_t i = 0; i < outBuf.size(); i++)
+    f.writeByte(int(outBuf[i]));
+  f.closeFile();
+}
+
+// ----------------------------------------------------------------------------
+
+struct CompressJobState {
+  Ep128Emu::Mutex mutex;
+  const std::vector< std::string >  *fileNames;
+  size_t  nextFile;
+  size_t  nErrors;
+};
+
+// compress the next file to the output directory; returns false if there
+// are no more files
+static bool compressNextFile(CompressJobState& st)
+{
+  st.mutex.lock();
+  size_t  n = st.nextFile;
+  if (n < st.fileNames->size())
+    st.nextFile++;
+  st.mutex.unlock();
+  if (n >= st.fileNames->size())
+    return false;
+  const std::string&  inFileName = (*(st.fileNames))[n];
+  std::string outFileName(outputDirectory);
+  {
+    // remove directory name
+    size_t  i = inFileName.length();
+    while (i > 0) {
+      char    c = inFileName[i - 1];
+      if (c == '/' || c == '\\' || c == ':')
+        break;
+      i--;
+    }
+    outFileName += (inFileName.c_str() + i);
+  }
+  const char  *errMsg = (char *) 0;
+  std::string errBuf;
+  try {
+    if (outFileName.length() <= outputDirectory.length())
+      throw Ep128Emu::Exception("invalid input file name");
+    std::vector< std::string >  tmp;
+    tmp.push_back(inFileName);
+    compressFiles(tmp, outFileName);
+  }
+  catch (std::exception& e) {
+    errBuf = e.what();
+    errMsg = errBuf.c_str();
+  }
+  st.mutex.lock();
+  if (errMsg) {
+    st.nErrors++;
+    std::fprintf(stderr, " *** %s: %s\n", inFileName.c_str(), errMsg);
+  }
+  else {
+    std::printf("  %s -> %s\n", inFileName.c_str(), outFileName.c_str());
+  }
+  st.mutex.unlock();
+  return true;
+}
+
+class CompressJobThread : public Ep128Emu::Thread {
+ private:
+  CompressJobState& st;
+ public:
+  CompressJobThread(CompressJobState& st_)
+    : Ep128Emu::Thread(),
+      st(st_)
+  {
+  }
+  virtual ~CompressJobThread()
+  {
+  }
+  virtual void run()
+  {
+    while (compressNextFile(st))
+      ;
+  }
+};
+
+// compress all files to the output directory on 'nJobs' threads,
+// returns the number of files that could not be compressed
+static size_t compressFilesToDirectory(
+    const std::vector< std::string >& fileNames)
+{
+  CompressJobState  st;
+  st.fileNames = &fileNames;
+  st.nextFile = 0;
+  st.nErrors = 0;
+  std::vector< CompressJobThread * >  threads;
+  try {
+    for (int i = 1; i < nJobs && size_t(i) < fileNames.size(); i++) {
+      threads.push_back((CompressJobThread *) 0);
+      threads.back() = new CompressJobThread(st);
+      threads.back()->start();
+    }
+    while (compressNextFile(st))
+      ;
+  }
+  catch (...) {
+    for (size_t i = 0; i < threads.size(); i++)
+      delete threads[i];
+    throw;
+  }
+  for (size_t i = 0; i < threads.size(); i++)
+    delete threads[i];
+  return st.nErrors;
+}
+
 int main(int argc, char **argv)
 {
   const char  *programName = argv[0];
@@ -355,12 +560,12 @@ int main(int argc, char **argv)
           throw Ep128Emu::Exception("missing argument for -m");
         compressionType = int(std::atoi(argv[i]));
         if (!(compressionType == -1 ||
-              (compressionType >= 2 && compressionType <= 3))) {
+              (compressionType >= 2 && compressionType <= 4))) {
           throw Ep128Emu::Exception("invalid compression type");
         }
       }
       else if (tmp.length() == 3 && tmp[0] == '-' && tmp[1] == 'm' &&
-               tmp[2] >= '2' && tmp[2] <= '3') {
+               tmp[2] >= '2' && tmp[2] <= '4') {
         compressionType = int(tmp[2] - '0');
       }
       else if (tmp == "-borderfx") {
@@ -398,20 +603,57 @@ int main(int argc, char **argv)
           volumeSize = volumeSize * 1024;
         }
       }
+      else if (tmp == "-d") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -d");
+        outputDirectory = argv[i];
+        if (outputDirectory.length() < 1)
+          throw Ep128Emu::Exception("invalid output directory name");
+        char    c = outputDirectory[outputDirectory.length() - 1];
+        if (c != '/' && c != '\\' && c != ':')
+          outputDirectory += '/';
+      }
+      else if (tmp == "-c") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -c");
+        byteCost = int(std::atoi(argv[i]));
+        if (byteCost < 0 || byteCost > 1024)
+          throw Ep128Emu::Exception("byte cost is out of range");
+      }
+      else if (tmp == "-j") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -j");
+        nJobs = int(std::atoi(argv[i]));
+        if (nJobs < 1 || nJobs > 64)
+          throw Ep128Emu::Exception("number of jobs is out of range");
+      }
       else {
         printUsageFlag = true;
         throw Ep128Emu::Exception("invalid command line option");
       }
     }
-    if (fileNames.size()
-        < ((testMode || (archiveFormat && extractMode)) ? 1 : 2)) {
-      printUsageFlag = true;
-      throw Ep128Emu::Exception("missing file name");
+    if (!outputDirectory.empty()) {
+      if (testMode || extractMode || archiveFormat) {
+        printUsageFlag = true;
+        throw Ep128Emu::Exception("-d can only be used when compressing "
+                                  "without -a");
+      }
+      if (fileNames.size() < 1) {
+        printUsageFlag = true;
+        throw Ep128Emu::Exception("missing file name");
+      }
     }
-    if (fileNames.size() > ((archiveFormat && extractMode) ? 1 : 2) &&
-        !(testMode || (archiveFormat && !extractMode))) {
-      printUsageFlag = true;
-      throw Ep128Emu::Exception("too many file names");
+    else {
+      if (fileNames.size()
+          < ((testMode || (archiveFormat && extractMode)) ? 1 : 2)) {
+        printUsageFlag = true;
+        throw Ep128Emu::Exception("missing file name");
+      }
+      if (fileNames.size() > ((archiveFormat && extractMode) ? 1 : 2) &&
+          !(testMode || (archiveFormat && !extractMode))) {
+        printUsageFlag = true;
+        throw Ep128Emu::Exception("too many file names");
+      }
     }
     if (archiveFormat)
       forceRawMode = true;
@@ -472,83 +714,11 @@ int main(int argc, char **argv)
     // compress file
     if (compressionType < 0)
       compressionType = 3;              // set default compression type
-    std::vector< unsigned char >  outBuf;
-    std::vector< unsigned char >  inBuf;
-    // read input file
-    int     exosFileType = 0;
-    if (archiveFormat) {
-      std::string tmp(fileNames[fileNames.size() - 1]);
-      fileNames.resize(fileNames.size() - 1);
-      Ep128Compress::createArchive(inBuf, fileNames);
-      fileNames.push_back(tmp);
-    }
-    else {
-      exosFileType = readInputFile(inBuf, fileNames[0].c_str());
-    }
-    bool    isImageFile = false;
-    if (exosFileType == 0) {
-      size_t  imageDataSize1 = 0;
-      size_t  imageDataSize2 = 0;
-      bool    imageCompressedFlag = false;
-      if (isEPImageFile(inBuf, &imageDataSize1, &imageDataSize2,
-                        &imageCompressedFlag)) {
-        if (imageCompressedFlag) {
-          // compressed image file: decompress it first
-          std::vector< unsigned char >  tmpBuf;
-          tmpBuf.insert(tmpBuf.end(), inBuf.begin(), inBuf.end());
-          inBuf.clear();
-          decompressFile(inBuf, tmpBuf, false);
-          if (!isEPImageFile(inBuf, &imageDataSize1, &imageDataSize2,
-                             &imageCompressedFlag)) {
-            throw Ep128Emu::Exception("internal error loading "
-                                      "compressed image file");
-          }
-        }
-        // copy image header, and set compression type
-        outBuf.insert(outBuf.end(), inBuf.begin(), inBuf.begin() + 16);
-        outBuf[10] = (unsigned char) (compressionType == 2 ? 0x01 : 0x03);
-        // compress video mode, bias, and palette data
-        outBuf.push_back((unsigned char) (imageDataSize1 & 0xFF));
-        outBuf.push_back((unsigned char) (imageDataSize1 >> 8));
-        outBuf.push_back(0x00); // reserve space for compressed data size
-        outBuf.push_back(0x00);
-        size_t  compressedSize1 =
-            compressFile(outBuf, inBuf, 0xFFFFFFFFU, 16, imageDataSize1);
-        outBuf[18] = (unsigned char) (compressedSize1 & 0xFF);
-        outBuf[19] = (unsigned char) (compressedSize1 >> 8);
-        // compress attribute and pixel data
-        outBuf.push_back((unsigned char) (imageDataSize2 & 0xFF));
-        outBuf.push_back((unsigned char) (imageDataSize2 >> 8));
-        outBuf.push_back(0x00); // reserve space for compressed data size
-        outBuf.push_back(0x00);
-        size_t  compressedSize2 =
-            compressFile(outBuf, inBuf, 0xFFFFFFFFU,
-                         imageDataSize1 + 16, imageDataSize2);
-        outBuf[compressedSize1 + 22] = (unsigned char) (compressedSize2 & 0xFF);
-        outBuf[compressedSize1 + 23] = (unsigned char) (compressedSize2 >> 8);
-        isImageFile = true;
-      }
-    }
-    unsigned int  startAddr = (exosFileType == 5 ? 0x0100U : 0xFFFFFFFFU);
-    // compress data
-    if (!isImageFile) {
-      if (compressionType != 3 && exosFileType != 0 && !forceRawMode)
-        throw Ep128Emu::Exception("output format requires -a or -raw");
-      compressFile(outBuf, inBuf, startAddr);
-      if (exosFileType != 0) {
-        std::vector< unsigned char >  sfxBuf;
-        Ep128Compress::addSFXModule(sfxBuf, outBuf, compressionType,
-                                    noBorderFX, noCleanup, noCleanup,
-                                    (exosFileType == 6));
-        outBuf = sfxBuf;
-      }
-    }
-    // write output file
-    Ep128Compress::CompressedFileVolume
-        f(fileNames[fileNames.size() - 1].c_str(), true, volumeSize);
-    for (size_t i = 0; i < outBuf.size(); i++)
-      f.writeByte(int(outBuf[i]));
-    f.closeFile();
+    if (!outputDirectory.empty())
+      return (compressFilesToDirectory(fileNames) == 0 ? 0 : -1);
+    std::string outFileName(fileNames[fileNames.size() - 1]);
+    fileNames.resize(fileNames.size() - 1);
+    compressFiles(fileNames, outFileName);
   }
   catch (std::exception& e) {
     if (printUsageFlag || helpFlag) {
@@ -561,15 +731,25 @@ int main(int argc, char **argv)
       std::printf("        extract compressed file\n");
       std::printf("    %s -t [OPTIONS...] <infile...>\n", programName);
       std::printf("        test compressed file(s)\n");
+      std::printf("    %s -d <DIR> [OPTIONS...] <infile...>\n", programName);
+      std::printf("        compress multiple files to directory DIR, with "
+                  "the same file names\n");
       std::printf("Options:\n");
       std::printf("    --\n");
       std::printf("        interpret all remaining arguments as file names\n");
       std::printf("    -h | -help | --help\n");
       std::printf("        print usage information\n");
-      std::printf("    -m2 | -m3\n");
+      std::printf("    -m2 | -m3 | -m4\n");
       std::printf("        select compression type (default: 3, or "
                   "automatically detected\n"
-                  "        when decompressing)\n");
+                  "        when decompressing); type 4 is larger, but "
+                  "much faster to\n"
+                  "        decompress on the Z80\n");
+      std::printf("    -c <N>\n");
+      std::printf("        cost of one byte of compressed data in Z80 cycles "
+                  "with -m4 (0 to\n"
+                  "        1024, default: 64); lower values favor "
+                  "decompression speed over size\n");
       std::printf("    -raw | -noraw\n");
       std::printf("        ignore EXOS file headers if -raw (default: no)\n");
       std::printf("    -a | -n\n");
@@ -589,6 +769,9 @@ int main(int argc, char **argv)
       std::printf("        split compressed output file to N kilobyte volumes "
                   "(compress\n"
                   "        mode only; N should be an integer multiple of 4)\n");
+      std::printf("    -j <N>\n");
+      std::printf("        compress N files in parallel with -d (default: "
+                  "1)\n");
       std::printf("    -borderfx | -noborderfx\n");
       std::printf("        enable or disable decompressor border effects "
                   "(default: enabled)\n");
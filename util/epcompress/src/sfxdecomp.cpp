@@ -146,10 +146,10 @@ namespace Ep128Compress {
     size_t  sfxLoaderSize = extLoaderSize;
     if (!isExtension) {
       sfxLoaderSize = 0x7FFFFFFF;
-      for (size_t i = 80; (i + 8) <= inBuf.size(); i++) {
+      for (size_t i = offs + 80; (i + 8) <= inBuf.size(); i++) {
         if (inBuf[i] == 0x0E && inBuf[i + 1] == 0x80 &&         // LD C, 80H
             inBuf[i + 2] == 0x18 && inBuf[i + 3] == 0xFA) {     // JR -6
-          sfxLoaderSize = i + 8;
+          sfxLoaderSize = (i - offs) + 8;
           break;
         }
       }
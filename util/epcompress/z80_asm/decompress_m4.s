@@ -0,0 +1,53 @@
+
+        org   0ff00h
+
+; decompressor for compression type 4 (epcompress -m4)
+; HL: compressed data start address
+; DE: decompressed data start address (updated on return)
+; HL points to the byte after the end of the compressed data on return
+;
+; cycles (without wait states), n = number of bytes copied:
+;   literal sequence:   42 + 21 * n
+;   match (1 byte):    111 + 21 * n
+;   match (2 bytes):   128 + 21 * n
+
+decompressData:
+        inc   hl                        ; skip compressed data size
+        inc   hl
+        ld    b, 0
+.l1:    ld    a, (hl)                   ; read command byte
+        inc   hl
+        add   a, a
+        jr    c, .l2                    ; LZ77 match ?
+        ret   z                         ; end of data ?
+        rrca
+        ld    c, a                      ; copy literal sequence
+        ldir
+        jp    .l1
+.l2:    jp    m, .l3                    ; 16-bit offset ?
+        rrca
+        add   a, 2                      ; length = 2 to 65 bytes
+        ld    c, a
+        push  hl
+        ld    l, (hl)                   ; read 8-bit offset
+        ld    h, 0ffh
+        add   hl, de                    ; calculate source address,
+        ldir                            ; and copy match
+        pop   hl
+        inc   hl
+        jp    .l1
+.l3:    and   7eh
+        rrca
+        add   a, 3                      ; length = 3 to 66 bytes
+        ld    c, a
+        ld    a, (hl)                   ; read 16-bit offset
+        inc   hl
+        push  hl
+        ld    h, (hl)
+        ld    l, a
+        add   hl, de                    ; calculate source address,
+        ldir                            ; and copy match
+        pop   hl
+        inc   hl
+        jp    .l1
+
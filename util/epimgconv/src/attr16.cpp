@@ -140,21 +140,13 @@ namespace Ep128ImgConv {
       tmpPaletteV[i] = (paletteV[c0] * (1.0f - f)) + (paletteV[c1] * f);
     }
     double  totalError = 0.0;
+    float   minErr[8];
     // 8x1
-    for (int i = 0; i < 8; i++) {
-      double  minErr = 1000000000.0;
-      float   y = inBufY[i];
-      float   u = inBufU[i];
-      float   v = inBufV[i];
-      for (int j = 0; j < 2; j++) {
-        double  err = Ep128ImgConv::calculateYUVErrorSqr(
-                          tmpPaletteY[j], tmpPaletteU[j], tmpPaletteV[j],
-                          y, u, v, colorErrorScale);
-        if (err < minErr)
-          minErr = err;
-      }
-      totalError += minErr;
-    }
+    calculateMinYUVErrors(&(minErr[0]), inBufY, inBufU, inBufV, 8,
+                          tmpPaletteY, tmpPaletteU, tmpPaletteV, 2,
+                          colorErrorScale);
+    for (int i = 0; i < 8; i++)
+      totalError += minErr[i];
     if (ditherType == 0)
       return totalError;
     for (int i = 0; i < 4; i++) {
@@ -162,34 +154,23 @@ namespace Ep128ImgConv {
       inBufY[i] = (inBufY[i << 1] + inBufY[(i << 1) + 1]) * 0.5f;
       inBufU[i] = (inBufU[i << 1] + inBufU[(i << 1) + 1]) * 0.5f;
       inBufV[i] = (inBufV[i << 1] + inBufV[(i << 1) + 1]) * 0.5f;
-      double  minErr = 1000000000.0;
-      float   y = inBufY[i];
-      float   u = inBufU[i];
-      float   v = inBufV[i];
-      for (int j = 0; j < 3; j++) {
-        double  err = Ep128ImgConv::calculateYUVErrorSqr(
-                          tmpPaletteY[j], tmpPaletteU[j], tmpPaletteV[j],
-                          y, u, v, colorErrorScale);
-        if (err < minErr)
-          minErr = err;
-      }
-      totalError += (minErr * 3.0);
     }
+    calculateMinYUVErrors(&(minErr[0]), inBufY, inBufU, inBufV, 4,
+                          tmpPaletteY, tmpPaletteU, tmpPaletteV, 3,
+                          colorErrorScale);
+    for (int i = 0; i < 4; i++)
+      totalError += (minErr[i] * 3.0);
     for (int i = 0; i < 2; i++) {
       // downsample to 2x1
-      double  minErr = 1000000000.0;
-      float   y = (inBufY[i << 1] + inBufY[(i << 1) + 1]) * 0.5f;
-      float   u = (inBufU[i << 1] + inBufU[(i << 1) + 1]) * 0.5f;
-      float   v = (inBufV[i << 1] + inBufV[(i << 1) + 1]) * 0.5f;
-      for (int j = 0; j < 5; j++) {
-        double  err = Ep128ImgConv::calculateYUVErrorSqr(
-                          tmpPaletteY[j], tmpPaletteU[j], tmpPaletteV[j],
-                          y, u, v, colorErrorScale);
-        if (err < minErr)
-          minErr = err;
-      }
-      totalError += (minErr * 2.0);
+      inBufY[i] = (inBufY[i << 1] + inBufY[(i << 1) + 1]) * 0.5f;
+      inBufU[i] = (inBufU[i << 1] + inBufU[(i << 1) + 1]) * 0.5f;
+      inBufV[i] = (inBufV[i << 1] + inBufV[(i << 1) + 1]) * 0.5f;
     }
+    calculateMinYUVErrors(&(minErr[0]), inBufY, inBufU, inBufV, 2,
+                          tmpPaletteY, tmpPaletteU, tmpPaletteV, 5,
+                          colorErrorScale);
+    for (int i = 0; i < 2; i++)
+      totalError += (minErr[i] * 2.0);
     return totalError;
   }
 
@@ -658,11 +639,13 @@ namespace Ep128ImgConv {
     unsigned char tmpPalette[256];
     for (int i = 0; i < 256; i++)
       tmpPalette[i] = (unsigned char) i;
+    NearestColorIndex colorIndex;
+    colorIndex.setPalette(paletteY, paletteU, paletteV, 256, colorErrorScale);
     for (int yc = 0; yc < height; yc++) {
       Ep128ImgConv::ditherLine(convertedImage, inputImage, ditherErrorImage, yc,
                                ditherType, ditherDiffusion, colorErrorScale,
                                &(tmpPalette[0]), 256,
-                               paletteY, paletteU, paletteV);
+                               paletteY, paletteU, paletteV, &colorIndex);
     }
   }
 
@@ -750,6 +733,50 @@ namespace Ep128ImgConv {
     return calculateLineError16(yc);
   }
 
+  void ImageConv_Attr16::setLineAttributeIndices(int yc)
+  {
+    for (int xc = 0; xc < width; xc += 8) {
+      unsigned char&  c0 = attr0[yc][xc >> 3];
+      unsigned char&  c1 = attr1[yc][xc >> 3];
+      int     i = 0;
+      for ( ; i < 16; i++) {
+        if (palette[yc][i] == c0) {
+          c0 = i;
+          break;
+        }
+      }
+      for ( ; i < 16; i++) {
+        if (palette[yc][i] == c1) {
+          c1 = i;
+          break;
+        }
+      }
+    }
+  }
+
+  void ImageConv_Attr16::optimizeLineCallback(void *userData, int yc)
+  {
+    ImageConv_Attr16&  this_ =
+        *(reinterpret_cast<ImageConv_Attr16 *>(userData));
+    (void) this_.optimizeLineAttributes(yc, false, this_.lineOptimizeLevel);
+    this_.ditherLine(yc, false);
+    for (int xc = 0; xc < this_.width; xc++) {
+      if (this_.convertedImage[yc][xc] == 0)
+        this_.convertedImage[yc][xc] = this_.attr0[yc][xc >> 3];
+      else
+        this_.convertedImage[yc][xc] = this_.attr1[yc][xc >> 3];
+    }
+    (void) this_.optimizeLinePalette(yc, this_.lineOptimizeLevel);
+  }
+
+  void ImageConv_Attr16::optimizeLinePaletteFastCallback(void *userData,
+                                                         int yc)
+  {
+    ImageConv_Attr16&  this_ =
+        *(reinterpret_cast<ImageConv_Attr16 *>(userData));
+    (void) this_.optimizeLinePalette_fast(yc);
+  }
+
   void ImageConv_Attr16::pixelStoreCallback(void *userData, int xc, int yc,
                                             float y, float u, float v)
   {
@@ -795,7 +822,8 @@ namespace Ep128ImgConv {
       borderColor(0x00),
       ditherType(1),
       ditherDiffusion(0.95f),
-      errorTable((double *) 0)
+      errorTable((double *) 0),
+      lineOptimizeLevel(1)
   {
     for (int i = 0; i < 8; i++)
       fixedColors[i] = false;
@@ -890,7 +918,40 @@ namespace Ep128ImgConv {
     setFixBias(bestFixBias);
     ditherErrorImage.clear();
     int     optimizeLevel = 1 + ((conversionQuality - 1) >> 1);
-    if (config.paletteResolution != 0) {
+    if (config.paletteResolution != 0 && config.nThreads > 0) {
+      // generate optimal palette independently for each line, on multiple
+      // threads: the error diffused from the previous lines is estimated
+      // by dithering with the fast palettes first, then the attributes and
+      // palette of all lines are optimized in parallel, and finally the
+      // image is dithered again
+      int     progressCnt = 0;
+      int     progressMax = height * 10;
+      if (!processLinesParallel(height, config.nThreads,
+                                &optimizeLinePaletteFastCallback,
+                                (void *) this, progressCnt, 0, progressMax)) {
+        return false;
+      }
+      for (int yc = 0; yc < height; yc++) {
+        optimizeLineAttributes(yc, true, optimizeLevel);
+        ditherLine(yc, true);
+      }
+      lineOptimizeLevel = optimizeLevel;
+      if (!processLinesParallel(height, config.nThreads,
+                                &optimizeLineCallback, (void *) this,
+                                progressCnt, 9, progressMax)) {
+        return false;
+      }
+      ditherErrorImage.clear();
+      for (int yc = 0; yc < height; yc++) {
+        if (!setProgressPercentage((progressCnt * 100) / progressMax))
+          return false;
+        progressCnt++;
+        optimizeLineAttributes(yc, true, optimizeLevel);
+        ditherLine(yc, true);
+        setLineAttributeIndices(yc);
+      }
+    }
+    else if (config.paletteResolution != 0) {
       // generate optimal palette independently for each line
       int     progressCnt = 0;
       int     progressMax = height;
@@ -908,23 +969,7 @@ namespace Ep128ImgConv {
         optimizeLinePalette(yc, optimizeLevel);
         optimizeLineAttributes(yc, true, optimizeLevel);
         ditherLine(yc, true);
-        for (int xc = 0; xc < width; xc += 8) {
-          unsigned char&  c0 = attr0[yc][xc >> 3];
-          unsigned char&  c1 = attr1[yc][xc >> 3];
-          int     i = 0;
-          for ( ; i < 16; i++) {
-            if (palette[yc][i] == c0) {
-              c0 = i;
-              break;
-            }
-          }
-          for ( ; i < 16; i++) {
-            if (palette[yc][i] == c1) {
-              c1 = i;
-              break;
-            }
-          }
-        }
+        setLineAttributeIndices(yc);
         progressCnt++;
       }
     }
@@ -956,23 +1001,7 @@ namespace Ep128ImgConv {
         progressCnt++;
         optimizeLineAttributes(yc, true, optimizeLevel);
         ditherLine(yc, true);
-        for (int xc = 0; xc < width; xc += 8) {
-          unsigned char&  c0 = attr0[yc][xc >> 3];
-          unsigned char&  c1 = attr1[yc][xc >> 3];
-          int     i = 0;
-          for ( ; i < 16; i++) {
-            if (palette[yc][i] == c0) {
-              c0 = i;
-              break;
-            }
-          }
-          for ( ; i < 16; i++) {
-            if (palette[yc][i] == c1) {
-              c1 = i;
-              break;
-            }
-          }
-        }
+        setLineAttributeIndices(yc);
       }
     }
     imgData.setBorderColor(borderColor);
@@ -45,6 +45,7 @@ namespace Ep128ImgConv {
     int           ditherType;
     float         ditherDiffusion;
     double        *errorTable;          // size = 256*256
+    int           lineOptimizeLevel;    // used by optimizeLineCallback
     bool          fixedColors[8];
     float         paletteY[256];
     float         paletteU[256];
@@ -84,6 +85,10 @@ namespace Ep128ImgConv {
     void ditherLine(long yc, bool updateError = true);
     void preDitherImage();
     double optimizeLinePalette_fast(int yc);
+    // convert attribute colors of line 'yc' to palette indices
+    void setLineAttributeIndices(int yc);
+    static void optimizeLineCallback(void *userData, int yc);
+    static void optimizeLinePaletteFastCallback(void *userData, int yc);
     static void pixelStoreCallback(void *userData, int xc, int yc,
                                    float y, float u, float v);
     static void pixelStoreCallbackI(void *userData, int xc, int yc,
@@ -0,0 +1,175 @@
+
+// epimgconv: Enterprise 128 image converter utility
+// Copyright (C) 2008-2016 Istvan Varga <istvanv@users.sourceforge.net>
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Checks that NearestColorIndex::findNearestColor() returns the same color
+// and error as findNearestYUVColor() on the full palette, for random YUV
+// colors inside and outside the range of limitYUVColor(), with the 256
+// Enterprise colors and with random palettes, at several color error
+// scales; also measures the speed of both methods.
+
+#include "epimgconv.hpp"
+#include "system.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace Ep128ImgConv;
+
+static const double colorErrorScales[5] = { 0.05, 0.1, 0.25, 0.5, 1.0 };
+
+static float getRandomFloat(int& seedValue, float min_, float max_)
+{
+  int     n = getRandomNumber(seedValue) & 0xFFFFFF;
+  return (min_ + ((max_ - min_) * (float(n) / float(0x1000000))));
+}
+
+// returns the number of mismatches
+
+static size_t testPalette(const char *name,
+                          const float *palY, const float *palU,
+                          const float *palV, int nColors, size_t nPoints,
+                          int& seedValue)
+{
+  size_t  nErrors = 0;
+  for (int i = 0; i < 5; i++) {
+    float   colorErrorScale = float(colorErrorScales[i]);
+    NearestColorIndex colorIndex;
+    colorIndex.setPalette(palY, palU, palV, nColors, colorErrorScale);
+    std::vector< float >  inY(nPoints);
+    std::vector< float >  inU(nPoints);
+    std::vector< float >  inV(nPoints);
+    for (size_t j = 0; j < nPoints; j++) {
+      // 1/8 of the colors is outside the limited range
+      float   m = ((j & 7) == 0 ? 0.2f : 0.0f);
+      inY[j] = getRandomFloat(seedValue, -m, 1.0f + m);
+      inU[j] = getRandomFloat(seedValue, -0.435912f - m, 0.435912f + m);
+      inV[j] = getRandomFloat(seedValue, -0.614777f - m, 0.614777f + m);
+    }
+    std::vector< int >    indexResult(nPoints);
+    std::vector< float >  indexErr(nPoints);
+    Ep128Emu::Timer timer;
+    for (size_t j = 0; j < nPoints; j++) {
+      indexResult[j] = colorIndex.findNearestColor(inY[j], inU[j], inV[j],
+                                                   &(indexErr[j]));
+    }
+    double  t0 = timer.getRealTime();
+    timer.reset();
+    size_t  n = 0;
+    for (size_t j = 0; j < nPoints; j++) {
+      int     c = 0;
+      float   err = findNearestYUVColor(palY, palU, palV, nColors,
+                                        inY[j], inU[j], inV[j],
+                                        colorErrorScale, &c);
+      if (c != indexResult[j] || err != indexErr[j]) {
+        if (n < 5) {
+          std::printf("  mismatch at Y = %f, U = %f, V = %f: "
+                      "color %d (%g) instead of %d (%g)\n",
+                      inY[j], inU[j], inV[j], indexResult[j],
+                      indexErr[j], c, err);
+        }
+        n++;
+      }
+    }
+    double  t1 = timer.getRealTime();
+    std::printf("%-12s scale %4.2f: %lu mismatches, "
+                "index: %.4f us, full search: %.4f us\n",
+                name, colorErrorScale, (unsigned long) n,
+                t0 * 1000000.0 / double(nPoints),
+                t1 * 1000000.0 / double(nPoints));
+    nErrors += n;
+  }
+  return nErrors;
+}
+
+int main(int argc, char **argv)
+{
+  size_t  nPoints = 1000000;
+  bool    printUsageFlag = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string tmp = argv[i];
+      if (tmp.length() < 1)
+        continue;
+      if (tmp == "-n") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -n");
+        int     n = int(std::atoi(argv[i]));
+        if (n < 1 || n > 100000000)
+          throw Ep128Emu::Exception("number of test colors is out of range");
+        nPoints = size_t(n);
+      }
+      else {
+        printUsageFlag = true;
+        if (tmp == "-h" || tmp == "-help" || tmp == "--help")
+          throw Ep128Emu::Exception("");
+        throw Ep128Emu::Exception("invalid command line option");
+      }
+    }
+    int     seedValue = 0;
+    setRandomSeed(seedValue, 1U);
+    float   palY[256];
+    float   palU[256];
+    float   palV[256];
+    size_t  nErrors = 0;
+    for (int i = 0; i < 256; i++)
+      convertEPColorToYUV(i, palY[i], palU[i], palV[i]);
+    nErrors += testPalette("EP palette", palY, palU, palV, 256, nPoints,
+                           seedValue);
+    for (int i = 0; i < 256; i++)
+      convertEPColorToYUV(i, palY[i], palU[i], palV[i], 0.6);
+    nErrors += testPalette("EP gamma 0.6", palY, palU, palV, 256, nPoints,
+                           seedValue);
+    static const int  paletteSizes[3] = { 16, 100, 256 };
+    for (int k = 0; k < 3; k++) {
+      int     nColors = paletteSizes[k];
+      for (int i = 0; i < nColors; i++) {
+        float   r = getRandomFloat(seedValue, 0.0f, 1.0f);
+        float   g = getRandomFloat(seedValue, 0.0f, 1.0f);
+        float   b = getRandomFloat(seedValue, 0.0f, 1.0f);
+        rgbToYUV(palY[i], palU[i], palV[i], r, g, b);
+      }
+      // duplicate colors test that ties return the first color
+      palY[nColors - 1] = palY[0];
+      palU[nColors - 1] = palU[0];
+      palV[nColors - 1] = palV[0];
+      char    name[16];
+      std::sprintf(&(name[0]), "random %d", nColors);
+      nErrors += testPalette(&(name[0]), palY, palU, palV, nColors, nPoints,
+                             seedValue);
+    }
+    if (nErrors) {
+      throw Ep128Emu::Exception("NearestColorIndex returned "
+                                "incorrect results");
+    }
+  }
+  catch (std::exception& e) {
+    if (printUsageFlag) {
+      std::printf("Usage: %s [OPTIONS...]\n", argv[0]);
+      std::printf("Options:\n");
+      std::printf("    -n <N>\n");
+      std::printf("        number of random colors to test for each palette "
+                  "and error scale\n        (default: 1000000)\n");
+      if (e.what()[0] == '\0')
+        return 0;
+    }
+    std::fprintf(stderr, " *** %s: %s\n", argv[0], e.what());
+    return -1;
+  }
+  return 0;
+}
+
@@ -32,11 +32,14 @@
 #include "tvc_2.hpp"
 #include "tvc_4.hpp"
 #include "tvc_16.hpp"
+#include "system.hpp"
 
 #include <FL/Fl.H>
 #include <FL/Fl_Image.H>
 #include <FL/Fl_Shared_Image.H>
 
+#include <vector>
+
 static const int  ditherTable_Bayer[4096] = {
      0, 2048,  512, 2560,  128, 2176,  640, 2688,   32, 2080,  544, 2592,
    160, 2208,  672, 2720,    8, 2056,  520, 2568,  136, 2184,  648, 2696,
@@ -1477,6 +1480,67 @@ namespace Ep128ImgConv {
 
   // --------------------------------------------------------------------------
 
+  struct ParallelLineState {
+    Ep128Emu::Mutex mutex;
+    void    (*func)(void *userData, int yc);
+    void    *userData;
+    int     nLines;
+    int     nextLine;
+    int     linesDone;
+    bool    stopFlag;
+    bool    errorFlag;
+    std::string errorMessage;
+  };
+
+  // process the next unprocessed line; returns false if there are no more
+  // lines, or the processing has been stopped
+  static bool processNextLine(ParallelLineState& st)
+  {
+    int     yc = -1;
+    st.mutex.lock();
+    if (!st.stopFlag && st.nextLine < st.nLines)
+      yc = st.nextLine++;
+    st.mutex.unlock();
+    if (yc < 0)
+      return false;
+    try {
+      st.func(st.userData, yc);
+      st.mutex.lock();
+      st.linesDone++;
+      st.mutex.unlock();
+    }
+    catch (std::exception& e) {
+      st.mutex.lock();
+      if (!st.errorFlag) {
+        st.errorFlag = true;
+        st.errorMessage = e.what();
+      }
+      st.stopFlag = true;
+      st.mutex.unlock();
+      return false;
+    }
+    return true;
+  }
+
+  class ImageConvLineThread : public Ep128Emu::Thread {
+   private:
+    ParallelLineState&  st;
+   public:
+    ImageConvLineThread(ParallelLineState& st_)
+      : Ep128Emu::Thread(),
+        st(st_)
+    {
+    }
+    virtual ~ImageConvLineThread()
+    {
+    }
+    virtual void run()
+    {
+      while (processNextLine(st))
+        ;
+    }
+  };
+
   ImageConverter::ImageConverter()
     : progressMessageCallback(&defaultProgressMessageCb),
       progressMessageUserData((void *) 0),
@@ -1544,6 +1608,61 @@ namespace Ep128ImgConv {
     return true;
   }
 
+  bool ImageConverter::processLinesParallel(
+      int nLines, int nThreads, void (*func)(void *userData, int yc),
+      void *userData, int& progressCnt, int progressInc, int progressMax)
+  {
+    ParallelLineState st;
+    st.func = func;
+    st.userData = userData;
+    st.nLines = nLines;
+    st.nextLine = 0;
+    st.linesDone = 0;
+    st.stopFlag = false;
+    st.errorFlag = false;
+    limitValue(nThreads, 1, 64);
+    if (nThreads > nLines)
+      nThreads = nLines;
+    std::vector< ImageConvLineThread * >  threads;
+    bool    retval = true;
+    try {
+      for (int i = 1; i < nThreads; i++) {
+        threads.push_back((ImageConvLineThread *) 0);
+        threads.back() = new ImageConvLineThread(st);
+        threads.back()->start();
+      }
+      while (true) {
+        st.mutex.lock();
+        int     linesDone = st.linesDone;
+        st.mutex.unlock();
+        if (!setProgressPercentage(((progressCnt + (linesDone * progressInc))
+                                    * 100) / progressMax)) {
+          st.mutex.lock();
+          st.stopFlag = true;
+          st.mutex.unlock();
+          retval = false;
+          break;
+        }
+        if (!processNextLine(st))
+          break;
+      }
+    }
+    catch (...) {
+      st.mutex.lock();
+      st.stopFlag = true;
+      st.mutex.unlock();
+      for (size_t i = 0; i < threads.size(); i++)
+        delete threads[i];
+      throw;
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+      delete threads[i];
+    if (st.errorFlag)
+      throw Ep128Emu::Exception(st.errorMessage.c_str());
+    progressCnt += (nLines * progressInc);
+    return retval;
+  }
+
   // --------------------------------------------------------------------------
 
   void convertEPColorToYUV(int c, float& y, float& u, float& v,
@@ -1625,13 +1744,128 @@ namespace Ep128ImgConv {
     (void) getRandomNumber(seedValue);
   }
 
+  NearestColorIndex::NearestColorIndex()
+    : yOffset(0.0f),
+      uOffset(0.0f),
+      vOffset(0.0f),
+      gridScaleY(1.0f),
+      gridScaleU(1.0f),
+      gridScaleV(1.0f),
+      colorErrorScale(0.5f),
+      nColors(0)
+  {
+    float   tmp = 0.0f;
+    setPalette(&tmp, &tmp, &tmp, 1, 0.5f);
+  }
+
+  void NearestColorIndex::setPalette(const float *palY, const float *palU,
+                                     const float *palV, int nColors_,
+                                     float colorErrorScale_)
+  {
+    limitValue(nColors_, 1, 256);
+    nColors = nColors_;
+    colorErrorScale = colorErrorScale_;
+    for (int i = 0; i < 256; i++) {
+      paletteY[i] = (i < nColors ? palY[i] : 0.0f);
+      paletteU[i] = (i < nColors ? palU[i] : 0.0f);
+      paletteV[i] = (i < nColors ? palV[i] : 0.0f);
+    }
+    // the grid covers the range of limitYUVColor() with a small margin
+    const double  yMin = -0.001;
+    const double  uMin = -0.436912;
+    const double  vMin = -0.615777;
+    const double  cellSizeY = (1.001 - yMin) / double(gridSize);
+    const double  cellSizeU = (0.436912 - uMin) / double(gridSize);
+    const double  cellSizeV = (0.615777 - vMin) / double(gridSize);
+    yOffset = float(yMin);
+    uOffset = float(uMin);
+    vOffset = float(vMin);
+    gridScaleY = float(1.0 / cellSizeY);
+    gridScaleU = float(1.0 / cellSizeU);
+    gridScaleV = float(1.0 / cellSizeV);
+    cellOffsets.resize(size_t(gridSize * gridSize * gridSize + 1));
+    cellColors.clear();
+    cellColorY.clear();
+    cellColorU.clear();
+    cellColorV.clear();
+    // the smallest and largest squared error between each color and the
+    // cells along each axis; the cell bounds are extended by 1% of the cell
+    // size to allow for rounding errors in the calculation of the cell number
+    std::vector< double > minErrTable(size_t(gridSize * 3 * 256));
+    std::vector< double > maxErrTable(size_t(gridSize * 3 * 256));
+    for (int i = 0; i < (gridSize * 3); i++) {
+      int     j = i % gridSize;
+      const float *p = &(paletteY[0]);
+      double  x0 = yMin + ((double(j) - 0.01) * cellSizeY);
+      double  x1 = yMin + ((double(j) + 1.01) * cellSizeY);
+      double  errScale = 1.0;
+      if (i >= gridSize) {
+        errScale = double(colorErrorScale);
+        if (i < (gridSize * 2)) {
+          p = &(paletteU[0]);
+          x0 = uMin + ((double(j) - 0.01) * cellSizeU);
+          x1 = uMin + ((double(j) + 1.01) * cellSizeU);
+        }
+        else {
+          p = &(paletteV[0]);
+          x0 = vMin + ((double(j) - 0.01) * cellSizeV);
+          x1 = vMin + ((double(j) + 1.01) * cellSizeV);
+        }
+      }
+      for (int c = 0; c < nColors; c++) {
+        double  x = p[c];
+        double  err0 = calculateErrorSqr(x, x0) * errScale;
+        double  err1 = calculateErrorSqr(x, x1) * errScale;
+        minErrTable[(i << 8) | c] = (x < x0 ? err0 : (x > x1 ? err1 : 0.0));
+        maxErrTable[(i << 8) | c] = (err0 > err1 ? err0 : err1);
+      }
+    }
+    int     n = 0;
+    for (int yi = 0; yi < gridSize; yi++) {
+      const double  *minErrY = &(minErrTable[yi << 8]);
+      const double  *maxErrY = &(maxErrTable[yi << 8]);
+      for (int ui = 0; ui < gridSize; ui++) {
+        const double  *minErrU = &(minErrTable[(gridSize + ui) << 8]);
+        const double  *maxErrU = &(maxErrTable[(gridSize + ui) << 8]);
+        for (int vi = 0; vi < gridSize; vi++) {
+          const double  *minErrV = &(minErrTable[((gridSize * 2) + vi) << 8]);
+          const double  *maxErrV = &(maxErrTable[((gridSize * 2) + vi) << 8]);
+          // smallest maximum error of any color in the cell
+          double  maxErrLimit = 1000000000.0;
+          for (int c = 0; c < nColors; c++) {
+            double  maxErr = maxErrY[c] + maxErrU[c] + maxErrV[c];
+            if (maxErr < maxErrLimit)
+              maxErrLimit = maxErr;
+          }
+          // colors that cannot be the nearest one are not stored; the limit
+          // is increased slightly to allow for single precision rounding
+          maxErrLimit = (maxErrLimit * 1.0001) + 0.000001;
+          cellOffsets[n] = int(cellColors.size());
+          for (int c = 0; c < nColors; c++) {
+            if ((minErrY[c] + minErrU[c] + minErrV[c]) <= maxErrLimit) {
+              cellColors.push_back((unsigned char) c);
+              cellColorY.push_back(paletteY[c]);
+              cellColorU.push_back(paletteU[c]);
+              cellColorV.push_back(paletteV[c]);
+            }
+          }
+          n++;
+        }
+      }
+    }
+    cellOffsets[n] = int(cellColors.size());
+  }
+
+  // --------------------------------------------------------------------------
+
   void ditherLine(IndexedImage& ditheredImage, const YUVImage& inputImage,
                   YUVImage& ditherErrorImage,
                   long yc, int ditherType, double ditherDiffusion,
                   double colorErrorScale,
                   const unsigned char *linePalette, size_t linePaletteSize,
                   const float *epPaletteY, const float *epPaletteU,
-                  const float *epPaletteV)
+                  const float *epPaletteV,
+                  const NearestColorIndex *colorIndex)
   {
     if (ditherType >= 4) {
       ditherLine_ordered(ditheredImage, inputImage, yc, ditherType,
@@ -1650,6 +1884,17 @@ namespace Ep128ImgConv {
       h = ditherErrorImage.getHeight();
     if (yc < 0L || yc >= long(h))
       return;
+    float   tmpPaletteY[256];
+    float   tmpPaletteU[256];
+    float   tmpPaletteV[256];
+    if (linePaletteSize > 256)
+      linePaletteSize = 256;
+    for (size_t i = 0; i < linePaletteSize && !colorIndex; i++) {
+      int     c = linePalette[i];
+      tmpPaletteY[i] = epPaletteY[c];
+      tmpPaletteU[i] = epPaletteU[c];
+      tmpPaletteV[i] = epPaletteV[c];
+    }
     for (int xc = 0; xc < w; xc++) {
       if ((yc & 1L) != 0L)
         xc = (w - 1) - xc;
@@ -1660,18 +1905,15 @@ namespace Ep128ImgConv {
       float   u = u0 + ditherErrorImage.u(xc, yc);
       float   v = v0 + ditherErrorImage.v(xc, yc);
       limitYUVColor(y, u, v);
-      double  bestError = 1000000000.0;
+      // find nearest color
       int     bestColor = 0;
-      for (size_t i = 0; i < linePaletteSize; i++) {
-        // find nearest color
-        int     c = linePalette[i];
-        double  err =
-            calculateYUVErrorSqr(epPaletteY[c], epPaletteU[c], epPaletteV[c],
-                                 y, u, v, colorErrorScale);
-        if (err < bestError) {
-          bestColor = int(i);
-          bestError = err;
-        }
+      if (colorIndex) {
+        bestColor = colorIndex->findNearestColor(y, u, v);
+      }
+      else {
+        (void) findNearestYUVColor(tmpPaletteY, tmpPaletteU, tmpPaletteV,
+                                   int(linePaletteSize), y, u, v,
+                                   float(colorErrorScale), &bestColor);
       }
       ditheredImage[yc][xc] = (unsigned char) (bestColor & 0xFF);
       limitYUVColorToRGB(y, u, v);
@@ -1897,13 +2139,17 @@ namespace Ep128ImgConv {
         throw Ep128Emu::Exception("invalid output image size");
       // width or height is unspecified, calculate from the other value
       // and image aspect ratio
-      Fl_Shared_Image *f = Fl_Shared_Image::get(inputFileName);
-      if (!f)
-        throw Ep128Emu::Exception("error opening image file");
-      int     w = f->w();
-      int     h = f->h();
-      f->release();
-      f = (Fl_Shared_Image *) 0;
+      int     w = 0;
+      int     h = 0;
+      {
+        ImageFileLock   imageFileLock;
+        Fl_Shared_Image *f = Fl_Shared_Image::get(inputFileName);
+        if (!f)
+          throw Ep128Emu::Exception("error opening image file");
+        w = f->w();
+        h = f->h();
+        f->release();
+      }
       if (w < 1 || w > 16384 || h < 1 || h > 16384)
         throw Ep128Emu::Exception("invalid input image size");
       double  aspectRatio = double(w) / double(h);
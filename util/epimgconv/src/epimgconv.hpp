@@ -27,6 +27,13 @@
 #include "img_cfg.hpp"
 
 #include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#  include <emmintrin.h>
+#  define EPIMGCONV_USE_SSE2            1
+#endif
 
 namespace Ep128ImgConv {
 
@@ -253,6 +260,17 @@ namespace Ep128ImgConv {
    protected:
     virtual void progressMessage(const char *msg);
     virtual bool setProgressPercentage(int n);
+    // call func(userData, yc) for each line from 0 to nLines - 1, using
+    // up to nThreads threads (including the calling thread); the order in
+    // which the lines are processed is not defined, so func must not depend
+    // on the results of other lines; 'progressCnt' is incremented by
+    // 'progressInc' for each line, and the progress display is updated
+    // from the calling thread only
+    // the return value is false if the processing has been stopped
+    bool processLinesParallel(int nLines, int nThreads,
+                              void (*func)(void *userData, int yc),
+                              void *userData, int& progressCnt,
+                              int progressInc, int progressMax);
   };
 
   static inline double calculateError(double a, double b)
@@ -274,6 +292,200 @@ namespace Ep128ImgConv {
                                   + calculateErrorSqr(v0, v1))));
   }
 
+  // single precision version of calculateYUVErrorSqr(), with the operations
+  // in the same order as in the SIMD color search functions below
+  static inline float calculateYUVErrorSqrF(float y0, float u0, float v0,
+                                            float y1, float u1, float v1,
+                                            float colorErrorScale)
+  {
+    float   dy = y0 - y1;
+    float   du = u0 - u1;
+    float   dv = v0 - v1;
+    return ((dy * dy) + (((du * du) + (dv * dv)) * colorErrorScale));
+  }
+
+  // returns the smallest squared error between y, u, v and the colors of a
+  // palette stored in separate Y, U, and V tables of 'nColors' entries;
+  // if 'colorIndex' is not NULL, the index of the first color with this
+  // error is stored there
+  static inline float findNearestYUVColor(const float *palY,
+                                          const float *palU,
+                                          const float *palV, int nColors,
+                                          float y, float u, float v,
+                                          float colorErrorScale,
+                                          int *colorIndex = (int *) 0)
+  {
+    float   minErr = 1000000000.0f;
+    int     bestColor = 0;
+    int     i = 0;
+#ifdef EPIMGCONV_USE_SSE2
+    if (nColors >= 4) {
+      __m128  y_ = _mm_set1_ps(y);
+      __m128  u_ = _mm_set1_ps(u);
+      __m128  v_ = _mm_set1_ps(v);
+      __m128  scale_ = _mm_set1_ps(colorErrorScale);
+      __m128  minErr_ = _mm_set1_ps(minErr);
+      __m128i bestColor_ = _mm_setzero_si128();
+      __m128i c_ = _mm_set_epi32(3, 2, 1, 0);
+      __m128i four_ = _mm_set1_epi32(4);
+      for ( ; (i + 4) <= nColors; i += 4) {
+        __m128  dy = _mm_sub_ps(_mm_loadu_ps(palY + i), y_);
+        __m128  du = _mm_sub_ps(_mm_loadu_ps(palU + i), u_);
+        __m128  dv = _mm_sub_ps(_mm_loadu_ps(palV + i), v_);
+        __m128  err = _mm_add_ps(_mm_mul_ps(dy, dy),
+                                 _mm_mul_ps(_mm_add_ps(_mm_mul_ps(du, du),
+                                                       _mm_mul_ps(dv, dv)),
+                                            scale_));
+        if (colorIndex) {
+          __m128i mask = _mm_castps_si128(_mm_cmplt_ps(err, minErr_));
+          bestColor_ = _mm_or_si128(_mm_and_si128(mask, c_),
+                                    _mm_andnot_si128(mask, bestColor_));
+          c_ = _mm_add_epi32(c_, four_);
+        }
+        minErr_ = _mm_min_ps(err, minErr_);
+      }
+      if (colorIndex) {
+        float   errBuf[4];
+        int32_t colorBuf[4];
+        _mm_storeu_ps(&(errBuf[0]), minErr_);
+        _mm_storeu_si128(reinterpret_cast< __m128i * >(&(colorBuf[0])),
+                         bestColor_);
+        for (int j = 0; j < 4; j++) {
+          if (errBuf[j] < minErr ||
+              (errBuf[j] == minErr && colorBuf[j] < bestColor)) {
+            minErr = errBuf[j];
+            bestColor = colorBuf[j];
+          }
+        }
+      }
+      else {
+        minErr_ = _mm_min_ps(minErr_, _mm_shuffle_ps(minErr_, minErr_, 0x4E));
+        minErr_ = _mm_min_ps(minErr_, _mm_shuffle_ps(minErr_, minErr_, 0xB1));
+        minErr = _mm_cvtss_f32(minErr_);
+      }
+    }
+#endif
+    for ( ; i < nColors; i++) {
+      float   err = calculateYUVErrorSqrF(palY[i], palU[i], palV[i],
+                                          y, u, v, colorErrorScale);
+      if (err < minErr) {
+        minErr = err;
+        bestColor = i;
+      }
+    }
+    if (colorIndex)
+      *colorIndex = bestColor;
+    return minErr;
+  }
+
+  // for each of the 'nPixels' input colors, store in minErr[] the smallest
+  // squared error to the colors of a palette of 'nColors' entries
+  static inline void calculateMinYUVErrors(float *minErr,
+                                           const float *inY, const float *inU,
+                                           const float *inV, int nPixels,
+                                           const float *palY,
+                                           const float *palU,
+                                           const float *palV, int nColors,
+                                           float colorErrorScale)
+  {
+    int     i = 0;
+#ifdef EPIMGCONV_USE_SSE2
+    __m128  scale_ = _mm_set1_ps(colorErrorScale);
+    for ( ; (i + 4) <= nPixels; i += 4) {
+      __m128  y_ = _mm_loadu_ps(inY + i);
+      __m128  u_ = _mm_loadu_ps(inU + i);
+      __m128  v_ = _mm_loadu_ps(inV + i);
+      __m128  minErr_ = _mm_set1_ps(1000000000.0f);
+      for (int j = 0; j < nColors; j++) {
+        __m128  dy = _mm_sub_ps(_mm_set1_ps(palY[j]), y_);
+        __m128  du = _mm_sub_ps(_mm_set1_ps(palU[j]), u_);
+        __m128  dv = _mm_sub_ps(_mm_set1_ps(palV[j]), v_);
+        __m128  err = _mm_add_ps(_mm_mul_ps(dy, dy),
+                                 _mm_mul_ps(_mm_add_ps(_mm_mul_ps(du, du),
+                                                       _mm_mul_ps(dv, dv)),
+                                            scale_));
+        minErr_ = _mm_min_ps(err, minErr_);
+      }
+      _mm_storeu_ps(minErr + i, minErr_);
+    }
+#endif
+    for ( ; i < nPixels; i++) {
+      minErr[i] = findNearestYUVColor(palY, palU, palV, nColors,
+                                      inY[i], inU[i], inV[i],
+                                      colorErrorScale);
+    }
+  }
+
+  // index for finding the nearest color of a fixed palette without searching
+  // all colors: the YUV space (as limited by limitYUVColor()) is divided into
+  // a grid of cells, and each cell stores the colors that can be the nearest
+  // one to any point in the cell; the result of findNearestColor() is always
+  // the same as that of findNearestYUVColor() on the full palette
+  class NearestColorIndex {
+   public:
+    static const int  gridSize = 8;
+   private:
+    float   yOffset;
+    float   uOffset;
+    float   vOffset;
+    float   gridScaleY;
+    float   gridScaleU;
+    float   gridScaleV;
+    float   colorErrorScale;
+    int     nColors;
+    // offset of the first color of each cell in cellColors,
+    // gridSize^3 + 1 entries
+    std::vector< int >    cellOffsets;
+    std::vector< unsigned char >  cellColors;
+    // cellColorY/U/V[i] is the color of cellColors[i]
+    std::vector< float >  cellColorY;
+    std::vector< float >  cellColorU;
+    std::vector< float >  cellColorV;
+    float   paletteY[256];
+    float   paletteU[256];
+    float   paletteV[256];
+   public:
+    NearestColorIndex();
+    // build the index for a palette of 1 to 256 colors
+    void setPalette(const float *palY, const float *palU, const float *palV,
+                    int nColors_, float colorErrorScale_);
+    inline int getColorCount() const
+    {
+      return nColors;
+    }
+    // returns the index of the first palette color with the smallest error,
+    // and optionally stores the error in *minErr
+    inline int findNearestColor(float y, float u, float v,
+                                float *minErr = (float *) 0) const
+    {
+      int     ci = 0;
+      float   err = 0.0f;
+      float   yf = (y - yOffset) * gridScaleY;
+      float   uf = (u - uOffset) * gridScaleU;
+      float   vf = (v - vOffset) * gridScaleV;
+      if (yf >= 0.0f && yf < float(gridSize) &&
+          uf >= 0.0f && uf < float(gridSize) &&
+          vf >= 0.0f && vf < float(gridSize)) {
+        int     n = (((int(yf) * gridSize) + int(uf)) * gridSize) + int(vf);
+        int     offs = cellOffsets[n];
+        err = findNearestYUVColor(&(cellColorY[offs]), &(cellColorU[offs]),
+                                  &(cellColorV[offs]),
+                                  cellOffsets[n + 1] - offs, y, u, v,
+                                  colorErrorScale, &ci);
+        ci = cellColors[offs + ci];
+      }
+      else {
+        // not in the grid, search all colors
+        err = findNearestYUVColor(&(paletteY[0]), &(paletteU[0]),
+                                  &(paletteV[0]), nColors, y, u, v,
+                                  colorErrorScale, &ci);
+      }
+      if (minErr)
+        *minErr = err;
+      return ci;
+    }
+  };
+
   template < typename T >
   static inline void limitValue(T& x, T min_, T max_)
   {
@@ -341,13 +553,17 @@ namespace Ep128ImgConv {
 
   void setRandomSeed(int& seedValue, uint32_t n);
 
+  // if 'colorIndex' is not NULL, it is used for finding the nearest color,
+  // and it must have been built from the colors of 'linePalette'
   void ditherLine(IndexedImage& ditheredImage, const YUVImage& inputImage,
                   YUVImage& ditherErrorImage,
                   long yc, int ditherType, double ditherDiffusion,
                   double colorErrorScale,
                   const unsigned char *linePalette, size_t linePaletteSize,
                   const float *epPaletteY, const float *epPaletteU,
-                  const float *epPaletteV);
+                  const float *epPaletteV,
+                  const NearestColorIndex *colorIndex =
+                      (NearestColorIndex *) 0);
 
   void ditherLine_ordered(IndexedImage& ditheredImage,
                           const YUVImage& inputImage, long yc, int ditherType,
@@ -22,6 +22,7 @@
 
 #include "epimgconv.hpp"
 #include "imageconv.hpp"
+#include "system.hpp"
 
 #include <vector>
 #include <map>
@@ -240,6 +241,30 @@ namespace Ep128ImgConv {
     std::fputc(int(b * 255.0f + 0.5f), stdout);
   }
 
+  static Ep128Emu::Mutex  imageFileMutex;
+
+  ImageFileLock::ImageFileLock()
+    : isLocked(true)
+  {
+    imageFileMutex.lock();
+  }
+
+  ImageFileLock::~ImageFileLock()
+  {
+    if (isLocked)
+      imageFileMutex.unlock();
+  }
+
+  void ImageFileLock::unlock()
+  {
+    if (isLocked) {
+      isLocked = false;
+      imageFileMutex.unlock();
+    }
+  }
+
+  // --------------------------------------------------------------------------
+
   YUVImageConverter::YUVImageConverter()
     : width(640),
       height(400),
@@ -279,6 +304,7 @@ namespace Ep128ImgConv {
     float     *windowX = (float *) 0;
     float     *windowY = (float *) 0;
     float     *inputImage = (float *) 0;
+    ImageFileLock   imageFileLock;
     Fl_Shared_Image *f = Fl_Shared_Image::get(fileName);
     if (!f)
       throw Ep128Emu::Exception("error opening image file");
@@ -296,6 +322,7 @@ namespace Ep128ImgConv {
         readColormapImage(pixelBuf, palette, *f);
         f->release();
         f = (Fl_Shared_Image *) 0;
+        imageFileLock.unlock();
       }
       else {
         // RGB or greyscale format
@@ -380,6 +407,7 @@ namespace Ep128ImgConv {
       if (f) {
         f->release();
         f = (Fl_Shared_Image *) 0;
+        imageFileLock.unlock();
       }
       // calculate X and Y scale
       float   aspectScale = (float(width) * pixelAspectRatio / float(height))
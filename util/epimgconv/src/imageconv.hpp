@@ -27,6 +27,17 @@
 
 namespace Ep128ImgConv {
 
+  // Fl_Shared_Image is not thread safe, so image files are opened and read
+  // with this lock held; the lock is released by unlock() or the destructor
+  class ImageFileLock {
+   private:
+    bool    isLocked;
+   public:
+    ImageFileLock();
+    ~ImageFileLock();
+    void unlock();
+  };
+
   class YUVImageConverter {
    private:
     int     width;
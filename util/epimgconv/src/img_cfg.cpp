@@ -224,6 +224,10 @@ namespace Ep128ImgConv {
     (*this)["noInterpolation"].setCallback(&configChangeCallbackBoolean,
                                            (void *) this, true);
     createKey("noCompress", noCompress);
+    createKey("nThreads", nThreads);
+    (*this)["nThreads"].setRange(0.0, 16.0);
+    (*this)["nThreads"].setCallback(&configChangeCallbackInteger,
+                                    (void *) this, true);
   }
 
   ImageConvConfig::~ImageConvConfig()
@@ -257,6 +261,7 @@ namespace Ep128ImgConv {
       paletteColors[i] = -1;
     noInterpolation = false;
     noCompress = false;
+    nThreads = 0;
     configChangeFlag = true;
   }
 
@@ -61,6 +61,8 @@ namespace Ep128ImgConv {
     int     paletteColors[8];   // palette colors (0 to 255), or -1 to optimize
     bool    noInterpolation;    // disable interpolation if true
     bool    noCompress;         // no automatic compression of large programs
+    int     nThreads;           // 0: sequential per-line palette optimization,
+                                // 1 to 16: optimize lines in parallel
     bool    configChangeFlag;
    private:
     static void configChangeCallbackBoolean(void *userData_,
@@ -572,7 +572,8 @@ int main(int argc, char **argv)
     }
     std::printf("Compressing PNG file...\n");
     Ep128Emu::writePNGImage(argv[argc - 1], &(outBuf.front()), w, h, 256,
-                            optimizePalette, 32768);
+                            optimizePalette, 32768,
+                            Ep128Emu::Compressor_ZLib::compressionLevelOptimal);
     std::printf("Done.\n");
   }
   catch (std::exception& e) {
@@ -24,8 +24,11 @@
 #include "imgwrite.hpp"
 #include "img_cfg.hpp"
 #include "guicolor.hpp"
+#include "system.hpp"
 
 #include <string>
+#include <vector>
+#include <map>
 
 #include <FL/Fl.H>
 #include <FL/Fl_Image.H>
@@ -93,12 +96,14 @@ static int convertColorValue(const char *s, bool isFixBias = false)
 }
 
 static void parseCommandLine(Ep128ImgConv::ImageConvConfig& config,
-                             std::string& infileName, std::string& outfileName,
+                             std::vector< std::string >& fileNames,
+                             std::string& batchOutputDir, int& nJobs,
                              bool& printUsageFlag, bool& helpFlag,
                              int argc, char **argv)
 {
-  infileName.clear();
-  outfileName.clear();
+  fileNames.clear();
+  batchOutputDir.clear();
+  nJobs = 1;
   printUsageFlag = false;
   helpFlag = false;
   bool    endOfOptions = false;
@@ -107,12 +112,7 @@ static void parseCommandLine(Ep128ImgConv::ImageConvConfig& config,
     if (s == (char *) 0 || s[0] == '\0')
       continue;
     if (endOfOptions || s[0] != '-') {
-      if (infileName.length() < 1)
-        infileName = s;
-      else if (outfileName.length() < 1)
-        outfileName = s;
-      else
-        throw Ep128Emu::Exception("too many filename arguments");
+      fileNames.push_back(std::string(s));
       continue;
     }
     if (std::strcmp(s, "--") == 0) {
@@ -231,6 +231,25 @@ static void parseCommandLine(Ep128ImgConv::ImageConvConfig& config,
         throw Ep128Emu::Exception("missing argument for '-nocompress'");
       config["noCompress"] = bool(std::atoi(argv[i]));
     }
+    else if (std::strcmp(s, "-threads") == 0) {
+      if (++i >= argc)
+        throw Ep128Emu::Exception("missing argument for '-threads'");
+      config["nThreads"] = int(std::atoi(argv[i]));
+    }
+    else if (std::strcmp(s, "-batch") == 0) {
+      if (++i >= argc)
+        throw Ep128Emu::Exception("missing argument for '-batch'");
+      batchOutputDir = argv[i];
+      if (batchOutputDir.empty())
+        throw Ep128Emu::Exception("invalid output directory name");
+    }
+    else if (std::strcmp(s, "-jobs") == 0) {
+      if (++i >= argc)
+        throw Ep128Emu::Exception("missing argument for '-jobs'");
+      nJobs = int(std::atoi(argv[i]));
+      if (nJobs < 1 || nJobs > 64)
+        throw Ep128Emu::Exception("number of jobs is out of range");
+    }
     else if (std::strcmp(s, "-h") == 0 ||
              std::strcmp(s, "-help") == 0 ||
              std::strcmp(s, "--help") == 0) {
@@ -249,6 +268,411 @@ static void parseCommandLine(Ep128ImgConv::ImageConvConfig& config,
   }
 }
 
+// ----------------------------------------------------------------------------
+
+// output file name extensions for batch mode, indexed by config.outputFormat
+static const char *batchOutputExtensions[17] = {
+  ".com", ".pic", ".pic", ".pic", ".pic", ".pic", ".crf", ".scr", ".pic",
+  ".pic", ".bin", ".kep", ".kep", ".kep", ".kep", ".kep", ".kep"
+};
+
+// name of the file in the output directory that stores the hash of the
+// input file and conversion settings for each output file; inputs with
+// an unchanged hash are not converted again if the output file exists
+static const char *batchCacheFileName = "epimgconv.cache";
+
+struct BatchConvertJob {
+  std::string infileName;
+  std::string outfileName;      // without the output directory
+  uint64_t    hashValue;
+  double      convTime;
+  bool        skipFlag;
+  bool        errorFlag;
+  std::string errorMessage;
+};
+
+struct BatchConvertState {
+  Ep128Emu::Mutex mutex;
+  const Ep128ImgConv::ImageConvConfig *config;
+  std::string outputDir;
+  std::vector< BatchConvertJob >  jobs;
+  std::map< std::string, uint64_t > hashCache;
+  uint64_t    configHash;
+  size_t      nextJob;
+  size_t      jobsDone;
+};
+
+static inline void hashBytes(uint64_t& h, const void *buf, size_t nBytes)
+{
+  // 64-bit FNV-1a hash
+  const unsigned char *p = reinterpret_cast< const unsigned char * >(buf);
+  for (size_t i = 0; i < nBytes; i++) {
+    h = h ^ uint64_t(p[i]);
+    h = h * ((uint64_t(0x00000100UL) << 32) | uint64_t(0x000001B3UL));
+  }
+}
+
+template < typename T >
+static inline void hashValue(uint64_t& h, const T& value)
+{
+  hashBytes(h, &value, sizeof(T));
+}
+
+static uint64_t calculateConfigHash(const Ep128ImgConv::ImageConvConfig& cfg)
+{
+  uint64_t  h = (uint64_t(0xCBF29CE4UL) << 32) | uint64_t(0x84222325UL);
+  hashValue(h, cfg.getOutputFormat());
+  hashValue(h, cfg.conversionType);
+  hashValue(h, cfg.width);
+  hashValue(h, cfg.height);
+  hashValue(h, cfg.borderColor);
+  hashValue(h, cfg.paletteResolution);
+  hashValue(h, cfg.conversionQuality);
+  hashValue(h, cfg.colorErrorScale);
+  hashValue(h, cfg.ditherType);
+  hashValue(h, cfg.ditherDiffusion);
+  hashValue(h, cfg.scaleMode);
+  hashValue(h, cfg.scaleX);
+  hashValue(h, cfg.scaleY);
+  hashValue(h, cfg.offsetX);
+  hashValue(h, cfg.offsetY);
+  hashValue(h, cfg.yMin);
+  hashValue(h, cfg.yMax);
+  hashValue(h, cfg.colorSaturationMult);
+  hashValue(h, cfg.gammaCorrection);
+  hashValue(h, cfg.fixBias);
+  for (int i = 0; i < 8; i++)
+    hashValue(h, cfg.paletteColors[i]);
+  hashValue(h, cfg.noInterpolation);
+  hashValue(h, cfg.noCompress);
+  // the result does not depend on the number of threads if it is not zero
+  hashValue(h, bool(cfg.nThreads > 0));
+  return h;
+}
+
+static uint64_t calculateFileHash(const std::string& fileName, uint64_t h)
+{
+  std::FILE *f = Ep128Emu::fileOpen(fileName.c_str(), "rb");
+  if (!f)
+    throw Ep128Emu::Exception("error opening image file");
+  std::vector< unsigned char >  buf(65536);
+  while (true) {
+    size_t  n = std::fread(&(buf.front()), sizeof(unsigned char), buf.size(),
+                           f);
+    if (n < 1)
+      break;
+    hashBytes(h, &(buf.front()), n);
+  }
+  bool    errorFlag = bool(std::ferror(f));
+  std::fclose(f);
+  if (errorFlag)
+    throw Ep128Emu::Exception("error reading image file");
+  return h;
+}
+
+static bool fileExists(const std::string& fileName)
+{
+  std::FILE *f = Ep128Emu::fileOpen(fileName.c_str(), "rb");
+  if (!f)
+    return false;
+  std::fclose(f);
+  return true;
+}
+
+static void readBatchCacheFile(BatchConvertState& st)
+{
+  std::FILE *f = Ep128Emu::fileOpen((st.outputDir + batchCacheFileName).c_str(),
+                                    "rb");
+  if (!f)
+    return;
+  // each line contains a 16 digit hexadecimal hash value, a space character,
+  // and the output file name
+  std::string lineBuf;
+  while (true) {
+    int     c = std::fgetc(f);
+    if (c != EOF && c != '\n') {
+      if (c != '\r')
+        lineBuf += char(c);
+      continue;
+    }
+    if (lineBuf.length() > 17 && lineBuf[16] == ' ') {
+      uint64_t  h = 0U;
+      size_t  i = 0;
+      for ( ; i < 16; i++) {
+        char    d = lineBuf[i];
+        if (d >= '0' && d <= '9')
+          h = (h << 4) | uint64_t(d - '0');
+        else if (d >= 'A' && d <= 'F')
+          h = (h << 4) | uint64_t(d - 'A' + 10);
+        else
+          break;
+      }
+      if (i == 16)
+        st.hashCache[lineBuf.substr(17)] = h;
+    }
+    lineBuf.clear();
+    if (c == EOF)
+      break;
+  }
+  std::fclose(f);
+}
+
+static void writeBatchCacheFile(const BatchConvertState& st)
+{
+  std::FILE *f = Ep128Emu::fileOpen((st.outputDir + batchCacheFileName).c_str(),
+                                    "wb");
+  if (!f)
+    throw Ep128Emu::Exception("error opening batch cache file");
+  bool    errorFlag = false;
+  for (std::map< std::string, uint64_t >::const_iterator i =
+           st.hashCache.begin(); i != st.hashCache.end(); i++) {
+    if (std::fprintf(f, "%08X%08X %s\n",
+                     (unsigned int) ((*i).second >> 32),
+                     (unsigned int) ((*i).second & 0xFFFFFFFFUL),
+                     (*i).first.c_str()) < 0) {
+      errorFlag = true;
+      break;
+    }
+  }
+  if (std::fclose(f) != 0 || errorFlag)
+    throw Ep128Emu::Exception("error writing batch cache file");
+}
+
+static void batchProgressMessageCb(void *userData, const char *msg)
+{
+  (void) userData;
+  (void) msg;
+}
+
+static bool batchProgressPercentageCb(void *userData, int n)
+{
+  (void) userData;
+  (void) n;
+  return true;
+}
+
+static void batchConvertFile(BatchConvertState& st, BatchConvertJob& job)
+{
+  Ep128Emu::Timer timer;
+  job.hashValue = calculateFileHash(job.infileName, st.configHash);
+  std::string outfileName(st.outputDir + job.outfileName);
+  st.mutex.lock();
+  std::map< std::string, uint64_t >::iterator i =
+      st.hashCache.find(job.outfileName);
+  job.skipFlag = (i != st.hashCache.end() && (*i).second == job.hashValue);
+  st.mutex.unlock();
+  if (job.skipFlag) {
+    job.skipFlag = fileExists(outfileName);
+    if (job.skipFlag)
+      return;
+  }
+  Ep128ImgConv::ImageData *imgData =
+      Ep128ImgConv::convertImage(job.infileName.c_str(), *(st.config),
+                                 &batchProgressMessageCb,
+                                 &batchProgressPercentageCb);
+  if (!imgData)
+    throw Ep128Emu::Exception("image conversion failed");
+  try {
+    writeConvertedImageFile(outfileName.c_str(), *imgData,
+                            st.config->getOutputFormat(),
+                            st.config->noCompress,
+                            &batchProgressMessageCb,
+                            &batchProgressPercentageCb);
+  }
+  catch (...) {
+    delete imgData;
+    throw;
+  }
+  delete imgData;
+  job.convTime = timer.getRealTime();
+}
+
+// convert the next unconverted file; returns false if there are no more
+// files in the job list
+static bool batchConvertNextFile(BatchConvertState& st)
+{
+  st.mutex.lock();
+  size_t  n = st.nextJob;
+  if (n < st.jobs.size())
+    st.nextJob++;
+  st.mutex.unlock();
+  if (n >= st.jobs.size())
+    return false;
+  BatchConvertJob&  job = st.jobs[n];
+  try {
+    batchConvertFile(st, job);
+  }
+  catch (std::exception& e) {
+    job.errorFlag = true;
+    job.errorMessage = e.what();
+  }
+  st.mutex.lock();
+  st.jobsDone++;
+  if (job.errorFlag) {
+    std::fprintf(stderr, " *** epimgconv error: %s: %s\n",
+                 job.infileName.c_str(), job.errorMessage.c_str());
+  }
+  else if (job.skipFlag) {
+    std::printf("[%4d/%4d] %s: skipped (output is up to date)\n",
+                int(st.jobsDone), int(st.jobs.size()), job.infileName.c_str());
+  }
+  else {
+    st.hashCache[job.outfileName] = job.hashValue;
+    std::printf("[%4d/%4d] %s -> %s: %.3f s\n",
+                int(st.jobsDone), int(st.jobs.size()), job.infileName.c_str(),
+                job.outfileName.c_str(), job.convTime);
+  }
+  std::fflush(stdout);
+  st.mutex.unlock();
+  return true;
+}
+
+class BatchConvertThread : public Ep128Emu::Thread {
+ private:
+  BatchConvertState&  st;
+ public:
+  BatchConvertThread(BatchConvertState& st_)
+    : Ep128Emu::Thread(),
+      st(st_)
+  {
+  }
+  virtual ~BatchConvertThread()
+  {
+  }
+  virtual void run()
+  {
+    while (batchConvertNextFile(st))
+      ;
+  }
+};
+
+// read input file names from a list file (one name per line)
+static void readFileList(std::vector< std::string >& fileNames,
+                         const char *listFileName)
+{
+  std::FILE *f = Ep128Emu::fileOpen(listFileName, "rb");
+  if (!f)
+    throw Ep128Emu::Exception("error opening file list");
+  std::string lineBuf;
+  while (true) {
+    int     c = std::fgetc(f);
+    if (c != EOF && c != '\n') {
+      lineBuf += char(c);
+      continue;
+    }
+    Ep128Emu::stripString(lineBuf);
+    if (!lineBuf.empty())
+      fileNames.push_back(lineBuf);
+    lineBuf.clear();
+    if (c == EOF)
+      break;
+  }
+  std::fclose(f);
+}
+
+// convert all files in 'fileNames' to 'outputDir' on 'nJobs' threads,
+// returns the number of files that could not be converted
+static int batchConvertImages(const Ep128ImgConv::ImageConvConfig& config,
+                              const std::vector< std::string >& fileNames,
+                              const std::string& outputDir, int nJobs)
+{
+  Ep128Emu::Timer timer;
+  BatchConvertState st;
+  st.config = &config;
+  st.outputDir = outputDir;
+  if (st.outputDir[st.outputDir.length() - 1] != '/' &&
+      st.outputDir[st.outputDir.length() - 1] != '\\') {
+    st.outputDir += '/';
+  }
+  st.configHash = calculateConfigHash(config);
+  st.nextJob = 0;
+  st.jobsDone = 0;
+  int     outputFormat = config.outputFormat;
+  if (!(outputFormat >= 0 && outputFormat <= 16))
+    outputFormat = 10;
+  std::map< std::string, std::string >  outfileNames;
+  for (size_t i = 0; i < fileNames.size(); i++) {
+    std::vector< std::string >  tmpList;
+    if (fileNames[i][0] == '@')
+      readFileList(tmpList, fileNames[i].c_str() + 1);
+    else
+      tmpList.push_back(fileNames[i]);
+    for (size_t j = 0; j < tmpList.size(); j++) {
+      BatchConvertJob job;
+      job.infileName = tmpList[j];
+      std::string dirName;
+      Ep128Emu::splitPath(job.infileName, dirName, job.outfileName);
+      if (job.outfileName.empty())
+        throw Ep128Emu::Exception("invalid input file name");
+      size_t  n = job.outfileName.rfind('.');
+      if (n != std::string::npos && n > 0)
+        job.outfileName.resize(n);
+      job.outfileName += batchOutputExtensions[outputFormat];
+      if (outfileNames.find(job.outfileName) != outfileNames.end()) {
+        throw Ep128Emu::Exception((std::string("'") + job.infileName
+                                   + "' and '"
+                                   + outfileNames[job.outfileName]
+                                   + "' have the same output file name")
+                                  .c_str());
+      }
+      outfileNames[job.outfileName] = job.infileName;
+      job.hashValue = 0U;
+      job.convTime = 0.0;
+      job.skipFlag = false;
+      job.errorFlag = false;
+      st.jobs.push_back(job);
+    }
+  }
+  if (st.jobs.size() < 1)
+    throw Ep128Emu::Exception("missing file name");
+  readBatchCacheFile(st);
+  if (size_t(nJobs) > st.jobs.size())
+    nJobs = int(st.jobs.size());
+  std::vector< BatchConvertThread * > threads;
+  try {
+    for (int i = 1; i < nJobs; i++) {
+      threads.push_back((BatchConvertThread *) 0);
+      threads.back() = new BatchConvertThread(st);
+      threads.back()->start();
+    }
+    while (batchConvertNextFile(st))
+      ;
+  }
+  catch (...) {
+    for (size_t i = 0; i < threads.size(); i++)
+      delete threads[i];
+    throw;
+  }
+  for (size_t i = 0; i < threads.size(); i++)
+    delete threads[i];
+  int     nConverted = 0;
+  int     nSkipped = 0;
+  int     nErrors = 0;
+  double  totalConvTime = 0.0;
+  for (size_t i = 0; i < st.jobs.size(); i++) {
+    if (st.jobs[i].errorFlag) {
+      nErrors++;
+      // do not skip the file next time, even if the output exists
+      st.hashCache.erase(st.jobs[i].outfileName);
+    }
+    else if (st.jobs[i].skipFlag) {
+      nSkipped++;
+    }
+    else {
+      nConverted++;
+      totalConvTime += st.jobs[i].convTime;
+    }
+  }
+  writeBatchCacheFile(st);
+  std::printf("Converted %d files (%d skipped, %d failed) in %.3f s, "
+              "%.3f s per file\n",
+              nConverted, nSkipped, nErrors, timer.getRealTime(),
+              (nConverted > 0 ? (totalConvTime / double(nConverted)) : 0.0));
+  return nErrors;
+}
+
+// ----------------------------------------------------------------------------
+
 int main(int argc, char **argv)
 {
   bool    printUsageFlag = false;
@@ -260,12 +684,13 @@ int main(int argc, char **argv)
     Ep128Emu::setGUIColorScheme(3);
 #endif
     Ep128ImgConv::ImageConvConfig config;
-    std::string infileName;
-    std::string outfileName;
-    parseCommandLine(config, infileName, outfileName, printUsageFlag, helpFlag,
-                     argc, argv);
+    std::vector< std::string >  fileNames;
+    std::string batchOutputDir;
+    int     nJobs = 1;
+    parseCommandLine(config, fileNames, batchOutputDir, nJobs,
+                     printUsageFlag, helpFlag, argc, argv);
 #ifndef DISABLE_OPENGL_DISPLAY
-    if (infileName.empty() && outfileName.empty()) {
+    if (fileNames.size() < 1 && batchOutputDir.empty()) {
       // if there are no file name arguments, run in GUI mode,
       // but still use any command line options specified
       config.resetDefaultSettings();
@@ -277,7 +702,7 @@ int main(int argc, char **argv)
       }
       catch (...) {
       }
-      parseCommandLine(config, infileName, outfileName,
+      parseCommandLine(config, fileNames, batchOutputDir, nJobs,
                        printUsageFlag, helpFlag, argc, argv);
       config.clearConfigurationChangeFlag();
       Ep128ImgConvGUI *gui = new Ep128ImgConvGUI(config);
@@ -294,15 +719,27 @@ int main(int argc, char **argv)
       return 0;
     }
 #endif
-    if (infileName.empty() || outfileName.empty()) {
+    if (!batchOutputDir.empty()) {
+      if (fileNames.size() < 1) {
+        printUsageFlag = true;
+        throw Ep128Emu::Exception("missing file name");
+      }
+      return (batchConvertImages(config, fileNames, batchOutputDir, nJobs) == 0
+              ? 0 : -1);
+    }
+    if (fileNames.size() < 2) {
       printUsageFlag = true;
       throw Ep128Emu::Exception("missing file name");
     }
+    if (fileNames.size() > 2) {
+      printUsageFlag = true;
+      throw Ep128Emu::Exception("too many filename arguments");
+    }
     Ep128ImgConv::ImageData *imgData =
-        Ep128ImgConv::convertImage(infileName.c_str(), config);
+        Ep128ImgConv::convertImage(fileNames[0].c_str(), config);
     if (imgData) {
       try {
-        writeConvertedImageFile(outfileName.c_str(), *imgData,
+        writeConvertedImageFile(fileNames[1].c_str(), *imgData,
                                 config.getOutputFormat(), config.noCompress);
       }
       catch (...) {
@@ -317,6 +754,8 @@ int main(int argc, char **argv)
     if (printUsageFlag || helpFlag) {
       std::fprintf(stderr, "Usage: %s [OPTIONS...] <infile> <outfile>\n",
                            argv[0]);
+      std::fprintf(stderr, "       %s [OPTIONS...] -batch <outdir> "
+                           "<infiles...>\n", argv[0]);
       std::fprintf(stderr, "Options:\n");
       std::fprintf(stderr, "    -h | -help | --help\n");
       std::fprintf(stderr, "        print this message\n");
@@ -388,6 +827,21 @@ int main(int argc, char **argv)
                            "chrominance error\n");
       std::fprintf(stderr, "    -quality <N>        (1 to 9, default: 3)\n");
       std::fprintf(stderr, "        set conversion quality vs. speed\n");
+      std::fprintf(stderr, "    -threads <N>        (0 to 16, default: 0)\n");
+      std::fprintf(stderr, "        optimize the palette of independent "
+                           "lines on N threads; the\n"
+                           "        result does not depend on N, but it "
+                           "may differ from N = 0\n");
+      std::fprintf(stderr, "    -batch <DIR>\n");
+      std::fprintf(stderr, "        convert all input files to DIR, with "
+                           "the extension replaced\n"
+                           "        according to -outfmt; @FILE reads input "
+                           "file names from FILE,\n"
+                           "        and files not changed since the last run "
+                           "are skipped\n");
+      std::fprintf(stderr, "    -jobs <N>           (1 to 64, default: 1)\n");
+      std::fprintf(stderr, "        convert N files in parallel in batch "
+                           "mode\n");
       std::fprintf(stderr, "    -bias <C>           (-1 to 31, default: -1)\n");
       std::fprintf(stderr, "        set FIXBIAS value, or optimize if C = "
                            "-1\n");
@@ -293,6 +293,36 @@ namespace Ep128ImgConv {
     return bestError;
   }
 
+  void ImageConv_Pixel16_1::optimizeLinePaletteCallback(void *userData,
+                                                        int yc)
+  {
+    ImageConv_Pixel16_1&  this_ =
+        *(reinterpret_cast<ImageConv_Pixel16_1 *>(userData));
+    (void) this_.optimizeLinePalette(yc, this_.lineOptimizeLevel);
+  }
+
+  bool ImageConv_Pixel16_1::optimizeAllLinePalettes(int optimizeLevel,
+                                                    int nThreads,
+                                                    int& progressCnt,
+                                                    int progressMax)
+  {
+    if (nThreads > 0) {
+      // the lines do not depend on each other, since the palette is
+      // optimized for the pre-dithered image
+      lineOptimizeLevel = optimizeLevel;
+      return processLinesParallel(height, nThreads,
+                                  &optimizeLinePaletteCallback, (void *) this,
+                                  progressCnt, optimizeLevel, progressMax);
+    }
+    for (int yc = 0; yc < height; yc++) {
+      if (!setProgressPercentage((progressCnt * 100) / progressMax))
+        return false;
+      optimizeLinePalette(yc, optimizeLevel);
+      progressCnt += optimizeLevel;
+    }
+    return true;
+  }
+
   double ImageConv_Pixel16_1::optimizeImagePalette(int optimizeLevel,
                                                    bool optimizeFixBias)
   {
@@ -406,10 +436,13 @@ namespace Ep128ImgConv {
     unsigned char tmpPalette[256];
     for (int i = 0; i < 256; i++)
       tmpPalette[i] = (unsigned char) i;
+    NearestColorIndex colorIndex;
+    colorIndex.setPalette(paletteY, paletteU, paletteV, 256, colorErrorScale);
     for (int yc = 0; yc < height; yc++) {
       ditherLine(ditheredImage, inputImage, ditherErrorImage, yc,
                  ditherType, ditherDiffusion, colorErrorScale,
-                 &(tmpPalette[0]), 256, paletteY, paletteU, paletteV);
+                 &(tmpPalette[0]), 256, paletteY, paletteU, paletteV,
+                 &colorIndex);
     }
   }
 
@@ -457,7 +490,8 @@ namespace Ep128ImgConv {
       borderColor(0x00),
       ditherType(1),
       ditherDiffusion(0.95f),
-      errorTable((double *) 0)
+      errorTable((double *) 0),
+      lineOptimizeLevel(1)
   {
     for (int i = 0; i < 8; i++)
       fixedColors[i] = false;
@@ -551,11 +585,9 @@ namespace Ep128ImgConv {
             }
           }
           setFixBias(bestFixBias);
-          for (int yc = 0; yc < height; yc++) {
-            if (!setProgressPercentage((progressCnt * 100) / progressMax))
-              return false;
-            optimizeLinePalette(yc, l + 1);
-            progressCnt += (l + 1);
+          if (!optimizeAllLinePalettes(l + 1, config.nThreads,
+                                       progressCnt, progressMax)) {
+            return false;
           }
         }
       }
@@ -568,11 +600,9 @@ namespace Ep128ImgConv {
           double  bestError = 1000000000.0;
           for (int fb = 0; fb < 32; fb++) {
             setFixBias(fb);
-            for (int yc = 0; yc < height; yc++) {
-              if (!setProgressPercentage((progressCnt * 100) / progressMax))
-                return false;
-              optimizeLinePalette(yc, 2);
-              progressCnt += 2;
+            if (!optimizeAllLinePalettes(2, config.nThreads,
+                                         progressCnt, progressMax)) {
+              return false;
             }
             double  err = calculateTotalError(bestError);
             if (err < bestError) {
@@ -585,11 +615,9 @@ namespace Ep128ImgConv {
           bestFixBias = config.fixBias & 0x1F;
         }
         setFixBias(bestFixBias);
-        for (int yc = 0; yc < height; yc++) {
-          if (!setProgressPercentage((progressCnt * 100) / progressMax))
-            return false;
-          optimizeLinePalette(yc, optimizeLevel);
-          progressCnt += optimizeLevel;
+        if (!optimizeAllLinePalettes(optimizeLevel, config.nThreads,
+                                     progressCnt, progressMax)) {
+          return false;
         }
       }
     }
@@ -44,6 +44,7 @@ namespace Ep128ImgConv {
     int           ditherType;
     float         ditherDiffusion;
     double        *errorTable;          // size = 256*256
+    int           lineOptimizeLevel;    // used by optimizeLinePaletteCallback
     bool          fixedColors[8];
     float         paletteY[256];
     float         paletteU[256];
@@ -71,6 +72,11 @@ namespace Ep128ImgConv {
         double *errorCache = (double *) 0, double maxError = 1000000000.0);
     double calculateTotalError(double maxError = 1000000000.0);
     double optimizeLinePalette(int yc, int optimizeLevel = 2);
+    static void optimizeLinePaletteCallback(void *userData, int yc);
+    // optimize the palette of all lines, on 'nThreads' threads if it is
+    // greater than zero; returns false if the processing has been stopped
+    bool optimizeAllLinePalettes(int optimizeLevel, int nThreads,
+                                 int& progressCnt, int progressMax);
     double optimizeImagePalette(int optimizeLevel = 2,
                                 bool optimizeFixBias = false);
     void sortLinePalette(int yc);
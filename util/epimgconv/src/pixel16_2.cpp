@@ -85,6 +85,19 @@ namespace Ep128ImgConv {
         n++;
       }
     }
+    // colors that can be combined with the changed color, for searching the
+    // nearest pair without calculating the error of all 136 entries
+    float   pairPaletteY[16];
+    float   pairPaletteU[16];
+    float   pairPaletteV[16];
+    if (colorChanged >= 0) {
+      for (int i = 0; i < 16; i++) {
+        int     tmp = paletteMap[(colorChanged << 4) | i];
+        pairPaletteY[i] = tmpPaletteY[tmp];
+        pairPaletteU[i] = tmpPaletteU[tmp];
+        pairPaletteV[i] = tmpPaletteV[tmp];
+      }
+    }
     double  totalError = 0.0;
     float   tmpY = 0.0;
     float   tmpU = 0.0;
@@ -101,10 +114,10 @@ namespace Ep128ImgConv {
       if (colorChanged >= 0) {
         if (int(colorIndexCache[xc]) != colorChanged) {
           double  err =
-              Ep128ImgConv::calculateYUVErrorSqr(tmpPaletteY[colorChanged],
-                                                 tmpPaletteU[colorChanged],
-                                                 tmpPaletteV[colorChanged],
-                                                 y, u, v, colorErrorScale);
+              calculateYUVErrorSqrF(tmpPaletteY[colorChanged],
+                                    tmpPaletteU[colorChanged],
+                                    tmpPaletteV[colorChanged],
+                                    y, u, v, colorErrorScale);
           double  minErr = errorCache[xc];
           if (err < minErr) {
             minErr = err;
@@ -116,19 +129,10 @@ namespace Ep128ImgConv {
         }
       }
       if (searchFlag) {
-        double  minErr = 1000000000.0;
         int     ci = 0;
-        for (int i = 0; i < 16; i++) {
-          double  err =
-              Ep128ImgConv::calculateYUVErrorSqr(tmpPaletteY[i],
-                                                 tmpPaletteU[i],
-                                                 tmpPaletteV[i],
-                                                 y, u, v, colorErrorScale);
-          if (err < minErr) {
-            minErr = err;
-            ci = i;
-          }
-        }
+        double  minErr = findNearestYUVColor(tmpPaletteY, tmpPaletteU,
+                                             tmpPaletteV, 16, y, u, v,
+                                             colorErrorScale, &ci);
         if (colorIndexCache) {
           colorIndexCache[xc] = (unsigned char) ci;
           errorCache[xc] = minErr;
@@ -141,19 +145,11 @@ namespace Ep128ImgConv {
       if (colorChanged >= 0) {
         if (int(colorIndexCache[width + (xc - 1)]) != colorChanged &&
             int(colorIndexCache[width + xc]) != colorChanged) {
-          double  minErr2 = 1000000000.0;
           int     ci = 0;
-          for (int i = 0; i < 16; i++) {
-            int     tmp = paletteMap[(colorChanged << 4) | i];
-            double  err =
-                Ep128ImgConv::calculateYUVErrorSqr(
-                    tmpPaletteY[tmp], tmpPaletteU[tmp], tmpPaletteV[tmp],
-                    tmpY, tmpU, tmpV, colorErrorScale);
-            if (err < minErr2) {
-              minErr2 = err;
-              ci = i;
-            }
-          }
+          double  minErr2 = findNearestYUVColor(pairPaletteY, pairPaletteU,
+                                                pairPaletteV, 16,
+                                                tmpY, tmpU, tmpV,
+                                                colorErrorScale, &ci);
           double  minErr = errorCache[width + (xc >> 1)];
           if (minErr2 < minErr) {
             minErr = minErr2;
@@ -166,28 +162,11 @@ namespace Ep128ImgConv {
         }
       }
       if (searchFlag) {
-        double  minErr = 1000000000.0;
         int     ci = 0;
-        for (int i = 0; i < 136; i += 2) {
-          double  err = Ep128ImgConv::calculateYUVErrorSqr(tmpPaletteY[i],
-                                                           tmpPaletteU[i],
-                                                           tmpPaletteV[i],
-                                                           tmpY, tmpU, tmpV,
-                                                           colorErrorScale);
-          if (err < minErr) {
-            minErr = err;
-            ci = i;
-          }
-          err = Ep128ImgConv::calculateYUVErrorSqr(tmpPaletteY[i + 1],
-                                                   tmpPaletteU[i + 1],
-                                                   tmpPaletteV[i + 1],
-                                                   tmpY, tmpU, tmpV,
-                                                   colorErrorScale);
-          if (err < minErr) {
-            minErr = err;
-            ci = i + 1;
-          }
-        }
+        double  minErr = findNearestYUVColor(tmpPaletteY, tmpPaletteU,
+                                             tmpPaletteV, 136,
+                                             tmpY, tmpU, tmpV,
+                                             colorErrorScale, &ci);
         if (colorIndexCache) {
           colorIndexCache[width + (xc - 1)] = (tmpPaletteI[ci] >> 4) & 0x0F;
           colorIndexCache[width + xc] = tmpPaletteI[ci] & 0x0F;
@@ -497,6 +476,22 @@ namespace Ep128ImgConv {
     sortLinePalette(yc);
   }
 
+  void ImageConv_Pixel16_2::optimizeLinePaletteCallback(void *userData,
+                                                        int yc)
+  {
+    ImageConv_Pixel16_2&  this_ =
+        *(reinterpret_cast<ImageConv_Pixel16_2 *>(userData));
+    (void) this_.optimizeLinePalette(yc, this_.lineOptimizeLevel);
+  }
+
+  void ImageConv_Pixel16_2::optimizeLinePaletteFastCallback(void *userData,
+                                                            int yc)
+  {
+    ImageConv_Pixel16_2&  this_ =
+        *(reinterpret_cast<ImageConv_Pixel16_2 *>(userData));
+    this_.optimizeLinePalette_fast(yc);
+  }
+
   void ImageConv_Pixel16_2::pixelStoreCallback(void *userData, int xc, int yc,
                                                float y, float u, float v)
   {
@@ -539,7 +534,8 @@ namespace Ep128ImgConv {
       conversionQuality(3),
       borderColor(0x00),
       ditherType(1),
-      ditherDiffusion(0.95f)
+      ditherDiffusion(0.95f),
+      lineOptimizeLevel(1)
   {
     for (int i = 0; i < 8; i++)
       fixedColors[i] = false;
@@ -633,6 +629,41 @@ namespace Ep128ImgConv {
           bestFixBias = config.fixBias & 0x1F;
         }
         setFixBias(bestFixBias);
+        if (config.nThreads > 0) {
+          // optimize the lines in parallel: the diffused error is estimated
+          // by dithering with the current palettes (from the fast search,
+          // or the previous level), and then the image is dithered again
+          // with the new palettes
+          if (config.fixBias >= 0) {
+            if (!processLinesParallel(height, config.nThreads,
+                                      &optimizeLinePaletteFastCallback,
+                                      (void *) this, progressCnt, 0,
+                                      progressMax)) {
+              return false;
+            }
+          }
+          for (int yc = 0; yc < height; yc++) {
+            ditherLine(convertedImage, inputImage, ditherErrorImage, yc,
+                       ditherType, ditherDiffusion,
+                       colorErrorScale, &(palette[yc][0]), 16,
+                       paletteY, paletteU, paletteV);
+          }
+          lineOptimizeLevel = l + 1;
+          if (!processLinesParallel(height, config.nThreads,
+                                    &optimizeLinePaletteCallback,
+                                    (void *) this, progressCnt, l + 1,
+                                    progressMax)) {
+            return false;
+          }
+          ditherErrorImage.clear();
+          for (int yc = 0; yc < height; yc++) {
+            ditherLine(convertedImage, inputImage, ditherErrorImage, yc,
+                       ditherType, ditherDiffusion,
+                       colorErrorScale, &(palette[yc][0]), 16,
+                       paletteY, paletteU, paletteV);
+          }
+          continue;
+        }
         for (int yc = 0; yc < height; yc++) {
           if (!setProgressPercentage((progressCnt * 100) / progressMax))
             return false;
@@ -42,6 +42,7 @@ namespace Ep128ImgConv {
     int           borderColor;
     int           ditherType;
     float         ditherDiffusion;
+    int           lineOptimizeLevel;    // used by optimizeLinePaletteCallback
     bool          fixedColors[8];
     float         paletteY[256];
     float         paletteU[256];
@@ -71,6 +72,8 @@ namespace Ep128ImgConv {
     void sortLinePalette(int yc);
     void setFixedPalette();
     void optimizeLinePalette_fast(int yc);
+    static void optimizeLinePaletteCallback(void *userData, int yc);
+    static void optimizeLinePaletteFastCallback(void *userData, int yc);
     static void pixelStoreCallback(void *userData, int xc, int yc,
                                    float y, float u, float v);
     static void pixelStoreCallbackI(void *userData, int xc, int yc,
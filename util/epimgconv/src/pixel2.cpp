@@ -72,21 +72,13 @@ namespace Ep128ImgConv {
         inBufV[i] = inputImage.v(xc + i, yc) + ditherErrorImage.v(xc + i, yc);
         limitYUVColor(inBufY[i], inBufU[i], inBufV[i]);
       }
+      float   minErr[8];
       // 8x1
-      for (int i = 0; i < 8; i++) {
-        double  minErr = 1000000000.0;
-        float   y = inBufY[i];
-        float   u = inBufU[i];
-        float   v = inBufV[i];
-        for (int j = 0; j < 2; j++) {
-          double  err = Ep128ImgConv::calculateYUVErrorSqr(
-                            tmpPaletteY[j], tmpPaletteU[j], tmpPaletteV[j],
-                            y, u, v, colorErrorScale);
-          if (err < minErr)
-            minErr = err;
-        }
-        totalError += minErr;
-      }
+      calculateMinYUVErrors(&(minErr[0]), inBufY, inBufU, inBufV, 8,
+                            tmpPaletteY, tmpPaletteU, tmpPaletteV, 2,
+                            colorErrorScale);
+      for (int i = 0; i < 8; i++)
+        totalError += minErr[i];
       if (ditherType == 0)
         continue;
       for (int i = 0; i < 4; i++) {
@@ -94,34 +86,23 @@ namespace Ep128ImgConv {
         inBufY[i] = (inBufY[i << 1] + inBufY[(i << 1) + 1]) * 0.5f;
         inBufU[i] = (inBufU[i << 1] + inBufU[(i << 1) + 1]) * 0.5f;
         inBufV[i] = (inBufV[i << 1] + inBufV[(i << 1) + 1]) * 0.5f;
-        double  minErr = 1000000000.0;
-        float   y = inBufY[i];
-        float   u = inBufU[i];
-        float   v = inBufV[i];
-        for (int j = 0; j < 3; j++) {
-          double  err = Ep128ImgConv::calculateYUVErrorSqr(
-                            tmpPaletteY[j], tmpPaletteU[j], tmpPaletteV[j],
-                            y, u, v, colorErrorScale);
-          if (err < minErr)
-            minErr = err;
-        }
-        totalError += (minErr * 4.0);
       }
+      calculateMinYUVErrors(&(minErr[0]), inBufY, inBufU, inBufV, 4,
+                            tmpPaletteY, tmpPaletteU, tmpPaletteV, 3,
+                            colorErrorScale);
+      for (int i = 0; i < 4; i++)
+        totalError += (minErr[i] * 4.0);
       for (int i = 0; i < 2; i++) {
         // downsample to 2x1
-        double  minErr = 1000000000.0;
-        float   y = (inBufY[i << 1] + inBufY[(i << 1) + 1]) * 0.5f;
-        float   u = (inBufU[i << 1] + inBufU[(i << 1) + 1]) * 0.5f;
-        float   v = (inBufV[i << 1] + inBufV[(i << 1) + 1]) * 0.5f;
-        for (int j = 0; j < 5; j++) {
-          double  err = Ep128ImgConv::calculateYUVErrorSqr(
-                            tmpPaletteY[j], tmpPaletteU[j], tmpPaletteV[j],
-                            y, u, v, colorErrorScale);
-          if (err < minErr)
-            minErr = err;
-        }
-        totalError += (minErr * 6.0);
+        inBufY[i] = (inBufY[i << 1] + inBufY[(i << 1) + 1]) * 0.5f;
+        inBufU[i] = (inBufU[i << 1] + inBufU[(i << 1) + 1]) * 0.5f;
+        inBufV[i] = (inBufV[i << 1] + inBufV[(i << 1) + 1]) * 0.5f;
       }
+      calculateMinYUVErrors(&(minErr[0]), inBufY, inBufU, inBufV, 2,
+                            tmpPaletteY, tmpPaletteU, tmpPaletteV, 5,
+                            colorErrorScale);
+      for (int i = 0; i < 2; i++)
+        totalError += (minErr[i] * 6.0);
     }
     return totalError;
   }
@@ -118,11 +118,14 @@ namespace Ep128ImgConv {
     unsigned char palette[256];
     for (int i = 0; i < 256; i++)
       palette[i] = (unsigned char) i;
+    NearestColorIndex colorIndex;
+    colorIndex.setPalette(paletteY, paletteU, paletteV, 256,
+                          float(config.colorErrorScale));
     for (int yc = 0; yc < height; yc++) {
       ditherLine(convertedImage, inputImage, ditherErrorImage, yc,
                  ditherType, ditherDiffusion,
                  float(config.colorErrorScale), &(palette[0]), 256,
-                 paletteY, paletteU, paletteV);
+                 paletteY, paletteU, paletteV, &colorIndex);
     }
     imgData.setBorderColor(borderColor);
     for (int yc = 0; yc < height; yc++) {
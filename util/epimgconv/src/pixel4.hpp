@@ -41,6 +41,7 @@ namespace Ep128ImgConv {
     int           borderColor;
     int           ditherType;
     float         ditherDiffusion;
+    int           lineOptimizeLevel;    // used by optimizeLinePaletteCallback
     bool          fixedColors[4];
     float         paletteY[256];
     float         paletteU[256];
@@ -61,6 +62,7 @@ namespace Ep128ImgConv {
     double optimizeImagePalette(int optimizeLevel = 2);
     void sortLinePalette(int yc);
     void setFixedPalette();
+    static void optimizeLinePaletteCallback(void *userData, int yc);
     static void pixelStoreCallback(void *userData, int xc, int yc,
                                    float y, float u, float v);
     static void pixelStoreCallbackI(void *userData, int xc, int yc,
@@ -70,53 +70,46 @@ namespace Ep128ImgConv {
       }
     }
     double  totalError = 0.0;
-    float   tmpY = 0.0;
-    float   tmpU = 0.0;
-    float   tmpV = 0.0;
-    for (int xc = 0; xc < width; xc++) {
-      float   y = inputImage.y(xc, yc) + ditherErrorImage.y(xc, yc);
-      float   u = inputImage.u(xc, yc) + ditherErrorImage.u(xc, yc);
-      float   v = inputImage.v(xc, yc) + ditherErrorImage.v(xc, yc);
-      limitYUVColor(y, u, v);
-      tmpY += (y * 0.5f);
-      tmpU += (u * 0.5f);
-      tmpV += (v * 0.5f);
-      double  minErr = 1000000000.0;
-      for (int i = 0; i < 4; i++) {
-        double  err = Ep128ImgConv::calculateYUVErrorSqr(tmpPaletteY[i],
-                                                         tmpPaletteU[i],
-                                                         tmpPaletteV[i],
-                                                         y, u, v,
-                                                         colorErrorScale);
-        if (err < minErr)
-          minErr = err;
+    // the line is processed in blocks of 8 pixels, so that the errors of
+    // multiple pixels can be calculated in parallel
+    for (int xc = 0; xc < width; xc += 8) {
+      int     nPixels = width - xc;
+      if (nPixels > 8)
+        nPixels = 8;
+      float   inBufY[8];
+      float   inBufU[8];
+      float   inBufV[8];
+      for (int i = 0; i < nPixels; i++) {
+        inBufY[i] = inputImage.y(xc + i, yc) + ditherErrorImage.y(xc + i, yc);
+        inBufU[i] = inputImage.u(xc + i, yc) + ditherErrorImage.u(xc + i, yc);
+        inBufV[i] = inputImage.v(xc + i, yc) + ditherErrorImage.v(xc + i, yc);
+        limitYUVColor(inBufY[i], inBufU[i], inBufV[i]);
       }
-      totalError += minErr;
-      if (xc & int(bool(ditherType))) {
-        minErr = 1000000000.0;
-        for (int i = 0; i < 10; i += 2) {
-          double  err = Ep128ImgConv::calculateYUVErrorSqr(tmpPaletteY[i],
-                                                           tmpPaletteU[i],
-                                                           tmpPaletteV[i],
-                                                           tmpY, tmpU, tmpV,
-                                                           colorErrorScale);
-          if (err < minErr)
-            minErr = err;
-          err = Ep128ImgConv::calculateYUVErrorSqr(tmpPaletteY[i + 1],
-                                                   tmpPaletteU[i + 1],
-                                                   tmpPaletteV[i + 1],
-                                                   tmpY, tmpU, tmpV,
-                                                   colorErrorScale);
-          if (err < minErr)
-            minErr = err;
-        }
-        totalError += (minErr * 4.0);
-        tmpY = 0.0f;
-        tmpU = 0.0f;
-        tmpV = 0.0f;
+      float   minErr[8];
+      calculateMinYUVErrors(&(minErr[0]), inBufY, inBufU, inBufV, nPixels,
+                            tmpPaletteY, tmpPaletteU, tmpPaletteV, 4,
+                            colorErrorScale);
+      // average of pixel pairs for dithering
+      int     nPairs = (ditherType != 0 ? (nPixels >> 1) : 0);
+      float   pairBufY[4];
+      float   pairBufU[4];
+      float   pairBufV[4];
+      float   pairErr[4];
+      for (int i = 0; i < nPairs; i++) {
+        pairBufY[i] = (inBufY[i << 1] * 0.5f) + (inBufY[(i << 1) + 1] * 0.5f);
+        pairBufU[i] = (inBufU[i << 1] * 0.5f) + (inBufU[(i << 1) + 1] * 0.5f);
+        pairBufV[i] = (inBufV[i << 1] * 0.5f) + (inBufV[(i << 1) + 1] * 0.5f);
+      }
+      calculateMinYUVErrors(&(pairErr[0]), pairBufY, pairBufU, pairBufV,
+                            nPairs, tmpPaletteY, tmpPaletteU, tmpPaletteV, 10,
+                            colorErrorScale);
+      for (int i = 0; i < nPixels; i++) {
+        totalError += minErr[i];
+        if ((i & 1) != 0 && (i >> 1) < nPairs)
+          totalError += (pairErr[i >> 1] * 4.0);
+        if (totalError > (maxError * 1.00001))
+          return totalError;
       }
-      if (totalError > (maxError * 1.00001))
-        break;
     }
     return totalError;
   }
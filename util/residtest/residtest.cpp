@@ -0,0 +1,315 @@
+
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2017 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Compares the output of SID::clock_block() (the block filter, using SSE2
+// if it was enabled at compile time, and the 6581 fixed-point skip) with the
+// cycle by cycle emulation of SID::clockCallback(), which is the same as
+// clock() without the external filter, on random register writes and block
+// lengths with both chip models. The output of every cycle must be identical.
+// The error of the multi-cycle approximation of clock_fast(delta_t)
+// (clock(delta_t) without the external filter), with the output at the end
+// of each block held for all cycles of the block, is also measured, and the
+// speed of all three methods.
+
+#include "ep128emu.hpp"
+#include "resid/sid.hpp"
+#include "system.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+static uint32_t randomSeed = 0x12345678U;
+
+static int getRandomNumber(int n)
+{
+  randomSeed = (randomSeed * 1103515245U + 12345U) & 0xFFFFFFFFU;
+  return int((randomSeed >> 16) % uint32_t(n));
+}
+
+struct SIDTestBlock {
+  // number of cycles to run
+  int     nCycles;
+  // register writes before the block, in SIDTestData::writes
+  size_t  firstWrite;
+  size_t  nWrites;
+};
+
+struct SIDTestData {
+  std::vector< SIDTestBlock >   blocks;
+  // register address in the high byte, value in the low byte
+  std::vector< uint16_t >       writes;
+  size_t  nCycles;
+};
+
+static const char *segmentTypeNames[5] = {
+  "silence", "tones", "sync/ring", "test/noise", "random"
+};
+
+static void addWrite(SIDTestData& t, int addr, int value)
+{
+  t.writes.push_back(uint16_t((addr << 8) | (value & 0xFF)));
+}
+
+// create a segment of test data of about 'nCycles' cycles:
+//   0: silence, with the filter settled (tests the 6581 fixed-point skip)
+//   1: tones without sync and ring modulation (the voices are clocked in
+//      blocks)
+//   2: hard sync and ring modulation (the voices are clocked in every cycle)
+//   3: test bit and noise
+//   4: random writes to all registers
+
+static void createTestSegment(SIDTestData& t, int segmentType, int nCycles)
+{
+  SIDTestBlock  b;
+  b.firstWrite = t.writes.size();
+  b.nWrites = 0;
+  // filter
+  addWrite(t, 0x15, getRandomNumber(8));
+  addWrite(t, 0x16, getRandomNumber(256));
+  addWrite(t, 0x17, getRandomNumber(256));
+  addWrite(t, 0x18, getRandomNumber(256) | 0x0F);
+  for (int i = 0; i < 21; i += 7) {
+    int     ctrl = 0x00;
+    switch (segmentType) {
+    case 0:
+      addWrite(t, i + 6, 0x00);                 // release = 0
+      break;
+    case 1:
+      ctrl = (0x10 << getRandomNumber(3)) | (getRandomNumber(2) ? 0x40 : 0);
+      ctrl = ctrl | getRandomNumber(2);
+      break;
+    case 2:
+      ctrl = (0x10 << getRandomNumber(3)) | 0x02 | (getRandomNumber(2) << 2);
+      ctrl = ctrl | getRandomNumber(2);
+      break;
+    case 3:
+      ctrl = (getRandomNumber(2) ? 0x80 : (0x10 << getRandomNumber(4)));
+      ctrl = ctrl | (getRandomNumber(2) << 3) | getRandomNumber(2);
+      break;
+    default:
+      ctrl = getRandomNumber(256);
+      break;
+    }
+    if (segmentType != 0) {
+      addWrite(t, i, getRandomNumber(256));
+      addWrite(t, i + 1, getRandomNumber(4) ? getRandomNumber(64) : 0);
+      addWrite(t, i + 2, getRandomNumber(256));
+      addWrite(t, i + 3, getRandomNumber(16));
+      addWrite(t, i + 5, getRandomNumber(256));
+      addWrite(t, i + 6, getRandomNumber(256));
+    }
+    addWrite(t, i + 4, ctrl);
+  }
+  b.nWrites = t.writes.size() - b.firstWrite;
+  while (nCycles > 0) {
+    // mostly short blocks, and some longer than Filter::block_size
+    b.nCycles = (getRandomNumber(2) ?
+                 (getRandomNumber(16) + 1) : (getRandomNumber(400) + 1));
+    t.blocks.push_back(b);
+    t.nCycles += size_t(b.nCycles);
+    nCycles -= b.nCycles;
+    b.firstWrite = t.writes.size();
+    b.nWrites = 0;
+    if (segmentType != 0 && getRandomNumber(16) == 0) {
+      int     i = getRandomNumber(3) * 7;
+      switch (getRandomNumber(4)) {
+      case 0:                           // toggle gate or test bit
+        addWrite(t, i + 4, getRandomNumber(segmentType >= 3 ? 256 : 128) | 1);
+        addWrite(t, i + 4, getRandomNumber(256) & 0xFE);
+        break;
+      case 1:                           // frequency
+        addWrite(t, i + 1, getRandomNumber(256));
+        break;
+      case 2:                           // filter cutoff
+        addWrite(t, 0x16, getRandomNumber(256));
+        break;
+      default:                          // volume and filter mode
+        addWrite(t, 0x18, getRandomNumber(256));
+        break;
+      }
+      b.nWrites = t.writes.size() - b.firstWrite;
+    }
+  }
+}
+
+static void writeRegisters(Ep128::SID& sid, const SIDTestData& t,
+                           const SIDTestBlock& b)
+{
+  for (size_t i = 0; i < b.nWrites; i++) {
+    uint16_t  w = t.writes[b.firstWrite + i];
+    sid.write(Ep128::reg8(w >> 8), Ep128::reg8(w & 0xFF));
+  }
+}
+
+// run the test data with 'method' (0: clockCallback(), 1: clock_block(),
+// 2: clock_fast(delta_t)), and store the output of each cycle in 'outBuf';
+// returns the time in seconds
+
+static double runSID(std::vector< int >& outBuf, const SIDTestData& t,
+                     Ep128::chip_model model, bool enableFilter, int method)
+{
+  int32_t     soundOutputAccumulator = 0;
+  Ep128::SID  sid(soundOutputAccumulator);
+  sid.set_chip_model(model);
+  sid.enable_filter(enableFilter);
+  sid.reset();
+  outBuf.resize(t.nCycles);
+  int     *bufp = &(outBuf.front());
+  Ep128Emu::Timer timer;
+  for (size_t i = 0; i < t.blocks.size(); i++) {
+    const SIDTestBlock& b = t.blocks[i];
+    writeRegisters(sid, t, b);
+    if (method == 0) {
+      for (int j = 0; j < b.nCycles; j++) {
+        soundOutputAccumulator = 0;
+        Ep128::SID::clockCallback(&sid);
+        *(bufp++) = int(soundOutputAccumulator >> 3);
+      }
+    }
+    else if (method == 1) {
+      sid.clock_block(Ep128::cycle_count(b.nCycles), bufp);
+      bufp += b.nCycles;
+    }
+    else {
+      sid.clock_fast(Ep128::cycle_count(b.nCycles));
+      for (int j = 0; j < b.nCycles; j++)
+        *(bufp++) = int(soundOutputAccumulator >> 4);
+    }
+  }
+  return timer.getRealTime();
+}
+
+// returns the number of cycles with different output
+
+static size_t runTest(const SIDTestData& t, Ep128::chip_model model,
+                      bool enableFilter)
+{
+  const char  *name = (model == Ep128::MOS6581 ?
+                       (enableFilter ? "6581" : "6581 (no filter)")
+                       : (enableFilter ? "8580" : "8580 (no filter)"));
+  std::vector< int >  refBuf;
+  std::vector< int >  blockBuf;
+  std::vector< int >  fastBuf;
+  double  t0 = runSID(refBuf, t, model, enableFilter, 0);
+  double  t1 = runSID(blockBuf, t, model, enableFilter, 1);
+  double  t2 = runSID(fastBuf, t, model, enableFilter, 2);
+  size_t  nErrors = 0;
+  double  maxErr = 0.0;
+  double  errSum = 0.0;
+  double  sigSum = 0.0;
+  for (size_t i = 0; i < t.nCycles; i++) {
+    if (blockBuf[i] != refBuf[i]) {
+      if (nErrors < 5) {
+        std::printf("  %s: mismatch at cycle %lu: %d instead of %d\n",
+                    name, (unsigned long) i, blockBuf[i], refBuf[i]);
+      }
+      nErrors++;
+    }
+    double  err = double(fastBuf[i] - refBuf[i]);
+    double  sig = double(refBuf[i]);
+    if (std::fabs(err) > maxErr)
+      maxErr = std::fabs(err);
+    errSum += (err * err);
+    sigSum += (sig * sig);
+  }
+  double  nsPerCycle = 1000000000.0 / double(t.nCycles);
+  std::printf("%-16s clock_block: %lu mismatches, "
+              "clock_fast(delta_t): max. error %.0f, RMS error %.1f "
+              "(signal %.1f)\n",
+              name, (unsigned long) nErrors,
+              maxErr, std::sqrt(errSum / double(t.nCycles)),
+              std::sqrt(sigSum / double(t.nCycles)));
+  std::printf("%-16s clockCallback: %.2f ns, clock_block: %.2f ns, "
+              "clock_fast(delta_t): %.2f ns per cycle\n",
+              name, t0 * nsPerCycle, t1 * nsPerCycle, t2 * nsPerCycle);
+  return nErrors;
+}
+
+int main(int argc, char **argv)
+{
+  size_t  nCycles = 10000000;
+  bool    printUsageFlag = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string tmp = argv[i];
+      if (tmp.length() < 1)
+        continue;
+      if (tmp == "-n") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -n");
+        int     n = int(std::atoi(argv[i]));
+        if (n < 1 || n > 1000)
+          throw Ep128Emu::Exception("number of cycles is out of range");
+        nCycles = size_t(n) * 1000000;
+      }
+      else {
+        printUsageFlag = true;
+        if (tmp == "-h" || tmp == "-help" || tmp == "--help")
+          throw Ep128Emu::Exception("");
+        throw Ep128Emu::Exception("invalid command line option");
+      }
+    }
+#ifdef RESID_FILTER_USE_SSE2
+    std::printf("Filter::clock_block(): SSE2\n");
+#else
+    std::printf("Filter::clock_block(): no SSE2\n");
+#endif
+    SIDTestData t;
+    t.nCycles = 0;
+    size_t  segmentCycles[5] = { 0, 0, 0, 0, 0 };
+    while (t.nCycles < nCycles) {
+      int     segmentType = getRandomNumber(5);
+      size_t  n = t.nCycles;
+      // long segments of silence to let the filter settle
+      createTestSegment(t, segmentType,
+                        getRandomNumber(segmentType == 0 ? 200000 : 50000)
+                        + 1000);
+      segmentCycles[segmentType] += (t.nCycles - n);
+    }
+    std::printf("%lu cycles in %lu blocks (",
+                (unsigned long) t.nCycles, (unsigned long) t.blocks.size());
+    for (int i = 0; i < 5; i++) {
+      std::printf("%s%s: %.1f%%", (i == 0 ? "" : ", "), segmentTypeNames[i],
+                  double(segmentCycles[i]) * 100.0 / double(t.nCycles));
+    }
+    std::printf(")\n");
+    size_t  nErrors = 0;
+    nErrors += runTest(t, Ep128::MOS6581, true);
+    nErrors += runTest(t, Ep128::MOS8580, true);
+    nErrors += runTest(t, Ep128::MOS6581, false);
+    if (nErrors)
+      throw Ep128Emu::Exception("SID::clock_block() output does not match");
+  }
+  catch (std::exception& e) {
+    if (printUsageFlag) {
+      std::printf("Usage: %s [OPTIONS...]\n", argv[0]);
+      std::printf("Options:\n");
+      std::printf("    -n <N>\n");
+      std::printf("        number of cycles to test for each chip model, "
+                  "in millions (default: 10)\n");
+      if (e.what()[0] == '\0')
+        return 0;
+    }
+    std::fprintf(stderr, " *** %s: %s\n", argv[0], e.what());
+    return -1;
+  }
+  return 0;
+}
+
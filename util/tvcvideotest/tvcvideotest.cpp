@@ -0,0 +1,238 @@
+
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2017 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Checks that the TVC video emulation produces the same output when the
+// pixels are converted by TVCVideo::renderLine() at the end of the line (or
+// before a color change), and when they are converted in every cycle, like
+// before the conversion was deferred. The CRTC is run with random video
+// memory, and random palette, border color, video mode and CRTC register
+// changes at random cycles; a hash of the data passed to drawLine() and the
+// vsyncStateChange() events are compared, and the speed of both methods is
+// measured.
+
+#include "ep128emu.hpp"
+#include "crtc6845.hpp"
+#include "tvcvideo.hpp"
+#include "system.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+// number of CRTC cycles in a frame (100 characters * 312.5 lines)
+static const size_t frameCycles = 31250;
+
+static uint32_t randomSeed = 0x12345678U;
+
+static int getRandomNumber(int n)
+{
+  randomSeed = (randomSeed * 1103515245U + 12345U) & 0xFFFFFFFFU;
+  return int((randomSeed >> 16) % uint32_t(n));
+}
+
+class TVCVideoTest : public TVC64::TVCVideo {
+ protected:
+  virtual void drawLine(const uint8_t *buf, size_t nBytes);
+  virtual void vsyncStateChange(bool newState, unsigned int currentSlot_);
+ public:
+  // FNV-1a hash of each line, and the VSYNC events
+  std::vector< uint32_t > events;
+  // --------
+  TVCVideoTest(const CPC464::CRTC6845& crtc_, const uint8_t *videoMemory_)
+    : TVC64::TVCVideo(crtc_, videoMemory_)
+  {
+  }
+  virtual ~TVCVideoTest()
+  {
+  }
+  EP128EMU_INLINE void renderPixels()
+  {
+    renderLine();
+  }
+};
+
+void TVCVideoTest::drawLine(const uint8_t *buf, size_t nBytes)
+{
+  uint32_t  h = 0x811C9DC5U ^ uint32_t(nBytes);
+  for (size_t i = 0; i < nBytes; i++)
+    h = (h ^ uint32_t(buf[i])) * 0x01000193U;
+  events.push_back(h & 0x7FFFFFFFU);
+}
+
+void TVCVideoTest::vsyncStateChange(bool newState, unsigned int currentSlot_)
+{
+  events.push_back(0x80000000U | (uint32_t(newState) << 8) | currentSlot_);
+}
+
+static EP128EMU_REGPARM2 void hSyncStateChangeCallback(void *userData,
+                                                       bool newState)
+{
+  reinterpret_cast< TVCVideoTest * >(userData)->crtcHSyncStateChange(newState);
+}
+
+static EP128EMU_REGPARM2 void vSyncStateChangeCallback(void *userData,
+                                                       bool newState)
+{
+  reinterpret_cast< TVCVideoTest * >(userData)->crtcVSyncStateChange(newState);
+}
+
+// run the video emulation for 'nFrames' frames, converting the pixels in
+// every cycle if 'perCycleRendering' is true; the random changes depend
+// only on the seed, so that they are the same in both modes
+// returns the time in seconds
+
+static double runTest(std::vector< uint32_t >& events, size_t nFrames,
+                      bool perCycleRendering)
+{
+  randomSeed = 0x12345678U;
+  std::vector< uint8_t >  videoMemory(16384);
+  for (size_t i = 0; i < videoMemory.size(); i++)
+    videoMemory[i] = uint8_t(getRandomNumber(256));
+  CPC464::CRTC6845  crtc;
+  TVCVideoTest  videoRenderer(crtc, &(videoMemory.front()));
+  crtc.setHSyncStateChangeCallback(&hSyncStateChangeCallback,
+                                   (void *) &videoRenderer);
+  crtc.setVSyncStateChangeCallback(&vSyncStateChangeCallback,
+                                   (void *) &videoRenderer);
+  // 64 characters * 240 lines, 4 lines per character row
+  static const uint8_t  crtcRegisters[14] = {
+    99, 64, 75, 0x37, 77, 0, 60, 70, 0, 3, 0, 0, 0, 0
+  };
+  for (uint16_t i = 0; i < 14; i++)
+    crtc.writeRegister(i, crtcRegisters[i]);
+  crtc.reset();
+  videoRenderer.reset();
+  Ep128Emu::Timer timer;
+  for (size_t i = 0; i < (nFrames * frameCycles); i++) {
+    videoRenderer.runOneCycle();
+    if (perCycleRendering)
+      videoRenderer.renderPixels();
+    crtc.runOneCycle();
+    int     n = getRandomNumber(65536);
+    if (n >= 16384)
+      continue;
+    if (n < 4096) {
+      // video memory write
+      videoMemory[n * 4 + getRandomNumber(4)] = uint8_t(getRandomNumber(256));
+    }
+    else if (n < 5120) {
+      // palette or border color
+      videoRenderer.setColor(uint8_t(getRandomNumber(5)),
+                             uint8_t(getRandomNumber(256)));
+    }
+    else if (n < 5184) {
+      videoRenderer.setVideoMode(uint8_t(getRandomNumber(4)));
+    }
+    else if (n < 5186) {
+      // start address, display width, sync position, or skew
+      switch (getRandomNumber(4)) {
+      case 0:
+        crtc.writeRegister(12, uint8_t(getRandomNumber(64)));
+        crtc.writeRegister(13, uint8_t(getRandomNumber(256)));
+        break;
+      case 1:
+        crtc.writeRegister(1, uint8_t(getRandomNumber(32) + 48));
+        break;
+      case 2:
+        crtc.writeRegister(2, uint8_t(getRandomNumber(8) + 72));
+        break;
+      default:
+        crtc.writeRegister(8, uint8_t(getRandomNumber(4) << 4));
+        break;
+      }
+    }
+  }
+  double  t = timer.getRealTime();
+  events.swap(videoRenderer.events);
+  return t;
+}
+
+int main(int argc, char **argv)
+{
+  size_t  nFrames = 500;
+  bool    printUsageFlag = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string tmp = argv[i];
+      if (tmp.length() < 1)
+        continue;
+      if (tmp == "-n") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -n");
+        int     n = int(std::atoi(argv[i]));
+        if (n < 1 || n > 100000)
+          throw Ep128Emu::Exception("number of frames is out of range");
+        nFrames = size_t(n);
+      }
+      else {
+        printUsageFlag = true;
+        if (tmp == "-h" || tmp == "-help" || tmp == "--help")
+          throw Ep128Emu::Exception("");
+        throw Ep128Emu::Exception("invalid command line option");
+      }
+    }
+    std::vector< uint32_t > events;
+    std::vector< uint32_t > refEvents;
+    double  t0 = runTest(events, nFrames, false);
+    double  t1 = runTest(refEvents, nFrames, true);
+    size_t  nLines = 0;
+    size_t  nVSyncs = 0;
+    size_t  nErrors = 0;
+    uint32_t  h = 0x811C9DC5U;
+    for (size_t i = 0; i < refEvents.size(); i++) {
+      h = (h ^ refEvents[i]) * 0x01000193U;
+      if (refEvents[i] & 0x80000000U)
+        nVSyncs++;
+      else
+        nLines++;
+      if (i >= events.size() || events[i] != refEvents[i]) {
+        if (nErrors < 5) {
+          std::printf("  mismatch at line %lu (after %lu VSYNC events)\n",
+                      (unsigned long) nLines, (unsigned long) nVSyncs);
+        }
+        nErrors++;
+      }
+    }
+    if (events.size() != refEvents.size())
+      nErrors++;
+    // the hash of all events can also be compared between versions
+    std::printf("%lu lines, %lu VSYNC events, hash: %08X, %lu mismatches\n",
+                (unsigned long) nLines, (unsigned long) nVSyncs,
+                (unsigned int) h, (unsigned long) nErrors);
+    double  nsPerCycle = 1000000000.0 / double(nFrames * frameCycles);
+    std::printf("renderLine() at the end of the line: %.2f ns, "
+                "in every cycle: %.2f ns per cycle\n",
+                t0 * nsPerCycle, t1 * nsPerCycle);
+    if (nErrors)
+      throw Ep128Emu::Exception("TVC video output does not match");
+  }
+  catch (std::exception& e) {
+    if (printUsageFlag) {
+      std::printf("Usage: %s [OPTIONS...]\n", argv[0]);
+      std::printf("Options:\n");
+      std::printf("    -n <N>\n");
+      std::printf("        number of frames to test (default: 500)\n");
+      if (e.what()[0] == '\0')
+        return 0;
+    }
+    std::fprintf(stderr, " *** %s: %s\n", argv[0], e.what());
+    return -1;
+  }
+  return 0;
+}
+
@@ -0,0 +1,336 @@
+
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2017 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Compares the YV12 video capture chroma blending and frame resampling
+// functions of VideoCapture_YV12 (using SSE2 if it was enabled at compile
+// time) with a plain C++ reference implementation. Random frames are
+// resampled from a random input frame rate to 30 frames per second, with
+// the same calculation of the scale factors as in frameDone(), and random
+// short and unaligned buffers are also tested. The output, the accumulated
+// data and the frame changed flag must be identical. The speed of both
+// implementations is also measured.
+
+#include "ep128emu.hpp"
+#include "videorec.hpp"
+#include "system.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// number of bytes in a frame (Y, V and U planes)
+static const int frameBytes =
+    (Ep128Emu::VideoCapture_YV12::videoWidth
+     * Ep128Emu::VideoCapture_YV12::videoHeight * 3) / 2;
+
+static uint32_t randomSeed = 0x12345678U;
+
+static int getRandomNumber(int n)
+{
+  randomSeed = (randomSeed * 1103515245U + 12345U) & 0xFFFFFFFFU;
+  return int((randomSeed >> 16) % uint32_t(n));
+}
+
+class VideoCaptureTest : public Ep128Emu::VideoCapture_YV12 {
+ public:
+  using Ep128Emu::VideoCapture_YV12::averageChromaLine;
+  using Ep128Emu::VideoCapture_YV12::accumulateFrame;
+  using Ep128Emu::VideoCapture_YV12::interpolateFrame;
+};
+
+static void averageChromaLine_Ref(uint8_t *buf, const uint8_t *inBuf,
+                                  int nBytes)
+{
+  for (int i = 0; i < nBytes; i++)
+    buf[i] = uint8_t((uint32_t(buf[i]) + uint32_t(inBuf[i]) + 1U) >> 1);
+}
+
+static void accumulateFrame_Ref(int32_t *interpBuf,
+                                const uint8_t *buf0, const uint8_t *buf1,
+                                int32_t scaleFac, int n)
+{
+  for (int i = 0; i < n; i++)
+    interpBuf[i] += ((int32_t(buf0[i]) + int32_t(buf1[i])) * scaleFac);
+}
+
+static bool interpolateFrame_Ref(uint8_t *outBuf, int32_t *interpBuf,
+                                 const uint8_t *buf0, const uint8_t *buf1,
+                                 int32_t scaleFac0, int32_t scaleFac1,
+                                 int32_t outScale, int n)
+{
+  bool    frameChanged = false;
+  for (int i = 0; i < n; i++) {
+    int32_t tmp = (int32_t(buf0[i]) * scaleFac0)
+                  + (int32_t(buf1[i]) * scaleFac1);
+    uint8_t tmp2 = uint8_t(((((interpBuf[i] - tmp) >> 8) * outScale)
+                            + 0x00200000) >> 22);
+    interpBuf[i] = tmp;
+    frameChanged = frameChanged || (tmp2 != outBuf[i]);
+    outBuf[i] = tmp2;
+  }
+  return frameChanged;
+}
+
+struct ResampleState {
+  std::vector< int32_t >  interpBuf;
+  std::vector< uint8_t >  outBuf;
+  uint32_t  outHash;
+  size_t    nFramesChanged;
+};
+
+static size_t compareBuffers(const ResampleState& s, const ResampleState& r)
+{
+  size_t  nErrors = 0;
+  for (size_t i = 0; i < r.outBuf.size(); i++) {
+    if (s.outBuf[i] != r.outBuf[i] || s.interpBuf[i] != r.interpBuf[i])
+      nErrors++;
+  }
+  return nErrors;
+}
+
+// resample 'nFrames' random input frames to 30 frames per second, using
+// the reference implementation if 'useRef' is true; returns the time spent
+// in the resampling functions in seconds
+
+static double runResampleTest(ResampleState& s, size_t nFrames, bool useRef)
+{
+  randomSeed = 0x12345678U;
+  std::vector< uint8_t >  frameBuf0(size_t(frameBytes) + 16, 0x10);
+  std::vector< uint8_t >  frameBuf1(size_t(frameBytes) + 16, 0x10);
+  std::vector< uint8_t >  lineBuf(256);
+  s.interpBuf.clear();
+  s.interpBuf.resize(size_t(frameBytes), 0);
+  s.outBuf.clear();
+  s.outBuf.resize(size_t(frameBytes), 0x10);
+  s.outHash = 0x811C9DC5U;
+  s.nFramesChanged = 0;
+  // frame times in microseconds
+  const int32_t outFrameTime = 33333;
+  int32_t interpTime = 0;
+  double  t = 0.0;
+  Ep128Emu::Timer timer;
+  for (size_t i = 0; i < nFrames; i++) {
+    frameBuf0.swap(frameBuf1);
+    // mostly small changes, and some completely new frames
+    if (getRandomNumber(8) == 0) {
+      for (int j = 0; j < frameBytes; j++)
+        frameBuf1[j] = uint8_t(getRandomNumber(256));
+    }
+    else {
+      for (int j = getRandomNumber(64); j > 0; j--)
+        frameBuf1[getRandomNumber(frameBytes)] = uint8_t(getRandomNumber(256));
+    }
+    // blend chroma lines, with unaligned buffers
+    for (int j = getRandomNumber(32); j > 0; j--) {
+      int     nBytes = getRandomNumber(200);
+      int     offs = getRandomNumber(frameBytes - nBytes);
+      for (int k = 0; k < nBytes; k++)
+        lineBuf[k] = uint8_t(getRandomNumber(256));
+      timer.reset();
+      if (useRef)
+        averageChromaLine_Ref(&(frameBuf1[offs]), &(lineBuf[0]), nBytes);
+      else
+        VideoCaptureTest::averageChromaLine(&(frameBuf1[offs]), &(lineBuf[0]),
+                                            nBytes);
+      t += timer.getRealTime();
+    }
+    // input frame time between 10 and 40 ms
+    int32_t scaleFac = int32_t(getRandomNumber(30000) + 10000);
+    interpTime += scaleFac;
+    timer.reset();
+    if (useRef) {
+      accumulateFrame_Ref(&(s.interpBuf.front()),
+                          &(frameBuf0.front()), &(frameBuf1.front()),
+                          scaleFac, frameBytes);
+    }
+    else {
+      VideoCaptureTest::accumulateFrame(&(s.interpBuf.front()),
+                                        &(frameBuf0.front()),
+                                        &(frameBuf1.front()),
+                                        scaleFac, frameBytes);
+    }
+    t += timer.getRealTime();
+    while (interpTime >= outFrameTime) {
+      // same as in VideoCapture_YV12::frameDone()
+      int32_t t1 = interpTime - outFrameTime;
+      int32_t t0 = scaleFac - t1;
+      double  tt = 3.1415926535898 * (double(t1) / (double(t0) + double(t1)));
+      tt = 0.3183098861838 * (tt - std::sin(tt));
+      int32_t scaleFac0 = int32_t(double(t1) * tt + 0.5);
+      int32_t scaleFac1 = int32_t(double(t1) * (2.0 - tt) + 0.5);
+      int32_t outScale = int32_t(0x20000000) / outFrameTime;
+      bool    frameChanged = false;
+      timer.reset();
+      if (useRef) {
+        frameChanged =
+            interpolateFrame_Ref(&(s.outBuf.front()), &(s.interpBuf.front()),
+                                 &(frameBuf0.front()), &(frameBuf1.front()),
+                                 scaleFac0, scaleFac1, outScale, frameBytes);
+      }
+      else {
+        frameChanged =
+            VideoCaptureTest::interpolateFrame(
+                &(s.outBuf.front()), &(s.interpBuf.front()),
+                &(frameBuf0.front()), &(frameBuf1.front()),
+                scaleFac0, scaleFac1, outScale, frameBytes);
+      }
+      t += timer.getRealTime();
+      if (frameChanged)
+        s.nFramesChanged++;
+      for (int j = 0; j < frameBytes; j++)
+        s.outHash = (s.outHash ^ uint32_t(s.outBuf[j])) * 0x01000193U;
+      interpTime = t1;
+    }
+  }
+  return t;
+}
+
+// test short and unaligned buffers with random scale factors, in the range
+// that does not overflow with a frame time of 'frameTime' microseconds;
+// returns the number of errors
+
+static size_t runShortBufferTest(size_t nTests)
+{
+  std::vector< uint8_t >  buf0(64);
+  std::vector< uint8_t >  buf1(64);
+  std::vector< int32_t >  interpBuf(64);
+  std::vector< int32_t >  refInterpBuf(64);
+  std::vector< uint8_t >  outBuf(64);
+  std::vector< uint8_t >  refOutBuf(64);
+  size_t  nErrors = 0;
+  for (size_t i = 0; i < nTests; i++) {
+    int     offs = getRandomNumber(16);
+    int     n = getRandomNumber(48) + 1;
+    int32_t frameTime = int32_t(getRandomNumber(60000) + 16000);
+    for (int j = 0; j < 64; j++) {
+      buf0[j] = uint8_t(getRandomNumber(256));
+      buf1[j] = uint8_t(getRandomNumber(256));
+      refInterpBuf[j] = interpBuf[j] =
+          int32_t(getRandomNumber(511)) * frameTime
+          + int32_t(getRandomNumber(int(frameTime)));
+      refOutBuf[j] = outBuf[j] = uint8_t(getRandomNumber(256));
+    }
+    int32_t scaleFac0 = int32_t(getRandomNumber(int(frameTime)));
+    int32_t scaleFac1 = int32_t(getRandomNumber(int(frameTime)));
+    int32_t outScale = int32_t(0x20000000) / frameTime;
+    bool    frameChanged = false;
+    bool    refFrameChanged = false;
+    switch (getRandomNumber(3)) {
+    case 0:
+      VideoCaptureTest::averageChromaLine(&(outBuf[offs]), &(buf0[0]), n);
+      averageChromaLine_Ref(&(refOutBuf[offs]), &(buf0[0]), n);
+      break;
+    case 1:
+      VideoCaptureTest::accumulateFrame(&(interpBuf[offs]), &(buf0[0]),
+                                        &(buf1[offs]), scaleFac0, n);
+      accumulateFrame_Ref(&(refInterpBuf[offs]), &(buf0[0]),
+                          &(buf1[offs]), scaleFac0, n);
+      break;
+    default:
+      frameChanged =
+          VideoCaptureTest::interpolateFrame(&(outBuf[offs]),
+                                             &(interpBuf[offs]),
+                                             &(buf0[0]), &(buf1[offs]),
+                                             scaleFac0, scaleFac1, outScale,
+                                             n);
+      refFrameChanged =
+          interpolateFrame_Ref(&(refOutBuf[offs]), &(refInterpBuf[offs]),
+                               &(buf0[0]), &(buf1[offs]),
+                               scaleFac0, scaleFac1, outScale, n);
+      break;
+    }
+    bool    errorFlag = (frameChanged != refFrameChanged);
+    for (int j = 0; j < 64; j++) {
+      if (outBuf[j] != refOutBuf[j] || interpBuf[j] != refInterpBuf[j])
+        errorFlag = true;
+    }
+    if (errorFlag) {
+      if (nErrors < 5) {
+        std::printf("  mismatch in short buffer test %lu (offset %d, "
+                    "%d bytes)\n", (unsigned long) i, offs, n);
+      }
+      nErrors++;
+    }
+  }
+  return nErrors;
+}
+
+int main(int argc, char **argv)
+{
+  size_t  nFrames = 500;
+  bool    printUsageFlag = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string tmp = argv[i];
+      if (tmp.length() < 1)
+        continue;
+      if (tmp == "-n") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -n");
+        int     n = int(std::atoi(argv[i]));
+        if (n < 1 || n > 100000)
+          throw Ep128Emu::Exception("number of frames is out of range");
+        nFrames = size_t(n);
+      }
+      else {
+        printUsageFlag = true;
+        if (tmp == "-h" || tmp == "-help" || tmp == "--help")
+          throw Ep128Emu::Exception("");
+        throw Ep128Emu::Exception("invalid command line option");
+      }
+    }
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    std::printf("VideoCapture_YV12: SSE2\n");
+#else
+    std::printf("VideoCapture_YV12: no SSE2\n");
+#endif
+    ResampleState s;
+    ResampleState r;
+    double  t0 = runResampleTest(s, nFrames, false);
+    double  t1 = runResampleTest(r, nFrames, true);
+    size_t  nErrors = compareBuffers(s, r);
+    if (s.nFramesChanged != r.nFramesChanged || s.outHash != r.outHash)
+      nErrors++;
+    std::printf("%lu input frames, %lu changed output frames, hash: %08X, "
+                "%lu mismatches\n",
+                (unsigned long) nFrames, (unsigned long) r.nFramesChanged,
+                (unsigned int) r.outHash, (unsigned long) nErrors);
+    size_t  nShortErrors = runShortBufferTest(nFrames * 200);
+    std::printf("short buffer test: %lu mismatches\n",
+                (unsigned long) nShortErrors);
+    std::printf("VideoCapture_YV12: %.2f ms, reference: %.2f ms per frame\n",
+                t0 * 1000.0 / double(nFrames), t1 * 1000.0 / double(nFrames));
+    if (nErrors || nShortErrors)
+      throw Ep128Emu::Exception("YV12 resampling output does not match");
+  }
+  catch (std::exception& e) {
+    if (printUsageFlag) {
+      std::printf("Usage: %s [OPTIONS...]\n", argv[0]);
+      std::printf("Options:\n");
+      std::printf("    -n <N>\n");
+      std::printf("        number of input frames to test (default: 500)\n");
+      if (e.what()[0] == '\0')
+        return 0;
+    }
+    std::fprintf(stderr, " *** %s: %s\n", argv[0], e.what());
+    return -1;
+  }
+  return 0;
+}
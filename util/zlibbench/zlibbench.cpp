@@ -0,0 +1,236 @@
+
+// ep128emu -- portable Enterprise 128 emulator
+// Copyright (C) 2003-2017 Istvan Varga <istvanv@users.sourceforge.net>
+// https://github.com/istvan-v/ep128emu/
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+// Measures the speed and compression ratio of Compressor_ZLib with each
+// compression level, on 8-bit palette and 24-bit RGB PNG image data (using
+// each of the PNG filter types, and the adaptive filter selection of
+// writePNGImage()), and optionally on the contents of a file.
+
+#include "ep128emu.hpp"
+#include "pngwrite.hpp"
+#include "system.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// run each test for at least this many seconds
+static const double minTestTime = 0.5;
+
+static const int    imageWidth = 768;
+static const int    imageHeight = 576;
+
+static const char *levelNames[3] = {
+  "fast", "default", "optimal"
+};
+
+static const char *filterNames[6] = {
+  "adaptive", "none", "sub", "up", "average", "paeth"
+};
+
+static uint32_t randomSeed = 0x12345678U;
+
+static int getRandomNumber(int n)
+{
+  randomSeed = (randomSeed * 1103515245U + 12345U) & 0xFFFFFFFFU;
+  return int((randomSeed >> 16) % uint32_t(n));
+}
+
+// create a test image similar to an emulator screenshot: 16 colors, a text
+// area with random characters, a color gradient, and a smooth RGB gradient
+// (that is only visible in the RGB version of the image)
+
+static void createTestImage(std::vector< unsigned char >& palImage,
+                            std::vector< unsigned char >& rgbImage)
+{
+  unsigned char palette[48];
+  for (int i = 0; i < 16; i++) {
+    palette[i * 3] = (unsigned char) ((i & 1) ? 0xFF : ((i & 8) ? 0x80 : 0));
+    palette[i * 3 + 1] =
+        (unsigned char) ((i & 2) ? 0xFF : ((i & 8) ? 0x80 : 0));
+    palette[i * 3 + 2] =
+        (unsigned char) ((i & 4) ? 0xFF : ((i & 8) ? 0x80 : 0));
+  }
+  palImage.resize(size_t(imageWidth) * size_t(imageHeight));
+  for (int yc = 0; yc < imageHeight / 16; yc++) {
+    for (int xc = 0; xc < imageWidth / 16; xc++) {
+      unsigned char bgColor = 1;
+      unsigned char fgColor = 15;
+      int     c = getRandomNumber(96);
+      if (yc >= 24) {
+        // color bars
+        bgColor = (unsigned char) ((xc + yc) & 15);
+        c = 0;
+      }
+      else if (c < 32 || xc >= 40) {
+        c = 0;                          // space
+      }
+      for (int y = 0; y < 16; y++) {
+        unsigned char bits =
+            (unsigned char) ((c * 37 + (y >> 1) * 11) & 0x7E);
+        if (y < 2 || y >= 14)
+          bits = 0;
+        for (int x = 0; x < 16; x++) {
+          bool    fg = bool((bits << (x >> 1)) & 0x80) && c != 0;
+          palImage[size_t(yc * 16 + y) * size_t(imageWidth)
+                   + size_t(xc * 16 + x)] = (fg ? fgColor : bgColor);
+        }
+      }
+    }
+  }
+  rgbImage.resize(size_t(imageWidth) * size_t(imageHeight) * 3);
+  for (int y = 0; y < imageHeight; y++) {
+    for (int x = 0; x < imageWidth; x++) {
+      size_t  n = size_t(y) * size_t(imageWidth) + size_t(x);
+      const unsigned char *p = &(palette[int(palImage[n]) * 3]);
+      if (x >= 640 && y < 384) {
+        rgbImage[n * 3] = (unsigned char) (x - 512);
+        rgbImage[n * 3 + 1] = (unsigned char) (y * 2 / 3);
+        rgbImage[n * 3 + 2] = (unsigned char) ((x + y) >> 2);
+      }
+      else {
+        rgbImage[n * 3] = p[0];
+        rgbImage[n * 3 + 1] = p[1];
+        rgbImage[n * 3 + 2] = p[2];
+      }
+    }
+  }
+}
+
+// copy the image to 'buf' in the format expected by applyPNGFilters()
+
+static void copyImageLines(std::vector< unsigned char >& buf,
+                           const std::vector< unsigned char >& img,
+                           size_t lineBytes)
+{
+  size_t  h = img.size() / lineBytes;
+  buf.resize(h * (lineBytes + 1));
+  for (size_t y = 0; y < h; y++) {
+    buf[y * (lineBytes + 1)] = 0;
+    std::memcpy(&(buf[y * (lineBytes + 1) + 1]), &(img[y * lineBytes]),
+                lineBytes);
+  }
+}
+
+static void runTest(const char *name, const char *filterName,
+                    const std::vector< unsigned char >& img, size_t lineBytes,
+                    int filterType, int level, size_t blockSize)
+{
+  std::vector< unsigned char >  buf;
+  std::vector< unsigned char >  outBuf;
+  Ep128Emu::Timer timer;
+  size_t  n = 0;
+  double  t = 0.0;
+  do {
+    copyImageLines(buf, img, lineBytes);
+    if (filterType >= -1) {
+      Ep128Emu::applyPNGFilters(&(buf.front()), lineBytes,
+                                int(img.size() / lineBytes), filterType);
+    }
+    outBuf.clear();
+    Ep128Emu::Compressor_ZLib::compressData(outBuf, &(buf.front()),
+                                            buf.size(), blockSize, level);
+    n++;
+    t = timer.getRealTime();
+  } while (t < minTestTime);
+  std::printf("%-8s %-8s %-8s %10.3f ms %9lu bytes (%6.2f%%)\n",
+              name, filterName, levelNames[level], t * 1000.0 / double(n),
+              (unsigned long) outBuf.size(),
+              double(outBuf.size()) * 100.0 / double(buf.size()));
+}
+
+int main(int argc, char **argv)
+{
+  const char  *inFileName = (char *) 0;
+  size_t  blockSize = 16384;
+  bool    printUsageFlag = false;
+  try {
+    for (int i = 1; i < argc; i++) {
+      std::string tmp = argv[i];
+      if (tmp.length() < 1)
+        continue;
+      if (tmp == "-i") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -i");
+        inFileName = argv[i];
+      }
+      else if (tmp == "-b") {
+        if (++i >= argc)
+          throw Ep128Emu::Exception("missing argument for -b");
+        int     n = int(std::atoi(argv[i]));
+        if (n < 1024 || n > 32768 || (n & (n - 1)) != 0)
+          throw Ep128Emu::Exception("invalid block size");
+        blockSize = size_t(n);
+      }
+      else {
+        printUsageFlag = true;
+        if (tmp == "-h" || tmp == "-help" || tmp == "--help")
+          throw Ep128Emu::Exception("");
+        throw Ep128Emu::Exception("invalid command line option");
+      }
+    }
+    std::vector< unsigned char >  palImage;
+    std::vector< unsigned char >  rgbImage;
+    createTestImage(palImage, rgbImage);
+    for (int level = 0; level < 3; level++)
+      runTest("palette", "none", palImage, size_t(imageWidth), -2, level,
+              blockSize);
+    for (int filterType = -1; filterType <= 4; filterType++) {
+      for (int level = 0; level < 3; level++) {
+        runTest("RGB", filterNames[filterType + 1], rgbImage,
+                size_t(imageWidth) * 3, filterType, level, blockSize);
+      }
+    }
+    if (inFileName) {
+      std::vector< unsigned char >  fileData;
+      std::FILE *f = Ep128Emu::fileOpen(inFileName, "rb");
+      if (!f)
+        throw Ep128Emu::Exception("error opening input file");
+      int     c;
+      while ((c = std::fgetc(f)) != EOF)
+        fileData.push_back((unsigned char) c);
+      std::fclose(f);
+      if (fileData.size() < 1)
+        throw Ep128Emu::Exception("empty input file");
+      // compress the file as a single unfiltered line (with a zero byte
+      // prepended)
+      for (int level = 0; level < 3; level++) {
+        runTest("file", "-", fileData, fileData.size(), -2, level,
+                blockSize);
+      }
+    }
+  }
+  catch (std::exception& e) {
+    if (printUsageFlag) {
+      std::printf("Usage: %s [OPTIONS...]\n", argv[0]);
+      std::printf("Options:\n");
+      std::printf("    -i <FILENAME>\n");
+      std::printf("        also compress the contents of this file\n");
+      std::printf("    -b <N>\n");
+      std::printf("        Deflate block size (1024 to 32768, must be a "
+                  "power of two, default: 16384)\n");
+      if (e.what()[0] == '\0')
+        return 0;
+    }
+    std::fprintf(stderr, " *** %s: %s\n", argv[0], e.what());
+    return -1;
+  }
+  return 0;
+}
+
@@ -266,6 +266,19 @@ namespace Ep128 {
     void clearInterrupt();
     void setVectorBase(int);
     void executeInstruction();
+    /*!
+     * Returns true if the CPU is executing a HALT instruction, and there is
+     * no pending interrupt, NMI, or program counter change that would end
+     * it after the next instruction.
+     */
+    EP128EMU_INLINE bool getIsHalted() const
+    {
+      if ((R.Flags & (Z80_EXECUTING_HALT_FLAG | Z80_NMI_FLAG | Z80_SET_PC_FLAG))
+          != Z80_EXECUTING_HALT_FLAG) {
+        return false;
+      }
+      return (!(R.Flags & Z80_EXECUTE_INTERRUPT_HANDLER_FLAG) || !R.IFF1);
+    }
     /*!
      * Save snapshot.
      */
@@ -276,6 +289,20 @@ namespace Ep128 {
      */
     void loadState(Ep128Emu::File::Buffer&);
     void registerChunkType(Ep128Emu::File&);
+    /*!
+     * Save (cloneState()) or restore (restoreState()) a fast in-memory copy
+     * of the registers, see Ep128Emu::MachineState.
+     */
+    void cloneState(Ep128Emu::MachineState& s) const
+    {
+      s.write(R);
+      s.write(newPCAddress);
+    }
+    void restoreState(Ep128Emu::MachineState& s)
+    {
+      s.read(R);
+      s.read(newPCAddress);
+    }
    protected:
     /*!
      * Called when a maskable interrupt is to be executed. Subclasses should